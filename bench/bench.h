@@ -0,0 +1,63 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_BENCH_H
+#define LYNC_BENCH_H
+
+//clock_gettime under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "../src/common.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+//the compiler keeps its globals in main.c, benchmarks link without it
+#define BENCH_DEFINE_GLOBALS() \
+    LYNC_THREAD_LOCAL ErrorCollector* g_error_collector = nullptr; \
+    unsigned g_trace_mask = 0; \
+    LYNC_THREAD_LOCAL int g_trace_depth = 0
+
+//monotonic wall clock in seconds
+static inline double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+//growable text buffer used by the synthetic source generators
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} BenchText;
+
+static inline void bench_text_append(BenchText* t, const char* fmt, ...) {
+    va_list args;
+    for (;;) {
+        size_t room = t->cap - t->len;
+        va_start(args, fmt);
+        int n = vsnprintf(t->data ? t->data + t->len : NULL, room, fmt, args);
+        va_end(args);
+        if (n >= 0 && (size_t)n < room) {
+            t->len += n;
+            return;
+        }
+        t->cap = t->cap ? t->cap * 2 : 4096;
+        while (t->cap - t->len <= (size_t)n) t->cap *= 2;
+        t->data = realloc(t->data, t->cap);
+    }
+}
+
+#endif //LYNC_BENCH_H
@@ -0,0 +1,166 @@
+//created by bucka on 10/16/2026.
+
+#include "bench.h"
+#include "../src/analyzer.h"
+#include "../src/parser.h"
+#include "../src/error.h"
+#include "../src/source.h"
+
+BENCH_DEFINE_GLOBALS();
+
+//one function with `locals` variables, each reading the previous one, plus borrows and nested blocks
+static BenchText make_source(int locals) {
+    BenchText t = {0};
+    bench_text_append(&t, "def main(): int {\n");
+    bench_text_append(&t, "    local_value_0: int = 0;\n");
+    for (int i = 1; i < locals; i++) {
+        bench_text_append(&t, "    local_value_%d: int = local_value_%d + %d;\n", i, i - 1, i);
+        if (i % 50 == 0) {
+            bench_text_append(&t, "    owned_%d: own int = alloc %d;\n", i, i);
+            bench_text_append(&t, "    borrow_%d: ref int = owned_%d;\n", i, i);
+            bench_text_append(&t, "    free owned_%d;\n", i);
+        }
+        if (i % 100 == 0) {
+            bench_text_append(&t, "    if (true) {\n        local_value_%d: int = local_value_0 + %d;\n", i, i);
+            bench_text_append(&t, "        if (local_value_%d > 0) { local_value_1 = local_value_%d; }\n    }\n", i, i);
+        }
+    }
+    bench_text_append(&t, "    return local_value_%d;\n}\n", locals - 1);
+    return t;
+}
+
+//many small functions, each calling two earlier ones, two overloads per name
+static BenchText make_module(int funcs) {
+    BenchText t = {0};
+    for (int f = 0; f < funcs; f++) {
+        bench_text_append(&t, "def helper_%d(x: int): int {\n", f / 2);
+        if (f >= 4) bench_text_append(&t, "    return helper_%d(x + 1) + helper_%d(x);\n}\n", f / 2 - 1, f / 2 - 2);
+        else bench_text_append(&t, "    return x;\n}\n");
+        f++;
+        bench_text_append(&t, "def helper_%d(x: int, y: int): int {\n    return helper_%d(x + y);\n}\n", f / 2, f / 2);
+    }
+    bench_text_append(&t, "def main(): int {\n    return helper_0(1);\n}\n");
+    return t;
+}
+
+//the scope layout analyze_program used before the symbol table: per scope arrays, strcmp up the chain
+typedef struct LinearScope LinearScope;
+struct LinearScope {
+    char** names;
+    int count;
+    int capacity;
+    LinearScope* parent;
+};
+
+static void linear_declare(LinearScope* s, char* name) {
+    for (int i = 0; i < s->count; i++) {
+        if (strcmp(s->names[i], name) == 0) return;
+    }
+    if (s->count == s->capacity) {
+        s->capacity = s->capacity ? s->capacity * 2 : 2;
+        s->names = realloc(s->names, sizeof(char*) * s->capacity);
+    }
+    s->names[s->count++] = name;
+}
+
+static char* linear_lookup(LinearScope* s, char* name) {
+    for (; s; s = s->parent) {
+        for (int i = 0; i < s->count; i++) {
+            if (strcmp(s->names[i], name) == 0) return s->names[i];
+        }
+    }
+    return nullptr;
+}
+
+static double run_analyzer(BenchText src, int iterations) {
+    int file_id = source_add("bench.lync", src.data, (uint32_t)src.len);
+
+    double best = 1e30;
+    for (int it = 0; it < iterations; it++) {
+        int token_count = 0;
+        Token* tokens = tokenize(file_id, &token_count);
+        Parser parser = {.tokens = tokens, .count = token_count, .size = token_count, .pos = 0};
+        Program* program = parseProgram(&parser);
+
+        double start = bench_now();
+        analyze_program(program);
+        double elapsed = bench_now() - start;
+        if (elapsed < best) best = elapsed;
+
+        if (has_errors(g_error_collector)) {
+            print_messages(g_error_collector);
+            exit(1);
+        }
+        arena_release(&g_arena);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    g_error_collector = init_error_collector();
+
+    printf("analyzer bench: %d iterations\n", iterations);
+    static const int sizes[] = {1000, 2500, 5000, 10000};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        double best = run_analyzer(make_source(sizes[k]), iterations);
+        printf("  %6d locals:     analyze %8.2f ms  %7.1f ns/local\n",
+               sizes[k], best * 1000.0, best * 1e9 / sizes[k]);
+    }
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        double best = run_analyzer(make_module(sizes[k]), iterations);
+        printf("  %6d functions:  analyze %8.2f ms  %7.1f ns/function\n",
+               sizes[k], best * 1000.0, best * 1e9 / sizes[k]);
+    }
+
+    //declare + lookup of 5k names in isolation, symbol table against the old linear scan
+    int n = 5000;
+    char** names = malloc(sizeof(char*) * n);
+    for (int i = 0; i < n; i++) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "local_value_%d", i);
+        names[i] = intern_cstr(buf); //the analyzer compares names by pointer
+    }
+
+    double best_linear = 1e30, best_table = 1e30;
+    for (int it = 0; it < iterations; it++) {
+        double start = bench_now();
+        LinearScope root = {0};
+        LinearScope body = {.parent = &root};
+        unsigned long found = 0;
+        for (int i = 0; i < n; i++) {
+            linear_declare(&body, names[i]);
+            found += linear_lookup(&body, names[i / 2]) != nullptr;
+        }
+        double elapsed = bench_now() - start;
+        if (elapsed < best_linear) best_linear = elapsed;
+        free(body.names);
+
+        start = bench_now();
+        Scope* global = make_scope(nullptr);
+        Scope* scope = make_scope(global);
+        for (int i = 0; i < n; i++) {
+            declare(scope, names[i], INT_KEYWORD_T, OWNERSHIP_NONE, false, false, false, 0);
+            found -= lookup(scope, names[i / 2]) != nullptr;
+        }
+        pop_scope(scope);
+        elapsed = bench_now() - start;
+        if (elapsed < best_table) best_table = elapsed;
+        arena_release(&g_arena);
+
+        if (found != 0) {
+            fprintf(stderr, "lookup mismatch between linear scan and symbol table\n");
+            return 1;
+        }
+    }
+    printf("  %d declare+lookup:\n", n);
+    printf("    linear scan:     %8.2f ms\n", best_linear * 1000.0);
+    printf("    symbol table:    %8.2f ms\n", best_table * 1000.0);
+    printf("    speedup:         %8.2fx\n", best_linear / best_table);
+
+    free(names);
+    intern_release();
+    source_free_all();
+    free_error_collector(g_error_collector);
+    return 0;
+}
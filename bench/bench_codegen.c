@@ -0,0 +1,73 @@
+//created by bucka on 10/16/2026.
+
+#include "bench.h"
+#include "../src/analyzer.h"
+#include "../src/codegen.h"
+#include "../src/parser.h"
+#include "../src/error.h"
+#include "../src/source.h"
+
+BENCH_DEFINE_GLOBALS();
+
+//functions mixing the constructs codegen spends its time on: decls, arithmetic, loops, strings, calls
+static BenchText make_source(int funcs) {
+    BenchText t = {0};
+    for (int f = 0; f < funcs; f++) {
+        bench_text_append(&t, "def work_%d(alpha: int, beta: int): int {\n", f);
+        bench_text_append(&t, "    total: int = 0;\n");
+        bench_text_append(&t, "    scale: double = 1.5;\n");
+        for (int v = 0; v < 6; v++) {
+            bench_text_append(&t, "    value_%d: int = alpha * %d + beta - total;\n", v, v + 1);
+        }
+        bench_text_append(&t, "    for (i: 0 to 10) {\n");
+        bench_text_append(&t, "        if (i > value_2 && beta != 3) { total = total + i; } else { total = total - 1; }\n");
+        bench_text_append(&t, "    }\n");
+        bench_text_append(&t, "    print(\"work %d\\tdone:\\n\", total, scale);\n", f);
+        if (f > 0) bench_text_append(&t, "    return total + work_%d(value_1, value_5);\n}\n\n", f - 1);
+        else bench_text_append(&t, "    return total;\n}\n\n");
+    }
+    bench_text_append(&t, "def main(): int {\n    return work_%d(1, 2);\n}\n", funcs - 1);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    int funcs = argc > 1 ? atoi(argv[1]) : 20000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    g_error_collector = init_error_collector();
+
+    BenchText src = make_source(funcs);
+    int file_id = source_add("bench.lync", src.data, (uint32_t)src.len);
+    printf("codegen bench: %d functions, %d iterations\n", funcs, iterations);
+
+    double best = 1e30;
+    size_t out_len = 0;
+    for (int it = 0; it < iterations; it++) {
+        int token_count = 0;
+        Token* tokens = tokenize(file_id, &token_count);
+        Parser parser = {.tokens = tokens, .count = token_count, .size = token_count, .pos = 0};
+        Program* program = parseProgram(&parser);
+        analyze_program(program);
+        if (has_errors(g_error_collector)) {
+            print_messages(g_error_collector);
+            return 1;
+        }
+
+        OutBuf out;
+        ob_init(&out, 0);
+        double start = bench_now();
+        generate_code(program, &out);
+        double elapsed = bench_now() - start;
+        if (elapsed < best) best = elapsed;
+        out_len = out.len;
+        ob_free(&out);
+        arena_release(&g_arena);
+    }
+
+    printf("  generate_code:     %8.2f ms  %7.1f MB/s of C  (%.2f MB)\n",
+           best * 1000.0, (double)out_len / (1024.0 * 1024.0) / best, (double)out_len / (1024.0 * 1024.0));
+
+    source_free_all();
+    intern_release();
+    free_error_collector(g_error_collector);
+    return 0;
+}
@@ -0,0 +1,136 @@
+//created by bucka on 10/16/2026.
+
+#include "bench.h"
+#include "../src/lexer.h"
+#include "../src/error.h"
+#include "../src/source.h"
+
+BENCH_DEFINE_GLOBALS();
+
+//the classifier tokenize() used before lookup_keyword: copy the slice, then strcmp down the list
+static TokenType classify_strcmp_chain(const char* s, int len) {
+    char* word = malloc(len + 1);
+    memcpy(word, s, len);
+    word[len] = '\0';
+
+    static const struct { const char* text; TokenType type; } table[] = {
+        {"if", IF_T}, {"else", ELSE_T}, {"int", INT_KEYWORD_T}, {"char", CHAR_KEYWORD_T},
+        {"void", VOID_KEYWORD_T}, {"null", NULL_LIT_T}, {"bool", BOOL_KEYWORD_T},
+        {"string", STR_KEYWORD_T}, {"def", DEF_KEYWORD_T}, {"include", INCLUDE_T},
+        {"extern", EXTERN_T}, {"while", WHILE_T}, {"do", DO_T}, {"for", FOR_T}, {"to", TO_T},
+        {"return", RETURN_T}, {"alloc", ALLOC_T}, {"free", FREE_T}, {"match", MATCH_T},
+        {"some", SOME_T}, {"own", OWN_T}, {"ref", REF_T}, {"const", CONST_T},
+        {"float", FLOAT_KEYWORD_T}, {"double", DOUBLE_KEYWORD_T}, {"true", BOOL_LIT_T},
+        {"false", BOOL_LIT_T}, {"_", UNDERSCORE_T},
+    };
+
+    TokenType type = VAR_T;
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(word, table[i].text) == 0) { type = table[i].type; break; }
+    }
+    free(word); //the lexer kept identifiers as the token value, the bench just drops them
+    return type;
+}
+
+//synthetic module: many small functions full of locals, loops and calls
+static BenchText make_source(int funcs) {
+    BenchText t = {0};
+    for (int f = 0; f < funcs; f++) {
+        bench_text_append(&t, "def compute_value_%d(alpha_%d: int, beta_%d: int): int {\n", f, f, f);
+        for (int v = 0; v < 8; v++) {
+            bench_text_append(&t, "    local_variable_%d: int = alpha_%d * %d + beta_%d;\n", v, f, v, f);
+        }
+        bench_text_append(&t, "    total: int = 0;\n");
+        bench_text_append(&t, "    for i = 0 to 10 {\n");
+        bench_text_append(&t, "        if (i > local_variable_3 && true) { total = total + i; } else { total = total - 1; }\n");
+        bench_text_append(&t, "    }\n");
+        bench_text_append(&t, "    while (total > 100) do { total = total / 2; }\n");
+        bench_text_append(&t, "    return total + local_variable_7;\n}\n\n");
+    }
+    return t;
+}
+
+static bool is_ident_start(char c) {
+    return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_ident_char(char c) {
+    return is_ident_start(c) || (c >= '0' && c <= '9');
+}
+
+int main(int argc, char** argv) {
+    int funcs = argc > 1 ? atoi(argv[1]) : 20000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    g_error_collector = init_error_collector();
+
+    BenchText src = make_source(funcs);
+    int file_id = source_add("bench.lync", src.data, (uint32_t)src.len);
+    printf("lexer bench: %d functions, %.2f MB source, %d iterations\n",
+           funcs, (double)src.len / (1024.0 * 1024.0), iterations);
+
+    //full tokenize()
+    double best = 1e30;
+    int token_count = 0;
+    for (int it = 0; it < iterations; it++) {
+        double start = bench_now();
+        tokenize(file_id, &token_count);
+        double elapsed = bench_now() - start;
+        if (elapsed < best) best = elapsed;
+        arena_release(&g_arena); //the token array lives in the compilation arena
+    }
+    printf("  tokenize:          %8.2f ms  %10.0f tokens/s  %7.1f MB/s\n",
+           best * 1000.0, token_count / best, (double)src.len / (1024.0 * 1024.0) / best);
+    printf("  token array:       %8.2f MB (%zu bytes/token)\n",
+           (double)token_count * sizeof(Token) / (1024.0 * 1024.0), sizeof(Token));
+
+    //isolate the word classifier on every identifier-like slice of the source
+    int words = 0, word_cap = 1024;
+    int* starts = malloc(sizeof(int) * word_cap);
+    int* lens = malloc(sizeof(int) * word_cap);
+    for (size_t i = 0; i < src.len; ) {
+        if (!is_ident_start(src.data[i])) { i++; continue; }
+        size_t s = i;
+        while (i < src.len && is_ident_char(src.data[i])) i++;
+        if (words == word_cap) {
+            word_cap *= 2;
+            starts = realloc(starts, sizeof(int) * word_cap);
+            lens = realloc(lens, sizeof(int) * word_cap);
+        }
+        starts[words] = (int)s;
+        lens[words++] = (int)(i - s);
+    }
+
+    double best_chain = 1e30, best_switch = 1e30;
+    unsigned long checksum_chain = 0, checksum_switch = 0;
+    for (int it = 0; it < iterations; it++) {
+        double start = bench_now();
+        unsigned long sum = 0;
+        for (int k = 0; k < words; k++) sum += classify_strcmp_chain(&src.data[starts[k]], lens[k]);
+        double elapsed = bench_now() - start;
+        if (elapsed < best_chain) best_chain = elapsed;
+        checksum_chain = sum;
+
+        start = bench_now();
+        sum = 0;
+        for (int k = 0; k < words; k++) sum += lookup_keyword(&src.data[starts[k]], lens[k]);
+        elapsed = bench_now() - start;
+        if (elapsed < best_switch) best_switch = elapsed;
+        checksum_switch = sum;
+    }
+
+    if (checksum_chain != checksum_switch) {
+        fprintf(stderr, "classifier mismatch: %lu vs %lu\n", checksum_chain, checksum_switch);
+        return 1;
+    }
+    printf("  %d words classified\n", words);
+    printf("  strcmp chain:      %8.2f ms  %10.0f words/s\n", best_chain * 1000.0, words / best_chain);
+    printf("  lookup_keyword:    %8.2f ms  %10.0f words/s\n", best_switch * 1000.0, words / best_switch);
+    printf("  speedup:           %8.2fx\n", best_chain / best_switch);
+
+    free(starts);
+    free(lens);
+    source_free_all(); //owns src.data
+    intern_release();
+    free_error_collector(g_error_collector);
+    return 0;
+}
@@ -0,0 +1,82 @@
+//created by bucka on 10/16/2026.
+
+//the whole front end plus codegen with tracing off. built twice by cmake, once with the trace call
+//sites compiled in (LYNC_ENABLE_TRACE=1, mask empty) and once with them compiled out, compare the two
+
+#include "bench.h"
+#include "../src/analyzer.h"
+#include "../src/codegen.h"
+#include "../src/parser.h"
+#include "../src/error.h"
+#include "../src/source.h"
+
+BENCH_DEFINE_GLOBALS();
+
+//calls and lookups dominate, that is where the trace sites sit (consume, lookup, emit_*, get_mangled_name)
+static BenchText make_source(int funcs) {
+    BenchText t = {0};
+    for (int f = 0; f < funcs; f++) {
+        bench_text_append(&t, "def step_%d(a: int, b: int): int {\n", f);
+        bench_text_append(&t, "    acc: int = a + b;\n");
+        for (int v = 0; v < 8; v++) {
+            bench_text_append(&t, "    t_%d: int = acc * %d - b;\n", v, v + 2);
+            bench_text_append(&t, "    acc = acc + t_%d;\n", v);
+        }
+        if (f > 0) bench_text_append(&t, "    return step_%d(acc, t_3) + step_%d(t_1, a);\n}\n\n", f - 1, f - 1);
+        else bench_text_append(&t, "    return acc;\n}\n\n");
+    }
+    bench_text_append(&t, "def main(): int {\n    return step_%d(1, 2);\n}\n", funcs - 1);
+    return t;
+}
+
+int main(int argc, char** argv) {
+    int funcs = argc > 1 ? atoi(argv[1]) : 10000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    g_error_collector = init_error_collector();
+
+    BenchText src = make_source(funcs);
+    int file_id = source_add("bench.lync", src.data, (uint32_t)src.len);
+    printf("trace bench (call sites %s): %d functions, %d iterations\n",
+           LYNC_ENABLE_TRACE ? "compiled in" : "compiled out", funcs, iterations);
+
+    double best[4] = {1e30, 1e30, 1e30, 1e30};
+    for (int it = 0; it < iterations; it++) {
+        double t0 = bench_now();
+        int token_count = 0;
+        Token* tokens = tokenize(file_id, &token_count);
+        double t1 = bench_now();
+        Parser parser = {.tokens = tokens, .count = token_count, .size = token_count, .pos = 0};
+        Program* program = parseProgram(&parser);
+        double t2 = bench_now();
+        analyze_program(program);
+        double t3 = bench_now();
+        if (has_errors(g_error_collector)) {
+            print_messages(g_error_collector);
+            return 1;
+        }
+        OutBuf out;
+        ob_init(&out, 0);
+        generate_code(program, &out);
+        double t4 = bench_now();
+
+        double spans[4] = {t1 - t0, t2 - t1, t3 - t2, t4 - t3};
+        for (int i = 0; i < 4; i++) {
+            if (spans[i] < best[i]) best[i] = spans[i];
+        }
+        ob_free(&out);
+        arena_release(&g_arena);
+    }
+
+    const char* names[4] = {"lexer", "parser", "analyzer", "codegen"};
+    double total = 0;
+    for (int i = 0; i < 4; i++) {
+        printf("  %-10s %8.2f ms\n", names[i], best[i] * 1000.0);
+        total += best[i];
+    }
+    printf("  %-10s %8.2f ms\n", "total", total * 1000.0);
+
+    source_free_all();
+    intern_release();
+    free_error_collector(g_error_collector);
+    return 0;
+}
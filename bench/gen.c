@@ -0,0 +1,168 @@
+//created by bucka on 10/16/2026.
+
+//mkdir under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "gen.h"
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#define make_dir(path) mkdir(path, 0755)
+#endif
+
+#define MODULE_FUNCS 8
+
+GenParams gen_default_params(size_t target_bytes) {
+    GenParams p = {
+        .target_bytes = target_bytes,
+        .stmts = 24,
+        .expr_depth = 6,
+        .includes = target_bytes >= 64 * 1024 ? 16 : 2,
+        .match_arms = 12,
+        .string_len = 48,
+        .seed = 12345,
+    };
+    //one full size function is already ~2 KB, shrink the shape so tiny targets stay near their size
+    if (target_bytes < 8 * 1024) {
+        p.stmts = 6;
+        p.match_arms = 3;
+        p.includes = 1;
+        p.string_len = 16;
+    }
+    return p;
+}
+
+static unsigned next_rand(unsigned* state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void gen_expr(BenchText* t, int depth, unsigned* rng) {
+    static const char* ops[] = {"+", "-", "*"};
+    static const char* leaves[] = {"a", "b", "acc"};
+
+    //left deep, so the nesting is real but the text stays linear in depth
+    for (int d = 0; d < depth; d++) bench_text_append(t, "(");
+    bench_text_append(t, "%s", leaves[next_rand(rng) % 3]);
+    for (int d = 0; d < depth; d++) {
+        const char* op = ops[next_rand(rng) % 3];
+        if (next_rand(rng) % 2) bench_text_append(t, " %s %u)", op, next_rand(rng) % 97 + 1);
+        else bench_text_append(t, " %s %s)", op, leaves[next_rand(rng) % 3]);
+    }
+}
+
+static void gen_function(BenchText* t, const GenParams* p, int f, unsigned* rng) {
+    bench_text_append(t, "def fn_%d(a: int, b: int): int {\n", f);
+    bench_text_append(t, "    acc: int = a;\n");
+
+    for (int s = 0; s < p->stmts; s++) {
+        switch (s % 6) {
+            case 0:
+                bench_text_append(t, "    v_%d: int = ", s);
+                gen_expr(t, p->expr_depth, rng);
+                bench_text_append(t, ";\n    acc = acc + v_%d;\n", s);
+                break;
+            case 1:
+                bench_text_append(t, "    if (acc > %u) {\n        acc = acc - b;\n    } else {\n        acc = acc + %u;\n    }\n",
+                                  next_rand(rng) % 1000, next_rand(rng) % 10 + 1);
+                break;
+            case 2:
+                bench_text_append(t, "    for (i_%d: 0 to %u) {\n        acc = acc + i_%d;\n    }\n", s, next_rand(rng) % 8 + 1, s);
+                break;
+            case 3:
+                bench_text_append(t, "    while (acc > %u) {\n        acc = acc - %u;\n    }\n",
+                                  next_rand(rng) % 5000 + 1000, next_rand(rng) % 100 + 1);
+                break;
+            case 4:
+                bench_text_append(t, "    print(\"");
+                for (int c = 0; c < p->string_len; c++) bench_text_append(t, "%c", 'a' + (int)(next_rand(rng) % 26));
+                bench_text_append(t, "\", acc);\n");
+                break;
+            case 5:
+                if (f > 0 && (s / 6) % 2 == 0) {
+                    bench_text_append(t, "    acc = acc + fn_%d(acc, b);\n", f - 1);
+                } else if (p->includes > 0) {
+                    bench_text_append(t, "    acc = acc + m%u_f%u(acc);\n",
+                                      next_rand(rng) % p->includes, next_rand(rng) % MODULE_FUNCS);
+                } else {
+                    bench_text_append(t, "    acc = acc * 2;\n");
+                }
+                break;
+        }
+    }
+
+    if (p->match_arms > 0) {
+        bench_text_append(t, "    match b {\n");
+        for (int m = 0; m < p->match_arms; m++) {
+            bench_text_append(t, "        %d: {\n            acc = acc + %d;\n        }\n", m, m * 3 + 1);
+        }
+        bench_text_append(t, "        _: {\n            acc = acc - 1;\n        }\n    };\n");
+    }
+
+    bench_text_append(t, "    return acc;\n}\n\n");
+}
+
+static size_t count_lines(const BenchText* t) {
+    size_t lines = 0;
+    for (size_t i = 0; i < t->len; i++) lines += t->data[i] == '\n';
+    return lines;
+}
+
+static bool write_text(const char* path, const BenchText* t) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(t->data, 1, t->len, f) == t->len;
+    return fclose(f) == 0 && ok;
+}
+
+bool gen_write_program(const GenParams* p, const char* dir, GenStats* stats) {
+    char path[1024];
+    unsigned rng = p->seed ? p->seed : 1;
+    memset(stats, 0, sizeof(*stats));
+
+    make_dir(dir);
+    if (p->includes > 0) {
+        snprintf(path, sizeof(path), "%s/gen", dir);
+        make_dir(path);
+    }
+
+    for (int m = 0; m < p->includes; m++) {
+        BenchText mod = {0};
+        for (int f = 0; f < MODULE_FUNCS; f++) {
+            bench_text_append(&mod, "def m%d_f%d(x: int): int {\n    return x * %d + %d;\n}\n\n", m, f, f + 1, m);
+        }
+        snprintf(path, sizeof(path), "%s/gen/mod_%d.lync", dir, m);
+        bool ok = write_text(path, &mod);
+        stats->bytes += mod.len;
+        stats->lines += count_lines(&mod);
+        free(mod.data);
+        if (!ok) return false;
+    }
+
+    BenchText t = {0};
+    for (int m = 0; m < p->includes; m++) bench_text_append(&t, "include gen.mod_%d.*;\n", m);
+    bench_text_append(&t, "\n");
+
+    //at least one function, then as many as it takes to reach the target size
+    int funcs = 0;
+    do {
+        gen_function(&t, p, funcs++, &rng);
+    } while (t.len + stats->bytes < p->target_bytes);
+    bench_text_append(&t, "def main(): int {\n    return fn_%d(1, 2);\n}\n", funcs - 1);
+
+    snprintf(path, sizeof(path), "%s/main.lync", dir);
+    bool ok = write_text(path, &t);
+    stats->bytes += t.len;
+    stats->lines += count_lines(&t);
+    stats->funcs = funcs + p->includes * MODULE_FUNCS;
+    free(t.data);
+    return ok;
+}
@@ -0,0 +1,31 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_BENCH_GEN_H
+#define LYNC_BENCH_GEN_H
+
+#include "bench.h"
+
+//shape of a synthetic lync program, every knob maps to something a real program stresses
+typedef struct {
+    size_t target_bytes;    //keep adding functions to the main file until it is about this big
+    int stmts;              //statements per function
+    int expr_depth;         //paren nesting of the arithmetic in each declaration
+    int includes;           //separate module files pulled in with include
+    int match_arms;         //arms of the int match every function carries, 0 for none
+    int string_len;         //length of the literal in each print
+    unsigned seed;
+} GenParams;
+
+//defaults for a given size, the mix the lync-bench suite uses
+GenParams gen_default_params(size_t target_bytes);
+
+typedef struct {
+    size_t bytes;           //main file plus all modules
+    size_t lines;
+    int funcs;
+} GenStats;
+
+//writes dir/main.lync and dir/gen/mod_N.lync, false if a file could not be written
+bool gen_write_program(const GenParams* p, const char* dir, GenStats* stats);
+
+#endif //LYNC_BENCH_GEN_H
@@ -0,0 +1,396 @@
+//created by bucka on 10/16/2026.
+
+//compiler throughput suite: generates programs from 1 KB to 100 MB (see gen.h), runs the pipeline
+//stage by stage on each and reports lines/s and arena traffic. with --baseline it compares against
+//an earlier --save and exits 1 when any size got slower (or allocates more) than --threshold allows
+
+//getpid/rmdir under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "gen.h"
+#include "../src/analyzer.h"
+#include "../src/codegen.h"
+#include "../src/file_loader.h"
+#include "../src/optimizer.h"
+#include "../src/parser.h"
+#include "../src/error.h"
+#include "../src/source.h"
+#include "../src/thread_pool.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#define remove_dir(path) _rmdir(path)
+#else
+#include <unistd.h>
+#define remove_dir(path) rmdir(path)
+#endif
+
+BENCH_DEFINE_GLOBALS();
+
+#define BASELINE_MAGIC "lync-bench 1"
+#define MAX_SIZES 16
+#define MIN_SAMPLE_SECONDS 0.25
+
+typedef enum {
+    BS_LEXER,
+    BS_PARSER,
+    BS_INCLUDES,
+    BS_ANALYZER,
+    BS_OPTIMIZER,
+    BS_CODEGEN,
+    BS_COUNT
+} BenchStage;
+
+static const char* bench_stage_names[BS_COUNT] = {"lexer", "parser", "includes", "analyzer", "optimizer", "codegen"};
+
+typedef struct {
+    char label[24];
+    size_t bytes;
+    size_t lines;
+    double best[BS_COUNT];      //seconds, best of all runs
+    double total;               //sum of the per stage bests
+    size_t alloc_bytes;         //g_arena bytes for one compile, the same every run
+    int runs;
+} SizeResult;
+
+typedef struct {
+    size_t sizes[MAX_SIZES];
+    int size_count;
+    int iterations;
+    bool optimize;
+    double threshold;           //percent
+    const char* save_file;
+    const char* baseline_file;
+} BenchOptions;
+
+static bool parse_size(const char* s, size_t* out) {
+    char* end;
+    double v = strtod(s, &end);
+    if (end == s || v <= 0) return false;
+    switch (*end) {
+        case 'k': case 'K': v *= 1024; end++; break;
+        case 'm': case 'M': v *= 1024 * 1024; end++; break;
+        case 'g': case 'G': v *= 1024.0 * 1024 * 1024; end++; break;
+        default: break;
+    }
+    if (*end == 'B' || *end == 'b') end++;
+    *out = (size_t)v;
+    return *end == '\0' || *end == ',';
+}
+
+static void size_label(size_t bytes, char* out, size_t size) {
+    if (bytes >= 1024 * 1024 && bytes % (1024 * 1024) == 0) snprintf(out, size, "%zuM", bytes / (1024 * 1024));
+    else if (bytes >= 1024 && bytes % 1024 == 0) snprintf(out, size, "%zuK", bytes / 1024);
+    else snprintf(out, size, "%zu", bytes);
+}
+
+static size_t arena_total_bytes(void) {
+    size_t total = 0;
+    for (int i = 0; i < ARENA_STAGE_COUNT; i++) total += g_arena.stats[i].bytes;
+    return total;
+}
+
+//one full compile of dir/main.lync, the same order main.c runs it in
+static bool compile_once(const char* main_file, bool optimize, double spans[BS_COUNT], size_t* alloc_bytes) {
+    g_error_collector = init_error_collector();
+    size_t alloc_start = arena_total_bytes();   //the per stage counters outlive arena_release
+    double t[BS_COUNT + 1];
+    bool ok = false;
+    Program* program = nullptr;
+
+    t[0] = bench_now();
+    int file_id = source_load(main_file);
+    if (file_id < 0) {
+        fprintf(stderr, "could not load %s\n", main_file);
+        goto done;
+    }
+    int token_count = 0;
+    arena_set_stage(&g_arena, STAGE_LEXER);
+    Token* tokens = tokenize(file_id, &token_count);
+    t[1] = bench_now();
+
+    arena_set_stage(&g_arena, STAGE_PARSER);
+    Parser parser = {.tokens = tokens, .count = token_count, .size = token_count, .pos = 0};
+    program = parseProgram(&parser);
+    t[2] = bench_now();
+
+    process_file_includes(program, main_file);
+    t[3] = bench_now();
+
+    arena_set_stage(&g_arena, STAGE_ANALYZER);
+    analyze_program(program);
+    t[4] = bench_now();
+    if (has_errors(g_error_collector)) {
+        print_messages(g_error_collector);
+        goto done;
+    }
+
+    if (optimize) {
+        arena_set_stage(&g_arena, STAGE_OPTIMIZER);
+        optimize_program(program->functions, program->func_count, OPT_CONST_FOLD | OPT_CONST_PROP | OPT_DEAD_CODE | OPT_PEEPHOLE | OPT_CSE | OPT_LICM | OPT_STRENGTH, nullptr);
+    }
+    t[5] = bench_now();
+
+    arena_set_stage(&g_arena, STAGE_CODEGEN);
+    OutBuf out;
+    ob_init(&out, 0);
+    generate_code(program, &out);
+    ob_free(&out);
+    t[6] = bench_now();
+
+    for (int i = 0; i < BS_COUNT; i++) spans[i] = t[i + 1] - t[i];
+    *alloc_bytes = arena_total_bytes() - alloc_start;
+    ok = true;
+
+done:
+    arena_release(&g_arena);
+    intern_release();
+    source_free_all();
+    free_error_collector(g_error_collector);
+    return ok;
+}
+
+static void remove_program(const char* dir, int includes) {
+    char path[1024];
+    for (int m = 0; m < includes; m++) {
+        snprintf(path, sizeof(path), "%s/gen/mod_%d.lync", dir, m);
+        remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/gen", dir);
+    remove_dir(path);
+    snprintf(path, sizeof(path), "%s/main.lync", dir);
+    remove(path);
+    remove_dir(dir);
+}
+
+static bool run_size(size_t target, const BenchOptions* opt, SizeResult* r) {
+    memset(r, 0, sizeof(*r));
+    size_label(target, r->label, sizeof(r->label));
+    for (int i = 0; i < BS_COUNT; i++) r->best[i] = 1e30;
+
+    const char* tmp = getenv("TMPDIR");
+#ifdef _WIN32
+    if (!tmp) tmp = getenv("TEMP");
+#endif
+    char dir[1024], main_file[1100];
+    snprintf(dir, sizeof(dir), "%s/lync-bench-%d-%s", tmp ? tmp : "/tmp", (int)getpid(), r->label);
+    snprintf(main_file, sizeof(main_file), "%s/main.lync", dir);
+
+    GenParams params = gen_default_params(target);
+    GenStats stats;
+    if (!gen_write_program(&params, dir, &stats)) {
+        fprintf(stderr, "could not write the generated program to %s\n", dir);
+        remove_program(dir, params.includes);
+        return false;
+    }
+    r->bytes = stats.bytes;
+    r->lines = stats.lines;
+
+    //small programs are repeated until the sample is long enough to mean something
+    double spent = 0;
+    bool ok = true;
+    while (r->runs < opt->iterations || (spent < MIN_SAMPLE_SECONDS && r->runs < 1000)) {
+        double spans[BS_COUNT];
+        if (!compile_once(main_file, opt->optimize, spans, &r->alloc_bytes)) {
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < BS_COUNT; i++) {
+            if (spans[i] < r->best[i]) r->best[i] = spans[i];
+            spent += spans[i];
+        }
+        r->runs++;
+    }
+
+    r->total = 0;
+    for (int i = 0; i < BS_COUNT; i++) r->total += r->best[i];
+    remove_program(dir, params.includes);
+    return ok;
+}
+
+static void print_result(const SizeResult* r, bool optimize) {
+    printf("%6s %10zu %9zu", r->label, r->bytes, r->lines);
+    for (int i = 0; i < BS_COUNT; i++) {
+        if (i == BS_OPTIMIZER && !optimize) continue;
+        printf(" %9.2f", r->best[i] * 1000.0);
+    }
+    printf(" %9.2f %11.0f %8.1f %9.1f %5d\n", r->total * 1000.0, (double)r->lines / r->total,
+           (double)r->bytes / (1024.0 * 1024.0) / r->total, (double)r->alloc_bytes / (1024.0 * 1024.0), r->runs);
+}
+
+static void print_header(bool optimize) {
+    printf("%6s %10s %9s", "size", "bytes", "lines");
+    for (int i = 0; i < BS_COUNT; i++) {
+        if (i == BS_OPTIMIZER && !optimize) continue;
+        printf(" %9s", bench_stage_names[i]);
+    }
+    printf(" %9s %11s %8s %9s %5s\n", "total ms", "lines/s", "MB/s", "alloc MB", "runs");
+}
+
+static bool save_results(const char* file, const SizeResult* results, int count) {
+    FILE* f = fopen(file, "w");
+    if (!f) return false;
+    fprintf(f, "%s\n", BASELINE_MAGIC);
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "%s lines_per_sec %.0f\n", results[i].label, (double)results[i].lines / results[i].total);
+        fprintf(f, "%s alloc_bytes %zu\n", results[i].label, results[i].alloc_bytes);
+    }
+    return fclose(f) == 0;
+}
+
+//0 when nothing regressed, 1 when something did, -1 when the baseline is unusable
+static int compare_baseline(const char* file, const SizeResult* results, int count, double threshold) {
+    FILE* f = fopen(file, "r");
+    if (!f) {
+        fprintf(stderr, "could not open baseline %s\n", file);
+        return -1;
+    }
+
+    char line[256];
+    if (!fgets(line, sizeof(line), f) || strncmp(line, BASELINE_MAGIC, strlen(BASELINE_MAGIC)) != 0) {
+        fprintf(stderr, "%s is not a lync-bench baseline\n", file);
+        fclose(f);
+        return -1;
+    }
+
+    printf("\nagainst %s (threshold %.1f%%):\n", file, threshold);
+    int regressions = 0, compared = 0;
+    while (fgets(line, sizeof(line), f)) {
+        char label[24], metric[32];
+        double base;
+        if (sscanf(line, "%23s %31s %lf", label, metric, &base) != 3) continue;
+
+        for (int i = 0; i < count; i++) {
+            const SizeResult* r = &results[i];
+            if (strcmp(r->label, label) != 0) continue;
+
+            //lines per second should not drop, allocated bytes should not grow
+            double now, change;
+            if (strcmp(metric, "lines_per_sec") == 0) {
+                now = (double)r->lines / r->total;
+                change = base > 0 ? (base - now) * 100.0 / base : 0;
+            } else if (strcmp(metric, "alloc_bytes") == 0) {
+                now = (double)r->alloc_bytes;
+                change = base > 0 ? (now - base) * 100.0 / base : 0;
+            } else {
+                continue;
+            }
+
+            bool regressed = change > threshold;
+            printf("  %6s %-14s %14.0f -> %14.0f  %+7.1f%%%s\n", label, metric, base, now,
+                   strcmp(metric, "lines_per_sec") == 0 ? -change : change, regressed ? "  REGRESSION" : "");
+            regressions += regressed;
+            compared++;
+        }
+    }
+    fclose(f);
+
+    if (compared == 0) {
+        fprintf(stderr, "baseline %s has none of the measured sizes\n", file);
+        return -1;
+    }
+    return regressions > 0;
+}
+
+static void print_usage(const char* name) {
+    fprintf(stderr, "Usage: %s [options]\n", name);
+    fprintf(stderr, "  --sizes=<list>       Source sizes to run, default 1K,10K,100K,1M,10M,100M\n");
+    fprintf(stderr, "  --iterations=<n>     Runs per size (best is kept), default 3\n");
+    fprintf(stderr, "  -O                   Include the optimizer (const fold, dce, peephole)\n");
+    fprintf(stderr, "  --jobs=<n>           Analyzer and codegen threads, default 1\n");
+    fprintf(stderr, "  --save=<file>        Write the results as a baseline\n");
+    fprintf(stderr, "  --baseline=<file>    Compare against a saved baseline, exit 1 on regression\n");
+    fprintf(stderr, "  --threshold=<pct>    Allowed slowdown / allocation growth, default 10\n");
+    fprintf(stderr, "  --generate=<dir>     Only write a program of --size=<size> (default 1M) to dir\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt = {.iterations = 3, .threshold = 10.0};
+    const char* generate_dir = nullptr;
+    size_t generate_size = 1024 * 1024;
+    const char* sizes = "1K,10K,100K,1M,10M,100M";
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--sizes=", 8) == 0) sizes = argv[i] + 8;
+        else if (strncmp(argv[i], "--iterations=", 13) == 0) opt.iterations = atoi(argv[i] + 13);
+        else if (strcmp(argv[i], "-O") == 0) opt.optimize = true;
+        else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            g_jobs = atoi(argv[i] + 7);
+            if (g_jobs <= 0) g_jobs = pool_cpu_count();
+        }
+        else if (strncmp(argv[i], "--save=", 7) == 0) opt.save_file = argv[i] + 7;
+        else if (strncmp(argv[i], "--baseline=", 11) == 0) opt.baseline_file = argv[i] + 11;
+        else if (strncmp(argv[i], "--threshold=", 12) == 0) opt.threshold = atof(argv[i] + 12);
+        else if (strncmp(argv[i], "--generate=", 11) == 0) generate_dir = argv[i] + 11;
+        else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (!parse_size(argv[i] + 7, &generate_size)) {
+                fprintf(stderr, "bad size: %s\n", argv[i] + 7);
+                return 2;
+            }
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (opt.iterations < 1) opt.iterations = 1;
+
+    if (generate_dir) {
+        GenParams params = gen_default_params(generate_size);
+        GenStats stats;
+        if (!gen_write_program(&params, generate_dir, &stats)) {
+            fprintf(stderr, "could not write the generated program to %s\n", generate_dir);
+            return 1;
+        }
+        printf("wrote %s/main.lync: %zu bytes, %zu lines, %d functions, %d modules\n",
+               generate_dir, stats.bytes, stats.lines, stats.funcs, params.includes);
+        return 0;
+    }
+
+    for (const char* s = sizes; *s && opt.size_count < MAX_SIZES;) {
+        if (!parse_size(s, &opt.sizes[opt.size_count++])) {
+            fprintf(stderr, "bad size list: %s\n", sizes);
+            return 2;
+        }
+        s += strcspn(s, ",");
+        if (*s == ',') s++;
+    }
+
+    printf("lync-bench: %d sizes, best of >= %d runs, times in ms%s\n",
+           opt.size_count, opt.iterations, opt.optimize ? ", with optimizer" : "");
+    print_header(opt.optimize);
+
+    SizeResult results[MAX_SIZES];
+    int done = 0;
+    for (int i = 0; i < opt.size_count; i++) {
+        if (!run_size(opt.sizes[i], &opt, &results[done])) {
+            fprintf(stderr, "size %zu failed to compile\n", opt.sizes[i]);
+            return 1;
+        }
+        print_result(&results[done], opt.optimize);
+        fflush(stdout);
+        done++;
+    }
+
+    if (opt.save_file) {
+        if (!save_results(opt.save_file, results, done)) {
+            fprintf(stderr, "could not write %s\n", opt.save_file);
+            return 1;
+        }
+        printf("saved baseline to %s\n", opt.save_file);
+    }
+
+    if (opt.baseline_file) {
+        int regressed = compare_baseline(opt.baseline_file, results, done, opt.threshold);
+        if (regressed < 0) return 2;
+        if (regressed) {
+            printf("performance regression beyond %.1f%%\n", opt.threshold);
+            return 1;
+        }
+        printf("no regressions\n");
+    }
+    return 0;
+}
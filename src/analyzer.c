@@ -1,6 +1,8 @@
 //created by bucka on 2/9/2026.
 
 #include "analyzer.h"
+#include "error.h"
+#include "thread_pool.h"
 
 //forward declaration
 void check_function_cleanup(Scope* scope);
@@ -9,9 +11,9 @@ void check_function_cleanup(Scope* scope);
 static ImportRegistry* g_import_registry = nullptr;
 
 ImportRegistry* make_import_registry() {
-    ImportRegistry* reg = malloc(sizeof(ImportRegistry));
+    ImportRegistry* reg = arena_alloc(&g_arena, sizeof(ImportRegistry));
     reg->capacity = 10;
-    reg->imported_functions = malloc(sizeof(char*) * reg->capacity);
+    reg->imported_functions = arena_alloc(&g_arena, sizeof(char*) * reg->capacity);
     reg->count = 0;
     reg->has_wildcard_io = false;
     return reg;
@@ -30,14 +32,15 @@ void register_import(ImportRegistry* reg, IncludeStmt* stmt) {
             //register specific import name
             if (reg->count >= reg->capacity) {
                 reg->capacity *= 2;
-                reg->imported_functions = realloc(reg->imported_functions, sizeof(char*) * reg->capacity);
+                reg->imported_functions = arena_realloc(&g_arena, reg->imported_functions,
+                                                        sizeof(char*) * (reg->capacity / 2), sizeof(char*) * reg->capacity);
             }
             reg->imported_functions[reg->count++] = stmt->function_name;
             return;
         }
     }
 
-    if (strcmp(stmt->module_name, "std.io") != 0) {
+    if (!is_known_name(stmt->module_name, NAME_STD_IO)) {
         stage_warning(STAGE_ANALYZER, stmt->loc, "unknown standard module '%s' (only std.io is supported)", stmt->module_name);
         return;
     }
@@ -49,7 +52,8 @@ void register_import(ImportRegistry* reg, IncludeStmt* stmt) {
         //iMPORT_SPECIFIC
         if (reg->count >= reg->capacity) {
             reg->capacity *= 2;
-            reg->imported_functions = realloc(reg->imported_functions, sizeof(char*) * reg->capacity);
+            reg->imported_functions = arena_realloc(&g_arena, reg->imported_functions,
+                                                    sizeof(char*) * (reg->capacity / 2), sizeof(char*) * reg->capacity);
         }
         reg->imported_functions[reg->count++] = stmt->function_name;
         stage_trace(STAGE_ANALYZER, "registered import: %s", stmt->function_name);
@@ -62,90 +66,195 @@ bool is_imported(ImportRegistry* reg, const char* func_name) {
     }
 
     for (int i = 0; i < reg->count; i++) {
-        if (strcmp(reg->imported_functions[i], func_name) == 0) {
+        if (reg->imported_functions[i] == func_name) {
             return true;
         }
     }
     return false;
 }
 
+#define SYMBOL_TABLE_INITIAL 64
+
+static SymbolTable* make_symbol_table(Arena* arena) {
+    SymbolTable* t = arena_alloc(arena, sizeof(SymbolTable));
+    t->capacity = SYMBOL_TABLE_INITIAL;
+    t->slots = arena_alloc(arena, sizeof(SymbolSlot) * t->capacity);
+    t->used = 0;
+    t->arena = arena;
+    return t;
+}
+
+//slot for name, either the one holding it or the empty one where it belongs
+static SymbolSlot* find_slot(SymbolSlot* slots, int capacity, const char* name, uint32_t hash) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t i = hash & mask;
+    while (slots[i].name) {
+        if (slots[i].name == name) return &slots[i];
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static void grow_symbol_table(SymbolTable* t) {
+    int capacity = t->capacity * 2;
+    SymbolSlot* slots = arena_alloc(t->arena, sizeof(SymbolSlot) * capacity);
+    for (int i = 0; i < t->capacity; i++) {
+        if (!t->slots[i].name) continue;
+        *find_slot(slots, capacity, t->slots[i].name, t->slots[i].hash) = t->slots[i];
+    }
+    t->slots = slots;
+    t->capacity = capacity;
+}
+
+//names stay in the table once seen, an empty chain just means nothing is visible
+static SymbolSlot* intern_slot(SymbolTable* t, const char* name) {
+    uint32_t hash = intern_hash(name);
+    SymbolSlot* slot = find_slot(t->slots, t->capacity, name, hash);
+    if (slot->name) return slot;
+
+    if ((t->used + 1) * 10 > t->capacity * 7) {
+        grow_symbol_table(t);
+        slot = find_slot(t->slots, t->capacity, name, hash);
+    }
+    slot->name = name;
+    slot->hash = hash;
+    slot->head = nullptr;
+    t->used++;
+    return slot;
+}
+
+//a root scope lives in keep with its own table, the scopes below it allocate from arena
+static Scope* make_root_scope(Arena* arena, Arena* keep) {
+    Scope* scope = arena_alloc(keep, sizeof(Scope));
+    scope->capacity = 2;
+    scope->symbols = arena_alloc(keep, sizeof(Symbol*) * scope->capacity);
+    scope->count = 0;
+    scope->parent = nullptr;
+    scope->arena = arena;
+    scope->keep = keep;
+    scope->table = make_symbol_table(keep);
+    return scope;
+}
+
 Scope* make_scope(Scope* parent) {
-    Scope* scope = malloc(sizeof(Scope));
+    if (!parent) {
+        Scope* root = make_root_scope(&g_arena, &g_arena);
+        stage_trace(STAGE_ANALYZER, "created scope %p (parent=%p)", root, parent);
+        return root;
+    }
+
+    Arena* arena = parent->arena;
+    Scope* scope = arena_alloc(arena, sizeof(Scope));
     scope->capacity = 2;
-    scope->symbols = malloc(sizeof(Symbol) * scope->capacity);
+    scope->symbols = arena_alloc(arena, sizeof(Symbol*) * scope->capacity);
     scope->count = 0;
     scope->parent = parent;
+    scope->arena = arena;
+    scope->keep = parent->keep;
+    scope->table = parent->table;
 
     stage_trace(STAGE_ANALYZER, "created scope %p (parent=%p)", scope, parent);
 
     return scope;
 }
 
+static void unlink_borrower(Symbol* ref) {
+    Symbol* owner = ref->borrowed_from;
+    if (!owner) return;
+    for (Symbol** it = &owner->borrowers; *it; it = &(*it)->next_borrower) {
+        if (*it == ref) {
+            *it = ref->next_borrower;
+            break;
+        }
+    }
+    ref->borrowed_from = nullptr;
+    ref->next_borrower = nullptr;
+}
+
+//ref now borrows from owner, so freeing owner can find it without scanning every scope
+static void set_borrow(Symbol* ref, char* owner_name, Symbol* owner) {
+    ref->owner = owner_name;
+    if (ref->borrowed_from == owner) return;
+    unlink_borrower(ref);
+    if (!owner || owner == ref) return;
+    ref->borrowed_from = owner;
+    ref->next_borrower = owner->borrowers;
+    owner->borrowers = ref;
+}
+
+void pop_scope(Scope* scope) {
+    for (int i = scope->count - 1; i >= 0; i--) {
+        Symbol* sym = scope->symbols[i];
+        unlink_borrower(sym);
+        if (!sym->visible) continue;
+        SymbolSlot* slot = intern_slot(scope->table, sym->name);
+        if (slot->head == sym) slot->head = sym->shadowed;
+        sym->visible = false;
+    }
+}
+
 void declare(Scope* scope, char* name, TokenType type, Ownership ownership, bool isNullable, bool isConst, bool isArray, int arraySize) {
-    if (strcmp(name, "print") == 0 || strcmp(name, "length") == 0) {
+    if (is_known_name(name, NAME_PRINT) || is_known_name(name, NAME_LENGTH)) {
         stage_error(STAGE_ANALYZER, NO_LOC,
                     "'%s' is a reserved built-in function and cannot be used as a variable name", name);
     }
 
-    for (int i = 0; i < scope->count; i++) {
-        if (strcmp(scope->symbols[i].name, name) == 0)
-            stage_error(STAGE_ANALYZER, NO_LOC,
-                        "variable '%s' already declared in this scope", name);
-    }
+    SymbolSlot* slot = intern_slot(scope->table, name);
+    bool duplicate = slot->head && slot->head->scope == scope;
+    if (duplicate)
+        stage_error(STAGE_ANALYZER, NO_LOC,
+                    "variable '%s' already declared in this scope", name);
 
     stage_trace(STAGE_ANALYZER, "declare %s : %s%s%s",
                 name, isNullable ? "nullable " : "", isArray ? "array " : "", token_type_name(type));
 
     if (scope->capacity == scope->count) {
         scope->capacity *= 2;
-        scope->symbols =
-                realloc(scope->symbols, sizeof(Symbol) * scope->capacity);
+        scope->symbols = arena_realloc(scope->arena, scope->symbols,
+                                       sizeof(Symbol*) * (scope->capacity / 2), sizeof(Symbol*) * scope->capacity);
     }
 
-    scope->symbols[scope->count++] =
-            (Symbol){
-                    .type = type,
-                    .name = name,
-                    .ownership = ownership,
-                    .is_nullable = isNullable,
-                    .is_const = isConst,
-                    .state = ALIVE,
-                    .owner = nullptr,
-                    .is_dangling = false,
-                    .is_unwrapped = false,
-                    .is_array = isArray,
-                    .array_size = arraySize
-            };
+    //symbols are allocated one by one so pointers into the chains stay valid while the scope grows
+    Symbol* sym = arena_alloc(scope->arena, sizeof(Symbol));
+    *sym = (Symbol){
+            .type = type,
+            .name = name,
+            .ownership = ownership,
+            .is_nullable = isNullable,
+            .is_const = isConst,
+            .state = ALIVE,
+            .owner = nullptr,
+            .is_dangling = false,
+            .is_unwrapped = false,
+            .is_array = isArray,
+            .array_size = arraySize,
+            .scope = scope
+    };
+    scope->symbols[scope->count++] = sym;
+
+    //a redeclaration stays hidden, lookups keep finding the first one
+    if (!duplicate) {
+        sym->shadowed = slot->head;
+        sym->visible = true;
+        slot->head = sym;
+    }
 }
 
 Symbol* lookup(Scope* scope, char* name) {
-    for (int i = 0; i < scope->count; ++i) {
-        if (strcmp(scope->symbols[i].name, name) == 0) {
-            stage_trace(STAGE_ANALYZER,
-                        "lookup '%s' -> found in scope %p", name, scope);
-            return &scope->symbols[i];
-        }
+    SymbolSlot* slot = find_slot(scope->table->slots, scope->table->capacity, name, intern_hash(name));
+    if (slot->head) {
+        stage_trace(STAGE_ANALYZER,
+                    "lookup '%s' -> found in scope %p", name, slot->head->scope);
+        return slot->head;
     }
 
-    if (scope->parent != NULL)
-        return lookup(scope->parent, name);
-
     stage_trace(STAGE_ANALYZER, "lookup '%s' -> not found", name);
     return NULL;
 }
 
-void mark_dangling_refs(Scope* scope, char* owner_name) {
-    for (int i = 0; i < scope->count; i++) {
-        Symbol* sym = &scope->symbols[i];
-        if (sym->ownership == OWNERSHIP_REF &&
-            sym->owner &&
-            strcmp(sym->owner, owner_name) == 0) {
-            sym->is_dangling = true;
-        }
-    }
-
-    if (scope->parent) {
-        mark_dangling_refs(scope->parent, owner_name);
+void mark_dangling_refs(Symbol* owner) {
+    for (Symbol* ref = owner->borrowers; ref; ref = ref->next_borrower) {
+        if (ref->ownership == OWNERSHIP_REF) ref->is_dangling = true;
     }
 }
 
@@ -177,7 +286,7 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
             Symbol* sym = lookup(scope, e->as.var.name);
             if (sym == nullptr) {
                 //check if trying to use print as a variable (give better error message)
-                if (strcmp(e->as.var.name, "print") == 0) {
+                if (is_known_name(e->as.var.name, NAME_PRINT)) {
                     stage_error(STAGE_ANALYZER, e->loc, "'print' is a built-in function, not a variable (use print(...) to call it)");
                 } else {
                     stage_error(STAGE_ANALYZER, e->loc, "variable '%s' is not declared", e->as.var.name);
@@ -339,7 +448,8 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
         }
         case FUNC_CALL_E: {
             //handle built-in print function
-            if(strcmp(e->as.func_call.name, "print") == 0) {
+            KnownName builtin = known_name(e->as.func_call.name);
+            if(builtin == NAME_PRINT) {
                 //...
                for (int i = 0; i < e->as.func_call.count; ++i) {
                     TokenType argType = analyze_expr(scope, funcTable, e->as.func_call.params[i], currentFunc);
@@ -358,7 +468,7 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
             }
 
             //handle length() built-in
-            if (strcmp(e->as.func_call.name, "length") == 0) {
+            if (builtin == NAME_LENGTH) {
                 if (e->as.func_call.count != 1) {
                     stage_error(STAGE_ANALYZER, e->loc, "length() takes exactly 1 argument");
                 }
@@ -394,13 +504,7 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
             }
 
             //handle std.io read_* functions
-            if (strcmp(e->as.func_call.name, "read_int") == 0 ||
-                strcmp(e->as.func_call.name, "read_str") == 0 ||
-                strcmp(e->as.func_call.name, "read_bool") == 0 ||
-                strcmp(e->as.func_call.name, "read_char") == 0 ||
-                strcmp(e->as.func_call.name, "read_float") == 0 ||
-                strcmp(e->as.func_call.name, "read_double") == 0 ||
-                strcmp(e->as.func_call.name, "read_key") == 0) {
+            if (builtin >= NAME_READ_INT && builtin <= NAME_READ_KEY) {
 
                 //check if function is imported
                 if (!is_imported(g_import_registry, e->as.func_call.name)) {
@@ -416,19 +520,14 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                 }
 
                 //determine return type based on function name
-                if (strcmp(e->as.func_call.name, "read_int") == 0) {
-                    result = INT_KEYWORD_T;
-                } else if (strcmp(e->as.func_call.name, "read_str") == 0) {
-                    result = STR_KEYWORD_T;
-                } else if (strcmp(e->as.func_call.name, "read_bool") == 0) {
-                    result = BOOL_KEYWORD_T;
-                } else if (strcmp(e->as.func_call.name, "read_char") == 0 ||
-                           strcmp(e->as.func_call.name, "read_key") == 0) {
-                    result = CHAR_KEYWORD_T;
-                } else if (strcmp(e->as.func_call.name, "read_float") == 0) {
-                    result = FLOAT_KEYWORD_T;
-                } else if (strcmp(e->as.func_call.name, "read_double") == 0) {
-                    result = DOUBLE_KEYWORD_T;
+                switch (builtin) {
+                    case NAME_READ_INT: result = INT_KEYWORD_T; break;
+                    case NAME_READ_STR: result = STR_KEYWORD_T; break;
+                    case NAME_READ_BOOL: result = BOOL_KEYWORD_T; break;
+                    case NAME_READ_CHAR:
+                    case NAME_READ_KEY: result = CHAR_KEYWORD_T; break;
+                    case NAME_READ_FLOAT: result = FLOAT_KEYWORD_T; break;
+                    default: result = DOUBLE_KEYWORD_T; break;
                 }
 
                 //mark this expression as nullable
@@ -436,31 +535,32 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                 
                 //create a dummy signature to handle ownership
                 //we need this so that assigning to 'own' variables works
-                FuncSign* sig = malloc(sizeof(FuncSign));
-                sig->name = strdup(e->as.func_call.name);
+                FuncSign* sig = arena_alloc(scope->keep, sizeof(FuncSign));
+                sig->name = e->as.func_call.name;
                 sig->retType = result;
                 sig->retOwnership = OWNERSHIP_OWN; //all read_* functions return owned pointers
                 sig->paramNum = 0;
                 sig->parameters = NULL;
+                sig->isExtern = false;
                 
                 e->as.func_call.resolved_sign = sig;
                 break;
             }
 
             //analyze all arguments first
-            TokenType* argTypes = malloc(sizeof(TokenType) * e->as.func_call.count);
+            TokenType* argTypes = arena_alloc(scope->arena, sizeof(TokenType) * e->as.func_call.count);
             for (int i = 0; i < e->as.func_call.count; ++i) {
                 argTypes[i] = analyze_expr(scope, funcTable, e->as.func_call.params[i], currentFunc);
             }
 
             //find ALL matching overloads by name and arity
-            FuncSign** matches = malloc(sizeof(FuncSign*) * funcTable->count);
+            FuncBucket* overloads = func_table_overloads(funcTable, e->as.func_call.name);
+            FuncSign** matches = arena_alloc(scope->arena, sizeof(FuncSign*) * (overloads ? overloads->count : 1));
             int matchCount = 0;
 
-            for (int i = 0; i < funcTable->count; i++) {
-                FuncSign* candidate = &funcTable->signs[i];
-                if (strcmp(candidate->name, e->as.func_call.name) == 0 &&
-                    candidate->paramNum == e->as.func_call.count) {
+            for (int i = 0; overloads && i < overloads->count; i++) {
+                FuncSign* candidate = overloads->signs[i];
+                if (candidate->paramNum == e->as.func_call.count) {
                     matches[matchCount++] = candidate;
                 }
             }
@@ -469,8 +569,6 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                 stage_error(STAGE_ANALYZER, e->loc,
                             "no function '%s' takes %d arguments",
                             e->as.func_call.name, e->as.func_call.count);
-                free(argTypes);
-                free(matches);
                 e->as.func_call.resolved_sign = NULL;
                 result = VOID_KEYWORD_T;
                 break;
@@ -522,8 +620,6 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                     stage_note(STAGE_ANALYZER, e->loc, "%s", cand_buffer);
                 }
 
-                free(argTypes);
-                free(matches);
                 e->as.func_call.resolved_sign = NULL;
                 result = VOID_KEYWORD_T;
                 break;
@@ -557,8 +653,6 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
             }
 
             result = match->retType;
-            free(argTypes);
-            free(matches);
             break;
         }
 
@@ -639,6 +733,9 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                 matchedSym = lookup(scope, e->as.match.var->as.var.name);
                 if (matchedSym) {
                     targetType = matchedSym->type;
+                    //codegen picks how to branch on the value by its type
+                    e->as.match.var->analyzedType = targetType;
+                    e->as.match.var->is_nullable = matchedSym->is_nullable;
                 } else {
                     stage_error(STAGE_ANALYZER, e->loc, "variable '%s' is not declared",
                                 e->as.match.var->as.var.name);
@@ -701,7 +798,7 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                     if (bindingOwnership == OWNERSHIP_REF) {
                         Symbol* bindingSym = lookup(branchScope, branch->pattern->as.binding_name);
                         if (bindingSym) {
-                            bindingSym->owner = matchedSym->name;
+                            set_borrow(bindingSym, matchedSym->name, matchedSym);
                         }
                     }
 
@@ -716,11 +813,7 @@ TokenType analyze_expr(Scope* scope, FuncTable* funcTable, Expr* e, FuncSign* cu
                 }
 
                 TokenType bodyType = analyze_expr(branchScope, funcTable, branch->caseRet, currentFunc);
-
-                //clean up temporary scope
-                if (branchScope != scope) {
-                    free(branchScope);
-                }
+                if (branchScope != scope) pop_scope(branchScope);
 
                 if (i == 0) {
                     resultType = bodyType;
@@ -915,7 +1008,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                 if (s->as.var_decl.expr->type == VAR_E) {
                     Symbol* refSym = lookup(scope, s->as.var_decl.name);
                     if (refSym && s->as.var_decl.expr->as.var.ownership == OWNERSHIP_OWN) {
-                        refSym->owner = s->as.var_decl.expr->as.var.name;
+                        set_borrow(refSym, s->as.var_decl.expr->as.var.name, lookup(scope, s->as.var_decl.expr->as.var.name));
                         refSym->is_const = s->as.var_decl.expr->as.var.isConst;
                     } else if (refSym) {
                         stage_error(STAGE_ANALYZER, s->loc, "ref variable '%s' can only borrow from 'own' variables", s->as.var_decl.name);
@@ -979,7 +1072,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                     if(s->as.var_assign.expr->as.var.ownership != OWNERSHIP_OWN)
                         stage_error(STAGE_ANALYZER, s->loc, "assigning non-own variable to '%s' not allowed!", s->as.var_assign.name);
 
-                    sym->owner = s->as.var_assign.expr->as.var.name;
+                    set_borrow(sym, s->as.var_assign.expr->as.var.name, lookup(scope, s->as.var_assign.expr->as.var.name));
                 }
             }
             break;
@@ -1006,12 +1099,12 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                 }
             }
             analyze_stmt(tScope, funcTable, s->as.if_stmt.trueStmt, currentFunc);
-            free(tScope);
+            pop_scope(tScope);
 
             if (s->as.if_stmt.falseStmt != nullptr) {
                 Scope* fScope = make_scope(scope);
                 analyze_stmt(fScope, funcTable, s->as.if_stmt.falseStmt, currentFunc);
-                free(fScope);
+                pop_scope(fScope);
             }
             break;
         }
@@ -1022,14 +1115,14 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                 stage_error(STAGE_ANALYZER, s->loc, "while condition must be bool, got %s", token_type_name(c));
             Scope* body = make_scope(scope);
             analyze_stmt(body, funcTable, s->as.while_stmt.body, currentFunc);
-            free(body);
+            pop_scope(body);
             break;
         }
 
         case DO_WHILE_S: {
             Scope* body = make_scope(scope);
             analyze_stmt(body, funcTable, s->as.do_while_stmt.body, currentFunc);
-            free(body);
+            pop_scope(body);
             TokenType c = analyze_expr(scope, funcTable, s->as.do_while_stmt.cond, currentFunc);
             if (c != BOOL_KEYWORD_T)
                 stage_error(STAGE_ANALYZER, s->loc, "do-while condition must be bool, got %s", token_type_name(c));
@@ -1044,7 +1137,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
             if (analyze_expr(body, funcTable, s->as.for_stmt.max, currentFunc) != INT_KEYWORD_T)
                 stage_error(STAGE_ANALYZER, s->loc, "for loop max must be int");
             analyze_stmt(body, funcTable, s->as.for_stmt.body, currentFunc);
-            free(body);
+            pop_scope(body);
             break;
         }
 
@@ -1054,7 +1147,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                 analyze_stmt(block, funcTable, s->as.block_stmt.stmts[i], currentFunc);
             }
             check_function_cleanup(block);
-            free(block);
+            pop_scope(block);
             break;
         }
 
@@ -1072,6 +1165,8 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                 matchedSym = lookup(scope, s->as.match_stmt.var->as.var.name);
                 if (matchedSym) {
                     matchedType = matchedSym->type;
+                    s->as.match_stmt.var->analyzedType = matchedType;
+                    s->as.match_stmt.var->is_nullable = matchedSym->is_nullable;
                 } else {
                     stage_error(STAGE_ANALYZER, s->loc, "variable '%s' is not declared",
                                 s->as.match_stmt.var->as.var.name);
@@ -1135,7 +1230,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
                     if (bindingOwnership == OWNERSHIP_REF) {
                         Symbol* bindingSym = lookup(branchScope, branch->pattern->as.binding_name);
                         if (bindingSym) {
-                            bindingSym->owner = matchedSym->name;
+                            set_borrow(bindingSym, matchedSym->name, matchedSym);
                         }
                     }
 
@@ -1161,7 +1256,7 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
 
                 //check ownership cleanup within branch
                 check_function_cleanup(branchScope);
-                free(branchScope);
+                pop_scope(branchScope);
             }
 
             break;
@@ -1237,21 +1332,22 @@ void analyze_stmt(Scope* scope, FuncTable* funcTable, Stmt* s, FuncSign* current
 
             //mark as freed
             sym->state = FREED;
-            mark_dangling_refs(scope, sym->name);
+            mark_dangling_refs(sym);
             break;
         }
     }
 }
 
 void defineAndAnalyzeFunc(FuncTable* table, Func* func) {
-    if(strcmp("print", func->signature->name) == 0) {
-        stage_error(STAGE_ANALYZER, NO_LOC, "'print' is a reserved built-in function and cannot be redefined");
-    } else if(strcmp("read_int", func->signature->name) == 0) {
-        stage_error(STAGE_ANALYZER, NO_LOC, "'print' is a reserved built-in function and cannot be redefined");
-    } else if(strcmp("read_str", func->signature->name) == 0) {
-        stage_error(STAGE_ANALYZER, NO_LOC, "'print' is a reserved built-in function and cannot be redefined");
-    } else if(strcmp("read_bool", func->signature->name) == 0) {
-        stage_error(STAGE_ANALYZER, NO_LOC, "'print' is a reserved built-in function and cannot be redefined");
+    switch (known_name(func->signature->name)) {
+        case NAME_PRINT:
+        case NAME_READ_INT:
+        case NAME_READ_STR:
+        case NAME_READ_BOOL:
+            stage_error(STAGE_ANALYZER, NO_LOC, "'print' is a reserved built-in function and cannot be redefined");
+            break;
+        default:
+            break;
     }
 
     if(lookup_func_sign(table, func->signature)) {
@@ -1259,74 +1355,19 @@ void defineAndAnalyzeFunc(FuncTable* table, Func* func) {
     }
 
     //check main
-    if(strcmp("main", func->signature->name) == 0) {
+    if(is_known_name(func->signature->name, NAME_MAIN)) {
         if(func->signature->retType != INT_KEYWORD_T) stage_error(STAGE_ANALYZER, NO_LOC, "Main function needs to have return type of int!");
         if(func->signature->paramNum > 0) stage_error(STAGE_ANALYZER, NO_LOC, "Main function does not take any parameters!");
     }
 
-    //add to table - need deep copy of FuncSign
-    stage_trace(STAGE_ANALYZER, "defineAndAnalyzeFunc: copying func '%s'", func->signature->name);
-    stage_trace(STAGE_ANALYZER, "  func->signature=%p, name=%p ('%s')",
-                func->signature, func->signature->name, func->signature->name);
-
-    FuncSign copy;
-    copy.name = strdup(func->signature->name);  //make a real copy of the name string
-    copy.retType = func->signature->retType;
-    copy.retOwnership = func->signature->retOwnership;
-    copy.paramNum = func->signature->paramNum;
-
-    //deep copy parameters array
-    if (copy.paramNum > 0) {
-        copy.parameters = malloc(sizeof(FuncParam) * copy.paramNum);
-        for (int i = 0; i < copy.paramNum; i++) {
-            copy.parameters[i] = func->signature->parameters[i];
-            //param names also come from tokens, stay alive
-        }
-    } else {
-        copy.parameters = NULL;
-    }
-
-    if(table->count >= table->capacity) {
-        stage_error(STAGE_ANALYZER, NO_LOC, "INTERNAL ERROR: FuncTable capacity exceeded");
-        return;
-    }
-
-    stage_trace(STAGE_ANALYZER, "  storing at table->signs[%d], table=%p, signs=%p",
-                table->count, table, table->signs);
-    stage_trace(STAGE_ANALYZER, "  address of table->signs[%d] = %p",
-                table->count, &table->signs[table->count]);
-    table->signs[table->count] = copy;
-    stage_trace(STAGE_ANALYZER, "  stored, table->signs[%d].name=%p ('%s')",
-                table->count, table->signs[table->count].name, table->signs[table->count].name);
-    table->count++;
-}
-
-FuncSign* lookup_func_sign(FuncTable* t, FuncSign* s) {
-    for (int i = 0; i < t->count; ++i) {
-        if(check_func_sign(&t->signs[i], s))
-            return &t->signs[i];
-    }
-    return nullptr;
-}
-FuncSign* lookup_func_name(FuncTable* t, char* n) {
-    for (int i = 0; i < t->count; ++i) {
-        if(strcmp(t->signs[i].name, n) == 0)
-            return &t->signs[i];
-    }
-    return nullptr;
-}
-
-FuncTable* make_funcTable() {
-    FuncTable* f = malloc(sizeof(FuncTable));
-    f->signs = malloc(sizeof(FuncSign) * 2);
-    f->capacity = 2;
-    f->count = 0;
-    return f;
+    //the table keeps the AST signature itself, so resolved_sign and the definition share one c_name
+    stage_trace(STAGE_ANALYZER, "defineAndAnalyzeFunc: adding func '%s'", func->signature->name);
+    func_table_add(table, func->signature);
 }
 
 void check_function_cleanup(Scope* scope) {
     for (int i = 0; i < scope->count; i++) {
-        Symbol* s = &scope->symbols[i];
+        Symbol* s = scope->symbols[i];
         if (s->ownership == OWNERSHIP_OWN) {
             if (s->state == ALIVE) {
                 //this is a leak!
@@ -1337,8 +1378,56 @@ void check_function_cleanup(Scope* scope) {
     }
 }
 
+//everything one thread needs to analyze bodies without touching another threads state
+typedef struct {
+    Arena scratch;          //function scopes and their symbols, reset after each function
+    Arena keep;             //what codegen reads later, handed over to g_arena at the end
+    ErrorCollector* errors;
+    Scope* global;
+} AnalyzeWorker;
+
+//where the messages of one function ended up
+typedef struct {
+    int worker;
+    int start;
+    int end;
+} MessageSpan;
+
+typedef struct {
+    Func** funcs;
+    FuncTable* funcTable;
+    AnalyzeWorker* workers;
+    MessageSpan* spans;
+} AnalyzeJob;
+
+static void analyze_body(Scope* global, FuncTable* funcTable, Func* f) {
+    Scope* funcScope = make_scope(global);
+
+    for (int j = 0; j < f->signature->paramNum; ++j) {
+        declare(funcScope, f->signature->parameters[j].name, f->signature->parameters[j].type, f->signature->parameters[j].ownership, f->signature->parameters[j].isNullable, f->signature->parameters[j].isConst, false, 0);
+    }
+
+    analyze_stmt(funcScope, funcTable, f->body, f->signature);
+
+    check_function_cleanup(funcScope);
+    pop_scope(funcScope);
+
+    //nothing from the scopes outlives the function, drop them all at once
+    arena_reset(global->arena);
+}
+
+static void analyze_task(void* ctx, int worker, int index) {
+    AnalyzeJob* job = ctx;
+    AnalyzeWorker* w = &job->workers[worker];
+
+    //stage_error goes through the thread local collector
+    g_error_collector = w->errors;
+    int start = w->errors->count;
+    analyze_body(w->global, job->funcTable, job->funcs[index]);
+    job->spans[index] = (MessageSpan){worker, start, w->errors->count};
+}
+
 void analyze_program(Program* prog) {
-    Scope* global = make_scope(nullptr);
     FuncTable* funcTable = make_funcTable();
 
     //initialize and process imports
@@ -1356,48 +1445,69 @@ void analyze_program(Program* prog) {
             if(lookup_func_sign(funcTable, sign)) {
                 stage_error(STAGE_ANALYZER, NO_LOC, "Extern function '%s' already defined", sign->name);
             }
-            if(funcTable->count >= funcTable->capacity) {
-                funcTable->capacity *= 2;
-                funcTable->signs = realloc(funcTable->signs, sizeof(FuncSign) * funcTable->capacity);
-            }
-            funcTable->signs[funcTable->count++] = *sign; //shallow copy struct
+            func_table_add(funcTable, sign);
         }
     }
 
     Func** fs = prog->functions;
     int count = prog->func_count;
 
-    //pre-allocate enough space for all functions to avoid realloc invalidating pointers
-    //pre-allocate enough space for all functions to avoid realloc invalidating pointers
-    int total_needed = funcTable->count + count;
-    if (total_needed > funcTable->capacity) {
-        funcTable->capacity = total_needed + 4; //add some buffer
-        funcTable->signs = realloc(funcTable->signs, sizeof(FuncSign) * funcTable->capacity);
-    }
-
     for (int i = 0; i < count; ++i) {
         defineAndAnalyzeFunc(funcTable, fs[i]);
     }
-    for (int i = 0; i < count; ++i) {
-        Scope* funcScope = make_scope(global);
 
-        for (int j = 0; j < fs[i]->signature->paramNum; ++j) {
-            declare(funcScope, fs[i]->signature->parameters[j].name, fs[i]->signature->parameters[j].type, fs[i]->signature->parameters[j].ownership, fs[i]->signature->parameters[j].isNullable, fs[i]->signature->parameters[j].isConst, false, 0);
+    //from here the function table and imports are only read, so bodies can go in parallel.
+    //trace output would interleave, keep it on one thread
+    int jobs = g_jobs;
+    if (jobs > count) jobs = count;
+    if (jobs < 1 || trace_on(STAGE_ANALYZER)) jobs = 1;
+
+    if (jobs == 1) {
+        //function scopes and their symbols go into a scratch arena, reset after each function
+        Arena scratch;
+        arena_init(&scratch, 0);
+        arena_set_stage(&scratch, STAGE_ANALYZER);
+        Scope* global = make_root_scope(&scratch, &g_arena);
+
+        for (int i = 0; i < count; ++i) {
+            analyze_body(global, funcTable, fs[i]);
         }
 
-        analyze_stmt(funcScope, funcTable, fs[i]->body, fs[i]->signature);
+        arena_merge_stats(&g_arena, &scratch);
+        arena_release(&scratch);
+    } else {
+        ErrorCollector* collector = g_error_collector;
+        AnalyzeWorker* workers = calloc(jobs, sizeof(AnalyzeWorker));
+        MessageSpan* spans = calloc(count, sizeof(MessageSpan));
+
+        for (int w = 0; w < jobs; w++) {
+            arena_init(&workers[w].scratch, 0);
+            arena_set_stage(&workers[w].scratch, STAGE_ANALYZER);
+            arena_init(&workers[w].keep, 0);
+            arena_set_stage(&workers[w].keep, STAGE_ANALYZER);
+            workers[w].errors = init_error_collector();
+            workers[w].global = make_root_scope(&workers[w].scratch, &workers[w].keep);
+        }
 
-        check_function_cleanup(funcScope);
+        AnalyzeJob job = {fs, funcTable, workers, spans};
+        pool_run(jobs, count, analyze_task, &job);
+        g_error_collector = collector;
 
-        free(funcScope->symbols);
-        free(funcScope);
-    }
+        //replay in source order, so the output does not depend on which thread got which function
+        for (int i = 0; i < count; ++i) {
+            error_collector_take(collector, workers[spans[i].worker].errors, spans[i].start, spans[i].end);
+        }
 
-    //dONT free funcTable yet - codegen needs the resolved_sign pointers!
-    //tODO: Free after codegen or store FuncTable in Program
-    //free(funcTable->signs);
-    //free(funcTable);
+        for (int w = 0; w < jobs; w++) {
+            arena_merge_stats(&g_arena, &workers[w].scratch);
+            arena_release(&workers[w].scratch);
+            arena_adopt(&g_arena, &workers[w].keep);
+            free_error_collector(workers[w].errors);
+        }
+        free(workers);
+        free(spans);
+    }
 
-    free(global->symbols);
-    free(global);
+    //funcTable stays in g_arena, codegen names functions through it
+    prog->func_table = funcTable;
 }
\ No newline at end of file
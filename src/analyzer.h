@@ -5,6 +5,7 @@
 
 #include "common.h"
 #include "parser.h"
+#include "func_table.h"
 
 typedef enum {
     ALIVE,   //can be used
@@ -12,7 +13,10 @@ typedef enum {
     FREED,   //has been freed, cannot be used
 } VarState;
 
-typedef struct {
+typedef struct Scope Scope;
+typedef struct Symbol Symbol;
+
+struct Symbol {
     TokenType type;
     char* name;
     Ownership ownership;
@@ -25,22 +29,38 @@ typedef struct {
     bool is_unwrapped;
     bool is_array;
     int array_size;
-} Symbol;
 
-typedef struct Scope Scope;
+    Scope* scope;           //declaring scope
+    Symbol* shadowed;       //next visible declaration with the same name
+    bool visible;           //false for redeclarations and once the scope is popped
+    Symbol* borrowers;      //refs currently borrowing from this symbol
+    Symbol* next_borrower;
+    Symbol* borrowed_from;
+};
+
+//one hash table per scope chain, maps an interned name to its innermost visible declaration
+typedef struct {
+    const char* name;
+    uint32_t hash;
+    Symbol* head;
+} SymbolSlot;
+
+typedef struct {
+    SymbolSlot* slots;
+    int capacity;   //power of two
+    int used;
+    Arena* arena;   //where the slots grow into
+} SymbolTable;
+
 struct Scope {
-    Symbol* symbols;
+    Symbol** symbols;   //declarations of this scope in order
     int count;
     int capacity;
 
     Scope* parent;
-};
-
-typedef struct FuncTable FuncTable;
-struct FuncTable {
-    FuncSign* signs;
-    int count;
-    int capacity;
+    Arena* arena;       //inherited from the parent, function bodies use a scratch arena
+    Arena* keep;        //inherited too, for what codegen still reads after the function (g_arena or a workers own)
+    SymbolTable* table; //shared with the whole chain
 };
 
 typedef struct {
@@ -55,17 +75,16 @@ void register_import(ImportRegistry* reg, IncludeStmt* stmt);
 bool is_imported(ImportRegistry* reg, const char* func_name);
 
 void defineAndAnalyzeFunc(FuncTable* table, Func* func);
-FuncSign* lookup_func_sign(FuncTable *t, FuncSign *s);
-FuncSign* lookup_func_name(FuncTable *t, char *s);
 
 Scope* make_scope(Scope* parent);
-FuncTable* make_funcTable();
+void pop_scope(Scope* scope); //hides the scopes declarations again, call when leaving it
 
 void declare(Scope*, char* name, TokenType type, Ownership ownership, bool isNullable, bool isConst, bool isArray, int arraySize);
 Symbol* lookup(Scope*, char* name);
 
 TokenType analyze_expr(Scope*, FuncTable*, Expr*, FuncSign* currentFunc);
 void analyze_stmt(Scope*, FuncTable*, Stmt*, FuncSign* currentFunc);
+//analyzes function bodies on g_jobs threads, messages come out in the same order as with one
 void analyze_program(Program*);
 
 #endif //lYNC_ANALYZER_H
\ No newline at end of file
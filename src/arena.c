@@ -0,0 +1,205 @@
+//created by bucka on 10/16/2026.
+
+#include "arena.h"
+#include <stddef.h>
+
+#define ARENA_ALIGN 16
+#define ALIGN_UP(n) (((n) + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1))
+
+Arena g_arena = {.block_size = ARENA_BLOCK_SIZE, .stage = STAGE_INTERNAL};
+
+void arena_init(Arena* a, size_t block_size) {
+    memset(a, 0, sizeof(Arena));
+    a->block_size = block_size ? block_size : ARENA_BLOCK_SIZE;
+    a->stage = STAGE_INTERNAL;
+}
+
+void arena_set_stage(Arena* a, ErrorStage stage) {
+    a->stage = stage;
+}
+
+static void link_block(Arena* a, ArenaBlock* b) {
+    b->prev = nullptr;
+    b->next = a->blocks;
+    if (a->blocks) a->blocks->prev = b;
+    a->blocks = b;
+
+    a->reserved += sizeof(ArenaBlock) + b->capacity;
+    if (a->reserved > a->peak_reserved) a->peak_reserved = a->reserved;
+}
+
+static void unlink_block(Arena* a, ArenaBlock* b) {
+    if (b->prev) b->prev->next = b->next;
+    else a->blocks = b->next;
+    if (b->next) b->next->prev = b->prev;
+    a->reserved -= sizeof(ArenaBlock) + b->capacity;
+}
+
+static ArenaBlock* new_block(Arena* a, size_t capacity, bool dedicated) {
+    //calloc so fresh allocations come out zeroed without a memset each
+    ArenaBlock* b = calloc(1, sizeof(ArenaBlock) + capacity);
+    if (!b) {
+        fprintf(stderr, "out of memory (arena block of %zu bytes)\n", capacity);
+        exit(1);
+    }
+    b->capacity = capacity;
+    b->dedicated = dedicated;
+    link_block(a, b);
+    return b;
+}
+
+void* arena_alloc(Arena* a, size_t size) {
+    if (size == 0) size = 1;
+    size_t aligned = ALIGN_UP(size);
+
+    a->stats[a->stage].bytes += size;
+    a->stats[a->stage].allocs++;
+
+    //big requests get their own block so they dont waste the rest of a bump block
+    if (aligned > a->block_size / 4) {
+        ArenaBlock* b = new_block(a, aligned, true);
+        b->used = aligned;
+        return b->data;
+    }
+
+    ArenaBlock* b = a->current;
+    if (!b || b->used + aligned > b->capacity) {
+        b = new_block(a, a->block_size, false);
+        a->current = b;
+    }
+
+    void* p = b->data + b->used;
+    b->used += aligned;
+    return p;
+}
+
+void* arena_realloc(Arena* a, void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return arena_alloc(a, new_size);
+    if (new_size <= old_size) return ptr;
+
+    size_t old_aligned = ALIGN_UP(old_size ? old_size : 1);
+    size_t new_aligned = ALIGN_UP(new_size);
+
+    //large allocations sit at the start of a dedicated block, grow the block itself
+    if (old_aligned > a->block_size / 4) {
+        ArenaBlock* b = (ArenaBlock*)((char*)ptr - offsetof(ArenaBlock, data));
+        if (b->dedicated && b->data == ptr) {
+            ArenaBlock* prev = b->prev;
+            ArenaBlock* next = b->next;
+            unlink_block(a, b);
+            ArenaBlock* grown = realloc(b, sizeof(ArenaBlock) + new_aligned);
+            if (!grown) {
+                fprintf(stderr, "out of memory (arena block of %zu bytes)\n", new_aligned);
+                exit(1);
+            }
+            memset(grown->data + old_aligned, 0, new_aligned - old_aligned);
+            grown->capacity = new_aligned;
+            grown->used = new_aligned;
+
+            //relink in the same position
+            grown->prev = prev;
+            grown->next = next;
+            if (prev) prev->next = grown;
+            else a->blocks = grown;
+            if (next) next->prev = grown;
+            a->reserved += sizeof(ArenaBlock) + grown->capacity;
+            if (a->reserved > a->peak_reserved) a->peak_reserved = a->reserved;
+
+            a->stats[a->stage].bytes += new_size - old_size;
+            return grown->data;
+        }
+    }
+
+    //the newest allocation of the bump block can grow in place
+    ArenaBlock* cur = a->current;
+    if (cur && new_aligned <= a->block_size / 4 &&
+        (char*)ptr + old_aligned == cur->data + cur->used &&
+        cur->used - old_aligned + new_aligned <= cur->capacity) {
+        cur->used += new_aligned - old_aligned;
+        a->stats[a->stage].bytes += new_size - old_size;
+        return ptr;
+    }
+
+    void* p = arena_alloc(a, new_size);
+    memcpy(p, ptr, old_size);
+    return p;
+}
+
+char* arena_strndup(Arena* a, const char* s, size_t len) {
+    char* copy = arena_alloc(a, len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+char* arena_strdup(Arena* a, const char* s) {
+    if (!s) return nullptr;
+    return arena_strndup(a, s, strlen(s));
+}
+
+void arena_reset(Arena* a) {
+    ArenaBlock* keep = a->current;
+    ArenaBlock* b = a->blocks;
+    while (b) {
+        ArenaBlock* next = b->next;
+        if (b != keep) {
+            unlink_block(a, b);
+            free(b);
+        }
+        b = next;
+    }
+    if (keep) {
+        memset(keep->data, 0, keep->used);
+        keep->used = 0;
+    }
+}
+
+void arena_release(Arena* a) {
+    ArenaBlock* b = a->blocks;
+    while (b) {
+        ArenaBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    a->blocks = nullptr;
+    a->current = nullptr;
+    a->reserved = 0;
+}
+
+void arena_merge_stats(Arena* a, const Arena* other) {
+    for (int i = 0; i < ARENA_STAGE_COUNT; i++) {
+        a->stats[i].bytes += other->stats[i].bytes;
+        a->stats[i].allocs += other->stats[i].allocs;
+    }
+}
+
+void arena_adopt(Arena* a, Arena* other) {
+    ArenaBlock* b = other->blocks;
+    while (b) {
+        ArenaBlock* next = b->next;
+        link_block(a, b);
+        b = next;
+    }
+    arena_merge_stats(a, other);
+
+    other->blocks = nullptr;
+    other->current = nullptr;
+    other->reserved = 0;
+    memset(other->stats, 0, sizeof(other->stats));
+}
+
+void arena_print_stats(const Arena* a, FILE* out) {
+    size_t total_bytes = 0, total_allocs = 0;
+
+    fprintf(out, "=== MEMORY (arena) ===\n");
+    fprintf(out, "  %-10s %14s %12s\n", "stage", "bytes", "allocs");
+    for (int i = 0; i < ARENA_STAGE_COUNT; i++) {
+        if (a->stats[i].allocs == 0) continue;
+        fprintf(out, "  %-10s %14zu %12zu\n", stage_name((ErrorStage)i), a->stats[i].bytes, a->stats[i].allocs);
+        total_bytes += a->stats[i].bytes;
+        total_allocs += a->stats[i].allocs;
+    }
+    fprintf(out, "  %-10s %14zu %12zu\n", "total", total_bytes, total_allocs);
+    fprintf(out, "  reserved %zu bytes (peak %zu)\n", a->reserved, a->peak_reserved);
+    fprintf(out, "======================\n");
+}
@@ -0,0 +1,60 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_ARENA_H
+#define LYNC_ARENA_H
+
+#include "common.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_STAGE_COUNT (STAGE_INTERNAL + 1)
+
+typedef struct ArenaBlock ArenaBlock;
+struct ArenaBlock {
+    ArenaBlock* prev;
+    ArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    bool dedicated;         //holds a single large allocation, can be resized with realloc
+    _Alignas(16) char data[];
+};
+
+typedef struct {
+    size_t bytes;           //bytes handed out while the stage was active
+    size_t allocs;
+} ArenaStageStats;
+
+//region allocator, everything the pipeline builds lives here and goes away in one arena_release()
+typedef struct {
+    ArenaBlock* blocks;     //every block, newest first
+    ArenaBlock* current;    //bump block for small allocations
+    size_t block_size;
+    ErrorStage stage;       //allocations are accounted to this stage
+    ArenaStageStats stats[ARENA_STAGE_COUNT];
+    size_t reserved;        //bytes of blocks currently held
+    size_t peak_reserved;
+} Arena;
+
+//the compilation arena, AST/tables/codegen data all come from here
+extern Arena g_arena;
+
+void arena_init(Arena* a, size_t block_size);
+void arena_set_stage(Arena* a, ErrorStage stage);
+
+void* arena_alloc(Arena* a, size_t size); //zeroed
+void* arena_realloc(Arena* a, void* ptr, size_t old_size, size_t new_size);
+char* arena_strdup(Arena* a, const char* s);
+char* arena_strndup(Arena* a, const char* s, size_t len);
+
+//drop all allocations but keep the first block around for reuse
+void arena_reset(Arena* a);
+void arena_release(Arena* a);
+
+//adds another arenas per stage counters (e.g. a scratch arena) into a
+void arena_merge_stats(Arena* a, const Arena* other);
+
+//moves every block of other into a, they are freed with a from then on, and merges the counters.
+//other is left empty. lets a worker thread fill its own arena and hand the result over when done
+void arena_adopt(Arena* a, Arena* other);
+void arena_print_stats(const Arena* a, FILE* out);
+
+#endif //LYNC_ARENA_H
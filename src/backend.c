@@ -0,0 +1,462 @@
+//created by bucka on 10/16/2026.
+
+//fork/exec/pipe/sigaction under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "backend.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define CC_CACHE_MAGIC "lync-cc 1"
+
+//#line so the compilers diagnostics name the .c file rather than <stdin>, line numbers stay the same.
+//names that would need escaping are left alone
+static void line_marker(char* buf, size_t size, const char* c_name) {
+    buf[0] = '\0';
+    if (strpbrk(c_name, "\"\\\n")) return;
+    snprintf(buf, size, "#line 1 \"%s\"\n", c_name);
+}
+
+static bool is_cl(const char* name) {
+    const char* base = name;
+    for (const char* p = name; *p; p++) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    return strcmp(base, "cl") == 0 || strcmp(base, "cl.exe") == 0;
+}
+
+#ifndef _WIN32
+
+//argv joined with spaces, only for trace output
+static void trace_command(char* const argv[]) {
+    if (!trace_on(STAGE_CODEGEN)) return;
+    char cmd[2048];
+    size_t len = 0;
+    cmd[0] = '\0';
+    for (int i = 0; argv[i] && len < sizeof(cmd); i++) {
+        len += snprintf(cmd + len, sizeof(cmd) - len, i ? " %s" : "%s", argv[i]);
+    }
+    stage_trace(STAGE_CODEGEN, "running: %s", cmd);
+}
+
+//writes the whole buffer, false if the reader went away early
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static int wait_child(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("waitpid");
+            return -1;
+        }
+    }
+
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return -1;
+}
+
+//runs argv directly (no shell) and waits for it. when input is set it is fed to the childs stdin,
+//quiet sends the childs stdout and stderr to /dev/null
+static int run_process(char* const argv[], const char* prefix, const OutBuf* input, bool quiet) {
+    trace_command(argv);
+
+    int fds[2] = {-1, -1};
+    if (input && pipe(fds) != 0) {
+        perror("pipe");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        if (input) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        return -1;
+    }
+
+    if (pid == 0) {
+        if (input) {
+            dup2(fds[0], STDIN_FILENO);
+            close(fds[0]);
+            close(fds[1]);
+        }
+        if (quiet) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd >= 0) {
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+                close(null_fd);
+            }
+        }
+        execvp(argv[0], argv);
+        if (!quiet) fprintf(stderr, "Error: could not run '%s': %s\n", argv[0], strerror(errno));
+        _exit(127);
+    }
+
+    if (input) {
+        close(fds[0]);
+
+        //a compiler that dies early must not take us down with SIGPIPE, its exit status tells the story
+        struct sigaction ignore = {0}, old;
+        ignore.sa_handler = SIG_IGN;
+        sigemptyset(&ignore.sa_mask);
+        sigaction(SIGPIPE, &ignore, &old);
+
+        if (!write_all(fds[1], prefix, strlen(prefix)) || !write_all(fds[1], input->data, input->len)) {
+            stage_trace(STAGE_CODEGEN, "pipe closed early: %s", strerror(errno));
+        }
+        close(fds[1]);
+        sigaction(SIGPIPE, &old, nullptr);
+    }
+
+    return wait_child(pid);
+}
+
+int backend_compile_file(const CCompiler* cc, const char* c_file, const char* exe_file) {
+    char* argv[] = {(char*)cc->path, (char*)c_file, "-o", (char*)exe_file, nullptr};
+    return run_process(argv, nullptr, nullptr, false);
+}
+
+int backend_compile_pipe(const CCompiler* cc, const OutBuf* code, const char* c_name, const char* exe_file) {
+    char* argv[] = {(char*)cc->path, "-x", "c", "-", "-o", (char*)exe_file, nullptr};
+    char prefix[1024];
+    line_marker(prefix, sizeof(prefix), c_name);
+    return run_process(argv, prefix, code, false);
+}
+
+//first line of `path --version`, false if it could not be run or did not exit cleanly
+static bool probe_version(const char* path, char* out, size_t size) {
+    char* argv[] = {(char*)path, "--version", nullptr};
+    trace_command(argv);
+    out[0] = '\0';
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+            close(null_fd);
+        }
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv(path, argv);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    size_t len = 0;
+    bool line_done = false;
+    char chunk[512];
+    ssize_t n;
+    //keep draining after the first line so the child never blocks on a full pipe
+    while ((n = read(fds[0], chunk, sizeof(chunk))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (ssize_t i = 0; i < n && !line_done; i++) {
+            if (chunk[i] == '\n' || chunk[i] == '\r' || len + 1 == size) line_done = true;
+            else out[len++] = chunk[i];
+        }
+    }
+    out[len] = '\0';
+    close(fds[0]);
+
+    return wait_child(pid) == 0;
+}
+
+//whether the compiler takes source on stdin, by compiling a one line program through a pipe
+static bool probe_pipe(const char* path) {
+    static const char probe[] = "int lync_probe;\n";
+    OutBuf input = {.data = (char*)probe, .len = sizeof(probe) - 1, .cap = sizeof(probe)};
+    char* argv[] = {(char*)path, "-x", "c", "-fsyntax-only", "-", nullptr};
+    return run_process(argv, "", &input, true) == 0;
+}
+
+//the binary a bare name runs, the same search execvp does
+static bool resolve_in_path(const char* name, char* out, size_t size) {
+    struct stat st;
+    if (strchr(name, '/')) {
+        snprintf(out, size, "%s", name);
+        return stat(out, &st) == 0 && S_ISREG(st.st_mode) && access(out, X_OK) == 0;
+    }
+
+    const char* dirs = getenv("PATH");
+    if (!dirs) dirs = "/usr/bin:/bin";
+    while (true) {
+        const char* end = strchr(dirs, ':');
+        int len = end ? (int)(end - dirs) : (int)strlen(dirs);
+        if (len == 0) snprintf(out, size, "./%s", name);
+        else snprintf(out, size, "%.*s/%s", len, dirs, name);
+
+        if (stat(out, &st) == 0 && S_ISREG(st.st_mode) && access(out, X_OK) == 0) return true;
+        if (!end) return false;
+        dirs = end + 1;
+    }
+}
+
+static int make_dir(const char* path) {
+    return mkdir(path, 0755);
+}
+
+#else
+
+//no fork on windows, keep going through the shell like before
+int backend_compile_file(const CCompiler* cc, const char* c_file, const char* exe_file) {
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd), "%s \"%s\" -o \"%s\"", cc->path, c_file, exe_file);
+    stage_trace(STAGE_CODEGEN, "running: %s", cmd);
+    return system(cmd);
+}
+
+int backend_compile_pipe(const CCompiler* cc, const OutBuf* code, const char* c_name, const char* exe_file) {
+    char prefix[1024];
+    line_marker(prefix, sizeof(prefix), c_name);
+    char cmd[2048];
+    snprintf(cmd, sizeof(cmd), "%s -x c - -o \"%s\"", cc->path, exe_file);
+    stage_trace(STAGE_CODEGEN, "running: %s", cmd);
+
+    FILE* p = _popen(cmd, "wb");
+    if (!p) return -1;
+    bool written = fputs(prefix, p) >= 0 && ob_write_to(code, p);
+    int result = _pclose(p);
+    if (!written && result == 0) return -1;
+    return result;
+}
+
+static bool probe_version(const char* path, char* out, size_t size) {
+    char cmd[1200];
+    snprintf(cmd, sizeof(cmd), "%s --version 2>nul", path);
+    stage_trace(STAGE_CODEGEN, "running: %s", cmd);
+    out[0] = '\0';
+
+    FILE* p = _popen(cmd, "r");
+    if (!p) return false;
+    if (fgets(out, (int)size, p)) out[strcspn(out, "\r\n")] = '\0';
+    char drain[512];
+    while (fgets(drain, sizeof(drain), p)) {}
+    return _pclose(p) == 0;
+}
+
+//every compiler except cl reads stdin, probing would need a temp file anyway
+static bool probe_pipe(const char* path) {
+    return !is_cl(path);
+}
+
+//cmd.exe does the lookup (and PATHEXT) when the command runs, keep the bare name
+static bool resolve_in_path(const char* name, char* out, size_t size) {
+    snprintf(out, size, "%s", name);
+    return true;
+}
+
+static int make_dir(const char* path) {
+    return _mkdir(path);
+}
+
+#endif
+
+//--- detection cache ---
+//one small text file per PATH, holding the last detected compiler. it is trusted as long as the
+//binary it names still has the same mtime, size and inode, a compiler upgrade invalidates it
+
+static uint64_t hash_path_env(void) {
+    const char* s = getenv("PATH");
+    uint64_t h = 1469598103934665603ull;
+    for (; s && *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+//$XDG_CACHE_HOME/lync or ~/.cache/lync (%LOCALAPPDATA%\lync on windows), false if there is no home to use
+static bool cache_dir(char* out, size_t size) {
+#ifdef _WIN32
+    const char* base = getenv("LOCALAPPDATA");
+    if (!base || !*base) return false;
+    snprintf(out, size, "%s\\lync", base);
+#else
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) snprintf(out, size, "%s/lync", xdg);
+    else if (home && *home) snprintf(out, size, "%s/.cache/lync", home);
+    else return false;
+#endif
+    return true;
+}
+
+static void compiler_stamp(const char* path, char* out, size_t size) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        snprintf(out, size, "none");
+        return;
+    }
+    snprintf(out, size, "%lld %lld %llu",
+             (long long)st.st_mtime, (long long)st.st_size, (unsigned long long)st.st_ino);
+}
+
+//false when the value does not fit, a cut off path would name some other compiler
+static bool cache_field(char* out, size_t size, const char* value) {
+    return (size_t)snprintf(out, size, "%s", value) < size;
+}
+
+static bool read_cache(const char* file, CCompiler* cc) {
+    FILE* f = fopen(file, "r");
+    if (!f) return false;
+
+    char line[1200];
+    char stamp[128] = "";
+    bool magic = false, pipe_known = false, fits = true;
+    memset(cc, 0, sizeof(*cc));
+    while (fits && fgets(line, sizeof(line), f)) {
+        //a line longer than the buffer comes back in pieces, the rest would be read as its own line
+        if (!strchr(line, '\n') && !feof(f)) fits = false;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strcmp(line, CC_CACHE_MAGIC) == 0) magic = true;
+        else if (strncmp(line, "name ", 5) == 0) fits = fits && cache_field(cc->name, sizeof(cc->name), line + 5);
+        else if (strncmp(line, "path ", 5) == 0) fits = fits && cache_field(cc->path, sizeof(cc->path), line + 5);
+        else if (strncmp(line, "stamp ", 6) == 0) fits = fits && cache_field(stamp, sizeof(stamp), line + 6);
+        else if (strncmp(line, "version ", 8) == 0) fits = fits && cache_field(cc->version, sizeof(cc->version), line + 8);
+        else if (strncmp(line, "pipe ", 5) == 0) {
+            cc->can_pipe = line[5] == '1';
+            pipe_known = true;
+        }
+    }
+    fclose(f);
+
+    if (!fits) {
+        stage_trace(STAGE_CODEGEN, "cached compiler entry in %s does not fit, probing again", file);
+        return false;
+    }
+    if (!magic || !pipe_known || !cc->name[0] || !cc->path[0]) return false;
+
+    char current[128];
+    compiler_stamp(cc->path, current, sizeof(current));
+    if (strcmp(current, stamp) != 0) {
+        stage_trace(STAGE_CODEGEN, "cached compiler %s changed, probing again", cc->path);
+        return false;
+    }
+    return true;
+}
+
+//written next to the target and renamed over it, parallel builds never see half a file
+static void write_cache(const char* dir, const char* file, const CCompiler* cc) {
+    char parent[1024];
+    snprintf(parent, sizeof(parent), "%s", dir);
+    char* sep = strrchr(parent, '/');
+    if (!sep) sep = strrchr(parent, '\\');
+    if (sep) {
+        *sep = '\0';
+        make_dir(parent);
+    }
+    make_dir(dir);
+
+    //the pid suffix is at most ".-2147483648.tmp"
+    size_t tmp_size = strlen(file) + 24;
+    char* tmp = malloc(tmp_size);
+    if (!tmp) return;
+    snprintf(tmp, tmp_size, "%s.%d.tmp", file, (int)getpid());
+    FILE* f = fopen(tmp, "w");
+    if (!f) {
+        free(tmp);
+        return;
+    }
+
+    char stamp[128];
+    compiler_stamp(cc->path, stamp, sizeof(stamp));
+    fprintf(f, "%s\nname %s\npath %s\nstamp %s\nversion %s\npipe %d\n",
+            CC_CACHE_MAGIC, cc->name, cc->path, stamp, cc->version, cc->can_pipe ? 1 : 0);
+    if (fclose(f) != 0) {
+        remove(tmp);
+        free(tmp);
+        return;
+    }
+#ifdef _WIN32
+    remove(file);
+#endif
+    if (rename(tmp, file) != 0) remove(tmp);
+    free(tmp);
+}
+
+static bool detect_compiler(CCompiler* cc) {
+    const char* compilers[] = {
+#ifdef _WIN32
+        "gcc", "clang", "cl",
+#else
+        "cc", "gcc", "clang",
+#endif
+    };
+    int count = sizeof(compilers) / sizeof(compilers[0]);
+
+    for (int i = 0; i < count; i++) {
+        memset(cc, 0, sizeof(*cc));
+        snprintf(cc->name, sizeof(cc->name), "%s", compilers[i]);
+        if (!resolve_in_path(compilers[i], cc->path, sizeof(cc->path))) continue;
+        if (!probe_version(cc->path, cc->version, sizeof(cc->version))) continue;
+        cc->can_pipe = probe_pipe(cc->path);
+        return true;
+    }
+    return false;
+}
+
+bool backend_find_compiler(CCompiler* cc, const char* override) {
+    if (override) {
+        memset(cc, 0, sizeof(*cc));
+        snprintf(cc->name, sizeof(cc->name), "%s", override);
+        snprintf(cc->path, sizeof(cc->path), "%s", override);
+        cc->can_pipe = !is_cl(override);
+        return true;
+    }
+
+    char dir[1024], file[1100];
+    bool cacheable = cache_dir(dir, sizeof(dir));
+    if (cacheable) {
+        snprintf(file, sizeof(file), "%s/cc-%016llx", dir, (unsigned long long)hash_path_env());
+        if (read_cache(file, cc)) {
+            stage_trace(STAGE_CODEGEN, "compiler from cache %s", file);
+            return true;
+        }
+    }
+
+    if (!detect_compiler(cc)) return false;
+    if (cacheable) write_cache(dir, file, cc);
+    return true;
+}
@@ -0,0 +1,31 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_BACKEND_H
+#define LYNC_BACKEND_H
+
+#include "common.h"
+#include "outbuf.h"
+
+//the host C compiler the generated code is handed to
+typedef struct {
+    char name[64];          //cc, gcc, clang, cl or whatever --cc= named
+    char path[1024];        //what actually gets run, resolved through PATH where possible
+    char version[256];      //first line of --version, empty when not probed
+    bool can_pipe;          //reads C source from stdin (-x c -), msvc cl cannot
+} CCompiler;
+
+//finds the C compiler. an override (--cc=) is taken as is without probing anything, otherwise the
+//last detection is reused from a small on-disk cache keyed by PATH and the compiler binarys mtime
+bool backend_find_compiler(CCompiler* cc, const char* override);
+
+//invoking the compiler on the generated code.
+//both return the compiler exit status, 0 on success and -1 if it could not be started
+
+//compile a .c file that is already on disk
+int backend_compile_file(const CCompiler* cc, const char* c_file, const char* exe_file);
+
+//stream the generated code into the compilers stdin (cc -x c -), nothing touches the disk.
+//c_name is what diagnostics call the code instead of <stdin>
+int backend_compile_pipe(const CCompiler* cc, const OutBuf* code, const char* c_name, const char* exe_file);
+
+#endif //LYNC_BACKEND_H
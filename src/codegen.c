@@ -1,6 +1,8 @@
 //created by bucka on 2/9/2026.
 
 #include "codegen.h"
+#include "thread_pool.h"
+#include "ir.h"
 #include <string.h>
 
 char* type_to_c_type(TokenType t) {
@@ -17,49 +19,52 @@ char* type_to_c_type(TokenType t) {
 }
 
 //emit indentation (2 spaces per level)
-void emit_indent(FILE* out, int level) {
-    for (int i = 0; i < level; i++) {
-        fprintf(out, "  ");
-    }
-}
-
-void emit_type(TokenType type, FILE* out) {
+void emit_type(TokenType type, OutBuf* out) {
     switch (type) {
-        case INT_KEYWORD_T: fprintf(out, "int"); break;
-        case BOOL_KEYWORD_T: fprintf(out, "bool"); break;
-        case STR_KEYWORD_T: fprintf(out, "char"); break;
-        case CHAR_KEYWORD_T: fprintf(out, "char"); break;
-        case FLOAT_KEYWORD_T: fprintf(out, "float"); break;
-        case DOUBLE_KEYWORD_T: fprintf(out, "double"); break;
-        case VOID_KEYWORD_T: fprintf(out, "void"); break;
-        default: fprintf(out, "void"); break;
+        case INT_KEYWORD_T: ob_lit(out, "int"); break;
+        case BOOL_KEYWORD_T: ob_lit(out, "bool"); break;
+        case STR_KEYWORD_T: ob_lit(out, "char"); break;
+        case CHAR_KEYWORD_T: ob_lit(out, "char"); break;
+        case FLOAT_KEYWORD_T: ob_lit(out, "float"); break;
+        case DOUBLE_KEYWORD_T: ob_lit(out, "double"); break;
+        case VOID_KEYWORD_T: ob_lit(out, "void"); break;
+        default: ob_lit(out, "void"); break;
     }
 }
 
-bool emit_pattern_condition(Pattern* pattern, Expr* matchVar, FILE* out, FuncSignToName* fstn) {
+bool emit_pattern_condition(Pattern* pattern, Expr* matchVar, OutBuf* out, FuncTable* funcs) {
     switch (pattern->type) {
         case NULL_PATTERN:
             //for nullable pointers, check the pointer itself, not dereferenced value
             if (matchVar->type == VAR_E) {
-                fprintf(out, "%s", matchVar->as.var.name);
+                ob_puts(out, matchVar->as.var.name);
             } else {
-                emit_expr(matchVar, out, fstn);
+                emit_expr(matchVar, out, funcs);
             }
-            fprintf(out, " == NULL");
+            ob_lit(out, " == NULL");
             return false;
         case SOME_PATTERN:
             //for nullable pointers, check the pointer itself, not dereferenced value
             if (matchVar->type == VAR_E) {
-                fprintf(out, "%s", matchVar->as.var.name);
+                ob_puts(out, matchVar->as.var.name);
             } else {
-                emit_expr(matchVar, out, fstn);
+                emit_expr(matchVar, out, funcs);
             }
-            fprintf(out, " != NULL");
+            ob_lit(out, " != NULL");
             return false;
         case VALUE_PATTERN:
-            emit_expr(matchVar, out, fstn);
-            fprintf(out, " == ");
-            emit_expr(pattern->as.value_expr, out, fstn);
+            //strings by their text, not their pointers
+            if (matchVar->analyzedType == STR_KEYWORD_T) {
+                ob_lit(out, "strcmp(");
+                emit_expr(matchVar, out, funcs);
+                ob_lit(out, ", ");
+                emit_expr(pattern->as.value_expr, out, funcs);
+                ob_lit(out, ") == 0");
+                return false;
+            }
+            emit_expr(matchVar, out, funcs);
+            ob_lit(out, " == ");
+            emit_expr(pattern->as.value_expr, out, funcs);
             return false;
         case WILDCARD_PATTERN:
             return true;
@@ -67,14 +72,287 @@ bool emit_pattern_condition(Pattern* pattern, Expr* matchVar, FILE* out, FuncSig
     return false;
 }
 
-char* get_mangled_name(FuncSign* sign) {
-    static char buffer[512];
-    char* ptr = buffer;
+//a match on an int or char with only literal arms (and maybe _) picks its arm by value instead of testing
+//the arms one by one: a switch when the values sit close enough for a jump table, otherwise a binary
+//search over the sorted values sets the arm number and a switch on that runs it. string literals are
+//told apart by length and first character, so at most one memcmp runs
+#define MATCH_SWITCH_MIN_ARMS 3    //fewer literal arms stay an if chain
+#define MATCH_SWITCH_DENSITY 3     //switch on the value while the values span at most this many slots per arm
+#define MATCH_SEARCH_LEAF 3        //a search leaf compares this many values one after another
+
+typedef struct {
+    int value;          //the length for a string
+    int arm;
+    Expr* label;
+    const char* text;   //string arms only
+} MatchCase;
+
+typedef struct {
+    MatchCase* cases;   //sorted by value, duplicates dropped so the first arm with a value keeps it
+    int count;
+    int* arm_case;      //per arm its index in cases, -1 for _ and arms a value before them already took
+    int wildcard;       //the _ arm, -1 without one
+    bool search;        //binary search into __match_arm instead of a switch on the value
+    bool strings;       //length and first character dispatch into __match_arm
+    int indent;         //of the case labels
+} MatchSwitch;
+
+static bool match_case_value(Expr* e, bool strings, int* value) {
+    if (strings) {
+        if (e->type != STR_LIT_E) return false;
+        *value = (int)strlen(e->as.str_val);
+        return true;
+    }
+    switch (e->type) {
+        case INT_LIT_E: *value = e->as.int_val; return true;
+        case CHAR_LIT_E: *value = e->as.char_val; return true;
+        case UN_OP_E:
+            if (e->as.un_op.op != MINUS_T || e->as.un_op.expr->type != INT_LIT_E) return false;
+            *value = (int)(0u - (unsigned)e->as.un_op.expr->as.int_val);
+            return true;
+        default: return false;
+    }
+}
 
-    stage_trace(STAGE_CODEGEN, "get_mangled_name entry: sign=%p", sign);
+static int match_case_cmp(const void* a, const void* b) {
+    const MatchCase* x = a;
+    const MatchCase* y = b;
+    if (x->value != y->value) return x->value < y->value ? -1 : 1;
+    if (x->text) {
+        int order = strcmp(x->text, y->text);
+        if (order != 0) return order;
+    }
+    return x->arm - y->arm;
+}
 
+//false leaves the match to the if chain
+static bool match_switch_plan(Expr* var, Pattern** patterns, int count, MatchSwitch* plan) {
+    if (var->is_nullable) return false;
+    bool strings = var->analyzedType == STR_KEYWORD_T;
+    if (!strings && var->analyzedType != INT_KEYWORD_T && var->analyzedType != CHAR_KEYWORD_T) return false;
+
+    int wildcard = -1;
+    int literals = 0;
+    for (int i = 0; i < count; i++) {
+        int value;
+        if (patterns[i]->type == WILDCARD_PATTERN) {
+            if (wildcard != -1) return false;
+            wildcard = i;
+        } else if (patterns[i]->type == VALUE_PATTERN && match_case_value(patterns[i]->as.value_expr, strings, &value)) {
+            literals++;
+        } else {
+            return false;
+        }
+    }
+    if (literals < MATCH_SWITCH_MIN_ARMS) return false;
+
+    plan->cases = malloc(sizeof(MatchCase) * literals);
+    plan->arm_case = malloc(sizeof(int) * count);
+    plan->count = 0;
+    plan->wildcard = wildcard;
+    for (int i = 0; i < count; i++) {
+        plan->arm_case[i] = -1;
+        if (i == wildcard) continue;
+        MatchCase* c = &plan->cases[plan->count++];
+        match_case_value(patterns[i]->as.value_expr, strings, &c->value);
+        c->arm = i;
+        c->label = patterns[i]->as.value_expr;
+        c->text = strings ? c->label->as.str_val : nullptr;
+    }
+    qsort(plan->cases, plan->count, sizeof(MatchCase), match_case_cmp);
+
+    int kept = 0;
+    for (int i = 0; i < plan->count; i++) {
+        MatchCase* last = kept > 0 ? &plan->cases[kept - 1] : nullptr;
+        if (last && last->value == plan->cases[i].value && (!strings || strcmp(last->text, plan->cases[i].text) == 0)) continue;
+        plan->cases[kept] = plan->cases[i];
+        plan->arm_case[plan->cases[kept].arm] = kept;
+        kept++;
+    }
+    plan->count = kept;
+
+    plan->strings = strings;
+    if (strings) {
+        plan->search = true;
+        return true;
+    }
+    long long span = (long long)plan->cases[kept - 1].value - plan->cases[0].value + 1;
+    plan->search = span > (long long)MATCH_SWITCH_DENSITY * kept;
+    return true;
+}
+
+static void emit_match_search(MatchSwitch* plan, int lo, int hi, OutBuf* out, int indent, FuncTable* funcs) {
+    if (hi - lo <= MATCH_SEARCH_LEAF) {
+        for (int i = lo; i < hi; i++) {
+            ob_indent(out, indent);
+            if (i > lo) ob_lit(out, "else ");
+            ob_lit(out, "if (__match_value == ");
+            emit_expr(plan->cases[i].label, out, funcs);
+            ob_lit(out, ") __match_arm = ");
+            ob_int(out, plan->cases[i].arm);
+            ob_lit(out, ";\n");
+        }
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    ob_indent(out, indent);
+    ob_lit(out, "if (__match_value < ");
+    emit_expr(plan->cases[mid].label, out, funcs);
+    ob_lit(out, ") {\n");
+    emit_match_search(plan, lo, mid, out, indent + 1, funcs);
+    ob_indent(out, indent);
+    ob_lit(out, "} else {\n");
+    emit_match_search(plan, mid, hi, out, indent + 1, funcs);
+    ob_indent(out, indent);
+    ob_lit(out, "}\n");
+}
+
+//the strings in cases [lo, hi) agree on their first skip characters
+static void emit_match_string_tests(MatchSwitch* plan, int lo, int hi, int skip, OutBuf* out, int indent) {
+    for (int i = lo; i < hi; i++) {
+        MatchCase* c = &plan->cases[i];
+        ob_indent(out, indent);
+        if (c->value == skip) {
+            //nothing left to compare, only one string can be here
+            ob_lit(out, "__match_arm = ");
+        } else {
+            if (i > lo) ob_lit(out, "else ");
+            ob_puts(out, skip > 0 ? "if (memcmp(__match_str + 1, \"" : "if (memcmp(__match_str, \"");
+            ob_escaped(out, c->text + skip);
+            ob_lit(out, "\", ");
+            ob_int(out, c->value - skip);
+            ob_lit(out, ") == 0) __match_arm = ");
+        }
+        ob_int(out, c->arm);
+        ob_lit(out, ";\n");
+    }
+    ob_indent(out, indent);
+    ob_lit(out, "break;\n");
+}
+
+//cases are sorted by length and then text, so each length and first character is one run
+static void emit_match_string_search(MatchSwitch* plan, OutBuf* out, int indent) {
+    ob_indent(out, indent);
+    ob_lit(out, "switch (strlen(__match_str)) {\n");
+    for (int lo = 0; lo < plan->count;) {
+        int length = plan->cases[lo].value;
+        int hi = lo;
+        while (hi < plan->count && plan->cases[hi].value == length) hi++;
+
+        ob_indent(out, indent + 1);
+        ob_lit(out, "case ");
+        ob_int(out, length);
+        ob_lit(out, ":\n");
+        if (hi - lo == 1) {
+            emit_match_string_tests(plan, lo, hi, 0, out, indent + 2);
+        } else {
+            ob_indent(out, indent + 2);
+            ob_lit(out, "switch ((unsigned char)__match_str[0]) {\n");
+            for (int first = lo; first < hi;) {
+                unsigned char c = (unsigned char)plan->cases[first].text[0];
+                int end = first;
+                while (end < hi && (unsigned char)plan->cases[end].text[0] == c) end++;
+                ob_indent(out, indent + 3);
+                ob_lit(out, "case ");
+                ob_int(out, c);
+                ob_lit(out, ":\n");
+                emit_match_string_tests(plan, first, end, 1, out, indent + 4);
+                first = end;
+            }
+            ob_indent(out, indent + 2);
+            ob_lit(out, "}\n");
+            ob_indent(out, indent + 2);
+            ob_lit(out, "break;\n");
+        }
+        lo = hi;
+    }
+    ob_indent(out, indent);
+    ob_lit(out, "}\n");
+}
+
+//the match value is evaluated once, here
+static void emit_match_switch_open(MatchSwitch* plan, Expr* var, OutBuf* out, int indent, FuncTable* funcs) {
+    if (!plan->search) {
+        ob_indent(out, indent);
+        ob_lit(out, "switch (");
+        emit_expr(var, out, funcs);
+        ob_lit(out, ") {\n");
+        plan->indent = indent + 1;
+        return;
+    }
+
+    ob_indent(out, indent);
+    ob_lit(out, "{\n");
+    ob_indent(out, indent + 1);
+    ob_puts(out, plan->strings ? "const char* __match_str = " : "int __match_value = ");
+    emit_expr(var, out, funcs);
+    ob_lit(out, ";\n");
+    ob_indent(out, indent + 1);
+    ob_lit(out, "int __match_arm = -1;\n");
+    if (plan->strings) {
+        emit_match_string_search(plan, out, indent + 1);
+    } else {
+        emit_match_search(plan, 0, plan->count, out, indent + 1, funcs);
+    }
+    ob_indent(out, indent + 1);
+    ob_lit(out, "switch (__match_arm) {\n");
+    plan->indent = indent + 2;
+}
+
+//false for an arm no value reaches, its body is left out
+static bool emit_match_case_open(MatchSwitch* plan, int arm, OutBuf* out, FuncTable* funcs) {
+    if (arm == plan->wildcard) {
+        ob_indent(out, plan->indent);
+        ob_lit(out, "default: {\n");
+        return true;
+    }
+    int c = plan->arm_case[arm];
+    if (c == -1) return false;
+
+    ob_indent(out, plan->indent);
+    ob_lit(out, "case ");
+    if (plan->search) {
+        ob_int(out, arm);
+    } else {
+        emit_expr(plan->cases[c].label, out, funcs);
+    }
+    ob_lit(out, ": {\n");
+    return true;
+}
+
+static void emit_match_case_close(MatchSwitch* plan, OutBuf* out) {
+    ob_indent(out, plan->indent + 1);
+    ob_lit(out, "break;\n");
+    ob_indent(out, plan->indent);
+    ob_lit(out, "}\n");
+}
+
+static void emit_match_switch_close(MatchSwitch* plan, OutBuf* out) {
+    ob_indent(out, plan->indent - 1);
+    ob_lit(out, "}\n");
+    if (plan->search) {
+        ob_indent(out, plan->indent - 2);
+        ob_lit(out, "}\n");
+    }
+    free(plan->cases);
+    free(plan->arm_case);
+}
+
+//appends to a fixed size name buffer, a name that does not fit is cut off instead of overflowing
+static size_t name_append(char* buffer, size_t size, size_t len, const char* fmt, ...) {
+    if (len >= size) return len;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buffer + len, size - len, fmt, args);
+    va_end(args);
+    return n < 0 ? len : len + (size_t)n;
+}
+
+//writes into the callers buffer, so codegen threads never share one
+char* get_mangled_name(FuncSign* sign, char* buffer, size_t size) {
     if (sign == NULL) {
-        strcpy(buffer, "NULL_SIGN");
+        snprintf(buffer, size, "NULL_SIGN");
         return buffer;
     }
 
@@ -82,33 +360,22 @@ char* get_mangled_name(FuncSign* sign) {
         return sign->name;
     }
 
-    //read the name pointer without dereferencing the string yet
-    char* name_ptr = sign->name;
-    stage_trace(STAGE_CODEGEN, "name pointer value: %p", name_ptr);
-    if (name_ptr == NULL) {
-        strcpy(buffer, "NULL_NAME");
+    if (sign->name == NULL) {
+        snprintf(buffer, size, "NULL_NAME");
         return buffer;
     }
-    stage_trace(STAGE_CODEGEN, "about to dereference name");
-    stage_trace(STAGE_CODEGEN, "name is: %s", name_ptr);
-
-    stage_trace(STAGE_CODEGEN, "name is: %s", sign->name);
-    ptr += sprintf(ptr, "%s", sign->name);
 
-    stage_trace(STAGE_CODEGEN, "adding return type");
-    ptr += sprintf(ptr, "_%s", token_type_name(sign->retType));
-
-    stage_trace(STAGE_CODEGEN, "adding %d parameters", sign->paramNum);
+    size_t len = name_append(buffer, size, 0, "%s", sign->name);
+    len = name_append(buffer, size, len, "_%s", token_type_name(sign->retType));
     for (int i = 0; i < sign->paramNum; i++) {
-        stage_trace(STAGE_CODEGEN, "adding param %d", i);
-        ptr += sprintf(ptr, "_%s", token_type_name(sign->parameters[i].type));
+        len = name_append(buffer, size, len, "_%s", token_type_name(sign->parameters[i].type));
         if (sign->parameters[i].ownership != OWNERSHIP_NONE) {
-            ptr += sprintf(ptr, "%s",
-                           sign->parameters[i].ownership == OWNERSHIP_OWN ? "own" : "ref");
+            len = name_append(buffer, size, len, "%s",
+                              sign->parameters[i].ownership == OWNERSHIP_OWN ? "own" : "ref");
         }
     }
 
-    stage_trace(STAGE_CODEGEN, "get_mangled_name done: %s", buffer);
+    stage_trace(STAGE_CODEGEN, "mangled %s (%d params) -> %s", sign->name, sign->paramNum, buffer);
     return buffer;
 }
 
@@ -133,279 +400,284 @@ uint32_t hash_signature(FuncSign* sign) {
     return hash;
 }
 
-char* get_mangled_name_short(FuncSign* sign) {
-    static char buffer[128];
-    snprintf(buffer, sizeof(buffer), "%s_%x", sign->name, hash_signature(sign));
+char* get_mangled_name_short(FuncSign* sign, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s_%x", sign->name, hash_signature(sign));
     return buffer;
 }
 
-char* get_func_name_from_sign(FuncSignToName* fstn, FuncSign* sign) {
-    for (int i = 0; i < fstn->count; ++i) {
-        if(check_func_sign(fstn->elements[i].sign, sign))
-            return fstn->elements[i].name;
+//mangled once per signature, every later declaration/definition/call reuses it.
+//generate_code names the whole table up front, so the parallel emitters only ever read c_name
+char* func_c_name(FuncSign* sign) {
+    if (!sign->c_name) {
+        char buffer[512];
+        sign->c_name = sign->isExtern ? sign->name : arena_strdup(&g_arena, get_mangled_name(sign, buffer, sizeof(buffer)));
     }
-    return "--NO_GOOD_SIGN--";
+    return sign->c_name;
 }
 
-char* get_type_signature(FuncSign* sign) {
-    static char buffer[256];
-    char* ptr = buffer;
+char* get_func_name_from_sign(FuncTable* funcs, FuncSign* sign) {
+    FuncSign* defined = lookup_func_sign(funcs, sign);
+    return defined ? func_c_name(defined) : "--NO_GOOD_SIGN--";
+}
 
-    ptr += sprintf(ptr, "%s_", token_type_name(sign->retType));
+char* get_type_signature(FuncSign* sign, char* buffer, size_t size) {
+    size_t len = name_append(buffer, size, 0, "%s_", token_type_name(sign->retType));
 
     for (int i = 0; i < sign->paramNum; i++) {
-        if (i > 0) ptr += sprintf(ptr, "_");
-        ptr += sprintf(ptr, "%s", token_type_name(sign->parameters[i].type));
+        if (i > 0) len = name_append(buffer, size, len, "_");
+        len = name_append(buffer, size, len, "%s", token_type_name(sign->parameters[i].type));
         if (sign->parameters[i].ownership != OWNERSHIP_NONE) {
-            ptr += sprintf(ptr, "%s",
-                           sign->parameters[i].ownership == OWNERSHIP_OWN ? "own" : "ref");
+            len = name_append(buffer, size, len, "%s",
+                              sign->parameters[i].ownership == OWNERSHIP_OWN ? "own" : "ref");
         }
     }
 
     return buffer;
 }
 
-void emit_func(Func* f, FILE* out, FuncSignToName* fstn) {
+void emit_func(Func* f, OutBuf* out, FuncTable* funcs) {
     stage_trace(STAGE_CODEGEN, "emit_func: %s", f->signature->name);
 
-    if(strcmp(f->signature->name, "main") == 0) fprintf(out, "int");
-    else fprintf(out, "%s%s", type_to_c_type(f->signature->retType), (f->signature->retOwnership != OWNERSHIP_NONE && f->signature->retType != STR_KEYWORD_T) ? "*" : "");
-    fprintf(out, " %s(", strcmp(f->signature->name, "main") == 0 ? "main" : get_func_name_from_sign(fstn, f->signature));
+    bool is_main = is_known_name(f->signature->name, NAME_MAIN);
+    if(is_main) ob_lit(out, "int");
+    else {
+        ob_puts(out, type_to_c_type(f->signature->retType));
+        if (f->signature->retOwnership != OWNERSHIP_NONE && f->signature->retType != STR_KEYWORD_T) ob_putc(out, '*');
+    }
+    ob_lit(out, " ");
+    ob_puts(out, is_main ? "main" : get_func_name_from_sign(funcs, f->signature));
+    ob_lit(out, "(");
 
     for (int i = 0; i < f->signature->paramNum; ++i) {
-        if(i > 0) fprintf(out, ", ");
-        fprintf(out, "%s%s", type_to_c_type(f->signature->parameters[i].type), (f->signature->parameters[i].ownership != OWNERSHIP_NONE && f->signature->parameters[i].type != STR_KEYWORD_T) ? "*" : "");
-        fprintf(out, " %s", f->signature->parameters[i].name);
+        if(i > 0) ob_lit(out, ", ");
+        ob_puts(out, type_to_c_type(f->signature->parameters[i].type));
+        if (f->signature->parameters[i].ownership != OWNERSHIP_NONE && f->signature->parameters[i].type != STR_KEYWORD_T) ob_putc(out, '*');
+        ob_lit(out, " ");
+        ob_puts(out, f->signature->parameters[i].name);
     }
-    fprintf(out, ")\n");
+    ob_lit(out, ")\n");
 
-    stage_trace(STAGE_CODEGEN, "emit_func: calling emit_stmt for body");
-    emit_stmt(f->body, out, 0, fstn);
+    if (g_via_ir && f->ir) {
+        stage_trace(STAGE_CODEGEN, "emit_func: emitting body from ir");
+        emit_ir_body(f->ir, out, funcs);
+    } else {
+        stage_trace(STAGE_CODEGEN, "emit_func: calling emit_stmt for body");
+        emit_stmt(f->body, out, 0, funcs);
+    }
     stage_trace(STAGE_CODEGEN, "emit_func: done with %s", f->signature->name);
 }
 
-void emit_func_decl(Func* f, FILE* out, FuncNameCounter* fnc, FuncSignToName* fstn) {
-    if(strcmp(f->signature->name, "main") == 0) return;
-
-    int funcNum = -1;
-    char* origName = f->signature->name;
+void emit_func_decl(Func* f, OutBuf* out) {
+    if(is_known_name(f->signature->name, NAME_MAIN)) return;
 
-    for (int i = 0; i < fnc->count; ++i) {
-        if (strcmp(fnc->elements[i].name, origName) == 0) {
-            funcNum = ++fnc->elements[i].count;
-            if(fnc->count >= fnc->height) {
-                fnc->height *= 2;
-                fnc->elements = realloc(fnc->elements, sizeof(FuncNameCounterElement) * fnc->height);
-            }
-        }
-    }
-    if(funcNum == -1) {
-        fnc->elements[fnc->count++] = (FuncNameCounterElement){.count = 0, .name = origName};
-        if(fnc->count >= fnc->height) {
-            fnc->height *= 2;
-            fnc->elements = realloc(fnc->elements, sizeof(FuncNameCounterElement) * fnc->height);
-        }
-        funcNum = 0;
-    }
+    char* mangled = func_c_name(f->signature);
 
-    char* mangled = get_mangled_name(f->signature);
-    char* bufP = strdup(mangled);
+    ob_puts(out, type_to_c_type(f->signature->retType));
+    if (f->signature->retOwnership != OWNERSHIP_NONE && f->signature->retType != STR_KEYWORD_T) ob_putc(out, '*');
+    ob_lit(out, " ");
+    ob_puts(out, mangled);
+    ob_lit(out, "(");
 
-    fstn->elements[fstn->count++] = (FuncSignToNameElement){.sign = f->signature, .name = bufP};
+    for (int i = 0; i < f->signature->paramNum; ++i) {
+        if(i > 0) ob_lit(out, ", ");
+        ob_puts(out, type_to_c_type(f->signature->parameters[i].type));
+        if (f->signature->parameters[i].ownership != OWNERSHIP_NONE && f->signature->parameters[i].type != STR_KEYWORD_T) ob_putc(out, '*');
+        ob_lit(out, " ");
+        ob_puts(out, f->signature->parameters[i].name);
+    }
+    ob_lit(out, ");\n");
+}
 
-    if(fstn->count >= fstn->height) {
-        fstn->height *= 2;
-        fstn->elements = realloc(fstn->elements, sizeof(FuncSignToNameElement) * fstn->height);
+//with surrounding spaces, as emit_expr puts it between the operands
+const char* c_binary_op(TokenType op) {
+    switch (op) {
+        case PLUS_T: return " + ";
+        case MINUS_T: return " - ";
+        case STAR_T: return " * ";
+        case SLASH_T: return " / ";
+        case SHIFT_LEFT_T: return " << ";
+        case SHIFT_RIGHT_T: return " >> ";
+        case WRAP_PLUS_T: return " + ";
+        case WRAP_MINUS_T: return " - ";
+        case WRAP_STAR_T: return " * ";
+        case DOUBLE_EQUALS_T: return " == ";
+        case NOT_EQUALS_T: return " != ";
+        case LESS_T: return " < ";
+        case MORE_T: return " > ";
+        case LESS_EQUALS_T: return " <= ";
+        case MORE_EQUALS_T: return " >= ";
+        case AND_T: return " && ";
+        case OR_T: return " || ";
+        default: return " ??? ";
     }
+}
 
-    fprintf(out, "%s%s", type_to_c_type(f->signature->retType), (f->signature->retOwnership != OWNERSHIP_NONE && f->signature->retType != STR_KEYWORD_T) ? "*" : "");
-    fprintf(out, " %s(", mangled);
+//a negative int shifted left, and induction values the program may never compute, are undefined as signed c
+bool c_binary_wraps(TokenType op) {
+    return op == SHIFT_LEFT_T || op == WRAP_PLUS_T || op == WRAP_MINUS_T || op == WRAP_STAR_T;
+}
 
-    for (int i = 0; i < f->signature->paramNum; ++i) {
-        if(i > 0) fprintf(out, ", ");
-        fprintf(out, "%s%s", type_to_c_type(f->signature->parameters[i].type), (f->signature->parameters[i].ownership != OWNERSHIP_NONE && f->signature->parameters[i].type != STR_KEYWORD_T) ? "*" : "");
-        fprintf(out, " %s", f->signature->parameters[i].name);
+void emit_print_format(Expr* call, OutBuf* out) {
+    ob_lit(out, "printf(\"");
+
+    for (int i = 0; i < call->as.func_call.count; ++i) {
+        Expr* p = call->as.func_call.params[i];
+
+        if (p->analyzedType == INT_KEYWORD_T) {
+            ob_lit(out, "%d");
+        } else if (p->analyzedType == BOOL_KEYWORD_T) {
+            ob_lit(out, "%s");
+        } else if (p->analyzedType == STR_KEYWORD_T) {
+            ob_lit(out, "%s");
+        } else if (p->analyzedType == CHAR_KEYWORD_T) {
+            ob_lit(out, "%c");
+        } else if (p->analyzedType == FLOAT_KEYWORD_T || p->analyzedType == DOUBLE_KEYWORD_T) {
+            ob_lit(out, "%g");
+        }
+
+        if (i < call->as.func_call.count - 1) {
+            ob_lit(out, " ");
+        }
     }
-    fprintf(out, ");\n");
+    ob_lit(out, "\\n\"");
 }
 
-void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
+void emit_expr(Expr* e, OutBuf* out, FuncTable* funcs) {
     if (e == NULL) return;
 
     stage_trace(STAGE_CODEGEN, "emit_expr: type=%d", e->type);
 
     switch (e->type) {
         case INT_LIT_E:
-            fprintf(out, "%d", e->as.int_val);
+            //-2147483648 would be the long 2147483648 negated in c, folding can make this value
+            if (e->as.int_val == INT32_MIN) {
+                ob_lit(out, "(-2147483647 - 1)");
+                break;
+            }
+            ob_int(out, e->as.int_val);
             break;
 
         case FLOAT_LIT_E:
-            fprintf(out, "%g", e->as.double_val);
-            if (e->analyzedType == FLOAT_KEYWORD_T) fprintf(out, "f");
+            ob_printf(out, "%g", e->as.double_val);
+            if (e->analyzedType == FLOAT_KEYWORD_T) ob_lit(out, "f");
             break;
 
         case BOOL_LIT_E:
-            fprintf(out, e->as.bool_val ? "true" : "false");
+            ob_puts(out, e->as.bool_val ? "true" : "false");
             break;
 
         case STR_LIT_E: {
-            fprintf(out, "\"");
-            for (char* s = e->as.str_val; *s != '\0'; s++) {
-                switch (*s) {
-                    case '\n': fprintf(out, "\\n"); break;
-                    case '\t': fprintf(out, "\\t"); break;
-                    case '\r': fprintf(out, "\\r"); break;
-                    case '\\': fprintf(out, "\\\\"); break;
-                    case '"': fprintf(out, "\\\""); break;
-                    default: fprintf(out, "%c", *s); break;
-                }
-            }
-            fprintf(out, "\"");
+            ob_putc(out, '"');
+            ob_escaped(out, e->as.str_val);
+            ob_putc(out, '"');
             break;
         }
 
         case CHAR_LIT_E: {
-            fprintf(out, "'");
+            ob_lit(out, "'");
             char c = e->as.char_val;
             switch (c) {
-                case '\n': fprintf(out, "\\n"); break;
-                case '\t': fprintf(out, "\\t"); break;
-                case '\r': fprintf(out, "\\r"); break;
-                case '\0': fprintf(out, "\\0"); break;
-                case '\\': fprintf(out, "\\\\"); break;
-                case '\'': fprintf(out, "\\'"); break;
-                default: fprintf(out, "%c", c); break;
+                case '\n': ob_lit(out, "\\n"); break;
+                case '\t': ob_lit(out, "\\t"); break;
+                case '\r': ob_lit(out, "\\r"); break;
+                case '\0': ob_lit(out, "\\0"); break;
+                case '\\': ob_lit(out, "\\\\"); break;
+                case '\'': ob_lit(out, "\\'"); break;
+                default: ob_putc(out, c); break;
             }
-            fprintf(out, "'");
+            ob_lit(out, "'");
             break;
         }
 
         case NULL_LIT_E: {
-            fprintf(out, "NULL");
+            ob_lit(out, "NULL");
             break;
         }
 
         case VAR_E:
-            fprintf(out, "%s%s", (e->as.var.ownership != OWNERSHIP_NONE && e->analyzedType != STR_KEYWORD_T) ? "*" : "", e->as.var.name);
+            if (e->as.var.ownership != OWNERSHIP_NONE && e->analyzedType != STR_KEYWORD_T) ob_putc(out, '*');
+            ob_puts(out, e->as.var.name);
             break;
 
         case UN_OP_E: {
-            fprintf(out, "(");
+            ob_lit(out, "(");
             if (e->as.un_op.op == MINUS_T) {
-                fprintf(out, "-");
+                ob_lit(out, "-");
             } else if (e->as.un_op.op == NEGATION_T) {
-                fprintf(out, "!");
+                ob_lit(out, "!");
             }
-            emit_expr(e->as.un_op.expr, out, fstn);
-            fprintf(out, ")");
+            emit_expr(e->as.un_op.expr, out, funcs);
+            ob_lit(out, ")");
             break;
         }
 
         case BIN_OP_E: {
             //emit: (left op right)
-            fprintf(out, "(");
-            emit_expr(e->as.bin_op.exprL, out, fstn);
-
-            switch (e->as.bin_op.op) {
-                case PLUS_T: fprintf(out, " + "); break;
-                case MINUS_T: fprintf(out, " - "); break;
-                case STAR_T: fprintf(out, " * "); break;
-                case SLASH_T: fprintf(out, " / "); break;
-                case DOUBLE_EQUALS_T: fprintf(out, " == "); break;
-                case NOT_EQUALS_T: fprintf(out, " != "); break;
-                case LESS_T: fprintf(out, " < "); break;
-                case MORE_T: fprintf(out, " > "); break;
-                case LESS_EQUALS_T: fprintf(out, " <= "); break;
-                case MORE_EQUALS_T: fprintf(out, " >= "); break;
-                case AND_T: fprintf(out, " && "); break;
-                case OR_T: fprintf(out, " || "); break;
-                default: fprintf(out, " ??? "); break;
-            }
+            ob_lit(out, "(");
+            bool wraps = c_binary_wraps(e->as.bin_op.op);
+            if (wraps) ob_lit(out, "(int)((unsigned)");
+            emit_expr(e->as.bin_op.exprL, out, funcs);
 
-            emit_expr(e->as.bin_op.exprR, out, fstn);
-            fprintf(out, ")");
+            ob_puts(out, c_binary_op(e->as.bin_op.op));
+
+            emit_expr(e->as.bin_op.exprR, out, funcs);
+            if (wraps) ob_lit(out, ")");
+            ob_lit(out, ")");
             break;
         }
 
         case FUNC_CALL_E: {
-            //special handling for length() with strings -> strlen()
-            if (strcmp(e->as.func_call.name, "length") == 0) {
-                 fprintf(out, "strlen(");
-                 emit_expr(e->as.func_call.params[0], out, fstn);
-                 fprintf(out, ")");
-                 return;
-            }
-
-
-            //handle std.io read_* functions
-            if (strcmp(e->as.func_call.name, "read_int") == 0) {
-                fprintf(out, "read_int()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_str") == 0) {
-                fprintf(out, "read_str()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_bool") == 0) {
-                fprintf(out, "read_bool()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_char") == 0) {
-                fprintf(out, "read_char()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_key") == 0) {
-                fprintf(out, "read_key()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_float") == 0) {
-                fprintf(out, "read_float()");
-                break;
-            } else if (strcmp(e->as.func_call.name, "read_double") == 0) {
-                fprintf(out, "read_double()");
-                break;
+            //builtins are pre-interned, their id says which one this is
+            switch (known_name(e->as.func_call.name)) {
+                case NAME_LENGTH:
+                    //special handling for length() with strings -> strlen()
+                    ob_lit(out, "strlen(");
+                    emit_expr(e->as.func_call.params[0], out, funcs);
+                    ob_lit(out, ")");
+                    return;
+
+                //handle std.io read_* functions
+                case NAME_READ_INT:
+                case NAME_READ_STR:
+                case NAME_READ_BOOL:
+                case NAME_READ_CHAR:
+                case NAME_READ_KEY:
+                case NAME_READ_FLOAT:
+                case NAME_READ_DOUBLE:
+                    ob_puts(out, e->as.func_call.name);
+                    ob_lit(out, "()");
+                    return;
+
+                default:
+                    break;
             }
 
-            if(strcmp(e->as.func_call.name, "print") == 0) {
+            if (is_known_name(e->as.func_call.name, NAME_PRINT)) {
 
-                fprintf(out, "printf(\"");
+                emit_print_format(e, out);
 
                 for (int i = 0; i < e->as.func_call.count; ++i) {
                     Expr* p = e->as.func_call.params[i];
-
-                    if (p->analyzedType == INT_KEYWORD_T) {
-                        fprintf(out, "%%d");
-                    } else if (p->analyzedType == BOOL_KEYWORD_T) {
-                        fprintf(out, "%%s");
-                    } else if (p->analyzedType == STR_KEYWORD_T) {
-                        fprintf(out, "%%s");
-                    } else if (p->analyzedType == CHAR_KEYWORD_T) {
-                        fprintf(out, "%%c");
-                    } else if (p->analyzedType == FLOAT_KEYWORD_T || p->analyzedType == DOUBLE_KEYWORD_T) {
-                        fprintf(out, "%%g");
-                    }
-
-                    if (i < e->as.func_call.count - 1) {
-                        fprintf(out, " ");
-                    }
-                }
-                fprintf(out, "\\n\"");
-
-                for (int i = 0; i < e->as.func_call.count; ++i) {
-                    Expr* p = e->as.func_call.params[i];
-                    fprintf(out, ", ");
+                    ob_lit(out, ", ");
 
                     if (p->analyzedType == BOOL_KEYWORD_T) {
-                        fprintf(out, "(");
-                        emit_expr(p, out, fstn);
-                        fprintf(out, " ? \"true\" : \"false\")");
+                        ob_lit(out, "(");
+                        emit_expr(p, out, funcs);
+                        ob_lit(out, " ? \"true\" : \"false\")");
                     } else {
-                        emit_expr(p, out, fstn);
+                        emit_expr(p, out, funcs);
                     }
                 }
 
-                fprintf(out, ")");
+                ob_lit(out, ")");
                 return;
             }
 
             //regular function call
             if (e->as.func_call.resolved_sign == NULL) {
-                fprintf(out, "/* ERROR: unresolved function %s */", e->as.func_call.name);
+                ob_lit(out, "/* ERROR: unresolved function ");
+                ob_puts(out, e->as.func_call.name);
+                ob_lit(out, " */");
                 break;
             }
 
@@ -416,15 +688,16 @@ void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
             stage_trace(STAGE_CODEGEN, "resolved_sign pointer: %p", rs);
 
             //dont try to dereference if it might be bad
-            char* mangled_name = get_mangled_name(rs);
+            char* mangled_name = func_c_name(rs);
             stage_trace(STAGE_CODEGEN, "mangled name: %s", mangled_name);
-            fprintf(out, "%s(", mangled_name);
+            ob_puts(out, mangled_name);
+            ob_lit(out, "(");
             for (int i = 0; i < e->as.func_call.count; ++i) {
                 stage_trace(STAGE_CODEGEN, "emitting parameter %d", i);
-                if (i != 0) fprintf(out, ", ");
-                emit_expr(e->as.func_call.params[i], out, fstn);
+                if (i != 0) ob_lit(out, ", ");
+                emit_expr(e->as.func_call.params[i], out, funcs);
             }
-            fprintf(out, ")");
+            ob_lit(out, ")");
             stage_trace(STAGE_CODEGEN, "done with function call: %s", e->as.func_call.name);
             break;
         }
@@ -433,25 +706,25 @@ void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
             //if its a simple return, keep it on one line.
             //if its a match, use the temporary variable block.
             if (e->as.func_ret_expr->type == MATCH_E) {
-                emit_indent(out, 0);
-                fprintf(out, "{\n");
-                emit_indent(out, 0 + 1);
-                fprintf(out, "int _ret;\n");
-                emit_assign_expr_to_var(e->as.func_ret_expr, "_ret", OWNERSHIP_NONE, out, 0 + 1, fstn);
-                emit_indent(out, 0 + 1);
-                fprintf(out, "return _ret;\n");
-                emit_indent(out, 0);
-                fprintf(out, "}\n");
+                ob_indent(out, 0);
+                ob_lit(out, "{\n");
+                ob_indent(out, 0 + 1);
+                ob_lit(out, "int _ret;\n");
+                emit_assign_expr_to_var(e->as.func_ret_expr, "_ret", OWNERSHIP_NONE, out, 0 + 1, funcs);
+                ob_indent(out, 0 + 1);
+                ob_lit(out, "return _ret;\n");
+                ob_indent(out, 0);
+                ob_lit(out, "}\n");
             } else if (e->as.func_ret_expr->type == VOID_E) {
-                emit_indent(out, 0);
-                fprintf(out, "return");
+                ob_indent(out, 0);
+                ob_lit(out, "return");
             } else {
-                emit_indent(out, 0);
-                fprintf(out, "return ");
+                ob_indent(out, 0);
+                ob_lit(out, "return ");
                 if (e->as.func_ret_expr->type == VAR_E && e->as.func_ret_expr->as.var.ownership == OWNERSHIP_OWN) {
-                    fprintf(out, "%s", e->as.func_ret_expr->as.var.name);
+                    ob_puts(out, e->as.func_ret_expr->as.var.name);
                 } else {
-                    emit_expr(e->as.func_ret_expr, out, fstn);
+                    emit_expr(e->as.func_ret_expr, out, funcs);
                 }
             }
             break;
@@ -460,11 +733,12 @@ void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
         case SOME_E: {
             //for nullable pointers, dont dereference - check the pointer itself
             if (e->as.some.var->type == VAR_E) {
-                fprintf(out, "%s != NULL", e->as.some.var->as.var.name);
+                ob_puts(out, e->as.some.var->as.var.name);
+                ob_lit(out, " != NULL");
             } else {
-                fprintf(out, "(");
-                emit_expr(e->as.some.var, out, fstn);
-                fprintf(out, ") != NULL");
+                ob_lit(out, "(");
+                emit_expr(e->as.some.var, out, funcs);
+                ob_lit(out, ") != NULL");
             }
             break;
         }
@@ -474,19 +748,20 @@ void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
         }
 
         case ARRAY_DECL_E: {
-            fprintf(out, "{");
+            ob_lit(out, "{");
             for (int i = 0; i < e->as.arr_decl.count; i++) {
-                if (i > 0) fprintf(out, ", ");
-                emit_expr(e->as.arr_decl.values[i], out, fstn);
+                if (i > 0) ob_lit(out, ", ");
+                emit_expr(e->as.arr_decl.values[i], out, funcs);
             }
-            fprintf(out, "}");
+            ob_lit(out, "}");
             break;
         }
 
         case ARRAY_ACCESS_E: {
-            fprintf(out, "%s[", e->as.array_access.arrayName);
-            emit_expr(e->as.array_access.index, out, fstn);
-            fprintf(out, "]");
+            ob_puts(out, e->as.array_access.arrayName);
+            ob_lit(out, "[");
+            emit_expr(e->as.array_access.index, out, funcs);
+            ob_lit(out, "]");
             break;
         }
         
@@ -495,8 +770,25 @@ void emit_expr(Expr* e, FILE* out, FuncSignToName* fstn) {
 }
 
 
-void emit_assign_expr_to_var(Expr* e, const char* targetVar, Ownership o, FILE* out, int indent, FuncSignToName* fstn) {
+void emit_assign_expr_to_var(Expr* e, const char* targetVar, Ownership o, OutBuf* out, int indent, FuncTable* funcs) {
     if (e->type == MATCH_E) {
+        Pattern** patterns = malloc(sizeof(Pattern*) * e->as.match.branchCount);
+        for (int i = 0; i < e->as.match.branchCount; i++) patterns[i] = e->as.match.branches[i].pattern;
+        MatchSwitch plan;
+        bool switched = match_switch_plan(e->as.match.var, patterns, e->as.match.branchCount, &plan);
+        free(patterns);
+
+        if (switched) {
+            emit_match_switch_open(&plan, e->as.match.var, out, indent, funcs);
+            for (int i = 0; i < e->as.match.branchCount; i++) {
+                if (!emit_match_case_open(&plan, i, out, funcs)) continue;
+                emit_assign_expr_to_var(e->as.match.branches[i].caseRet, targetVar, o, out, plan.indent + 1, funcs);
+                emit_match_case_close(&plan, out);
+            }
+            emit_match_switch_close(&plan, out);
+            return;
+        }
+
         int defaultIdx = -1;
         bool firstCondition = true;
 
@@ -513,69 +805,79 @@ void emit_assign_expr_to_var(Expr* e, const char* targetVar, Ownership o, FILE*
 
             MatchBranchExpr* branch = &e->as.match.branches[i];
 
-            emit_indent(out, indent);
+            ob_indent(out, indent);
             if (firstCondition) {
-                fprintf(out, "if (");
+                ob_lit(out, "if (");
                 firstCondition = false;
             } else {
-                fprintf(out, "else if (");
+                ob_lit(out, "else if (");
             }
 
-            emit_pattern_condition(branch->pattern, e->as.match.var, out, fstn);
-            fprintf(out, ") {\n");
+            emit_pattern_condition(branch->pattern, e->as.match.var, out, funcs);
+            ob_lit(out, ") {\n");
 
             //if SOME_PATTERN, declare binding variable
             if (branch->pattern->type == SOME_PATTERN) {
-                emit_indent(out, indent + 1);
+                ob_indent(out, indent + 1);
                 emit_type(branch->analyzed_type, out);
-                fprintf(out, "* %s = ", branch->pattern->as.binding_name);
+                ob_lit(out, "* ");
+                ob_puts(out, branch->pattern->as.binding_name);
+                ob_lit(out, " = ");
                 //emit just the variable name, not dereferenced
                 if (e->as.match.var->type == VAR_E) {
-                    fprintf(out, "%s", e->as.match.var->as.var.name);
+                    ob_puts(out, e->as.match.var->as.var.name);
                 } else {
-                    emit_expr(e->as.match.var, out, fstn);
+                    emit_expr(e->as.match.var, out, funcs);
                 }
-                fprintf(out, ";\n");
+                ob_lit(out, ";\n");
             }
 
             //handles nested matches or simple values
-            emit_assign_expr_to_var(branch->caseRet, targetVar, o, out, indent + 1, fstn);
+            emit_assign_expr_to_var(branch->caseRet, targetVar, o, out, indent + 1, funcs);
 
-            emit_indent(out, indent);
-            fprintf(out, "}\n");
+            ob_indent(out, indent);
+            ob_lit(out, "}\n");
         }
 
         if (defaultIdx != -1) {
-            emit_indent(out, indent);
-            fprintf(out, "else {\n");
-            emit_assign_expr_to_var(e->as.match.branches[defaultIdx].caseRet, targetVar, o, out, indent + 1, fstn);
-            emit_indent(out, indent);
-            fprintf(out, "}\n");
+            ob_indent(out, indent);
+            ob_lit(out, "else {\n");
+            emit_assign_expr_to_var(e->as.match.branches[defaultIdx].caseRet, targetVar, o, out, indent + 1, funcs);
+            ob_indent(out, indent);
+            ob_lit(out, "}\n");
         }
     } else if (e->type == ALLOC_E) {
         //reassignment with alloc
-        emit_indent(out, indent);
-        fprintf(out, "%s = malloc(sizeof(%s));\n", targetVar, type_to_c_type(e->as.alloc.type));
-        emit_indent(out, indent);
-        fprintf(out, "*%s = ", targetVar);
-        emit_expr(e->as.alloc.initialValue, out, fstn);
-        fprintf(out, ";\n");
+        ob_indent(out, indent);
+        ob_puts(out, targetVar);
+        ob_lit(out, " = malloc(sizeof(");
+        ob_puts(out, type_to_c_type(e->as.alloc.type));
+        ob_lit(out, "));\n");
+        ob_indent(out, indent);
+        ob_lit(out, "*");
+        ob_puts(out, targetVar);
+        ob_lit(out, " = ");
+        emit_expr(e->as.alloc.initialValue, out, funcs);
+        ob_lit(out, ";\n");
     } else {
         //base case: just a normal assignment
-        emit_indent(out, indent);
+        ob_indent(out, indent);
         bool add_ampersand = (o != OWNERSHIP_NONE && e->type == VAR_E && e->as.var.ownership != OWNERSHIP_NONE);
 
         //dont dereference if expression is nullable (returns a pointer)
         bool needs_deref = (o != OWNERSHIP_NONE && e->analyzedType != NULL_LIT_T && !e->is_nullable && (e->type == VAR_E ? e->as.var.ownership == OWNERSHIP_NONE : true));
 
-        fprintf(out, "%s%s = %s", needs_deref ? "*" : "", targetVar, add_ampersand ? "&" : "");
-        emit_expr(e, out, fstn);
-        fprintf(out, ";\n");
+        if (needs_deref) ob_putc(out, '*');
+        ob_puts(out, targetVar);
+        ob_lit(out, " = ");
+        if (add_ampersand) ob_putc(out, '&');
+        emit_expr(e, out, funcs);
+        ob_lit(out, ";\n");
     }
 }
 
 //emit a statement (with indentation and newlines)
-void emit_stmt(Stmt* s, FILE* out, int indent, FuncSignToName* fstn) {
+void emit_stmt(Stmt* s, OutBuf* out, int indent, FuncTable* funcs) {
     if (s == NULL) return;
 
     stage_trace(STAGE_CODEGEN, "emit_stmt: type=%d, indent=%d", s->type, indent);
@@ -584,190 +886,236 @@ void emit_stmt(Stmt* s, FILE* out, int indent, FuncSignToName* fstn) {
         case VAR_DECL_S:
             if (s->as.var_decl.isArray && s->as.var_decl.ownership == OWNERSHIP_NONE && s->as.var_decl.elementOwnership == OWNERSHIP_NONE) {
                 //case 1: stack array of values - int arr[5]
-                emit_indent(out, indent);
-                fprintf(out, "%s %s[",
-                        type_to_c_type(s->as.var_decl.varType),
-                        s->as.var_decl.name);
-                emit_expr(s->as.var_decl.arraySize, out, fstn);
-                fprintf(out, "]");
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, " ");
+                ob_puts(out, s->as.var_decl.name);
+                ob_lit(out, "[");
+                emit_expr(s->as.var_decl.arraySize, out, funcs);
+                ob_lit(out, "]");
 
                 if (s->as.var_decl.expr->type == ARRAY_DECL_E) {
-                    fprintf(out, " = ");
-                    emit_expr(s->as.var_decl.expr, out, fstn);
+                    ob_lit(out, " = ");
+                    emit_expr(s->as.var_decl.expr, out, funcs);
                 }
-                fprintf(out, ";\n");
+                ob_lit(out, ";\n");
             } else if (s->as.var_decl.isArray && s->as.var_decl.ownership == OWNERSHIP_OWN && s->as.var_decl.elementOwnership == OWNERSHIP_NONE) {
                 //case 3: heap array of values - int* arr = malloc(N * sizeof(int))
-                emit_indent(out, indent);
-                fprintf(out, "%s* %s = malloc(sizeof(%s) * ",
-                        type_to_c_type(s->as.var_decl.varType),
-                        s->as.var_decl.name,
-                        type_to_c_type(s->as.var_decl.varType));
-                emit_expr(s->as.var_decl.arraySize, out, fstn);
-                fprintf(out, ");\n");
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, "* ");
+                ob_puts(out, s->as.var_decl.name);
+                ob_lit(out, " = malloc(sizeof(");
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, ") * ");
+                emit_expr(s->as.var_decl.arraySize, out, funcs);
+                ob_lit(out, ");\n");
             } else if (s->as.var_decl.isArray && s->as.var_decl.ownership == OWNERSHIP_NONE && s->as.var_decl.elementOwnership == OWNERSHIP_OWN) {
                 //case 4: stack array of owned pointers - int* arr[5]
-                emit_indent(out, indent);
-                fprintf(out, "%s* %s[",
-                        type_to_c_type(s->as.var_decl.varType),
-                        s->as.var_decl.name);
-                emit_expr(s->as.var_decl.arraySize, out, fstn);
-                fprintf(out, "];\n");
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, "* ");
+                ob_puts(out, s->as.var_decl.name);
+                ob_lit(out, "[");
+                emit_expr(s->as.var_decl.arraySize, out, funcs);
+                ob_lit(out, "];\n");
             } else if (s->as.var_decl.isArray && s->as.var_decl.ownership == OWNERSHIP_OWN && s->as.var_decl.elementOwnership == OWNERSHIP_OWN) {
                 //case 5: heap array of owned pointers - int** arr = malloc(N * sizeof(int*))
-                emit_indent(out, indent);
-                fprintf(out, "%s** %s = malloc(sizeof(%s*) * ",
-                        type_to_c_type(s->as.var_decl.varType),
-                        s->as.var_decl.name,
-                        type_to_c_type(s->as.var_decl.varType));
-                emit_expr(s->as.var_decl.arraySize, out, fstn);
-                fprintf(out, ");\n");
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, "** ");
+                ob_puts(out, s->as.var_decl.name);
+                ob_lit(out, " = malloc(sizeof(");
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, "*) * ");
+                emit_expr(s->as.var_decl.arraySize, out, funcs);
+                ob_lit(out, ");\n");
             } else if (s->as.var_decl.expr->type == ALLOC_E) {
                 //regular alloc (non-array variable)
                 bool isString = (s->as.var_decl.varType == STR_KEYWORD_T);
                 
-                emit_indent(out, indent);
-                fprintf(out, "%s", type_to_c_type(s->as.var_decl.varType));
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
                 //strings in Lync are char*, and own string is just char* (with ownership semantics), so no extra *
-                fprintf(out, " %s%s", (s->as.var_decl.ownership != OWNERSHIP_NONE && !isString) ? "*" : "", s->as.var_decl.name);
+                ob_lit(out, " ");
+                if (s->as.var_decl.ownership != OWNERSHIP_NONE && !isString) ob_putc(out, '*');
+                ob_puts(out, s->as.var_decl.name);
                 
                 if (isString && s->as.var_decl.expr->as.alloc.isArray) {
                     //own string = alloc[n] char
                     //char* s = malloc(sizeof(char) * size);
-                    fprintf(out, " = malloc(sizeof(%s) * ", type_to_c_type(s->as.var_decl.expr->as.alloc.type));
-                    emit_expr(s->as.var_decl.expr->as.alloc.initialValue, out, fstn);
-                    fprintf(out, ");\n");
+                    ob_lit(out, " = malloc(sizeof(");
+                    ob_puts(out, type_to_c_type(s->as.var_decl.expr->as.alloc.type));
+                    ob_lit(out, ") * ");
+                    emit_expr(s->as.var_decl.expr->as.alloc.initialValue, out, funcs);
+                    ob_lit(out, ");\n");
                 } else {
                      //own int = alloc 42
-                     fprintf(out, " = malloc(sizeof(%s));\n", type_to_c_type(s->as.var_decl.varType));
+                     ob_lit(out, " = malloc(sizeof(");
+                     ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                     ob_lit(out, "));\n");
                      
                      if (s->as.var_decl.expr->as.alloc.isArray) {
                         //allocating an array for a scalar pointer (e.g. string)
-                        emit_indent(out, indent);
-                        fprintf(out, "*%s = malloc(sizeof(%s) * ", s->as.var_decl.name, type_to_c_type(s->as.var_decl.expr->as.alloc.type));
-                         emit_expr(s->as.var_decl.expr->as.alloc.initialValue, out, fstn);
-                        fprintf(out, ");\n");
+                        ob_indent(out, indent);
+                        ob_lit(out, "*");
+                        ob_puts(out, s->as.var_decl.name);
+                        ob_lit(out, " = malloc(sizeof(");
+                        ob_puts(out, type_to_c_type(s->as.var_decl.expr->as.alloc.type));
+                        ob_lit(out, ") * ");
+                         emit_expr(s->as.var_decl.expr->as.alloc.initialValue, out, funcs);
+                        ob_lit(out, ");\n");
                     } else {
                         emit_assign_expr_to_var(s->as.var_decl.expr->as.alloc.initialValue,
                                                 s->as.var_decl.name,
                                                 s->as.var_decl.ownership,
                                                 out,
-                                                indent, fstn);
+                                                indent, funcs);
                     }
                 }
             } else {
                 //normal variable
-                emit_indent(out, indent);
-                fprintf(out, "%s", type_to_c_type(s->as.var_decl.varType));
-                fprintf(out, " %s%s", s->as.var_decl.ownership != OWNERSHIP_NONE ? "*" : "", s->as.var_decl.name);
-                fprintf(out, ";\n");
+                ob_indent(out, indent);
+                ob_puts(out, type_to_c_type(s->as.var_decl.varType));
+                ob_lit(out, " ");
+                if (s->as.var_decl.ownership != OWNERSHIP_NONE) ob_putc(out, '*');
+                ob_puts(out, s->as.var_decl.name);
+                ob_lit(out, ";\n");
                 emit_assign_expr_to_var(s->as.var_decl.expr,
                                         s->as.var_decl.name,
                                         s->as.var_decl.ownership,
                                         out,
-                                        indent, fstn);
+                                        indent, funcs);
             }
             break;
 
         case ASSIGN_S:
             if (s->as.var_assign.isArray && s->as.var_assign.expr->type == ALLOC_E) {
                 //array reallocation
-                emit_indent(out, indent);
-                fprintf(out, "%s = malloc(sizeof(%s) * ",
-                        s->as.var_assign.name,
-                        type_to_c_type(s->as.var_assign.expr->as.alloc.type));
-                emit_expr(s->as.var_assign.expr->as.alloc.initialValue, out, fstn);
-                fprintf(out, ");\n");
+                ob_indent(out, indent);
+                ob_puts(out, s->as.var_assign.name);
+                ob_lit(out, " = malloc(sizeof(");
+                ob_puts(out, type_to_c_type(s->as.var_assign.expr->as.alloc.type));
+                ob_lit(out, ") * ");
+                emit_expr(s->as.var_assign.expr->as.alloc.initialValue, out, funcs);
+                ob_lit(out, ");\n");
             } else {
-                emit_assign_expr_to_var(s->as.var_assign.expr, s->as.var_assign.name, s->as.var_assign.ownership, out, indent, fstn);
+                emit_assign_expr_to_var(s->as.var_assign.expr, s->as.var_assign.name, s->as.var_assign.ownership, out, indent, funcs);
             }
             break;
 
         case ARRAY_ELEM_ASSIGN_S:
-            emit_indent(out, indent);
-            fprintf(out, "%s[", s->as.array_elem_assign.arrayName);
-            emit_expr(s->as.array_elem_assign.index, out, fstn);
-            fprintf(out, "] = ");
-            emit_expr(s->as.array_elem_assign.value, out, fstn);
-            fprintf(out, ";\n");
+            ob_indent(out, indent);
+            ob_puts(out, s->as.array_elem_assign.arrayName);
+            ob_lit(out, "[");
+            emit_expr(s->as.array_elem_assign.index, out, funcs);
+            ob_lit(out, "] = ");
+            emit_expr(s->as.array_elem_assign.value, out, funcs);
+            ob_lit(out, ";\n");
             break;
 
         case IF_S:
-            emit_indent(out, indent);
-            fprintf(out, "if (");
-            emit_expr(s->as.if_stmt.cond, out, fstn);
-            fprintf(out, ") ");
+            ob_indent(out, indent);
+            ob_lit(out, "if (");
+            emit_expr(s->as.if_stmt.cond, out, funcs);
+            ob_lit(out, ") ");
 
             //true
             if (s->as.if_stmt.trueStmt->type == BLOCK_S) {
-                emit_stmt(s->as.if_stmt.trueStmt, out, indent, fstn);
+                emit_stmt(s->as.if_stmt.trueStmt, out, indent, funcs);
             } else {
-                fprintf(out, "{\n");
-                emit_stmt(s->as.if_stmt.trueStmt, out, indent + 1, fstn);
-                emit_indent(out, indent);
-                fprintf(out, "}");
+                ob_lit(out, "{\n");
+                emit_stmt(s->as.if_stmt.trueStmt, out, indent + 1, funcs);
+                ob_indent(out, indent);
+                ob_lit(out, "}");
             }
 
             //false
             if (s->as.if_stmt.falseStmt != NULL) {
-                fprintf(out, " else ");
+                ob_lit(out, " else ");
                 if (s->as.if_stmt.falseStmt->type == BLOCK_S) {
-                    emit_stmt(s->as.if_stmt.falseStmt, out, indent, fstn);
+                    emit_stmt(s->as.if_stmt.falseStmt, out, indent, funcs);
                 } else {
-                    fprintf(out, "{\n");
-                    emit_stmt(s->as.if_stmt.falseStmt, out, indent + 1, fstn);
-                    emit_indent(out, indent);
-                    fprintf(out, "}");
+                    ob_lit(out, "{\n");
+                    emit_stmt(s->as.if_stmt.falseStmt, out, indent + 1, funcs);
+                    ob_indent(out, indent);
+                    ob_lit(out, "}");
                 }
             }
-            fprintf(out, "\n");
+            ob_lit(out, "\n");
             break;
 
         case WHILE_S:
-            emit_indent(out, indent);
-            fprintf(out, "while (");
-            emit_expr(s->as.while_stmt.cond, out, fstn);
-            fprintf(out, ") ");
-            emit_stmt(s->as.while_stmt.body, out, indent, fstn);
+            ob_indent(out, indent);
+            ob_lit(out, "while (");
+            emit_expr(s->as.while_stmt.cond, out, funcs);
+            ob_lit(out, ") ");
+            emit_stmt(s->as.while_stmt.body, out, indent, funcs);
             break;
 
         case DO_WHILE_S:
-            emit_indent(out, indent);
-            fprintf(out, "do ");
-            emit_stmt(s->as.do_while_stmt.body, out, indent, fstn);
-            emit_indent(out, indent);
-            fprintf(out, "while (");
-            emit_expr(s->as.do_while_stmt.cond, out, fstn);
-            fprintf(out, ");\n");
+            ob_indent(out, indent);
+            ob_lit(out, "do ");
+            emit_stmt(s->as.do_while_stmt.body, out, indent, funcs);
+            ob_indent(out, indent);
+            ob_lit(out, "while (");
+            emit_expr(s->as.do_while_stmt.cond, out, funcs);
+            ob_lit(out, ");\n");
             break;
 
         case FOR_S:
-            emit_indent(out, indent);
-            fprintf(out, "for (int %s = ", s->as.for_stmt.varName);
-            emit_expr(s->as.for_stmt.min, out, fstn);
-            fprintf(out, "; %s <= ", s->as.for_stmt.varName);
-            emit_expr(s->as.for_stmt.max, out, fstn);
-            fprintf(out, "; %s++) ", s->as.for_stmt.varName);
-            emit_stmt(s->as.for_stmt.body, out, indent, fstn);
+            ob_indent(out, indent);
+            ob_lit(out, "for (int ");
+            ob_puts(out, s->as.for_stmt.varName);
+            ob_lit(out, " = ");
+            emit_expr(s->as.for_stmt.min, out, funcs);
+            ob_lit(out, "; ");
+            ob_puts(out, s->as.for_stmt.varName);
+            ob_lit(out, " <= ");
+            emit_expr(s->as.for_stmt.max, out, funcs);
+            ob_lit(out, "; ");
+            ob_puts(out, s->as.for_stmt.varName);
+            ob_lit(out, "++) ");
+            emit_stmt(s->as.for_stmt.body, out, indent, funcs);
             break;
 
         case BLOCK_S:
-            emit_indent(out, indent);
-            fprintf(out, "{\n");
+            ob_indent(out, indent);
+            ob_lit(out, "{\n");
             for (int i = 0; i < s->as.block_stmt.count; i++) {
-                emit_stmt(s->as.block_stmt.stmts[i], out, indent + 1, fstn);
+                emit_stmt(s->as.block_stmt.stmts[i], out, indent + 1, funcs);
             }
-            emit_indent(out, indent);
-            fprintf(out, "}\n");
+            ob_indent(out, indent);
+            ob_lit(out, "}\n");
             break;
 
         case EXPR_STMT_S:
-            emit_indent(out, indent);
-            emit_expr(s->as.expr_stmt, out, fstn);
-            fprintf(out, ";\n");
+            ob_indent(out, indent);
+            emit_expr(s->as.expr_stmt, out, funcs);
+            ob_lit(out, ";\n");
             break;
 
         case MATCH_S: {
+            Pattern** patterns = malloc(sizeof(Pattern*) * s->as.match_stmt.branchCount);
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) patterns[i] = s->as.match_stmt.branches[i].pattern;
+            MatchSwitch plan;
+            bool switched = match_switch_plan(s->as.match_stmt.var, patterns, s->as.match_stmt.branchCount, &plan);
+            free(patterns);
+
+            if (switched) {
+                emit_match_switch_open(&plan, s->as.match_stmt.var, out, indent, funcs);
+                for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                    if (!emit_match_case_open(&plan, i, out, funcs)) continue;
+                    MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                    for (int j = 0; j < branch->stmtCount; j++) {
+                        emit_stmt(branch->stmts[j], out, plan.indent + 1, funcs);
+                    }
+                    emit_match_case_close(&plan, out);
+                }
+                emit_match_switch_close(&plan, out);
+                break;
+            }
+
             int wildcardIdx = -1;
 
             for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
@@ -783,47 +1131,49 @@ void emit_stmt(Stmt* s, FILE* out, int indent, FuncSignToName* fstn) {
 
                 MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
 
-                emit_indent(out, indent);
+                ob_indent(out, indent);
                 if (firstCondition) {
-                    fprintf(out, "if (");
+                    ob_lit(out, "if (");
                     firstCondition = false;
                 } else {
-                    fprintf(out, "else if (");
+                    ob_lit(out, "else if (");
                 }
 
-                emit_pattern_condition(branch->pattern, s->as.match_stmt.var, out, fstn);
-                fprintf(out, ") {\n");
+                emit_pattern_condition(branch->pattern, s->as.match_stmt.var, out, funcs);
+                ob_lit(out, ") {\n");
 
                 if (branch->pattern->type == SOME_PATTERN) {
-                    emit_indent(out, indent + 1);
+                    ob_indent(out, indent + 1);
                     emit_type(branch->analyzed_type, out);
-                    fprintf(out, "* %s = ", branch->pattern->as.binding_name);
+                    ob_lit(out, "* ");
+                    ob_puts(out, branch->pattern->as.binding_name);
+                    ob_lit(out, " = ");
                     //emit just the variable name, not dereferenced
                     if (s->as.match_stmt.var->type == VAR_E) {
-                        fprintf(out, "%s", s->as.match_stmt.var->as.var.name);
+                        ob_puts(out, s->as.match_stmt.var->as.var.name);
                     } else {
-                        emit_expr(s->as.match_stmt.var, out, fstn);
+                        emit_expr(s->as.match_stmt.var, out, funcs);
                     }
-                    fprintf(out, ";\n");
+                    ob_lit(out, ";\n");
                 }
 
                 for (int j = 0; j < branch->stmtCount; j++) {
-                    emit_stmt(branch->stmts[j], out, indent + 1, fstn);
+                    emit_stmt(branch->stmts[j], out, indent + 1, funcs);
                 }
 
-                emit_indent(out, indent);
-                fprintf(out, "}\n");
+                ob_indent(out, indent);
+                ob_lit(out, "}\n");
             }
 
             if (wildcardIdx != -1) {
-                emit_indent(out, indent);
-                fprintf(out, "else {\n");
+                ob_indent(out, indent);
+                ob_lit(out, "else {\n");
                 MatchBranchStmt* branch = &s->as.match_stmt.branches[wildcardIdx];
                 for (int j = 0; j < branch->stmtCount; j++) {
-                    emit_stmt(branch->stmts[j], out, indent + 1, fstn);
+                    emit_stmt(branch->stmts[j], out, indent + 1, funcs);
                 }
-                emit_indent(out, indent);
-                fprintf(out, "}\n");
+                ob_indent(out, indent);
+                ob_lit(out, "}\n");
             }
 
             break;
@@ -834,22 +1184,50 @@ void emit_stmt(Stmt* s, FILE* out, int indent, FuncSignToName* fstn) {
             //we store element ownership info via the analyzed symbol
             //the codegen needs to check the symbol table, so we pass it via free_stmt
             if (s->as.free_stmt.isArrayOfOwned) {
-                emit_indent(out, indent);
-                fprintf(out, "for (int _i = 0; _i < %d; _i++) {\n", s->as.free_stmt.arraySize);
-                emit_indent(out, indent + 1);
-                fprintf(out, "free(%s[_i]);\n", s->as.free_stmt.varName);
-                emit_indent(out, indent);
-                fprintf(out, "}\n");
+                ob_indent(out, indent);
+                ob_lit(out, "for (int _i = 0; _i < ");
+                ob_int(out, s->as.free_stmt.arraySize);
+                ob_lit(out, "; _i++) {\n");
+                ob_indent(out, indent + 1);
+                ob_lit(out, "free(");
+                ob_puts(out, s->as.free_stmt.varName);
+                ob_lit(out, "[_i]);\n");
+                ob_indent(out, indent);
+                ob_lit(out, "}\n");
             }
-            emit_indent(out, indent);
-            fprintf(out, "free(%s);\n", s->as.free_stmt.varName);
+            ob_indent(out, indent);
+            ob_lit(out, "free(");
+            ob_puts(out, s->as.free_stmt.varName);
+            ob_lit(out, ");\n");
             break;
         }
     }
 }
 
+//where one function body ended up in its workers buffer
+typedef struct {
+    int worker;
+    size_t start;
+    size_t end;
+} FuncSpan;
+
+typedef struct {
+    Func** funcs;
+    FuncTable* table;
+    OutBuf* bufs;       //one per worker
+    FuncSpan* spans;    //one per function
+} EmitJob;
+
+static void emit_task(void* ctx, int worker, int index) {
+    EmitJob* job = ctx;
+    OutBuf* out = &job->bufs[worker];
+    size_t start = out->len;
+    emit_func(job->funcs[index], out, job->table);
+    job->spans[index] = (FuncSpan){worker, start, out->len};
+}
+
 //main codegen entry point
-void generate_code(Program* prog, FILE* output) {
+void generate_code(Program* prog, OutBuf* output) {
     stage_trace(STAGE_CODEGEN, "generate_code called with prog=%p, output=%p", prog, output);
 
     if (!prog) {
@@ -862,15 +1240,17 @@ void generate_code(Program* prog, FILE* output) {
     stage_trace(STAGE_CODEGEN, "prog->func_count=%d", prog->func_count);
 
     //emit C headers
-    fprintf(output, "#include <stdio.h>\n");
-    fprintf(output, "#include <stdlib.h>\n");
-    fprintf(output, "#include <stdint.h>\n");
-    fprintf(output, "#include <stdbool.h>\n");
-    fprintf(output, "#include <string.h>\n");
+    ob_lit(output, "#include <stdio.h>\n");
+    ob_lit(output, "#include <stdlib.h>\n");
+    ob_lit(output, "#include <stdint.h>\n");
+    ob_lit(output, "#include <stdbool.h>\n");
+    ob_lit(output, "#include <string.h>\n");
 
     //emit extern includes
     for(int i = 0; i < prog->ext_block_count; ++i) {
-        fprintf(output, "#include <%s>\n", prog->externBlocks[i]->header);
+        ob_lit(output, "#include <");
+        ob_puts(output, prog->externBlocks[i]->header);
+        ob_lit(output, ">\n");
     }
 
     //add platform-specific headers for read_key if needed
@@ -878,31 +1258,31 @@ void generate_code(Program* prog, FILE* output) {
         bool need_read_key = false;
         for (int i = 0; i < prog->imports->import_count; i++) {
             IncludeStmt* import = prog->imports->imports[i];
-            if (import->type == IMPORT_ALL && strcmp(import->module_name, "std.io") == 0) {
+            if (import->type == IMPORT_ALL && is_known_name(import->module_name, NAME_STD_IO)) {
                 need_read_key = true;
                 break;
-            } else if (import->type == IMPORT_SPECIFIC && strcmp(import->function_name, "read_key") == 0) {
+            } else if (import->type == IMPORT_SPECIFIC && is_known_name(import->function_name, NAME_READ_KEY)) {
                 need_read_key = true;
                 break;
             }
         }
         if (need_read_key) {
-            fprintf(output, "#ifdef _WIN32\n");
-            fprintf(output, "#include <conio.h>\n");
-            fprintf(output, "#else\n");
-            fprintf(output, "#include <termios.h>\n");
-            fprintf(output, "#include <unistd.h>\n");
-            fprintf(output, "#endif\n");
+            ob_lit(output, "#ifdef _WIN32\n");
+            ob_lit(output, "#include <conio.h>\n");
+            ob_lit(output, "#else\n");
+            ob_lit(output, "#include <termios.h>\n");
+            ob_lit(output, "#include <unistd.h>\n");
+            ob_lit(output, "#endif\n");
         }
     }
 
-    fprintf(output, "\n");
+    ob_lit(output, "\n");
 
     stage_trace(STAGE_CODEGEN, "headers written, checking imports");
 
     //generate C helper functions based on imports
     if (prog->imports && prog->imports->import_count > 0) {
-        fprintf(output, "//std.io helper functions\n");
+        ob_lit(output, "//std.io helper functions\n");
 
         //check which functions are imported
         bool has_wildcard = false;
@@ -916,132 +1296,125 @@ void generate_code(Program* prog, FILE* output) {
 
         for (int i = 0; i < prog->imports->import_count; i++) {
             IncludeStmt* import = prog->imports->imports[i];
-            if (import->type == IMPORT_ALL && strcmp(import->module_name, "std.io") == 0) {
+            if (import->type == IMPORT_ALL && is_known_name(import->module_name, NAME_STD_IO)) {
                 has_wildcard = true;
                 break;
             } else if (import->type == IMPORT_SPECIFIC) {
-                if (strcmp(import->function_name, "read_int") == 0) need_read_int = true;
-                else if (strcmp(import->function_name, "read_str") == 0) need_read_str = true;
-                else if (strcmp(import->function_name, "read_bool") == 0) need_read_bool = true;
-                else if (strcmp(import->function_name, "read_char") == 0) need_read_char = true;
-                else if (strcmp(import->function_name, "read_float") == 0) need_read_float = true;
-                else if (strcmp(import->function_name, "read_double") == 0) need_read_double = true;
-                else if (strcmp(import->function_name, "read_key") == 0) need_read_key = true;
+                switch (known_name(import->function_name)) {
+                    case NAME_READ_INT: need_read_int = true; break;
+                    case NAME_READ_STR: need_read_str = true; break;
+                    case NAME_READ_BOOL: need_read_bool = true; break;
+                    case NAME_READ_CHAR: need_read_char = true; break;
+                    case NAME_READ_FLOAT: need_read_float = true; break;
+                    case NAME_READ_DOUBLE: need_read_double = true; break;
+                    case NAME_READ_KEY: need_read_key = true; break;
+                    default: break;
+                }
             }
         }
 
         //generate read_int
         if (has_wildcard || need_read_int) {
-            fprintf(output, "int* read_int() {\n");
-            fprintf(output, "    char buffer[256];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    int* result = malloc(sizeof(int));\n");
-            fprintf(output, "    *result = atoll(buffer);\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "int* read_int() {\n");
+            ob_lit(output, "    char buffer[256];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    int* result = malloc(sizeof(int));\n");
+            ob_lit(output, "    *result = atoll(buffer);\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_str
         if (has_wildcard || need_read_str) {
-            fprintf(output, "char** read_str() {\n");
-            fprintf(output, "    char buffer[1024];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    //remove trailing newline\n");
-            fprintf(output, "    size_t len = strlen(buffer);\n");
-            fprintf(output, "    if (len > 0 && buffer[len-1] == '\\n') buffer[len-1] = '\\0';\n");
-            fprintf(output, "    char** result = malloc(sizeof(char*));\n");
-            fprintf(output, "#ifdef _WIN32\n");
-            fprintf(output, "    *result = _strdup(buffer);\n");
-            fprintf(output, "#else\n");
-            fprintf(output, "    *result = strdup(buffer);\n");
-            fprintf(output, "#endif\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "char** read_str() {\n");
+            ob_lit(output, "    char buffer[1024];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    //remove trailing newline\n");
+            ob_lit(output, "    size_t len = strlen(buffer);\n");
+            ob_lit(output, "    if (len > 0 && buffer[len-1] == '\\n') buffer[len-1] = '\\0';\n");
+            ob_lit(output, "    char** result = malloc(sizeof(char*));\n");
+            ob_lit(output, "#ifdef _WIN32\n");
+            ob_lit(output, "    *result = _strdup(buffer);\n");
+            ob_lit(output, "#else\n");
+            ob_lit(output, "    *result = strdup(buffer);\n");
+            ob_lit(output, "#endif\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_bool
         if (has_wildcard || need_read_bool) {
-            fprintf(output, "bool* read_bool() {\n");
-            fprintf(output, "    char buffer[256];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    bool* result = malloc(sizeof(bool));\n");
-            fprintf(output, "    if (strncmp(buffer, \"true\", 4) == 0 || strncmp(buffer, \"1\", 1) == 0) {\n");
-            fprintf(output, "        *result = true;\n");
-            fprintf(output, "    } else if (strncmp(buffer, \"false\", 5) == 0 || strncmp(buffer, \"0\", 1) == 0) {\n");
-            fprintf(output, "        *result = false;\n");
-            fprintf(output, "    } else {\n");
-            fprintf(output, "        free(result);\n");
-            fprintf(output, "        return NULL;\n");
-            fprintf(output, "    }\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "bool* read_bool() {\n");
+            ob_lit(output, "    char buffer[256];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    bool* result = malloc(sizeof(bool));\n");
+            ob_lit(output, "    if (strncmp(buffer, \"true\", 4) == 0 || strncmp(buffer, \"1\", 1) == 0) {\n");
+            ob_lit(output, "        *result = true;\n");
+            ob_lit(output, "    } else if (strncmp(buffer, \"false\", 5) == 0 || strncmp(buffer, \"0\", 1) == 0) {\n");
+            ob_lit(output, "        *result = false;\n");
+            ob_lit(output, "    } else {\n");
+            ob_lit(output, "        free(result);\n");
+            ob_lit(output, "        return NULL;\n");
+            ob_lit(output, "    }\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_char
         if (has_wildcard || need_read_char) {
-            fprintf(output, "char* read_char() {\n");
-            fprintf(output, "    char buffer[256];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    if (buffer[0] == '\\0' || buffer[0] == '\\n') return NULL;\n");
-            fprintf(output, "    char* result = malloc(sizeof(char));\n");
-            fprintf(output, "    *result = buffer[0];\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "char* read_char() {\n");
+            ob_lit(output, "    char buffer[256];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    if (buffer[0] == '\\0' || buffer[0] == '\\n') return NULL;\n");
+            ob_lit(output, "    char* result = malloc(sizeof(char));\n");
+            ob_lit(output, "    *result = buffer[0];\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_float
         if (has_wildcard || need_read_float) {
-            fprintf(output, "float* read_float() {\n");
-            fprintf(output, "    char buffer[256];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    float* result = malloc(sizeof(float));\n");
-            fprintf(output, "    *result = strtof(buffer, NULL);\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "float* read_float() {\n");
+            ob_lit(output, "    char buffer[256];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    float* result = malloc(sizeof(float));\n");
+            ob_lit(output, "    *result = strtof(buffer, NULL);\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_double
         if (has_wildcard || need_read_double) {
-            fprintf(output, "double* read_double() {\n");
-            fprintf(output, "    char buffer[256];\n");
-            fprintf(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
-            fprintf(output, "    double* result = malloc(sizeof(double));\n");
-            fprintf(output, "    *result = strtod(buffer, NULL);\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "double* read_double() {\n");
+            ob_lit(output, "    char buffer[256];\n");
+            ob_lit(output, "    if (fgets(buffer, sizeof(buffer), stdin) == NULL) return NULL;\n");
+            ob_lit(output, "    double* result = malloc(sizeof(double));\n");
+            ob_lit(output, "    *result = strtod(buffer, NULL);\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
 
         //generate read_key (tbh no idea how this works but oh well, not all code needs to be mine :D)
         if (has_wildcard || need_read_key) {
-            fprintf(output, "char* read_key() {\n");
-            fprintf(output, "    char* result = malloc(sizeof(char));\n");
-            fprintf(output, "#ifdef _WIN32\n");
-            fprintf(output, "    *result = _getch();\n");
-            fprintf(output, "#else\n");
-            fprintf(output, "    struct termios oldt, newt;\n");
-            fprintf(output, "    tcgetattr(STDIN_FILENO, &oldt);\n");
-            fprintf(output, "    newt = oldt;\n");
-            fprintf(output, "    newt.c_lflag &= ~(ICANON | ECHO);\n");
-            fprintf(output, "    tcsetattr(STDIN_FILENO, TCSANOW, &newt);\n");
-            fprintf(output, "    *result = getchar();\n");
-            fprintf(output, "    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);\n");
-            fprintf(output, "#endif\n");
-            fprintf(output, "    return result;\n");
-            fprintf(output, "}\n\n");
+            ob_lit(output, "char* read_key() {\n");
+            ob_lit(output, "    char* result = malloc(sizeof(char));\n");
+            ob_lit(output, "#ifdef _WIN32\n");
+            ob_lit(output, "    *result = _getch();\n");
+            ob_lit(output, "#else\n");
+            ob_lit(output, "    struct termios oldt, newt;\n");
+            ob_lit(output, "    tcgetattr(STDIN_FILENO, &oldt);\n");
+            ob_lit(output, "    newt = oldt;\n");
+            ob_lit(output, "    newt.c_lflag &= ~(ICANON | ECHO);\n");
+            ob_lit(output, "    tcsetattr(STDIN_FILENO, TCSANOW, &newt);\n");
+            ob_lit(output, "    *result = getchar();\n");
+            ob_lit(output, "    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);\n");
+            ob_lit(output, "#endif\n");
+            ob_lit(output, "    return result;\n");
+            ob_lit(output, "}\n\n");
         }
     }
 
-    stage_trace(STAGE_CODEGEN, "imports processed, allocating FuncSignToName");
-
-    FuncSignToName* fstn = malloc(sizeof(FuncSignToName));
-    fstn->count = 0;
-    fstn->height = 2;
-    fstn->elements = malloc(sizeof(FuncSignToNameElement) * fstn->height);
-
-    FuncNameCounter* fnc = malloc(sizeof(FuncNameCounter));
-    fnc->count = 0;
-    fnc->height = 2;
-    fnc->elements = malloc(sizeof(FuncSignToNameElement) * fnc->height);
+    FuncTable* funcs = prog->func_table;
 
     Func** program = prog->functions;
     int count = prog->func_count;
@@ -1050,20 +1423,41 @@ void generate_code(Program* prog, FILE* output) {
 
     for (int i = 0; i < count; ++i) {
         stage_trace(STAGE_CODEGEN, "emitting decl for function %d", i);
-        emit_func_decl(program[i], output, fnc, fstn);
+        emit_func_decl(program[i], output);
     }
 
     stage_trace(STAGE_CODEGEN, "emitting %d function definitions", count);
 
-    for (int i = 0; i < count; ++i) {
-        stage_trace(STAGE_CODEGEN, "emitting function %d", i);
-        emit_func(program[i], output, fstn);
-    }
+    //bodies only read the AST and the table from here on, c_name included once every signature has one.
+    //trace output would interleave, keep it on one thread
+    for (int i = 0; i < funcs->count; ++i) func_c_name(funcs->signs[i]);
+
+    int jobs = g_jobs;
+    if (jobs > count) jobs = count;
+    if (jobs < 1 || trace_on(STAGE_CODEGEN)) jobs = 1;
 
-    stage_trace(STAGE_CODEGEN, "all functions emitted, cleaning up");
+    if (jobs == 1) {
+        for (int i = 0; i < count; ++i) {
+            stage_trace(STAGE_CODEGEN, "emitting function %d", i);
+            emit_func(program[i], output, funcs);
+        }
+    } else {
+        OutBuf* bufs = calloc(jobs, sizeof(OutBuf));
+        FuncSpan* spans = calloc(count, sizeof(FuncSpan));
+        for (int w = 0; w < jobs; w++) ob_init(&bufs[w], 0);
+
+        EmitJob job = {program, funcs, bufs, spans};
+        pool_run(jobs, count, emit_task, &job);
+
+        //stitch together in source order, the result is byte for byte what one thread writes
+        for (int i = 0; i < count; ++i) {
+            ob_write(output, bufs[spans[i].worker].data + spans[i].start, spans[i].end - spans[i].start);
+        }
+
+        for (int w = 0; w < jobs; w++) ob_free(&bufs[w]);
+        free(bufs);
+        free(spans);
+    }
 
-    free(fstn->elements);
-    free(fstn);
-    free(fnc->elements);
-    free(fnc);
+    stage_trace(STAGE_CODEGEN, "all functions emitted");
 }
\ No newline at end of file
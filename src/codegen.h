@@ -5,37 +5,29 @@
 
 #include "common.h"
 #include "parser.h"
+#include "func_table.h"
+#include "outbuf.h"
 
-typedef struct {
-    char* name;
-    int count;
-} FuncNameCounterElement;
-typedef struct {
-    FuncNameCounterElement* elements;
-    int height;
-    int count;
-} FuncNameCounter;
-
-typedef struct {
-    FuncSign* sign;
-    char* name;
-} FuncSignToNameElement;
-typedef struct {
-    FuncSignToNameElement* elements;
-    int height;
-    int count;
-} FuncSignToName;
-
-void generate_code(Program* program, FILE* output);
+void generate_code(Program* program, OutBuf* output);
 void generate_assembly(Func** program, int count, FILE* output);
 
-void emit_expr(Expr* e, FILE* out, FuncSignToName*);
-void emit_stmt(Stmt* s, FILE* out, int indent_level, FuncSignToName*);
-void emit_indent(FILE* out, int level);
-void emit_func(Func* f, FILE* out, FuncSignToName*);
-void emit_func_decl(Func* f, FILE* out, FuncNameCounter*, FuncSignToName*);
-void emit_assign_expr_to_var(Expr* e, const char* targetVar, Ownership, FILE* out, int indent, FuncSignToName*);
+void emit_expr(Expr* e, OutBuf* out, FuncTable*);
+void emit_stmt(Stmt* s, OutBuf* out, int indent_level, FuncTable*);
+void emit_func(Func* f, OutBuf* out, FuncTable*);
+void emit_func_decl(Func* f, OutBuf* out);
+void emit_assign_expr_to_var(Expr* e, const char* targetVar, Ownership, OutBuf* out, int indent, FuncTable*);
 
 char* type_to_c_type(TokenType t);
+char* func_c_name(FuncSign* sign);
+const char* c_binary_op(TokenType op);
+//ops emitted as (int)((unsigned)left op right), signed overflow is undefined in c
+bool c_binary_wraps(TokenType op);
+
+//printf("<formats>\n" for a print() call, the caller adds the arguments and the closing paren
+void emit_print_format(Expr* call, OutBuf* out);
+
+//body of a function that lowered to ir, braces included (see codegen_ir.c)
+struct IrFunc;
+void emit_ir_body(struct IrFunc* ir, OutBuf* out, FuncTable*);
 
 #endif //lYNC_CODEGEN_H
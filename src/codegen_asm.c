@@ -19,7 +19,7 @@ void generate_assembly(Func** program, int count, FILE* out) {
         Func* f = program[i];
 
         //function label
-        if (strcmp(f->signature->name, "main") == 0) {
+        if (is_known_name(f->signature->name, NAME_MAIN)) {
             fprintf(out, "_main:\n");
         } else {
             fprintf(out, "_%s:\n", f->signature->name);
@@ -34,7 +34,7 @@ void generate_assembly(Func** program, int count, FILE* out) {
         //haha dont think i will soon
 
         //default implementation - just return 0 for main
-        if (strcmp(f->signature->name, "main") == 0) {
+        if (is_known_name(f->signature->name, NAME_MAIN)) {
             fprintf(out, "\tmovl $0, %%eax\n");
         }
 
@@ -0,0 +1,206 @@
+//created by bucka on 10/16/2026.
+
+#include "codegen.h"
+#include "ir.h"
+#include "intern.h"
+
+//c for a function body that lowered to ir: every value becomes a local, blocks become labels and the
+//control flow becomes gotos. the c compiler turns it back into registers, so no effort goes into making it pretty
+
+bool g_via_ir = false;
+
+static void emit_operand(IrValue* v, OutBuf* out, FuncTable* funcs) {
+    switch (v->opcode) {
+        case IR_CONST: emit_expr(v->ast, out, funcs); break;
+        case IR_PARAM: ob_puts(out, v->name); break;
+        case IR_UNDEF: ob_lit(out, "0"); break;
+        default: ob_printf(out, "__v%d", v->id); break;
+    }
+}
+
+static void emit_call(IrValue* v, OutBuf* out, FuncTable* funcs) {
+    Expr* call = v->ast;
+    if (!v->callee && is_known_name(call->as.func_call.name, NAME_PRINT)) {
+        emit_print_format(call, out);
+        for (int i = 0; i < v->argc; i++) {
+            ob_lit(out, ", ");
+            if (call->as.func_call.params[i]->analyzedType == BOOL_KEYWORD_T) {
+                ob_lit(out, "(");
+                emit_operand(v->args[i], out, funcs);
+                ob_lit(out, " ? \"true\" : \"false\")");
+            } else {
+                emit_operand(v->args[i], out, funcs);
+            }
+        }
+        ob_lit(out, ")");
+        return;
+    }
+
+    ob_puts(out, v->callee ? func_c_name(v->callee) : "strlen");
+    ob_lit(out, "(");
+    for (int i = 0; i < v->argc; i++) {
+        if (i > 0) ob_lit(out, ", ");
+        emit_operand(v->args[i], out, funcs);
+    }
+    ob_lit(out, ")");
+}
+
+static void emit_inst(IrValue* v, OutBuf* out, FuncTable* funcs) {
+    ob_indent(out, 1);
+    if (v->type != VOID_KEYWORD_T) ob_printf(out, "__v%d = ", v->id);
+
+    switch (v->opcode) {
+        case IR_UNOP:
+            //parenthesized, a negative literal operand would otherwise turn into --
+            ob_puts(out, v->op == MINUS_T ? "-(" : "!(");
+            emit_operand(v->args[0], out, funcs);
+            ob_lit(out, ")");
+            break;
+        case IR_BINOP:
+            //as in emit_expr, shifts left and wrapping steps go through unsigned
+            if (c_binary_wraps(v->op)) ob_lit(out, "(int)((unsigned)");
+            emit_operand(v->args[0], out, funcs);
+            ob_puts(out, c_binary_op(v->op));
+            emit_operand(v->args[1], out, funcs);
+            if (c_binary_wraps(v->op)) ob_lit(out, ")");
+            break;
+        case IR_CAST:
+            ob_printf(out, "(%s)", type_to_c_type(v->type));
+            emit_operand(v->args[0], out, funcs);
+            break;
+        case IR_INDEX:
+            emit_operand(v->args[0], out, funcs);
+            ob_lit(out, "[");
+            emit_operand(v->args[1], out, funcs);
+            ob_lit(out, "]");
+            break;
+        case IR_CALL:
+            emit_call(v, out, funcs);
+            break;
+        default:
+            break;
+    }
+    ob_lit(out, ";\n");
+}
+
+//a predecessor hands its phi arguments over in __v<phi>_in, the phi reads them when its block starts.
+//so all phis of a block see the values from before the edge, even when one feeds another
+static void emit_phi_copies(IrBlock* from, IrBlock* to, OutBuf* out, FuncTable* funcs) {
+    int index = ir_pred_index(to, from);
+    for (int i = 0; i < to->count && to->insts[i]->opcode == IR_PHI; i++) {
+        IrValue* phi = to->insts[i];
+        ob_indent(out, 1);
+        ob_printf(out, "__v%d_in = ", phi->id);
+        emit_operand(phi->args[index], out, funcs);
+        ob_lit(out, ";\n");
+    }
+}
+
+static void emit_goto(IrBlock* target, OutBuf* out) {
+    ob_printf(out, "goto __bb%d;\n", target->id);
+}
+
+void emit_ir_body(IrFunc* ir, OutBuf* out, FuncTable* funcs) {
+    bool is_main = is_known_name(ir->func->signature->name, NAME_MAIN);
+    ob_lit(out, "{\n");
+
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        for (int j = 0; j < b->count; j++) {
+            IrValue* v = b->insts[j];
+            if (v->type == VOID_KEYWORD_T) continue;
+            ob_indent(out, 1);
+            ob_printf(out, "%s __v%d;\n", type_to_c_type(v->type), v->id);
+            if (v->opcode == IR_PHI) {
+                ob_indent(out, 1);
+                ob_printf(out, "%s __v%d_in;\n", type_to_c_type(v->type), v->id);
+            }
+        }
+    }
+
+    //blocks are laid out in order, only a block something jumps to (rather than falls into) needs a label
+    //block_count is never negative, the check lets the compiler see that too. not g_arena, bodies are emitted in parallel
+    size_t block_count = ir->block_count > 0 ? (size_t)ir->block_count : 0;
+    bool* labeled = calloc(block_count ? block_count : 1, sizeof(bool));
+    if (!labeled) {
+        fprintf(stderr, "out of memory (labels for %zu blocks)\n", block_count);
+        exit(1);
+    }
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        IrBlock* next = i + 1 < ir->block_count ? ir->blocks[i + 1] : nullptr;
+        if (b->term == IR_JUMP && b->succs[0] != next) {
+            labeled[b->succs[0]->id] = true;
+        } else if (b->term == IR_BRANCH) {
+            if (b->succs[1] != next) labeled[b->succs[1]->id] = true;
+            if (b->succs[0] != next || b->succs[1] == next) labeled[b->succs[0]->id] = true;
+        }
+    }
+
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        IrBlock* next = i + 1 < ir->block_count ? ir->blocks[i + 1] : nullptr;
+
+        if (labeled[b->id]) ob_printf(out, "__bb%d:\n", b->id);
+        for (int j = 0; j < b->count; j++) {
+            IrValue* v = b->insts[j];
+            if (v->opcode == IR_PHI) {
+                ob_indent(out, 1);
+                ob_printf(out, "__v%d = __v%d_in;\n", v->id, v->id);
+            } else {
+                emit_inst(v, out, funcs);
+            }
+        }
+
+        switch (b->term) {
+            case IR_JUMP:
+                emit_phi_copies(b, b->succs[0], out, funcs);
+                if (b->succs[0] != next) {
+                    ob_indent(out, 1);
+                    emit_goto(b->succs[0], out);
+                }
+                break;
+            case IR_BRANCH:
+                emit_phi_copies(b, b->succs[0], out, funcs);
+                emit_phi_copies(b, b->succs[1], out, funcs);
+                ob_indent(out, 1);
+                if (b->succs[1] == next) {
+                    ob_lit(out, "if (");
+                    emit_operand(b->value, out, funcs);
+                    ob_lit(out, ") ");
+                    emit_goto(b->succs[0], out);
+                } else if (b->succs[0] == next) {
+                    ob_lit(out, "if (!");
+                    emit_operand(b->value, out, funcs);
+                    ob_lit(out, ") ");
+                    emit_goto(b->succs[1], out);
+                } else {
+                    ob_lit(out, "if (");
+                    emit_operand(b->value, out, funcs);
+                    ob_lit(out, ") ");
+                    emit_goto(b->succs[0], out);
+                    ob_indent(out, 1);
+                    emit_goto(b->succs[1], out);
+                }
+                break;
+            case IR_RETURN:
+                ob_indent(out, 1);
+                if (b->value) {
+                    ob_lit(out, "return ");
+                    emit_operand(b->value, out, funcs);
+                    ob_lit(out, ";\n");
+                } else if (is_main || ir->func->signature->retType != VOID_KEYWORD_T) {
+                    //fell off the end of a function with a result, main gets the 0 c gives it
+                    ob_lit(out, "return 0;\n");
+                } else {
+                    ob_lit(out, "return;\n");
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    free(labeled);
+    ob_lit(out, "}\n");
+}
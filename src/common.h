@@ -15,6 +15,30 @@
 #define nullptr NULL
 #endif
 
+//trace call sites compile away completely when this is 0. follows NDEBUG unless set explicitly,
+//so release builds carry no tracing at all
+#ifndef LYNC_ENABLE_TRACE
+#ifdef NDEBUG
+#define LYNC_ENABLE_TRACE 0
+#else
+#define LYNC_ENABLE_TRACE 1
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define LYNC_THREAD_LOCAL __declspec(thread)
+#else
+#define LYNC_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LYNC_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define LYNC_COLD __attribute__((cold, noinline))
+#else
+#define LYNC_UNLIKELY(x) (x)
+#define LYNC_COLD
+#endif
+
 typedef enum {
     STAGE_LEXER,
     STAGE_PARSER,
@@ -42,9 +66,13 @@ typedef struct {
     const char* filename;
 } SourceLocation;
 
-extern ErrorCollector* g_error_collector;
-extern bool g_trace_mode;
-extern int g_trace_depth;
+//per thread, so worker threads can collect into their own (see analyze_program)
+extern LYNC_THREAD_LOCAL ErrorCollector* g_error_collector;
+extern unsigned g_trace_mask;     //one bit per ErrorStage, see trace_on
+extern LYNC_THREAD_LOCAL int g_trace_depth;
+
+#define TRACE_STAGE_BIT(stage) (1u << (stage))
+#define TRACE_ALL ((1u << (STAGE_INTERNAL + 1)) - 1)
 
 void add_error(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, ...);
 void vadd_error(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, va_list args);
@@ -78,22 +106,28 @@ static inline void _stage_error_helper(ErrorCollector* ec, ErrorStage stage, Sou
 #define stage_note(stage, loc, fmt, ...) \
     add_note(g_error_collector, stage, loc, fmt, ##__VA_ARGS__)
 
+//whether trace output for stage is wanted. a constant false without LYNC_ENABLE_TRACE, which lets the
+//compiler drop the call sites and their arguments, otherwise one load and a branch predicted not taken
+#if LYNC_ENABLE_TRACE
+#define trace_on(stage) LYNC_UNLIKELY(g_trace_mask & TRACE_STAGE_BIT(stage))
+#else
+#define trace_on(stage) false
+#endif
+
+//the formatting lives out of line so a disabled call site is only the trace_on test
+LYNC_COLD void trace_emit(ErrorStage stage, const char* fmt, ...);
+
 #define stage_trace(stage, fmt, ...) do { \
-    if (g_trace_mode) { \
-        for (int _i = 0; _i < g_trace_depth; _i++) fprintf(stderr, "  "); \
-        fprintf(stderr, "[%s:trace] ", stage_name(stage)); \
-        fprintf(stderr, fmt, ##__VA_ARGS__); \
-        fprintf(stderr, "\n"); \
-    } \
+    if (trace_on(stage)) trace_emit(stage, fmt, ##__VA_ARGS__); \
 } while(0)
 
 #define stage_trace_enter(stage, fmt, ...) do { \
     stage_trace(stage, fmt, ##__VA_ARGS__); \
-    g_trace_depth++; \
+    if (LYNC_ENABLE_TRACE) g_trace_depth++; \
 } while(0)
 
 #define stage_trace_exit(stage, fmt, ...) do { \
-    if (g_trace_depth > 0) g_trace_depth--; \
+    if (LYNC_ENABLE_TRACE && g_trace_depth > 0) g_trace_depth--; \
     stage_trace(stage, fmt, ##__VA_ARGS__); \
 } while(0)
 
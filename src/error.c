@@ -88,6 +88,28 @@ static void add_message(ErrorCollector* ec, MessageSeverity severity, ErrorStage
     }
 }
 
+void error_collector_take(ErrorCollector* dst, ErrorCollector* src, int from, int to) {
+    if (dst == NULL || src == NULL) return;
+
+    for (int i = from; i < to; i++) {
+        if (dst->count >= dst->capacity) {
+            dst->capacity *= 2;
+            dst->messages = realloc(dst->messages, sizeof(CompilerMessage) * dst->capacity);
+        }
+        CompilerMessage* msg = &src->messages[i];
+        dst->messages[dst->count++] = *msg;
+        msg->message = NULL;
+
+        if (msg->severity == MSG_ERROR) {
+            dst->error_count++;
+        } else if (msg->severity == MSG_WARNING) {
+            dst->warning_count++;
+        } else {
+            dst->note_count++;
+        }
+    }
+}
+
 void add_error(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
@@ -113,6 +135,16 @@ void add_note(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const ch
     va_end(args);
 }
 
+void trace_emit(ErrorStage stage, const char* fmt, ...) {
+    for (int i = 0; i < g_trace_depth; i++) fprintf(stderr, "  ");
+    fprintf(stderr, "[%s:trace] ", stage_name(stage));
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+}
+
 bool has_errors(ErrorCollector* ec) {
     return ec != NULL && ec->error_count > 0;
 }
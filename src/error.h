@@ -33,6 +33,9 @@ struct ErrorCollector {
 ErrorCollector* init_error_collector();
 void free_error_collector(ErrorCollector* ec);
 
+//moves messages [from, to) of src to the end of dst in order, src no longer owns their text
+void error_collector_take(ErrorCollector* dst, ErrorCollector* src, int from, int to);
+
 void add_error(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, ...);
 void vadd_error(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, va_list args);
 void add_warning(ErrorCollector* ec, ErrorStage stage, SourceLocation loc, const char* fmt, ...);
@@ -3,12 +3,13 @@
 #include "file_loader.h"
 #include "lexer.h"
 #include "error.h"
+#include "source.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-// track already-loaded files to prevent circular includes
-static char* loaded_files[MAX_INCLUDE_DEPTH];
+// track already-loaded files to prevent circular includes (interned paths)
+static const char* loaded_files[MAX_INCLUDE_DEPTH];
 static int loaded_file_count = 0;
 
 // reset loaded files tracking (call before processing a new compilation)
@@ -18,8 +19,9 @@ static void reset_loaded_files() {
 
 // check if a file has already been loaded
 static bool is_file_loaded(const char* path) {
+    const char* interned = intern_cstr(path);
     for (int i = 0; i < loaded_file_count; i++) {
-        if (strcmp(loaded_files[i], path) == 0) return true;
+        if (loaded_files[i] == interned) return true;
     }
     return false;
 }
@@ -27,7 +29,7 @@ static bool is_file_loaded(const char* path) {
 // mark a file as loaded
 static void mark_file_loaded(const char* path) {
     if (loaded_file_count < MAX_INCLUDE_DEPTH) {
-        loaded_files[loaded_file_count++] = strdup(path);
+        loaded_files[loaded_file_count++] = intern_cstr(path);
     }
 }
 
@@ -88,33 +90,25 @@ Program* load_and_parse_file(const char* file_path, int depth) {
     }
 
     // read the file
-    FILE* file = fopen(file_path, "r");
-    if (!file) {
+    int file_id = source_load(file_path);
+    if (file_id < 0) {
         return nullptr; // caller will emit the error with location info
     }
 
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char* code = malloc(file_size + 1);
-    size_t bytes_read = fread(code, 1, file_size, file);
-    code[bytes_read] = '\0';
-    fclose(file);
-
     mark_file_loaded(file_path);
 
     // lex
+    arena_set_stage(&g_arena, STAGE_LEXER);
     int token_count;
-    Token* tokens = tokenize(code, &token_count, file_path);
+    Token* tokens = tokenize(file_id, &token_count);
 
     // check for lexer errors (theyre collected in the global error collector)
     if (has_errors(g_error_collector)) {
-        free(code);
         return nullptr;
     }
 
     // parse
+    arena_set_stage(&g_arena, STAGE_PARSER);
     Parser parser = {
         .tokens = tokens,
         .count = token_count,
@@ -124,7 +118,7 @@ Program* load_and_parse_file(const char* file_path, int depth) {
 
     Program* prog = parseProgram(&parser);
 
-    // dont free code — tokens reference it
+    // source text stays in the registry, tokens and locations reference it
     // process nested includes in this file too
     if (prog && prog->imports && prog->imports->import_count > 0) {
         char* dir = get_directory(file_path);
@@ -151,13 +145,13 @@ Program* load_and_parse_file(const char* file_path, int depth) {
                     should_include = true;
                 } else {
                     // iMPORT_SPECIFIC — only include matching function
-                    should_include = (strcmp(nested->functions[j]->signature->name, imp->function_name) == 0);
+                    should_include = nested->functions[j]->signature->name == imp->function_name;
                 }
 
                 if (should_include) {
                     // grow the functions array if needed
                     int new_count = prog->func_count + 1;
-                    prog->functions = realloc(prog->functions, sizeof(Func*) * new_count);
+                    prog->functions = arena_realloc(&g_arena, prog->functions, sizeof(Func*) * prog->func_count, sizeof(Func*) * new_count);
                     prog->functions[prog->func_count] = nested->functions[j];
                     prog->func_count = new_count;
                 }
@@ -167,7 +161,7 @@ Program* load_and_parse_file(const char* file_path, int depth) {
             if (imp->type == IMPORT_SPECIFIC) {
                 bool found = false;
                 for (int j = 0; j < nested->func_count; j++) {
-                    if (strcmp(nested->functions[j]->signature->name, imp->function_name) == 0) {
+                    if (nested->functions[j]->signature->name == imp->function_name) {
                         found = true;
                         break;
                     }
@@ -217,14 +211,14 @@ void process_file_includes(Program* prog, const char* source_file) {
             if (imp->type == IMPORT_ALL) {
                 should_include = true;
             } else {
-                should_include = (strcmp(included->functions[j]->signature->name, imp->function_name) == 0);
+                should_include = included->functions[j]->signature->name == imp->function_name;
             }
 
             if (should_include) {
                 // check for duplicate function (same name + param count already exists)
                 bool duplicate = false;
                 for (int k = 0; k < prog->func_count; k++) {
-                    if (strcmp(prog->functions[k]->signature->name, included->functions[j]->signature->name) == 0 &&
+                    if (prog->functions[k]->signature->name == included->functions[j]->signature->name &&
                         prog->functions[k]->signature->paramNum == included->functions[j]->signature->paramNum) {
                         stage_error(STAGE_PARSER, imp->loc,
                             "duplicate function '%s' — already defined or imported",
@@ -236,7 +230,7 @@ void process_file_includes(Program* prog, const char* source_file) {
 
                 if (!duplicate) {
                     int new_count = prog->func_count + 1;
-                    prog->functions = realloc(prog->functions, sizeof(Func*) * new_count);
+                    prog->functions = arena_realloc(&g_arena, prog->functions, sizeof(Func*) * prog->func_count, sizeof(Func*) * new_count);
                     prog->functions[prog->func_count] = included->functions[j];
                     prog->func_count = new_count;
                 }
@@ -247,7 +241,7 @@ void process_file_includes(Program* prog, const char* source_file) {
         if (imp->type == IMPORT_SPECIFIC) {
             bool found = false;
             for (int j = 0; j < included->func_count; j++) {
-                if (strcmp(included->functions[j]->signature->name, imp->function_name) == 0) {
+                if (included->functions[j]->signature->name == imp->function_name) {
                     found = true;
                     break;
                 }
@@ -0,0 +1,83 @@
+//created by bucka on 10/16/2026.
+
+#include "func_table.h"
+#include "arena.h"
+
+#define FUNC_TABLE_INITIAL 64
+
+FuncTable* make_funcTable() {
+    FuncTable* t = arena_alloc(&g_arena, sizeof(FuncTable));
+    t->bucket_capacity = FUNC_TABLE_INITIAL;
+    t->buckets = arena_alloc(&g_arena, sizeof(FuncBucket) * t->bucket_capacity);
+    t->capacity = 16;
+    t->signs = arena_alloc(&g_arena, sizeof(FuncSign*) * t->capacity);
+    return t;
+}
+
+static FuncBucket* find_bucket(FuncBucket* buckets, int capacity, const char* name, uint32_t hash) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t i = hash & mask;
+    while (buckets[i].name) {
+        if (buckets[i].name == name) return &buckets[i];
+        i = (i + 1) & mask;
+    }
+    return &buckets[i];
+}
+
+static void grow_buckets(FuncTable* t) {
+    int capacity = t->bucket_capacity * 2;
+    FuncBucket* buckets = arena_alloc(&g_arena, sizeof(FuncBucket) * capacity);
+    for (int i = 0; i < t->bucket_capacity; i++) {
+        if (!t->buckets[i].name) continue;
+        *find_bucket(buckets, capacity, t->buckets[i].name, t->buckets[i].hash) = t->buckets[i];
+    }
+    t->buckets = buckets;
+    t->bucket_capacity = capacity;
+}
+
+void func_table_add(FuncTable* t, FuncSign* sign) {
+    uint32_t hash = intern_hash(sign->name);
+    FuncBucket* b = find_bucket(t->buckets, t->bucket_capacity, sign->name, hash);
+    if (!b->name) {
+        if ((t->bucket_count + 1) * 10 > t->bucket_capacity * 7) {
+            grow_buckets(t);
+            b = find_bucket(t->buckets, t->bucket_capacity, sign->name, hash);
+        }
+        b->name = sign->name;
+        b->hash = hash;
+        t->bucket_count++;
+    }
+
+    if (b->count == b->capacity) {
+        int old = b->capacity;
+        b->capacity = old ? old * 2 : 2;
+        b->signs = arena_realloc(&g_arena, b->signs, sizeof(FuncSign*) * old, sizeof(FuncSign*) * b->capacity);
+    }
+    b->signs[b->count++] = sign;
+
+    if (t->count == t->capacity) {
+        t->capacity *= 2;
+        t->signs = arena_realloc(&g_arena, t->signs, sizeof(FuncSign*) * (t->capacity / 2), sizeof(FuncSign*) * t->capacity);
+    }
+    t->signs[t->count++] = sign;
+}
+
+FuncBucket* func_table_overloads(FuncTable* t, const char* name) {
+    FuncBucket* b = find_bucket(t->buckets, t->bucket_capacity, name, intern_hash(name));
+    return b->name ? b : nullptr;
+}
+
+FuncSign* lookup_func_sign(FuncTable* t, FuncSign* s) {
+    FuncBucket* b = func_table_overloads(t, s->name);
+    if (!b) return nullptr;
+    for (int i = 0; i < b->count; ++i) {
+        if (check_func_sign(b->signs[i], s))
+            return b->signs[i];
+    }
+    return nullptr;
+}
+
+FuncSign* lookup_func_name(FuncTable* t, char* name) {
+    FuncBucket* b = func_table_overloads(t, name);
+    return b ? b->signs[0] : nullptr;
+}
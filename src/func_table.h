@@ -0,0 +1,39 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_FUNC_TABLE_H
+#define LYNC_FUNC_TABLE_H
+
+#include "common.h"
+#include "parser.h"
+
+//every overload sharing one name, in definition order
+typedef struct {
+    const char* name;
+    uint32_t hash;
+    FuncSign** signs;
+    int count;
+    int capacity;
+} FuncBucket;
+
+//name keyed table of all known signatures, filled by the analyzer and read by codegen.
+//keys are interned names (see intern.h) and compared by pointer
+struct FuncTable {
+    FuncBucket* buckets;    //open addressing, power of two capacity
+    int bucket_capacity;
+    int bucket_count;
+
+    FuncSign** signs;       //every signature in definition order
+    int count;
+    int capacity;
+};
+
+FuncTable* make_funcTable();
+void func_table_add(FuncTable* t, FuncSign* sign);
+
+//all overloads of name, nullptr if there are none
+FuncBucket* func_table_overloads(FuncTable* t, const char* name);
+
+FuncSign* lookup_func_sign(FuncTable* t, FuncSign* s);
+FuncSign* lookup_func_name(FuncTable* t, char* name);
+
+#endif //LYNC_FUNC_TABLE_H
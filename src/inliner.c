@@ -0,0 +1,682 @@
+//created by bucka on 10/16/2026.
+
+#include "inliner.h"
+#include "arena.h"
+#include "intern.h"
+
+int g_inline_threshold = INLINE_DEFAULT_THRESHOLD;
+
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} IntList;
+
+struct InlineCtx {
+    Func** program;
+    int count;
+
+    //signature -> function index, resolved_sign of a call points at the callees signature
+    FuncSign** keys;
+    int* vals;
+    int key_capacity;   //power of two
+
+    IntList* callers;   //per function, who calls it (each caller once)
+    bool* candidate;    //small leaf with a single trailing return, see is_candidate
+    int* cost;
+    int next_site;      //numbers the renamed locals, __inl<N>_name
+};
+
+// ============ SMALL HELPERS ============
+
+static void int_list_add_unique(IntList* l, int v) {
+    for (int i = 0; i < l->count; i++) {
+        if (l->items[i] == v) return;
+    }
+    if (l->count == l->capacity) {
+        l->capacity = l->capacity ? l->capacity * 2 : 4;
+        l->items = realloc(l->items, sizeof(int) * l->capacity);
+    }
+    l->items[l->count++] = v;
+}
+
+static uint32_t ptr_hash(const void* p) {
+    uintptr_t x = (uintptr_t)p;
+    x ^= x >> 17;
+    x *= 0x9E3779B1u;
+    return (uint32_t)(x ^ (x >> 15));
+}
+
+static int func_index(InlineCtx* ctx, FuncSign* sign) {
+    if (!sign) return -1;
+    uint32_t mask = (uint32_t)ctx->key_capacity - 1;
+    for (uint32_t i = ptr_hash(sign) & mask; ctx->keys[i]; i = (i + 1) & mask) {
+        if (ctx->keys[i] == sign) return ctx->vals[i];
+    }
+    return -1;
+}
+
+static bool is_literal(Expr* e) {
+    switch (e->type) {
+        case INT_LIT_E: case BOOL_LIT_E: case STR_LIT_E:
+        case CHAR_LIT_E: case FLOAT_LIT_E: case NULL_LIT_E:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void count_stmt(Stmt* s, void* data) {
+    (void)s;
+    (*(int*)data)++;
+}
+
+static void count_expr(Expr* e, void* data) {
+    (void)e;
+    (*(int*)data)++;
+}
+
+int inline_cost(Func* f) {
+    int cost = 0;
+    walk_stmt(f->body, count_stmt, count_expr, &cost);
+    return cost;
+}
+
+// ============ CANDIDATES ============
+
+typedef struct {
+    InlineCtx* ctx;
+    int returns;
+    bool calls_lync;    //calls a function with a body (itself included)
+} BodyScan;
+
+static void scan_expr(Expr* e, void* data) {
+    BodyScan* scan = data;
+    if (e->type == FUNC_RET_E) scan->returns++;
+    if (e->type == FUNC_CALL_E && func_index(scan->ctx, e->as.func_call.resolved_sign) >= 0) scan->calls_lync = true;
+}
+
+//the return that ends the body, nullptr if the last statement is something else
+static Expr* tail_return(Func* f) {
+    if (f->body->type != BLOCK_S || f->body->as.block_stmt.count == 0) return nullptr;
+    Stmt* last = f->body->as.block_stmt.stmts[f->body->as.block_stmt.count - 1];
+    if (last && last->type == EXPR_STMT_S && last->as.expr_stmt && last->as.expr_stmt->type == FUNC_RET_E) {
+        return last->as.expr_stmt;
+    }
+    return nullptr;
+}
+
+//leaves only: a leaf can never reach itself, so inlining it always terminates, and a caller whose last
+//lync call got inlined becomes a leaf itself. the only return has to be the last statement, there is
+//no goto to jump out of the middle of an inlined body
+static bool is_candidate(InlineCtx* ctx, int i) {
+    Func* f = ctx->program[i];
+    if (is_known_name(f->signature->name, NAME_MAIN)) return false;
+    if (!f->body || f->body->type != BLOCK_S) return false;
+    if (ctx->cost[i] > g_inline_threshold) return false;
+
+    BodyScan scan = {ctx, 0, false};
+    walk_stmt(f->body, nullptr, scan_expr, &scan);
+    if (scan.calls_lync) return false;
+    return scan.returns == (tail_return(f) ? 1 : 0);
+}
+
+static void collect_callers(Expr* e, void* data) {
+    void** args = data;
+    InlineCtx* ctx = args[0];
+    int caller = *(int*)args[1];
+    if (e->type != FUNC_CALL_E) return;
+    int callee = func_index(ctx, e->as.func_call.resolved_sign);
+    if (callee >= 0) int_list_add_unique(&ctx->callers[callee], caller);
+}
+
+InlineCtx* inline_begin(Func** program, int count) {
+    InlineCtx* ctx = calloc(1, sizeof(InlineCtx));
+    ctx->program = program;
+    ctx->count = count;
+
+    ctx->key_capacity = 16;
+    while (ctx->key_capacity < count * 2) ctx->key_capacity *= 2;
+    ctx->keys = calloc(ctx->key_capacity, sizeof(FuncSign*));
+    ctx->vals = calloc(ctx->key_capacity, sizeof(int));
+    uint32_t mask = (uint32_t)ctx->key_capacity - 1;
+    for (int i = 0; i < count; i++) {
+        uint32_t slot = ptr_hash(program[i]->signature) & mask;
+        while (ctx->keys[slot]) slot = (slot + 1) & mask;
+        ctx->keys[slot] = program[i]->signature;
+        ctx->vals[slot] = i;
+    }
+
+    ctx->callers = calloc(count, sizeof(IntList));
+    ctx->candidate = calloc(count, sizeof(bool));
+    ctx->cost = calloc(count, sizeof(int));
+    for (int i = 0; i < count; i++) {
+        void* args[2] = {ctx, &i};
+        walk_stmt(program[i]->body, nullptr, collect_callers, args);
+        ctx->cost[i] = inline_cost(program[i]);
+    }
+    for (int i = 0; i < count; i++) ctx->candidate[i] = is_candidate(ctx, i);
+    return ctx;
+}
+
+void inline_end(InlineCtx* ctx) {
+    if (!ctx) return;
+    for (int i = 0; i < ctx->count; i++) free(ctx->callers[i].items);
+    free(ctx->callers);
+    free(ctx->candidate);
+    free(ctx->cost);
+    free(ctx->keys);
+    free(ctx->vals);
+    free(ctx);
+}
+
+bool inline_update(InlineCtx* ctx, int func) {
+    bool was = ctx->candidate[func];
+    ctx->cost[func] = inline_cost(ctx->program[func]);
+    ctx->candidate[func] = is_candidate(ctx, func);
+    return !was && ctx->candidate[func];
+}
+
+const int* inline_callers(InlineCtx* ctx, int func, int* count) {
+    *count = ctx->callers[func].count;
+    return ctx->callers[func].items;
+}
+
+// ============ RENAMING ============
+
+//what a callee name turns into at one call site
+typedef struct {
+    char* from;
+    Expr* to_expr;  //uses of a parameter become a copy of the argument
+    char* to_name;  //every other occurrence (declarations, a[i], assignments, free)
+} Rename;
+
+typedef struct {
+    Rename* items;
+    int count;
+    int capacity;
+    bool failed;    //a name ended up somewhere only a variable fits
+} RenameMap;
+
+static void rename_add(RenameMap* m, char* from, Expr* to_expr, char* to_name) {
+    for (int i = 0; i < m->count; i++) {
+        if (m->items[i].from == from) return; //a local declared twice (two loops over i) keeps one name
+    }
+    if (m->count == m->capacity) {
+        m->capacity = m->capacity ? m->capacity * 2 : 8;
+        m->items = realloc(m->items, sizeof(Rename) * m->capacity);
+    }
+    m->items[m->count++] = (Rename){from, to_expr, to_name};
+}
+
+static Rename* rename_find(RenameMap* m, char* name) {
+    for (int i = 0; i < m->count; i++) {
+        if (m->items[i].from == name) return &m->items[i];
+    }
+    return nullptr;
+}
+
+static void rename_name(RenameMap* m, char** name) {
+    Rename* r = rename_find(m, *name);
+    if (!r) return;
+    if (r->to_name) *name = r->to_name;
+    else m->failed = true;
+}
+
+static void rename_expr(Expr* e, void* data) {
+    RenameMap* m = data;
+    if (e->type == VAR_E) {
+        Rename* r = rename_find(m, e->as.var.name);
+        if (!r) return;
+        if (r->to_expr) {
+            *e = *clone_expr(r->to_expr);
+        } else {
+            e->as.var.name = r->to_name;
+        }
+    } else if (e->type == ARRAY_ACCESS_E) {
+        rename_name(m, &e->as.array_access.arrayName);
+    } else if (e->type == MATCH_E) {
+        for (int i = 0; i < e->as.match.branchCount; i++) {
+            Pattern* p = e->as.match.branches[i].pattern;
+            if (p && p->type == SOME_PATTERN) rename_name(m, &p->as.binding_name);
+        }
+    }
+}
+
+static void rename_stmt(Stmt* s, void* data) {
+    RenameMap* m = data;
+    switch (s->type) {
+        case VAR_DECL_S: rename_name(m, &s->as.var_decl.name); break;
+        case ASSIGN_S: rename_name(m, &s->as.var_assign.name); break;
+        case ARRAY_ELEM_ASSIGN_S: rename_name(m, &s->as.array_elem_assign.arrayName); break;
+        case FOR_S: rename_name(m, &s->as.for_stmt.varName); break;
+        case FREE_S: rename_name(m, &s->as.free_stmt.varName); break;
+        case MATCH_S:
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                Pattern* p = s->as.match_stmt.branches[i].pattern;
+                if (p && p->type == SOME_PATTERN) rename_name(m, &p->as.binding_name);
+            }
+            break;
+        default: break;
+    }
+}
+
+//how a callee uses one of its names
+typedef struct {
+    char* name;
+    bool named;     //used where only a variable fits: a[i], a[i] = x, free a
+    bool assigned;  //a = x
+} NameUse;
+
+static void use_expr(Expr* e, void* data) {
+    NameUse* u = data;
+    if (e->type == ARRAY_ACCESS_E && e->as.array_access.arrayName == u->name) u->named = true;
+}
+
+static void use_stmt(Stmt* s, void* data) {
+    NameUse* u = data;
+    if (s->type == ASSIGN_S && s->as.var_assign.name == u->name) u->assigned = true;
+    if (s->type == ARRAY_ELEM_ASSIGN_S && s->as.array_elem_assign.arrayName == u->name) u->named = true;
+    if (s->type == FREE_S && s->as.free_stmt.varName == u->name) u->named = true;
+}
+
+static NameUse name_use(Func* f, char* name) {
+    NameUse u = {.name = name};
+    walk_stmt(f->body, use_stmt, use_expr, &u);
+    return u;
+}
+
+//names are unique per call site, so nothing the callee declares can capture a name of the caller
+typedef struct {
+    int site;
+} FreshNames;
+
+static char* fresh_name(FreshNames* names, char* name) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "__inl%d_%s", names->site, name);
+    return intern_cstr(buffer);
+}
+
+typedef struct {
+    RenameMap* map;
+    FreshNames* names;
+} LocalCollect;
+
+//locals of the callee, everything it declares
+static void collect_local(Stmt* s, void* data) {
+    LocalCollect* lc = data;
+    char* name = nullptr;
+    if (s->type == VAR_DECL_S) name = s->as.var_decl.name;
+    else if (s->type == FOR_S) name = s->as.for_stmt.varName;
+    if (name) rename_add(lc->map, name, nullptr, fresh_name(lc->names, name));
+
+    if (s->type == MATCH_S) {
+        for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+            Pattern* p = s->as.match_stmt.branches[i].pattern;
+            if (p && p->type == SOME_PATTERN) rename_add(lc->map, p->as.binding_name, nullptr, fresh_name(lc->names, p->as.binding_name));
+        }
+    }
+}
+
+// ============ SITES ============
+
+//binding for the arguments of one call, the statements that have to run first go into pre
+typedef struct {
+    RenameMap map;
+    Stmt** pre;
+    int pre_count;
+} Binding;
+
+static void binding_free(Binding* b) {
+    free(b->map.items);
+    free(b->pre);
+}
+
+//statement sites can bind any argument to a fresh local, expression sites can only substitute, and only
+//variables and literals: a use on the right of && or || would make anything else run conditionally
+static bool bind_params(Func* callee, Expr* call, bool stmt_site, FreshNames* names, Binding* b) {
+    FuncSign* sign = callee->signature;
+    if (call->as.func_call.count != sign->paramNum) return false;
+    b->pre = sign->paramNum ? calloc(sign->paramNum, sizeof(Stmt*)) : nullptr;
+
+    //a ref/own parameter that is written through could change a variable another parameter reads,
+    //only copy values in then
+    bool writes_through = false;
+    for (int i = 0; i < sign->paramNum; i++) {
+        if (sign->parameters[i].ownership == OWNERSHIP_NONE) continue;
+        NameUse u = name_use(callee, sign->parameters[i].name);
+        if (u.assigned || u.named) writes_through = true;
+    }
+
+    for (int i = 0; i < sign->paramNum; i++) {
+        FuncParam* p = &sign->parameters[i];
+        Expr* arg = call->as.func_call.params[i];
+        NameUse u = name_use(callee, p->name);
+
+        if (p->ownership != OWNERSHIP_NONE) {
+            //moving into own or borrowing as ref: the body works on the callers variable directly
+            if (arg->type != VAR_E) return false;
+            rename_add(&b->map, p->name, arg, arg->as.var.name);
+        } else if (!u.assigned && arg->type == VAR_E && !writes_through) {
+            rename_add(&b->map, p->name, arg, arg->as.var.name);
+        } else if (!u.assigned && !u.named && is_literal(arg)) {
+            rename_add(&b->map, p->name, arg, nullptr);
+        } else if (stmt_site) {
+            char* local = fresh_name(names, p->name);
+            Stmt* decl = makeVarDecl(arg->loc, local, p->type, arg);
+            decl->as.var_decl.ownership = OWNERSHIP_NONE;
+            decl->as.var_decl.isNullable = p->isNullable;
+            b->pre[b->pre_count++] = decl;
+            rename_add(&b->map, p->name, nullptr, local);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+//body of callee for one site: parameters bound, locals renamed, the trailing return split off into *ret.
+//ret_target names the local the trailing return hands back when the site declares a variable for it
+static bool instantiate(InlineCtx* ctx, Func* callee, Expr* call, bool stmt_site, char* ret_target,
+                        Stmt*** out, int* out_count, Expr** ret) {
+    FreshNames names = {++ctx->next_site};
+    Binding b = {0};
+    if (!bind_params(callee, call, stmt_site, &names, &b)) {
+        binding_free(&b);
+        return false;
+    }
+
+    //the returned local can take the name of the variable the site declares, no copy needed then
+    Expr* tail = tail_return(callee);
+    if (ret_target && tail && tail->as.func_ret_expr && tail->as.func_ret_expr->type == VAR_E) {
+        rename_add(&b.map, tail->as.func_ret_expr->as.var.name, nullptr, ret_target);
+    }
+    LocalCollect lc = {&b.map, &names};
+    walk_stmt(callee->body, collect_local, nullptr, &lc);
+
+    Stmt* body = clone_stmt(callee->body);
+    walk_stmt(body, rename_stmt, rename_expr, &b.map);
+    if (b.map.failed) {
+        binding_free(&b);
+        return false;
+    }
+
+    int count = body->as.block_stmt.count;
+    *ret = nullptr;
+    if (tail) {
+        *ret = body->as.block_stmt.stmts[--count]->as.expr_stmt->as.func_ret_expr;
+        if (*ret && (*ret)->type == VOID_E) *ret = nullptr;
+    }
+
+    Stmt** stmts = arena_alloc(&g_arena, sizeof(Stmt*) * (b.pre_count + count + 1));
+    if (b.pre_count) memcpy(stmts, b.pre, sizeof(Stmt*) * b.pre_count);
+    if (count) memcpy(stmts + b.pre_count, body->as.block_stmt.stmts, sizeof(Stmt*) * count);
+    *out = stmts;
+    *out_count = b.pre_count + count;
+    binding_free(&b);
+    return true;
+}
+
+static int inlinable_callee(InlineCtx* ctx, int caller, Expr* call) {
+    if (!call || call->type != FUNC_CALL_E) return -1;
+    int callee = func_index(ctx, call->as.func_call.resolved_sign);
+    if (callee < 0 || callee == caller || !ctx->candidate[callee]) return -1;
+    if (ctx->cost[caller] + ctx->cost[callee] > INLINE_CALLER_LIMIT) return -1;
+    return callee;
+}
+
+static bool is_pure(Expr* e) {
+    return e->type == VAR_E || is_literal(e);
+}
+
+//the local the returned expression names, when it is declared at the top of the callee like the site wants it
+static char* returned_local(Func* callee, Stmt* site) {
+    Expr* tail = tail_return(callee);
+    if (!tail || !tail->as.func_ret_expr || tail->as.func_ret_expr->type != VAR_E) return nullptr;
+    char* name = tail->as.func_ret_expr->as.var.name;
+
+    for (int i = 0; i < callee->body->as.block_stmt.count; i++) {
+        Stmt* s = callee->body->as.block_stmt.stmts[i];
+        if (s->type != VAR_DECL_S || s->as.var_decl.name != name) continue;
+        return s->as.var_decl.varType == site->as.var_decl.varType &&
+               s->as.var_decl.ownership == site->as.var_decl.ownership &&
+               !s->as.var_decl.isArray && !site->as.var_decl.isArray ? name : nullptr;
+    }
+    return nullptr;
+}
+
+//where the call sits when the whole statement is one: x: T = f(..), x = f(..), f(..), return f(..)
+static Expr** site_call_slot(Stmt* s) {
+    Expr** slot = nullptr;
+    if (s->type == VAR_DECL_S && !s->as.var_decl.isArray) slot = &s->as.var_decl.expr;
+    else if (s->type == ASSIGN_S && !s->as.var_assign.isArray) slot = &s->as.var_assign.expr;
+    else if (s->type == EXPR_STMT_S && s->as.expr_stmt) {
+        slot = &s->as.expr_stmt;
+        if ((*slot)->type == FUNC_RET_E) slot = &(*slot)->as.func_ret_expr;
+    }
+    return slot && *slot && (*slot)->type == FUNC_CALL_E ? slot : nullptr;
+}
+
+static bool inline_site(InlineCtx* ctx, int caller, Stmt* s, Stmt*** out, int* out_count) {
+    Expr** slot = site_call_slot(s);
+    if (!slot) return false;
+    Expr* call = *slot;
+    Expr* ret_wrapper = s->type == EXPR_STMT_S && s->as.expr_stmt->type == FUNC_RET_E ? s->as.expr_stmt : nullptr;
+
+    int callee_index = inlinable_callee(ctx, caller, call);
+    if (callee_index < 0) return false;
+    Func* callee = ctx->program[callee_index];
+    bool owned_ret = callee->signature->retOwnership != OWNERSHIP_NONE;
+
+    char* target = s->type == VAR_DECL_S && returned_local(callee, s) ? s->as.var_decl.name : nullptr;
+    Stmt** stmts;
+    int count;
+    Expr* ret;
+    if (!instantiate(ctx, callee, call, true, target, &stmts, &count, &ret)) return false;
+
+    Stmt* tail = nullptr;
+    if (s->type == VAR_DECL_S) {
+        if (!ret) return false;
+        if (!target) {
+            //handing an owned local over through a second variable is not something codegen does well
+            if (owned_ret && ret->type == VAR_E) return false;
+            tail = clone_stmt(s);
+            tail->as.var_decl.expr = ret;
+        }
+    } else if (s->type == ASSIGN_S) {
+        if (!ret || (owned_ret && ret->type == VAR_E)) return false;
+        tail = clone_stmt(s);
+        tail->as.var_assign.expr = ret;
+    } else if (ret_wrapper) {
+        if (!ret) return false;
+        Expr* r = clone_expr(ret_wrapper);
+        r->as.func_ret_expr = ret;
+        tail = makeExprStmt(s->loc, r);
+    } else if (ret && !is_pure(ret)) {
+        if (ret->type == MATCH_E) return false;
+        tail = makeExprStmt(s->loc, ret);
+    }
+
+    if (tail) stmts[count++] = tail;
+    *out = stmts;
+    *out_count = count;
+    ctx->cost[caller] += ctx->cost[callee_index];
+    stage_trace(STAGE_OPTIMIZER, "inlined %s into %s", callee->signature->name, ctx->program[caller]->signature->name);
+    return true;
+}
+
+//a call anywhere inside an expression, only a body that is nothing but `return expr` fits there
+static int inline_expr(InlineCtx* ctx, int caller, Expr** slot) {
+    Expr* e = *slot;
+    if (!e) return 0;
+    int changes = 0;
+
+    switch (e->type) {
+        case ARRAY_ACCESS_E: changes += inline_expr(ctx, caller, &e->as.array_access.index); break;
+        case FUNC_CALL_E:
+            for (int i = 0; i < e->as.func_call.count; i++) changes += inline_expr(ctx, caller, &e->as.func_call.params[i]);
+            break;
+        case FUNC_RET_E: changes += inline_expr(ctx, caller, &e->as.func_ret_expr); break;
+        case MATCH_E:
+            changes += inline_expr(ctx, caller, &e->as.match.var);
+            for (int i = 0; i < e->as.match.branchCount; i++) changes += inline_expr(ctx, caller, &e->as.match.branches[i].caseRet);
+            break;
+        case ARRAY_DECL_E:
+            for (int i = 0; i < e->as.arr_decl.count; i++) changes += inline_expr(ctx, caller, &e->as.arr_decl.values[i]);
+            break;
+        case ALLOC_E:
+        case ALLOC_ARR_E: changes += inline_expr(ctx, caller, &e->as.alloc.initialValue); break;
+        case SOME_E: changes += inline_expr(ctx, caller, &e->as.some.var); break;
+        case UN_OP_E: changes += inline_expr(ctx, caller, &e->as.un_op.expr); break;
+        case BIN_OP_E:
+            changes += inline_expr(ctx, caller, &e->as.bin_op.exprL);
+            changes += inline_expr(ctx, caller, &e->as.bin_op.exprR);
+            break;
+        default: break;
+    }
+
+    int callee_index = inlinable_callee(ctx, caller, e);
+    if (callee_index < 0) return changes;
+    Func* callee = ctx->program[callee_index];
+    if (callee->body->as.block_stmt.count != 1 || callee->signature->retOwnership != OWNERSHIP_NONE) return changes;
+
+    Stmt** stmts;
+    int count;
+    Expr* ret;
+    if (!instantiate(ctx, callee, e, false, nullptr, &stmts, &count, &ret)) return changes;
+    if (count != 0 || !ret || ret->type == MATCH_E) return changes;
+
+    *slot = ret;
+    ctx->cost[caller] += ctx->cost[callee_index];
+    stage_trace(STAGE_OPTIMIZER, "inlined %s into an expression of %s", callee->signature->name, ctx->program[caller]->signature->name);
+    return changes + 1;
+}
+
+static int inline_in_stmt(InlineCtx* ctx, int caller, Stmt** slot);
+
+//the call that makes s a site is left to inline_list, only its arguments are handled here
+static int inline_args_or_expr(InlineCtx* ctx, int caller, Stmt* s, Expr** slot) {
+    Expr** call = site_call_slot(s);
+    if (!call) return inline_expr(ctx, caller, slot);
+    int changes = 0;
+    for (int i = 0; i < (*call)->as.func_call.count; i++) changes += inline_expr(ctx, caller, &(*call)->as.func_call.params[i]);
+    return changes;
+}
+
+//walks a statement list, sites get replaced by the callee body spliced in place
+static int inline_list(InlineCtx* ctx, int caller, Stmt*** list, int* count) {
+    int changes = 0;
+    Stmt** out = nullptr;
+    int out_count = 0;
+    int out_capacity = 0;
+
+    for (int i = 0; i < *count; i++) {
+        Stmt* s = (*list)[i];
+        changes += inline_in_stmt(ctx, caller, &s);
+
+        //a `return expr` callee is substituted in place, anything longer gets spliced in
+        Stmt** body = &s;
+        int body_count = 1;
+        Expr** call = s ? site_call_slot(s) : nullptr;
+        int substituted = call ? inline_expr(ctx, caller, call) : 0;
+        if (substituted) changes += substituted;
+        else if (call && inline_site(ctx, caller, s, &body, &body_count)) changes++;
+
+        //copy on first change, untouched lists stay as they are
+        if (!out && (body_count != 1 || body[0] != (*list)[i])) {
+            out_capacity = *count + body_count;
+            out = malloc(sizeof(Stmt*) * out_capacity);
+            memcpy(out, *list, sizeof(Stmt*) * i);
+            out_count = i;
+        }
+        if (out) {
+            if (out_count + body_count > out_capacity) {
+                out_capacity = (out_count + body_count) * 2;
+                out = realloc(out, sizeof(Stmt*) * out_capacity);
+            }
+            memcpy(out + out_count, body, sizeof(Stmt*) * body_count);
+            out_count += body_count;
+        }
+    }
+
+    if (out) {
+        *list = arena_alloc(&g_arena, sizeof(Stmt*) * (out_count > 0 ? out_count : 1));
+        memcpy(*list, out, sizeof(Stmt*) * out_count);
+        *count = out_count;
+        free(out);
+    }
+    return changes;
+}
+
+//a single statement in a body slot (if/while/for), becomes a block if a site in it grows
+static int inline_body(InlineCtx* ctx, int caller, Stmt** slot) {
+    if (!*slot) return 0;
+    if ((*slot)->type == BLOCK_S) {
+        return inline_list(ctx, caller, &(*slot)->as.block_stmt.stmts, &(*slot)->as.block_stmt.count);
+    }
+    Stmt** list = slot;
+    int count = 1;
+    int changes = inline_list(ctx, caller, &list, &count);
+    if (list != slot) *slot = makeBlock((*slot)->loc, list, count);
+    return changes;
+}
+
+//everything inside s, except the call that makes s itself a site
+static int inline_in_stmt(InlineCtx* ctx, int caller, Stmt** slot) {
+    Stmt* s = *slot;
+    if (!s) return 0;
+    int changes = 0;
+
+    switch (s->type) {
+        case VAR_DECL_S:
+            changes += inline_expr(ctx, caller, &s->as.var_decl.arraySize);
+            changes += inline_args_or_expr(ctx, caller, s, &s->as.var_decl.expr);
+            break;
+        case ASSIGN_S:
+            changes += inline_args_or_expr(ctx, caller, s, &s->as.var_assign.expr);
+            break;
+        case ARRAY_ELEM_ASSIGN_S:
+            changes += inline_expr(ctx, caller, &s->as.array_elem_assign.index);
+            changes += inline_expr(ctx, caller, &s->as.array_elem_assign.value);
+            break;
+        case IF_S:
+            changes += inline_expr(ctx, caller, &s->as.if_stmt.cond);
+            changes += inline_body(ctx, caller, &s->as.if_stmt.trueStmt);
+            changes += inline_body(ctx, caller, &s->as.if_stmt.falseStmt);
+            break;
+        case WHILE_S:
+            changes += inline_expr(ctx, caller, &s->as.while_stmt.cond);
+            changes += inline_body(ctx, caller, &s->as.while_stmt.body);
+            break;
+        case DO_WHILE_S:
+            changes += inline_body(ctx, caller, &s->as.do_while_stmt.body);
+            changes += inline_expr(ctx, caller, &s->as.do_while_stmt.cond);
+            break;
+        case FOR_S:
+            changes += inline_expr(ctx, caller, &s->as.for_stmt.min);
+            changes += inline_expr(ctx, caller, &s->as.for_stmt.max);
+            changes += inline_body(ctx, caller, &s->as.for_stmt.body);
+            break;
+        case BLOCK_S:
+            changes += inline_list(ctx, caller, &s->as.block_stmt.stmts, &s->as.block_stmt.count);
+            break;
+        case MATCH_S:
+            changes += inline_expr(ctx, caller, &s->as.match_stmt.var);
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* b = &s->as.match_stmt.branches[i];
+                changes += inline_list(ctx, caller, &b->stmts, &b->stmtCount);
+            }
+            break;
+        case EXPR_STMT_S:
+            changes += inline_args_or_expr(ctx, caller, s, &s->as.expr_stmt);
+            break;
+        default:
+            break;
+    }
+    return changes;
+}
+
+int inline_calls(InlineCtx* ctx, int func) {
+    if (g_inline_threshold <= 0) return 0;
+    return inline_in_stmt(ctx, func, &ctx->program[func]->body);
+}
@@ -0,0 +1,34 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_INLINER_H
+#define LYNC_INLINER_H
+
+#include "common.h"
+#include "parser.h"
+
+//callee size limit in ast nodes (statements + expressions), the std string helpers are 40-60
+#define INLINE_DEFAULT_THRESHOLD 64
+//a caller stops taking in bodies once it is this big, so chains of helpers cant blow it up
+#define INLINE_CALLER_LIMIT 4000
+
+//--inline-threshold, 0 turns inlining off
+extern int g_inline_threshold;
+
+//call graph and per function state for one optimize_program run
+typedef struct InlineCtx InlineCtx;
+
+InlineCtx* inline_begin(Func** program, int count);
+void inline_end(InlineCtx* ctx);
+
+//replaces calls in program[func] to small leaf functions with their bodies, returns the sites inlined
+int inline_calls(InlineCtx* ctx, int func);
+
+//rechecks program[func] after it changed, true if it just became something callers can inline.
+//its callers are then worth another visit, see inline_callers
+bool inline_update(InlineCtx* ctx, int func);
+const int* inline_callers(InlineCtx* ctx, int func, int* count);
+
+//size of a function body in ast nodes, what the threshold is compared against
+int inline_cost(Func* f);
+
+#endif //LYNC_INLINER_H
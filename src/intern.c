@@ -0,0 +1,134 @@
+//created by bucka on 10/16/2026.
+
+#include "intern.h"
+#include "arena.h"
+
+static const char* known_names[NAME_KNOWN_COUNT] = {
+    [NAME_PRINT] = "print",
+    [NAME_LENGTH] = "length",
+    [NAME_READ_INT] = "read_int",
+    [NAME_READ_STR] = "read_str",
+    [NAME_READ_BOOL] = "read_bool",
+    [NAME_READ_CHAR] = "read_char",
+    [NAME_READ_FLOAT] = "read_float",
+    [NAME_READ_DOUBLE] = "read_double",
+    [NAME_READ_KEY] = "read_key",
+    [NAME_MAIN] = "main",
+    [NAME_STD_IO] = "std.io",
+};
+
+//own arena so interned names survive arena_release(&g_arena) between compilations in one process
+static Arena strings = {.block_size = ARENA_BLOCK_SIZE, .stage = STAGE_LEXER};
+static char** slots = nullptr;  //open addressing, power of two capacity
+static int slot_capacity = 0;
+static char** by_id = nullptr;
+static uint32_t count = 0;
+static uint32_t id_capacity = 0;
+static size_t lookups = 0;
+
+static char** find_slot(char** table, int capacity, const char* s, size_t len, uint32_t hash) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t i = hash & mask;
+    while (table[i]) {
+        const InternHeader* h = intern_header(table[i]);
+        if (h->hash == hash && h->length == len && memcmp(table[i], s, len) == 0) return &table[i];
+        i = (i + 1) & mask;
+    }
+    return &table[i];
+}
+
+static void grow_slots(void) {
+    int capacity = slot_capacity ? slot_capacity * 2 : 1024;
+    char** table = calloc(capacity, sizeof(char*));
+    for (int i = 0; i < slot_capacity; i++) {
+        if (!slots[i]) continue;
+        const InternHeader* h = intern_header(slots[i]);
+        *find_slot(table, capacity, slots[i], h->length, h->hash) = slots[i];
+    }
+    free(slots);
+    slots = table;
+    slot_capacity = capacity;
+}
+
+static uint32_t hash_bytes(const char* s, size_t len) {
+    uint32_t h = 2166136261u; //fNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char* insert(const char* s, size_t len, uint32_t hash, char** slot) {
+    if ((count + 1) * 10 > (uint32_t)slot_capacity * 7) {
+        grow_slots();
+        slot = find_slot(slots, slot_capacity, s, len, hash);
+    }
+    if (count == id_capacity) {
+        id_capacity = id_capacity ? id_capacity * 2 : 1024;
+        by_id = realloc(by_id, sizeof(char*) * id_capacity);
+    }
+
+    InternHeader* h = arena_alloc(&strings, sizeof(InternHeader) + len + 1);
+    h->hash = hash;
+    h->length = (uint32_t)len;
+    h->id = count;
+    char* str = (char*)(h + 1);
+    memcpy(str, s, len);
+    str[len] = '\0';
+
+    *slot = str;
+    by_id[count++] = str;
+    return str;
+}
+
+static char* lookup_or_insert(const char* s, size_t len) {
+    uint32_t hash = hash_bytes(s, len);
+    char** slot = find_slot(slots, slot_capacity, s, len, hash);
+    if (*slot) return *slot;
+    return insert(s, len, hash, slot);
+}
+
+static void intern_init(void) {
+    grow_slots();
+    for (int i = 0; i < NAME_KNOWN_COUNT; i++) {
+        lookup_or_insert(known_names[i], strlen(known_names[i]));
+    }
+}
+
+char* intern(const char* s, size_t len) {
+    if (!slots) intern_init();
+    lookups++;
+    return lookup_or_insert(s, len);
+}
+
+char* intern_cstr(const char* s) {
+    return s ? intern(s, strlen(s)) : nullptr;
+}
+
+char* intern_by_id(uint32_t id) {
+    return id < count ? by_id[id] : nullptr;
+}
+
+const char* known_name_str(KnownName n) {
+    if (!slots) intern_init();
+    return by_id[n];
+}
+
+void intern_print_stats(FILE* out) {
+    fprintf(out, "  interned %u names from %zu lookups, %zu bytes\n",
+            count, lookups, strings.stats[STAGE_LEXER].bytes);
+}
+
+void intern_release(void) {
+    arena_release(&strings);
+    memset(strings.stats, 0, sizeof(strings.stats));
+    free(slots);
+    free(by_id);
+    slots = nullptr;
+    by_id = nullptr;
+    slot_capacity = 0;
+    count = 0;
+    id_capacity = 0;
+    lookups = 0;
+}
@@ -0,0 +1,63 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_INTERN_H
+#define LYNC_INTERN_H
+
+#include "common.h"
+
+//names the compiler itself looks for, interned first so their id is the enum value
+typedef enum {
+    NAME_PRINT,
+    NAME_LENGTH,
+    NAME_READ_INT,
+    NAME_READ_STR,
+    NAME_READ_BOOL,
+    NAME_READ_CHAR,
+    NAME_READ_FLOAT,
+    NAME_READ_DOUBLE,
+    NAME_READ_KEY,
+    NAME_MAIN,
+    NAME_STD_IO,
+    NAME_KNOWN_COUNT,
+    NAME_OTHER = NAME_KNOWN_COUNT
+} KnownName;
+
+//lives right before the characters of every interned string
+typedef struct {
+    uint32_t hash;
+    uint32_t length;
+    uint32_t id;
+} InternHeader;
+
+//the interned copy of s, equal strings always give the same pointer. never modify it
+char* intern(const char* s, size_t len);
+char* intern_cstr(const char* s);
+char* intern_by_id(uint32_t id);
+const char* known_name_str(KnownName n);
+
+static inline const InternHeader* intern_header(const char* interned) {
+    return (const InternHeader*)interned - 1;
+}
+
+static inline uint32_t intern_id(const char* interned) {
+    return intern_header(interned)->id;
+}
+
+static inline uint32_t intern_hash(const char* interned) {
+    return intern_header(interned)->hash;
+}
+
+//which builtin an interned name is, NAME_OTHER for everything user defined
+static inline KnownName known_name(const char* interned) {
+    uint32_t id = intern_id(interned);
+    return id < NAME_KNOWN_COUNT ? (KnownName)id : NAME_OTHER;
+}
+
+static inline bool is_known_name(const char* interned, KnownName n) {
+    return intern_id(interned) == (uint32_t)n;
+}
+
+void intern_print_stats(FILE* out);
+void intern_release(void);
+
+#endif //LYNC_INTERN_H
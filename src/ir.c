@@ -0,0 +1,552 @@
+//created by bucka on 10/16/2026.
+
+#include "ir.h"
+#include "arena.h"
+
+// ============ BUILDING ============
+
+IrFunc* ir_new_func(Func* f) {
+    IrFunc* ir = arena_alloc(&g_arena, sizeof(IrFunc));
+    ir->func = f;
+    return ir;
+}
+
+IrBlock* ir_new_block(IrFunc* ir) {
+    //blocks are only ever appended, the array grows in powers of two
+    if ((ir->block_count & (ir->block_count - 1)) == 0) {
+        int capacity = ir->block_count ? ir->block_count * 2 : 8;
+        ir->blocks = arena_realloc(&g_arena, ir->blocks, sizeof(IrBlock*) * ir->block_count, sizeof(IrBlock*) * capacity);
+    }
+    IrBlock* b = arena_alloc(&g_arena, sizeof(IrBlock));
+    b->id = ir->block_count;
+    b->rpo = -1;
+    ir->blocks[ir->block_count++] = b;
+    return b;
+}
+
+static void append_inst(IrBlock* b, IrValue* v) {
+    if (b->count == b->capacity) {
+        int capacity = b->capacity ? b->capacity * 2 : 8;
+        b->insts = arena_realloc(&g_arena, b->insts, sizeof(IrValue*) * b->capacity, sizeof(IrValue*) * capacity);
+        b->capacity = capacity;
+    }
+    b->insts[b->count++] = v;
+}
+
+IrValue* ir_new_inst(IrFunc* ir, IrBlock* b, IrOpcode opcode, TokenType type, int argc) {
+    IrValue* v = arena_alloc(&g_arena, sizeof(IrValue));
+    v->opcode = opcode;
+    v->id = ir->value_count++;
+    v->type = type;
+    v->block = b;
+    v->argc = argc;
+    if (argc) v->args = arena_alloc(&g_arena, sizeof(IrValue*) * argc);
+    append_inst(b, v);
+    return v;
+}
+
+IrValue* ir_new_operand(IrOpcode opcode, TokenType type) {
+    IrValue* v = arena_alloc(&g_arena, sizeof(IrValue));
+    v->opcode = opcode;
+    v->id = -1;
+    v->type = type;
+    return v;
+}
+
+void ir_add_pred(IrBlock* b, IrBlock* pred) {
+    if (b->pred_count == b->pred_capacity) {
+        int capacity = b->pred_capacity ? b->pred_capacity * 2 : 2;
+        b->preds = arena_realloc(&g_arena, b->preds, sizeof(IrBlock*) * b->pred_capacity, sizeof(IrBlock*) * capacity);
+        b->pred_capacity = capacity;
+    }
+    b->preds[b->pred_count++] = pred;
+}
+
+int ir_pred_index(IrBlock* succ, IrBlock* pred) {
+    for (int i = 0; i < succ->pred_count; i++) {
+        if (succ->preds[i] == pred) return i;
+    }
+    return -1;
+}
+
+static int succ_count(IrBlock* b) {
+    switch (b->term) {
+        case IR_JUMP: return 1;
+        case IR_BRANCH: return 2;
+        default: return 0;
+    }
+}
+
+// ============ CLEANUP ============
+
+//iterative dfs, fills order with the reachable blocks in postorder and returns how many there are
+static int postorder(IrFunc* ir, IrBlock** order) {
+    IrBlock** stack = malloc(sizeof(IrBlock*) * ir->block_count);
+    int* next = calloc(ir->block_count, sizeof(int));
+    int count = 0, depth = 0;
+
+    for (int i = 0; i < ir->block_count; i++) ir->blocks[i]->rpo = -1;
+    ir->blocks[0]->rpo = 0;
+    stack[depth++] = ir->blocks[0];
+
+    while (depth > 0) {
+        IrBlock* b = stack[depth - 1];
+        if (next[b->id] < succ_count(b)) {
+            IrBlock* s = b->succs[next[b->id]++];
+            if (s->rpo < 0) {
+                s->rpo = 0;
+                stack[depth++] = s;
+            }
+        } else {
+            order[count++] = b;
+            depth--;
+        }
+    }
+
+    free(stack);
+    free(next);
+    return count;
+}
+
+static void remove_pred(IrBlock* b, int index) {
+    for (int i = 0; i < b->count; i++) {
+        IrValue* phi = b->insts[i];
+        if (phi->opcode != IR_PHI) continue;
+        memmove(&phi->args[index], &phi->args[index + 1], sizeof(IrValue*) * (phi->argc - index - 1));
+        phi->argc--;
+    }
+    memmove(&b->preds[index], &b->preds[index + 1], sizeof(IrBlock*) * (b->pred_count - index - 1));
+    b->pred_count--;
+}
+
+//a phi whose arguments are all one value (or itself) is that value
+static bool remove_trivial_phis(IrFunc* ir) {
+    bool changed = false;
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        for (int j = 0; j < b->count; j++) {
+            IrValue* phi = b->insts[j];
+            if (phi->opcode != IR_PHI || phi->replaced) continue;
+
+            IrValue* same = nullptr;
+            bool trivial = true;
+            for (int k = 0; k < phi->argc && trivial; k++) {
+                IrValue* arg = ir_resolve(phi->args[k]);
+                if (arg == same || arg == phi) continue;
+                if (same) trivial = false;
+                same = arg;
+            }
+            if (!trivial) continue;
+
+            phi->replaced = same ? same : ir_new_operand(IR_UNDEF, phi->type);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void ir_cleanup(IrFunc* ir) {
+    if (ir->block_count == 0) return;
+
+    IrBlock** order = malloc(sizeof(IrBlock*) * ir->block_count);
+    int reachable = postorder(ir, order);
+
+    //edges out of dropped blocks go away together with their phi arguments
+    for (int i = 0; i < reachable; i++) {
+        IrBlock* b = order[i];
+        for (int p = b->pred_count - 1; p >= 0; p--) {
+            if (b->preds[p]->rpo < 0) remove_pred(b, p);
+        }
+    }
+
+    //reverse postorder, the entry stays first
+    for (int i = 0; i < reachable; i++) {
+        ir->blocks[i] = order[reachable - 1 - i];
+        ir->blocks[i]->rpo = i;
+        ir->blocks[i]->id = i;
+    }
+    ir->block_count = reachable;
+    free(order);
+
+    while (remove_trivial_phis(ir)) {}
+
+    //point every use at the surviving value, drop what was replaced and put phis first
+    int id = 0;
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        b->value = ir_resolve(b->value);
+
+        int phis = 0;
+        for (int j = 0; j < b->count; j++) phis += b->insts[j]->opcode == IR_PHI && !b->insts[j]->replaced;
+
+        IrValue** insts = b->count ? arena_alloc(&g_arena, sizeof(IrValue*) * b->count) : nullptr;
+        int head = 0, tail = phis;
+        for (int j = 0; j < b->count; j++) {
+            IrValue* v = b->insts[j];
+            if (v->replaced) continue;
+            for (int k = 0; k < v->argc; k++) v->args[k] = ir_resolve(v->args[k]);
+            if (v->opcode == IR_PHI) insts[head++] = v;
+            else insts[tail++] = v;
+        }
+        b->insts = insts;
+        b->count = tail;
+        b->capacity = b->count;
+    }
+
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        for (int j = 0; j < b->count; j++) b->insts[j]->id = id++;
+    }
+    ir->value_count = id;
+
+    ir_dominators(ir);
+}
+
+// ============ DOMINATORS ============
+
+static IrBlock* intersect(IrBlock* a, IrBlock* b) {
+    while (a != b) {
+        while (a->rpo > b->rpo) a = a->idom;
+        while (b->rpo > a->rpo) b = b->idom;
+    }
+    return a;
+}
+
+//cooper, harvey and kennedy: iterate idoms in reverse postorder until nothing moves
+void ir_dominators(IrFunc* ir) {
+    if (ir->block_count == 0) return;
+    IrBlock* entry = ir->blocks[0];
+    for (int i = 0; i < ir->block_count; i++) ir->blocks[i]->idom = nullptr;
+    entry->idom = entry;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < ir->block_count; i++) {
+            IrBlock* b = ir->blocks[i];
+            IrBlock* idom = nullptr;
+            for (int p = 0; p < b->pred_count; p++) {
+                IrBlock* pred = b->preds[p];
+                if (!pred->idom) continue;
+                idom = idom ? intersect(pred, idom) : pred;
+            }
+            if (idom != b->idom) {
+                b->idom = idom;
+                changed = true;
+            }
+        }
+    }
+    entry->idom = nullptr;
+}
+
+bool ir_dominates(IrBlock* a, IrBlock* b) {
+    for (; b; b = b->idom) {
+        if (a == b) return true;
+    }
+    return false;
+}
+
+// ============ VERIFIER ============
+
+typedef struct {
+    IrFunc* ir;
+    int* pos;       //index of every instruction in its block, by id
+} Verify;
+
+static bool verify_fail(Verify* v, IrBlock* b, const char* fmt, ...) {
+    char message[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    stage_error(STAGE_INTERNAL, NO_LOC, "ir verifier: %s, bb%d: %s",
+                v->ir->func->signature->name, b ? b->id : -1, message);
+    return false;
+}
+
+static bool in_func(IrFunc* ir, IrBlock* b) {
+    return b && b->rpo >= 0 && b->rpo < ir->block_count && ir->blocks[b->rpo] == b;
+}
+
+//operand of something at position `at` in block b, at == b->count means the terminator
+static bool verify_operand(Verify* v, IrBlock* b, int at, IrValue* op) {
+    if (!op) return verify_fail(v, b, "missing operand");
+    if (op->replaced) return verify_fail(v, b, "uses %%%d, which was replaced", op->id);
+    if (op->type == VOID_KEYWORD_T) return verify_fail(v, b, "uses %%%d, which has no value", op->id);
+    if (op->opcode == IR_CONST || op->opcode == IR_PARAM || op->opcode == IR_UNDEF) return true;
+
+    if (!in_func(v->ir, op->block)) return verify_fail(v, b, "uses %%%d from a block outside the function", op->id);
+    if (op->id < 0 || op->id >= v->ir->value_count) return verify_fail(v, b, "value id %d out of range", op->id);
+    if (op->block == b) {
+        if (v->pos[op->id] >= at) return verify_fail(v, b, "%%%d is used before it is defined", op->id);
+    } else if (!ir_dominates(op->block, b)) {
+        return verify_fail(v, b, "%%%d does not dominate its use", op->id);
+    }
+    return true;
+}
+
+static bool verify_block(Verify* v, IrBlock* b) {
+    IrFunc* ir = v->ir;
+
+    for (int i = 0; i < b->pred_count; i++) {
+        IrBlock* p = b->preds[i];
+        if (!in_func(ir, p)) return verify_fail(v, b, "predecessor outside the function");
+        bool found = false;
+        for (int s = 0; s < succ_count(p); s++) found |= p->succs[s] == b;
+        if (!found) return verify_fail(v, b, "bb%d is a predecessor but does not branch here", p->id);
+    }
+
+    switch (b->term) {
+        case IR_TERM_NONE:
+            return verify_fail(v, b, "no terminator");
+        case IR_BRANCH:
+            if (!verify_operand(v, b, b->count, b->value)) return false;
+            //fallthrough
+        case IR_JUMP:
+            for (int s = 0; s < succ_count(b); s++) {
+                if (!in_func(ir, b->succs[s])) return verify_fail(v, b, "branches outside the function");
+                if (ir_pred_index(b->succs[s], b) < 0)
+                    return verify_fail(v, b, "bb%d is not listed as a predecessor of bb%d", b->id, b->succs[s]->id);
+            }
+            break;
+        case IR_RETURN:
+            if (b->value && !verify_operand(v, b, b->count, b->value)) return false;
+            break;
+    }
+
+    bool phis_done = false;
+    for (int i = 0; i < b->count; i++) {
+        IrValue* inst = b->insts[i];
+        if (inst->block != b) return verify_fail(v, b, "%%%d thinks it lives in another block", inst->id);
+        if (inst->replaced) return verify_fail(v, b, "%%%d was replaced but is still listed", inst->id);
+
+        if (inst->opcode != IR_PHI) {
+            phis_done = true;
+            for (int a = 0; a < inst->argc; a++) {
+                if (!verify_operand(v, b, i, inst->args[a])) return false;
+            }
+            continue;
+        }
+
+        if (phis_done) return verify_fail(v, b, "phi %%%d after a non-phi instruction", inst->id);
+        if (inst->argc != b->pred_count)
+            return verify_fail(v, b, "phi %%%d has %d arguments for %d predecessors", inst->id, inst->argc, b->pred_count);
+        //a phi argument is used at the end of the predecessor it comes from
+        for (int a = 0; a < inst->argc; a++) {
+            IrBlock* p = b->preds[a];
+            if (!verify_operand(v, p, p->count, inst->args[a])) return false;
+        }
+    }
+    return true;
+}
+
+bool ir_verify(IrFunc* ir) {
+    Verify v = {ir, calloc(ir->value_count ? ir->value_count : 1, sizeof(int))};
+    bool ok = ir->block_count > 0;
+    if (!ok) verify_fail(&v, nullptr, "no blocks");
+    if (ok && ir->blocks[0]->pred_count) ok = verify_fail(&v, ir->blocks[0], "the entry block has predecessors");
+
+    for (int i = 0; ok && i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        if (b->rpo != i) ok = verify_fail(&v, b, "blocks are out of order");
+        for (int j = 0; ok && j < b->count; j++) {
+            int id = b->insts[j]->id;
+            if (id < 0 || id >= ir->value_count) ok = verify_fail(&v, b, "value id %d out of range", id);
+            else v.pos[id] = j;
+        }
+    }
+    for (int i = 0; ok && i < ir->block_count; i++) ok = verify_block(&v, ir->blocks[i]);
+
+    free(v.pos);
+    return ok;
+}
+
+// ============ DUMP ============
+
+static const char* op_name(IrValue* v) {
+    if (v->opcode == IR_UNOP) return v->op == MINUS_T ? "neg" : "not";
+    switch (v->op) {
+        case PLUS_T: return "add";
+        case MINUS_T: return "sub";
+        case STAR_T: return "mul";
+        case SLASH_T: return "div";
+        case SHIFT_LEFT_T: return "shl";
+        case SHIFT_RIGHT_T: return "shr";
+        case WRAP_PLUS_T: return "wadd";
+        case WRAP_MINUS_T: return "wsub";
+        case WRAP_STAR_T: return "wmul";
+        case DOUBLE_EQUALS_T: return "eq";
+        case NOT_EQUALS_T: return "ne";
+        case LESS_T: return "lt";
+        case MORE_T: return "gt";
+        case LESS_EQUALS_T: return "le";
+        case MORE_EQUALS_T: return "ge";
+        default: return "???";
+    }
+}
+
+static const char* type_name(TokenType t) {
+    switch (t) {
+        case INT_KEYWORD_T: return "int";
+        case BOOL_KEYWORD_T: return "bool";
+        case CHAR_KEYWORD_T: return "char";
+        case STR_KEYWORD_T: return "string";
+        case FLOAT_KEYWORD_T: return "float";
+        case DOUBLE_KEYWORD_T: return "double";
+        default: return "void";
+    }
+}
+
+static void dump_operand(IrValue* v, OutBuf* out) {
+    switch (v->opcode) {
+        case IR_CONST: {
+            Expr* lit = v->ast;
+            switch (lit->type) {
+                case INT_LIT_E: ob_int(out, lit->as.int_val); break;
+                case BOOL_LIT_E: ob_puts(out, lit->as.bool_val ? "true" : "false"); break;
+                case FLOAT_LIT_E: ob_printf(out, "%g", lit->as.double_val); break;
+                case CHAR_LIT_E: {
+                    char s[2] = {lit->as.char_val, '\0'};
+                    ob_putc(out, '\'');
+                    ob_escaped(out, s);
+                    ob_putc(out, '\'');
+                    break;
+                }
+                case STR_LIT_E:
+                    ob_putc(out, '"');
+                    ob_escaped(out, lit->as.str_val);
+                    ob_putc(out, '"');
+                    break;
+                default: ob_lit(out, "?"); break;
+            }
+            break;
+        }
+        case IR_PARAM:
+            ob_putc(out, '%');
+            ob_puts(out, v->name);
+            break;
+        case IR_UNDEF:
+            ob_lit(out, "undef");
+            break;
+        default:
+            ob_printf(out, "%%%d", v->id);
+            break;
+    }
+}
+
+static void dump_args(IrValue* v, int from, OutBuf* out) {
+    for (int i = from; i < v->argc; i++) {
+        if (i > from) ob_lit(out, ", ");
+        dump_operand(v->args[i], out);
+    }
+}
+
+static void dump_inst(IrValue* v, OutBuf* out) {
+    ob_lit(out, "  ");
+    if (v->type != VOID_KEYWORD_T) ob_printf(out, "%%%d = ", v->id);
+
+    switch (v->opcode) {
+        case IR_PHI:
+            ob_printf(out, "phi %s ", type_name(v->type));
+            for (int i = 0; i < v->argc; i++) {
+                if (i > 0) ob_lit(out, ", ");
+                ob_lit(out, "[");
+                dump_operand(v->args[i], out);
+                ob_printf(out, ", bb%d]", v->block->preds[i]->id);
+            }
+            break;
+        case IR_UNOP:
+        case IR_BINOP:
+            ob_printf(out, "%s %s ", op_name(v), type_name(v->type));
+            dump_args(v, 0, out);
+            break;
+        case IR_CAST:
+            ob_printf(out, "cast %s ", type_name(v->type));
+            dump_args(v, 0, out);
+            break;
+        case IR_CALL:
+            ob_printf(out, "call %s %s(", type_name(v->type), v->callee ? v->callee->name : v->ast->as.func_call.name);
+            dump_args(v, 0, out);
+            ob_lit(out, ")");
+            break;
+        case IR_INDEX:
+            ob_printf(out, "index %s ", type_name(v->type));
+            dump_args(v, 0, out);
+            break;
+        default:
+            ob_lit(out, "???");
+            break;
+    }
+
+    if (v->name) {
+        ob_lit(out, "  ; ");
+        ob_puts(out, v->name);
+    }
+    ob_lit(out, "\n");
+}
+
+void ir_dump_func(IrFunc* ir, OutBuf* out) {
+    FuncSign* sign = ir->func->signature;
+    ob_printf(out, "func %s(", sign->name);
+    for (int i = 0; i < sign->paramNum; i++) {
+        if (i > 0) ob_lit(out, ", ");
+        ob_printf(out, "%s %%%s", type_name(sign->parameters[i].type), sign->parameters[i].name);
+    }
+    ob_printf(out, ") -> %s {\n", type_name(sign->retType));
+
+    for (int i = 0; i < ir->block_count; i++) {
+        IrBlock* b = ir->blocks[i];
+        ob_printf(out, "bb%d:", b->id);
+        if (b->pred_count) {
+            ob_lit(out, "  ; preds");
+            for (int p = 0; p < b->pred_count; p++) ob_printf(out, "%s bb%d", p ? "," : "", b->preds[p]->id);
+        }
+        ob_lit(out, "\n");
+
+        for (int j = 0; j < b->count; j++) dump_inst(b->insts[j], out);
+
+        switch (b->term) {
+            case IR_JUMP:
+                ob_printf(out, "  jmp bb%d\n", b->succs[0]->id);
+                break;
+            case IR_BRANCH:
+                ob_lit(out, "  br ");
+                dump_operand(b->value, out);
+                ob_printf(out, ", bb%d, bb%d\n", b->succs[0]->id, b->succs[1]->id);
+                break;
+            case IR_RETURN:
+                ob_lit(out, "  ret");
+                if (b->value) {
+                    ob_lit(out, " ");
+                    dump_operand(b->value, out);
+                }
+                ob_lit(out, "\n");
+                break;
+            default:
+                ob_lit(out, "  <no terminator>\n");
+                break;
+        }
+    }
+    ob_lit(out, "}\n");
+}
+
+void ir_dump_program(Func** program, int count, OutBuf* out) {
+    for (int i = 0; i < count; i++) {
+        Func* f = program[i];
+        if (i > 0) ob_lit(out, "\n");
+        if (f->ir) {
+            ir_dump_func(f->ir, out);
+            continue;
+        }
+
+        //lower it again for the reason, or to show what failed to verify
+        const char* reason = nullptr;
+        IrFunc* ir = ir_lower(f, &reason);
+        if (ir) {
+            ob_printf(out, "; %s: did not verify\n", f->signature->name);
+            ir_dump_func(ir, out);
+        } else {
+            ob_printf(out, "; %s: kept on the ast, %s\n", f->signature->name, reason ? reason : "no reason given");
+        }
+    }
+}
@@ -0,0 +1,117 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_IR_H
+#define LYNC_IR_H
+
+#include "common.h"
+#include "parser.h"
+#include "outbuf.h"
+
+//mid level ir: a function is a graph of basic blocks and every value is defined exactly once (ssa).
+//built from an analyzed and optimized body by ir_lower. bodies that use something the ir cannot
+//express yet (arrays, own/ref, nullables, free) keep going through the ast
+
+typedef struct IrValue IrValue;
+typedef struct IrBlock IrBlock;
+typedef struct IrFunc IrFunc;
+
+typedef enum {
+    //operands only, they belong to no block and are available everywhere
+    IR_CONST,       //ast is the literal
+    IR_PARAM,       //index is the parameter
+    IR_UNDEF,       //a variable read on a path that never wrote it
+
+    //instructions
+    IR_PHI,         //args[i] comes in from block->preds[i]
+    IR_UNOP,        //op is MINUS_T or NEGATION_T
+    IR_BINOP,       //op is the operator token, && and || are lowered to branches
+    IR_CAST,        //args[0] converted to type
+    IR_CALL,        //callee is the lync/extern function, nullptr for print and length (see ast)
+    IR_INDEX,       //args[0][args[1]], a char read out of a string
+} IrOpcode;
+
+struct IrValue {
+    IrOpcode opcode;
+    int id;                 //%id in dumps, __v<id> in emitted c. unique per function, -1 for operands
+    TokenType type;         //VOID_KEYWORD_T for calls without a result
+    IrBlock* block;
+    TokenType op;
+    int index;
+    IrValue** args;
+    int argc;
+    Expr* ast;              //IR_CONST literal, IR_CALL call (print formats come from its arguments)
+    FuncSign* callee;
+    char* name;             //source variable the value was assigned to, for readable dumps only
+    IrValue* replaced;      //set while building when a phi turned out trivial
+};
+
+typedef enum {
+    IR_TERM_NONE,           //still being built
+    IR_JUMP,                //succs[0]
+    IR_BRANCH,              //value ? succs[0] : succs[1]
+    IR_RETURN,              //value, nullptr for a plain return
+} IrTermKind;
+
+struct IrBlock {
+    int id;
+    IrValue** insts;        //phis first, then in execution order
+    int count;
+    int capacity;
+    IrTermKind term;
+    IrValue* value;
+    IrBlock* succs[2];
+    IrBlock** preds;
+    int pred_count;
+    int pred_capacity;
+    IrBlock* idom;          //immediate dominator, nullptr for the entry. set by ir_dominators
+    int rpo;                //index in IrFunc.blocks
+};
+
+struct IrFunc {
+    Func* func;
+    IrBlock** blocks;       //reverse postorder, blocks[0] is the entry. unreachable blocks are dropped
+    int block_count;
+    int value_count;
+};
+
+//--via-ir, codegen emits bodies that lowered from their ir instead of the ast
+extern bool g_via_ir;
+
+//building, everything lives in g_arena
+IrFunc* ir_new_func(Func* f);
+IrBlock* ir_new_block(IrFunc* ir);
+IrValue* ir_new_inst(IrFunc* ir, IrBlock* b, IrOpcode opcode, TokenType type, int argc);
+IrValue* ir_new_operand(IrOpcode opcode, TokenType type);
+void ir_add_pred(IrBlock* b, IrBlock* pred);
+
+//follows replaced links to the value that is actually used
+static inline IrValue* ir_resolve(IrValue* v) {
+    while (v && v->replaced) v = v->replaced;
+    return v;
+}
+
+//after building or a transform: drops unreachable blocks and trivial phis, puts phis first,
+//renumbers values and blocks in reverse postorder and recomputes dominators
+void ir_cleanup(IrFunc* ir);
+
+//nullptr when the body uses something the ir does not cover, *reason (if given) says what
+IrFunc* ir_lower(Func* f, const char** reason);
+
+//lowers and verifies every function, Func.ir is set for the ones that made it. returns how many did
+int ir_lower_program(Func** program, int count);
+
+//phi placement, operand dominance and cfg edge consistency, violations are internal errors
+bool ir_verify(IrFunc* ir);
+
+//idom for every block, blocks must already be in reverse postorder (ir_cleanup leaves them so)
+void ir_dominators(IrFunc* ir);
+bool ir_dominates(IrBlock* a, IrBlock* b);
+
+//which of succs predecessors pred is, the phi argument for that edge sits at the same index. -1 if none
+int ir_pred_index(IrBlock* succ, IrBlock* pred);
+
+//text form for --emit-ir, functions left on the ast get a comment saying why
+void ir_dump_program(Func** program, int count, OutBuf* out);
+void ir_dump_func(IrFunc* ir, OutBuf* out);
+
+#endif //LYNC_IR_H
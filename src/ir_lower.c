@@ -0,0 +1,761 @@
+//created by bucka on 10/16/2026.
+
+#include "ir.h"
+#include "arena.h"
+#include "intern.h"
+
+//ast -> ssa in one walk, after braun et al. "simple and efficient construction of static single assignment form":
+//every block remembers the value each variable has at its end, a read that misses walks up the predecessors
+//and places a phi where paths join. a block whose predecessors are not all known yet (a loop header) gets
+//placeholder phis that are filled in when it is sealed
+
+typedef struct {
+    char* name;             //nullptr for the temporaries && || and match results are merged through
+    TokenType type;
+} LowerVar;
+
+typedef struct {
+    int var;
+    IrValue* phi;
+} PendingPhi;
+
+typedef struct {
+    IrValue** defs;         //by variable index
+    int def_count;
+    PendingPhi* pending;
+    int pending_count;
+    int pending_capacity;
+    bool sealed;
+} BlockState;
+
+typedef struct {
+    IrFunc* ir;
+    IrBlock* cur;
+    BlockState* states;     //by block id
+    int state_capacity;
+    LowerVar* vars;
+    int var_count;
+    int var_capacity;
+    int* visible;           //variables in scope, innermost last
+    int visible_count;
+    int visible_capacity;
+    const char* reason;     //first thing that could not be lowered
+} Lower;
+
+static IrValue* fail(Lower* L, const char* reason) {
+    if (!L->reason) L->reason = reason;
+    return nullptr;
+}
+
+// ============ BLOCKS ============
+
+static BlockState* state(Lower* L, IrBlock* b) {
+    if (b->id >= L->state_capacity) {
+        int capacity = L->state_capacity ? L->state_capacity * 2 : 16;
+        while (capacity <= b->id) capacity *= 2;
+        L->states = realloc(L->states, sizeof(BlockState) * capacity);
+        memset(L->states + L->state_capacity, 0, sizeof(BlockState) * (capacity - L->state_capacity));
+        L->state_capacity = capacity;
+    }
+    return &L->states[b->id];
+}
+
+static IrBlock* new_block(Lower* L) {
+    IrBlock* b = ir_new_block(L->ir);
+    state(L, b);
+    return b;
+}
+
+static void seal(Lower* L, IrBlock* b);
+
+//statements after a return still get lowered, into a block nothing reaches that ir_cleanup drops
+static void open_block(Lower* L) {
+    if (L->cur->term == IR_TERM_NONE) return;
+    L->cur = new_block(L);
+    seal(L, L->cur);
+}
+
+static IrValue* inst(Lower* L, IrOpcode opcode, TokenType type, int argc) {
+    open_block(L);
+    return ir_new_inst(L->ir, L->cur, opcode, type, argc);
+}
+
+static void jump(Lower* L, IrBlock* to) {
+    if (L->cur->term != IR_TERM_NONE) return;
+    L->cur->term = IR_JUMP;
+    L->cur->succs[0] = to;
+    ir_add_pred(to, L->cur);
+}
+
+static void branch(Lower* L, IrValue* cond, IrBlock* t, IrBlock* f) {
+    open_block(L);
+    L->cur->term = IR_BRANCH;
+    L->cur->value = cond;
+    L->cur->succs[0] = t;
+    L->cur->succs[1] = f;
+    ir_add_pred(t, L->cur);
+    ir_add_pred(f, L->cur);
+}
+
+// ============ VARIABLES ============
+
+static int new_var(Lower* L, char* name, TokenType type) {
+    if (L->var_count == L->var_capacity) {
+        L->var_capacity = L->var_capacity ? L->var_capacity * 2 : 16;
+        L->vars = realloc(L->vars, sizeof(LowerVar) * L->var_capacity);
+    }
+    L->vars[L->var_count] = (LowerVar){name, type};
+    return L->var_count++;
+}
+
+static int declare(Lower* L, char* name, TokenType type) {
+    int var = new_var(L, name, type);
+    if (L->visible_count == L->visible_capacity) {
+        L->visible_capacity = L->visible_capacity ? L->visible_capacity * 2 : 16;
+        L->visible = realloc(L->visible, sizeof(int) * L->visible_capacity);
+    }
+    L->visible[L->visible_count++] = var;
+    return var;
+}
+
+//names are interned, the innermost declaration wins
+static int lookup(Lower* L, char* name) {
+    for (int i = L->visible_count - 1; i >= 0; i--) {
+        if (L->vars[L->visible[i]].name == name) return L->visible[i];
+    }
+    return -1;
+}
+
+static void write_var(Lower* L, int var, IrBlock* b, IrValue* v) {
+    BlockState* s = state(L, b);
+    if (var >= s->def_count) {
+        int count = L->var_count;
+        s->defs = realloc(s->defs, sizeof(IrValue*) * count);
+        memset(s->defs + s->def_count, 0, sizeof(IrValue*) * (count - s->def_count));
+        s->def_count = count;
+    }
+    s->defs[var] = v;
+    if (v->opcode >= IR_PHI && !v->name) v->name = L->vars[var].name;
+}
+
+static IrValue* read_var(Lower* L, int var, IrBlock* b);
+
+static IrValue* new_phi(Lower* L, int var, IrBlock* b) {
+    IrValue* phi = ir_new_inst(L->ir, b, IR_PHI, L->vars[var].type, 0);
+    phi->name = L->vars[var].name;
+    return phi;
+}
+
+//the rest of the trivial phis (ones that only become trivial later) are left to ir_cleanup
+static IrValue* add_phi_operands(Lower* L, int var, IrValue* phi) {
+    IrBlock* b = phi->block;
+    phi->argc = b->pred_count;
+    phi->args = arena_alloc(&g_arena, sizeof(IrValue*) * (b->pred_count ? b->pred_count : 1));
+    for (int i = 0; i < b->pred_count; i++) phi->args[i] = read_var(L, var, b->preds[i]);
+
+    IrValue* same = nullptr;
+    for (int i = 0; i < phi->argc; i++) {
+        IrValue* arg = ir_resolve(phi->args[i]);
+        if (arg == same || arg == phi) continue;
+        if (same) return phi;
+        same = arg;
+    }
+    phi->replaced = same ? same : ir_new_operand(IR_UNDEF, phi->type);
+    return phi->replaced;
+}
+
+static IrValue* read_var(Lower* L, int var, IrBlock* b) {
+    BlockState* s = state(L, b);
+    if (var < s->def_count && s->defs[var]) return ir_resolve(s->defs[var]);
+
+    IrValue* v;
+    if (!s->sealed) {
+        v = new_phi(L, var, b);
+        if (s->pending_count == s->pending_capacity) {
+            s->pending_capacity = s->pending_capacity ? s->pending_capacity * 2 : 4;
+            s->pending = realloc(s->pending, sizeof(PendingPhi) * s->pending_capacity);
+        }
+        s->pending[s->pending_count++] = (PendingPhi){var, v};
+    } else if (b->pred_count == 0) {
+        v = ir_new_operand(IR_UNDEF, L->vars[var].type);
+    } else if (b->pred_count == 1) {
+        v = read_var(L, var, b->preds[0]);
+    } else {
+        //written first so a loop back to this block finds the phi instead of recursing forever
+        IrValue* phi = new_phi(L, var, b);
+        write_var(L, var, b, phi);
+        v = add_phi_operands(L, var, phi);
+    }
+    write_var(L, var, b, v);
+    return v;
+}
+
+//all predecessors of b are known from here on
+static void seal(Lower* L, IrBlock* b) {
+    BlockState* s = state(L, b);
+    for (int i = 0; i < s->pending_count; i++) {
+        add_phi_operands(L, s->pending[i].var, s->pending[i].phi);
+    }
+    free(s->pending);
+    s->pending = nullptr;
+    s->pending_count = s->pending_capacity = 0;
+    s->sealed = true;
+}
+
+// ============ EXPRESSIONS ============
+
+static IrValue* lower_expr(Lower* L, Expr* e);
+static void lower_stmt(Lower* L, Stmt* s);
+
+static IrValue* constant(Expr* lit, TokenType type) {
+    IrValue* v = ir_new_operand(IR_CONST, type);
+    v->ast = lit;
+    return v;
+}
+
+static IrValue* bool_constant(SourceLocation loc, bool value) {
+    Expr* lit = makeBoolLit(loc, value);
+    lit->analyzedType = BOOL_KEYWORD_T;
+    return constant(lit, BOOL_KEYWORD_T);
+}
+
+//the type c computes an arithmetic result in, so temporaries never narrow what the ast version kept wide
+static TokenType arith_type(TokenType a, TokenType b) {
+    if (a == DOUBLE_KEYWORD_T || b == DOUBLE_KEYWORD_T) return DOUBLE_KEYWORD_T;
+    if (a == FLOAT_KEYWORD_T || b == FLOAT_KEYWORD_T) return FLOAT_KEYWORD_T;
+    return INT_KEYWORD_T;
+}
+
+static bool is_value_type(TokenType t) {
+    switch (t) {
+        case INT_KEYWORD_T: case BOOL_KEYWORD_T: case CHAR_KEYWORD_T:
+        case STR_KEYWORD_T: case FLOAT_KEYWORD_T: case DOUBLE_KEYWORD_T:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_comparison(TokenType op) {
+    switch (op) {
+        case DOUBLE_EQUALS_T: case NOT_EQUALS_T:
+        case LESS_T: case MORE_T: case LESS_EQUALS_T: case MORE_EQUALS_T:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//what c does implicitly when the value lands in a variable of that type
+static IrValue* convert(Lower* L, IrValue* v, TokenType type) {
+    if (v->type == type || v->type == STR_KEYWORD_T || type == STR_KEYWORD_T) return v;
+    IrValue* cast = inst(L, IR_CAST, type, 1);
+    cast->args[0] = v;
+    return cast;
+}
+
+static IrValue* lower_binary(Lower* L, IrOpcode opcode, TokenType op, TokenType type, IrValue* a, IrValue* b) {
+    IrValue* v = inst(L, opcode, type, 2);
+    v->op = op;
+    v->args[0] = a;
+    v->args[1] = b;
+    return v;
+}
+
+//a && b: b only runs when a holds, the result is merged through a temporary like any other variable
+static IrValue* lower_logic(Lower* L, Expr* e) {
+    bool is_and = e->as.bin_op.op == AND_T;
+    IrValue* left = lower_expr(L, e->as.bin_op.exprL);
+    if (!left) return nullptr;
+
+    int result = new_var(L, nullptr, BOOL_KEYWORD_T);
+    IrBlock* right_block = new_block(L);
+    IrBlock* join = new_block(L);
+    open_block(L);
+    write_var(L, result, L->cur, bool_constant(e->loc, !is_and));
+    if (is_and) branch(L, left, right_block, join);
+    else branch(L, left, join, right_block);
+    seal(L, right_block);
+
+    L->cur = right_block;
+    IrValue* right = lower_expr(L, e->as.bin_op.exprR);
+    if (!right) return nullptr;
+    open_block(L);
+    write_var(L, result, L->cur, right);
+    jump(L, join);
+
+    seal(L, join);
+    L->cur = join;
+    return read_var(L, result, join);
+}
+
+static IrValue* lower_call(Lower* L, Expr* e) {
+    KnownName builtin = known_name(e->as.func_call.name);
+    FuncSign* sign = e->as.func_call.resolved_sign;
+    TokenType type;
+
+    switch (builtin) {
+        case NAME_PRINT:
+            type = VOID_KEYWORD_T;
+            break;
+        case NAME_LENGTH:
+            if (e->as.func_call.count != 1) return fail(L, "length() with other than one argument");
+            type = INT_KEYWORD_T;
+            break;
+        case NAME_READ_INT: case NAME_READ_STR: case NAME_READ_BOOL: case NAME_READ_CHAR:
+        case NAME_READ_KEY: case NAME_READ_FLOAT: case NAME_READ_DOUBLE:
+            return fail(L, "read_* results are nullable");
+        default:
+            if (!sign) return fail(L, "an unresolved call");
+            if (sign->retOwnership != OWNERSHIP_NONE || e->is_nullable) return fail(L, "a call with an own/nullable result");
+            for (int i = 0; i < sign->paramNum; i++) {
+                if (sign->parameters[i].ownership != OWNERSHIP_NONE || sign->parameters[i].isNullable)
+                    return fail(L, "a call with own/ref/nullable parameters");
+            }
+            type = sign->retType;
+            builtin = NAME_OTHER;
+            break;
+    }
+
+    int count = e->as.func_call.count;
+    IrValue** args = count ? malloc(sizeof(IrValue*) * count) : nullptr;
+    for (int i = 0; i < count; i++) {
+        args[i] = lower_expr(L, e->as.func_call.params[i]);
+        if (!args[i] || args[i]->type == VOID_KEYWORD_T) {
+            free(args);
+            return fail(L, "a call argument without a value");
+        }
+    }
+
+    IrValue* call = inst(L, IR_CALL, type, count);
+    call->ast = e;
+    call->callee = builtin == NAME_OTHER ? sign : nullptr;
+    if (count) memcpy(call->args, args, sizeof(IrValue*) * count);
+    free(args);
+    return call;
+}
+
+//value arms become a chain of compares in source order, the wildcard arm runs last (as in codegen).
+//each arm writes its value to a temporary, the join reads it back as a phi
+static IrValue* lower_match_expr(Lower* L, Expr* e) {
+    if (!is_value_type(e->analyzedType)) return fail(L, "a match without a plain value type");
+    IrValue* subject = lower_expr(L, e->as.match.var);
+    if (!subject) return nullptr;
+    if (subject->type == STR_KEYWORD_T) return fail(L, "string matches");
+
+    int result = new_var(L, nullptr, e->analyzedType);
+    IrBlock* join = new_block(L);
+    int wildcard = -1;
+
+    for (int i = 0; i < e->as.match.branchCount; i++) {
+        MatchBranchExpr* arm = &e->as.match.branches[i];
+        if (arm->pattern->type == WILDCARD_PATTERN && wildcard < 0) {
+            wildcard = i;
+            continue;
+        }
+        if (arm->pattern->type != VALUE_PATTERN) return fail(L, "match patterns other than values");
+
+        IrValue* value = lower_expr(L, arm->pattern->as.value_expr);
+        if (!value) return nullptr;
+        IrValue* cond = lower_binary(L, IR_BINOP, DOUBLE_EQUALS_T, BOOL_KEYWORD_T, subject, value);
+        IrBlock* body = new_block(L);
+        IrBlock* next = new_block(L);
+        branch(L, cond, body, next);
+        seal(L, body);
+        seal(L, next);
+
+        L->cur = body;
+        IrValue* v = lower_expr(L, arm->caseRet);
+        if (!v) return nullptr;
+        write_var(L, result, L->cur, convert(L, v, e->analyzedType));
+        jump(L, join);
+        L->cur = next;
+    }
+
+    if (wildcard >= 0) {
+        IrValue* v = lower_expr(L, e->as.match.branches[wildcard].caseRet);
+        if (!v) return nullptr;
+        write_var(L, result, L->cur, convert(L, v, e->analyzedType));
+    }
+    jump(L, join);
+
+    seal(L, join);
+    L->cur = join;
+    return read_var(L, result, join);
+}
+
+static IrValue* lower_expr(Lower* L, Expr* e) {
+    open_block(L);
+
+    switch (e->type) {
+        case INT_LIT_E: return constant(e, INT_KEYWORD_T);
+        case BOOL_LIT_E: return constant(e, BOOL_KEYWORD_T);
+        case CHAR_LIT_E: return constant(e, CHAR_KEYWORD_T);
+        case STR_LIT_E: return constant(e, STR_KEYWORD_T);
+        case FLOAT_LIT_E: return constant(e, e->analyzedType == FLOAT_KEYWORD_T ? FLOAT_KEYWORD_T : DOUBLE_KEYWORD_T);
+
+        case VAR_E: {
+            int var = e->as.var.ownership == OWNERSHIP_NONE ? lookup(L, e->as.var.name) : -1;
+            if (var < 0) return fail(L, "a variable the ir does not track (array, own/ref or nullable)");
+            return read_var(L, var, L->cur);
+        }
+
+        case ARRAY_ACCESS_E: {
+            int var = lookup(L, e->as.array_access.arrayName);
+            if (var < 0 || L->vars[var].type != STR_KEYWORD_T) return fail(L, "array element reads");
+            IrValue* index = lower_expr(L, e->as.array_access.index);
+            if (!index) return nullptr;
+            IrValue* str = read_var(L, var, L->cur);
+            return lower_binary(L, IR_INDEX, 0, CHAR_KEYWORD_T, str, index);
+        }
+
+        case FUNC_CALL_E:
+            return lower_call(L, e);
+
+        case MATCH_E:
+            return lower_match_expr(L, e);
+
+        case UN_OP_E: {
+            IrValue* operand = lower_expr(L, e->as.un_op.expr);
+            if (!operand) return nullptr;
+            bool negate = e->as.un_op.op == NEGATION_T;
+            if (!negate && e->as.un_op.op != MINUS_T) return fail(L, "an unknown unary operator");
+            IrValue* v = inst(L, IR_UNOP, negate ? BOOL_KEYWORD_T : arith_type(operand->type, operand->type), 1);
+            v->op = e->as.un_op.op;
+            v->args[0] = operand;
+            return v;
+        }
+
+        case BIN_OP_E: {
+            TokenType op = e->as.bin_op.op;
+            if (op == AND_T || op == OR_T) return lower_logic(L, e);
+
+            IrValue* left = lower_expr(L, e->as.bin_op.exprL);
+            if (!left) return nullptr;
+            IrValue* right = lower_expr(L, e->as.bin_op.exprR);
+            if (!right) return nullptr;
+            if (left->type == VOID_KEYWORD_T || right->type == VOID_KEYWORD_T) return fail(L, "an operand without a value");
+
+            if (is_comparison(op)) return lower_binary(L, IR_BINOP, op, BOOL_KEYWORD_T, left, right);
+            if (op != PLUS_T && op != MINUS_T && op != STAR_T && op != SLASH_T && op != SHIFT_LEFT_T && op != SHIFT_RIGHT_T &&
+                op != WRAP_PLUS_T && op != WRAP_MINUS_T && op != WRAP_STAR_T) {
+                return fail(L, "an unknown binary operator");
+            }
+            if (left->type == STR_KEYWORD_T || right->type == STR_KEYWORD_T) return fail(L, "string arithmetic");
+            return lower_binary(L, IR_BINOP, op, arith_type(left->type, right->type), left, right);
+        }
+
+        case NULL_LIT_E:
+        case SOME_E:
+            return fail(L, "nullable values");
+        case ALLOC_E:
+        case ALLOC_ARR_E:
+            return fail(L, "alloc");
+        case ARRAY_DECL_E:
+            return fail(L, "array literals");
+        default:
+            return fail(L, "a return inside an expression");
+    }
+}
+
+// ============ STATEMENTS ============
+
+static void lower_scoped(Lower* L, Stmt* s) {
+    int mark = L->visible_count;
+    lower_stmt(L, s);
+    L->visible_count = mark;
+}
+
+static void lower_return(Lower* L, Expr* value) {
+    FuncSign* sign = L->ir->func->signature;
+    IrValue* v = nullptr;
+    if (value && value->type != VOID_E) {
+        v = lower_expr(L, value);
+        if (!v) return;
+        if (v->type == VOID_KEYWORD_T) {
+            fail(L, "returning a call without a value");
+            return;
+        }
+        if (sign->retType != VOID_KEYWORD_T) v = convert(L, v, sign->retType);
+    }
+    open_block(L);
+    L->cur->term = IR_RETURN;
+    L->cur->value = v;
+}
+
+static void lower_match_stmt(Lower* L, Stmt* s) {
+    IrValue* subject = lower_expr(L, s->as.match_stmt.var);
+    if (!subject) return;
+    if (subject->type == STR_KEYWORD_T) {
+        fail(L, "string matches");
+        return;
+    }
+
+    IrBlock* join = new_block(L);
+    int wildcard = -1;
+
+    for (int i = 0; i < s->as.match_stmt.branchCount && !L->reason; i++) {
+        MatchBranchStmt* arm = &s->as.match_stmt.branches[i];
+        if (arm->pattern->type == WILDCARD_PATTERN && wildcard < 0) {
+            wildcard = i;
+            continue;
+        }
+        if (arm->pattern->type != VALUE_PATTERN) {
+            fail(L, "match patterns other than values");
+            return;
+        }
+
+        IrValue* value = lower_expr(L, arm->pattern->as.value_expr);
+        if (!value) return;
+        IrValue* cond = lower_binary(L, IR_BINOP, DOUBLE_EQUALS_T, BOOL_KEYWORD_T, subject, value);
+        IrBlock* body = new_block(L);
+        IrBlock* next = new_block(L);
+        branch(L, cond, body, next);
+        seal(L, body);
+        seal(L, next);
+
+        L->cur = body;
+        int mark = L->visible_count;
+        for (int j = 0; j < arm->stmtCount && !L->reason; j++) lower_stmt(L, arm->stmts[j]);
+        L->visible_count = mark;
+        jump(L, join);
+        L->cur = next;
+    }
+
+    if (wildcard >= 0) {
+        MatchBranchStmt* arm = &s->as.match_stmt.branches[wildcard];
+        int mark = L->visible_count;
+        for (int j = 0; j < arm->stmtCount && !L->reason; j++) lower_stmt(L, arm->stmts[j]);
+        L->visible_count = mark;
+    }
+    jump(L, join);
+
+    seal(L, join);
+    L->cur = join;
+}
+
+static void lower_stmt(Lower* L, Stmt* s) {
+    if (!s || L->reason) return;
+
+    switch (s->type) {
+        case VAR_DECL_S: {
+            if (s->as.var_decl.isArray) { fail(L, "arrays"); return; }
+            if (s->as.var_decl.ownership != OWNERSHIP_NONE) { fail(L, "own/ref variables"); return; }
+            if (s->as.var_decl.isNullable) { fail(L, "nullable variables"); return; }
+            if (!is_value_type(s->as.var_decl.varType)) { fail(L, "a variable without a plain value type"); return; }
+            IrValue* v = lower_expr(L, s->as.var_decl.expr);
+            if (!v) return;
+            if (v->type == VOID_KEYWORD_T) { fail(L, "a variable initialized without a value"); return; }
+            v = convert(L, v, s->as.var_decl.varType);
+            int var = declare(L, s->as.var_decl.name, s->as.var_decl.varType);
+            write_var(L, var, L->cur, v);
+            break;
+        }
+
+        case ASSIGN_S: {
+            int var = s->as.var_assign.isArray || s->as.var_assign.ownership != OWNERSHIP_NONE
+                      ? -1 : lookup(L, s->as.var_assign.name);
+            if (var < 0) { fail(L, "assignments to arrays or own/ref/nullable variables"); return; }
+            IrValue* v = lower_expr(L, s->as.var_assign.expr);
+            if (!v) return;
+            if (v->type == VOID_KEYWORD_T) { fail(L, "assigning a call without a value"); return; }
+            v = convert(L, v, L->vars[var].type);
+            write_var(L, var, L->cur, v);
+            break;
+        }
+
+        case ARRAY_ELEM_ASSIGN_S:
+            fail(L, "element assignment");
+            break;
+
+        case FREE_S:
+            fail(L, "free");
+            break;
+
+        case IF_S: {
+            IrValue* cond = lower_expr(L, s->as.if_stmt.cond);
+            if (!cond) return;
+            IrBlock* then_block = new_block(L);
+            IrBlock* else_block = s->as.if_stmt.falseStmt ? new_block(L) : nullptr;
+            IrBlock* join = new_block(L);
+            branch(L, cond, then_block, else_block ? else_block : join);
+            seal(L, then_block);
+
+            L->cur = then_block;
+            lower_scoped(L, s->as.if_stmt.trueStmt);
+            jump(L, join);
+
+            if (else_block) {
+                seal(L, else_block);
+                L->cur = else_block;
+                lower_scoped(L, s->as.if_stmt.falseStmt);
+                jump(L, join);
+            }
+
+            seal(L, join);
+            L->cur = join;
+            break;
+        }
+
+        case WHILE_S: {
+            IrBlock* header = new_block(L);
+            jump(L, header);
+            L->cur = header;
+            IrValue* cond = lower_expr(L, s->as.while_stmt.cond);
+            if (!cond) return;
+            IrBlock* body = new_block(L);
+            IrBlock* exit = new_block(L);
+            branch(L, cond, body, exit);
+            seal(L, body);
+
+            L->cur = body;
+            lower_scoped(L, s->as.while_stmt.body);
+            jump(L, header);
+
+            seal(L, header);
+            seal(L, exit);
+            L->cur = exit;
+            break;
+        }
+
+        case DO_WHILE_S: {
+            IrBlock* body = new_block(L);
+            jump(L, body);
+            L->cur = body;
+            lower_scoped(L, s->as.do_while_stmt.body);
+            IrValue* cond = lower_expr(L, s->as.do_while_stmt.cond);
+            if (!cond) return;
+            IrBlock* exit = new_block(L);
+            branch(L, cond, body, exit);
+
+            seal(L, body);
+            seal(L, exit);
+            L->cur = exit;
+            break;
+        }
+
+        case FOR_S: {
+            //for (i: min to max) is i = min; while (i <= max) { body; i = i + 1 }, max is read every round as in c
+            IrValue* min = lower_expr(L, s->as.for_stmt.min);
+            if (!min) return;
+            int mark = L->visible_count;
+            int var = declare(L, s->as.for_stmt.varName, INT_KEYWORD_T);
+            write_var(L, var, L->cur, min);
+
+            IrBlock* header = new_block(L);
+            jump(L, header);
+            L->cur = header;
+            IrValue* max = lower_expr(L, s->as.for_stmt.max);
+            if (!max) return;
+            IrValue* cond = lower_binary(L, IR_BINOP, LESS_EQUALS_T, BOOL_KEYWORD_T, read_var(L, var, L->cur), max);
+            IrBlock* body = new_block(L);
+            IrBlock* exit = new_block(L);
+            branch(L, cond, body, exit);
+            seal(L, body);
+
+            L->cur = body;
+            lower_scoped(L, s->as.for_stmt.body);
+            if (L->reason) return;
+            open_block(L);
+            Expr* one = makeIntLit(s->loc, 1);
+            one->analyzedType = INT_KEYWORD_T;
+            IrValue* next = lower_binary(L, IR_BINOP, PLUS_T, INT_KEYWORD_T, read_var(L, var, L->cur), constant(one, INT_KEYWORD_T));
+            write_var(L, var, L->cur, next);
+            jump(L, header);
+
+            seal(L, header);
+            seal(L, exit);
+            L->cur = exit;
+            L->visible_count = mark;
+            break;
+        }
+
+        case BLOCK_S: {
+            int mark = L->visible_count;
+            for (int i = 0; i < s->as.block_stmt.count && !L->reason; i++) lower_stmt(L, s->as.block_stmt.stmts[i]);
+            L->visible_count = mark;
+            break;
+        }
+
+        case MATCH_S:
+            lower_match_stmt(L, s);
+            break;
+
+        case EXPR_STMT_S:
+            if (s->as.expr_stmt->type == FUNC_RET_E) lower_return(L, s->as.expr_stmt->as.func_ret_expr);
+            else lower_expr(L, s->as.expr_stmt);
+            break;
+    }
+}
+
+// ============ FUNCTIONS ============
+
+static const char* check_signature(FuncSign* sign) {
+    if (sign->retOwnership != OWNERSHIP_NONE) return "returns an own/ref value";
+    for (int i = 0; i < sign->paramNum; i++) {
+        if (sign->parameters[i].ownership != OWNERSHIP_NONE) return "own/ref parameters";
+        if (sign->parameters[i].isNullable) return "nullable parameters";
+        if (!is_value_type(sign->parameters[i].type)) return "a parameter without a plain value type";
+    }
+    if (sign->retType != VOID_KEYWORD_T && !is_value_type(sign->retType)) return "a return type without a plain value";
+    return nullptr;
+}
+
+IrFunc* ir_lower(Func* f, const char** reason) {
+    FuncSign* sign = f->signature;
+    Lower L = {0};
+    L.reason = f->body ? check_signature(sign) : "no body";
+
+    if (!L.reason) {
+        L.ir = ir_new_func(f);
+        L.cur = new_block(&L);
+        seal(&L, L.cur);
+
+        for (int i = 0; i < sign->paramNum; i++) {
+            IrValue* param = ir_new_operand(IR_PARAM, sign->parameters[i].type);
+            param->index = i;
+            param->name = sign->parameters[i].name;
+            write_var(&L, declare(&L, param->name, param->type), L.cur, param);
+        }
+
+        lower_stmt(&L, f->body);
+        //falling off the end returns nothing, like the c the ast turns into
+        if (!L.reason && L.cur->term == IR_TERM_NONE) lower_return(&L, nullptr);
+    }
+
+    for (int i = 0; i < L.state_capacity; i++) {
+        free(L.states[i].defs);
+        free(L.states[i].pending);
+    }
+    free(L.states);
+    free(L.vars);
+    free(L.visible);
+
+    if (L.reason) {
+        if (reason) *reason = L.reason;
+        return nullptr;
+    }
+    ir_cleanup(L.ir);
+    return L.ir;
+}
+
+int ir_lower_program(Func** program, int count) {
+    int lowered = 0;
+    for (int i = 0; i < count; i++) {
+        Func* f = program[i];
+        const char* reason = nullptr;
+        IrFunc* ir = ir_lower(f, &reason);
+        f->ir = nullptr;
+
+        if (!ir) {
+            stage_trace(STAGE_OPTIMIZER, "ir: %s stays on the ast, %s", f->signature->name, reason);
+            continue;
+        }
+        if (!ir_verify(ir)) continue;
+
+        stage_trace(STAGE_OPTIMIZER, "ir: %s lowered, %d blocks, %d values", f->signature->name, ir->block_count, ir->value_count);
+        f->ir = ir;
+        lowered++;
+    }
+    return lowered;
+}
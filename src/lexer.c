@@ -3,179 +3,169 @@
 #include "lexer.h"
 #include "error.h"
 
-extern ErrorCollector* g_error_collector;
-extern bool g_trace_mode;
+//keyword lookup on a raw source slice: dispatch on length, then first char,
+//so each identifier costs at most one memcmp instead of a strcmp chain
+TokenType lookup_keyword(const char* s, int len) {
+#define KW(str, tok) if (memcmp(s, str, len) == 0) return tok
+    switch (len) {
+        case 1:
+            if (s[0] == '_') return UNDERSCORE_T;
+            break;
+        case 2:
+            switch (s[0]) {
+                case 'i': KW("if", IF_T); break;
+                case 'd': KW("do", DO_T); break;
+                case 't': KW("to", TO_T); break;
+            }
+            break;
+        case 3:
+            switch (s[0]) {
+                case 'i': KW("int", INT_KEYWORD_T); break;
+                case 'd': KW("def", DEF_KEYWORD_T); break;
+                case 'f': KW("for", FOR_T); break;
+                case 'o': KW("own", OWN_T); break;
+                case 'r': KW("ref", REF_T); break;
+            }
+            break;
+        case 4:
+            switch (s[0]) {
+                case 'e': KW("else", ELSE_T); break;
+                case 'c': KW("char", CHAR_KEYWORD_T); break;
+                case 'v': KW("void", VOID_KEYWORD_T); break;
+                case 'n': KW("null", NULL_LIT_T); break;
+                case 'b': KW("bool", BOOL_KEYWORD_T); break;
+                case 'f': KW("free", FREE_T); break;
+                case 's': KW("some", SOME_T); break;
+                case 't': KW("true", BOOL_LIT_T); break;
+            }
+            break;
+        case 5:
+            switch (s[0]) {
+                case 'w': KW("while", WHILE_T); break;
+                case 'a': KW("alloc", ALLOC_T); break;
+                case 'm': KW("match", MATCH_T); break;
+                case 'c': KW("const", CONST_T); break;
+                case 'f':
+                    KW("float", FLOAT_KEYWORD_T);
+                    KW("false", BOOL_LIT_T);
+                    break;
+            }
+            break;
+        case 6:
+            switch (s[0]) {
+                case 's': KW("string", STR_KEYWORD_T); break;
+                case 'e': KW("extern", EXTERN_T); break;
+                case 'r': KW("return", RETURN_T); break;
+                case 'd': KW("double", DOUBLE_KEYWORD_T); break;
+            }
+            break;
+        case 7:
+            if (s[0] == 'i') KW("include", INCLUDE_T);
+            break;
+    }
+#undef KW
+    return VAR_T;
+}
 
-Token* tokenize(char* code, int* out_count, const char* filename) {
+Token* tokenize(int file_id, int* out_count) {
+    const char* code = source_text(file_id);
     int capacity = 20;
     int count = 0;
-    Token* tokens = malloc(capacity * sizeof(Token));
-
-    int line = 1;
-    int column = 1;
+    Token* tokens = arena_alloc(&g_arena, capacity * sizeof(Token));
+
+    //every token starts with these fields, the payload is filled per kind
+#define PUSH(tok_type, tok_start) do { \
+        if (count >= capacity) { \
+            capacity *= 2; \
+            tokens = arena_realloc(&g_arena, tokens, (capacity / 2) * sizeof(Token), capacity * sizeof(Token)); \
+        } \
+        tokens[count] = (Token){ .type = (tok_type), .file_id = file_id, .offset = (uint32_t)(tok_start) }; \
+        count++; \
+    } while (0)
+#define LAST tokens[count - 1]
 
     int i = 0;
 
     while (code[i] != '\0') {
         char c = code[i];
-        int start_col = column;  //save column at start of token
+        int start = i;  //save offset at start of token
 
-        if (c == '\n') {
-            line++;
-            column = 1;
-            i++;
-            continue;
-        }
-
-        if (c == ' ' || c == '\t' || c == '\r') {
-            column++;
+        if (c == '\n' || c == ' ' || c == '\t' || c == '\r') {
             i++;
             continue;
         }
 
         //number literals (int or float/double)
         if (code[i] >= '0' && code[i] <= '9') {
-            int num_start = i;
             bool is_float = false;
 
             //consume integer part
-            while (code[i] >= '0' && code[i] <= '9') {
-                i++;
-                column++;
-            }
+            while (code[i] >= '0' && code[i] <= '9') i++;
 
             //check for decimal point followed by digit
             if (code[i] == '.' && code[i+1] >= '0' && code[i+1] <= '9') {
                 is_float = true;
                 i++;  //consume .
-                column++;
-                while (code[i] >= '0' && code[i] <= '9') {
-                    i++;
-                    column++;
-                }
-            }
-
-            //check for f or F suffix (only if we have a decimal)
-            if (is_float && (code[i] == 'f' || code[i] == 'F')) {
-                i++;
-                column++;
+                while (code[i] >= '0' && code[i] <= '9') i++;
             }
 
             if (is_float) {
-                int len = i - num_start;
-                char* float_str = malloc(len + 1);
-                strncpy(float_str, &code[num_start], len);
-                float_str[len] = '\0';
-
-                tokens[count++] = (Token){
-                    .type = FLOAT_LIT_T,
-                    .value = float_str,
-                    .line = line,
-                    .column = start_col,
-                    .filename = filename
-                };
+                //strtod on the raw buffer would also eat an exponent the lexer doesnt accept
+                char num_buf[64];
+                int len = i - start;
+                char* num_str = len < (int)sizeof(num_buf) ? num_buf : malloc(len + 1);
+                memcpy(num_str, &code[start], len);
+                num_str[len] = '\0';
+
+                PUSH(FLOAT_LIT_T, start);
+                LAST.as.float_val = strtod(num_str, NULL);
+                if (num_str != num_buf) free(num_str);
+                //check for f or F suffix (only if we have a decimal)
+                if (code[i] == 'f' || code[i] == 'F') {
+                    LAST.flags |= TOKF_FLOAT_SUFFIX;
+                    i++;
+                }
             } else {
                 //parse as integer
                 int num = 0;
-                for (int j = num_start; j < i; j++) {
+                for (int j = start; j < i; j++) {
                     num = num * 10 + (code[j] - '0');
                 }
-                int* heap_num = malloc(sizeof(int));
-                *heap_num = num;
-                tokens[count++] = (Token){
-                    .type = INT_LIT_T,
-                    .value = heap_num,
-                    .line = line,
-                    .column = start_col,
-                    .filename = filename
-                };
-            }
-
-            if (count >= capacity) {
-                capacity *= 2;
-                tokens = realloc(tokens, capacity * sizeof(Token));
+                PUSH(INT_LIT_T, start);
+                LAST.as.int_val = num;
             }
             continue;
         }
 
-        //string literals
+        //string literals, escapes are decoded by token_string() when the parser needs the text
         if (c == '"') {
             i++;  //skip opening quote
-            column++;
-            int str_start = i;
-            int str_len = 0;
 
-            //find closing quote and calculate length
+            //find closing quote
             while (code[i] != '"' && code[i] != '\0' && code[i] != '\n') {
-                if (code[i] == '\\' && code[i + 1] != '\0') {
-                    i++;
-                    column++;
-                    str_len++;
-                }
+                if (code[i] == '\\' && code[i + 1] != '\0') i++;
                 i++;
-                column++;
-                str_len++;
             }
 
             if (code[i] != '"') {
-                SourceLocation loc = {.line = line, .column = start_col, .filename = filename};
-                add_error(g_error_collector, STAGE_LEXER, loc, "unterminated string literal");
+                add_error(g_error_collector, STAGE_LEXER, source_location(file_id, start), "unterminated string literal");
                 continue;
             }
 
-            char* str = malloc(str_len + 1);
-            int str_i = 0;
-            int j = str_start;
-
-            while (j < i) {
-                if (code[j] == '\\' && j + 1 < i) {
-                    j++;
-                    switch (code[j]) {
-                        case 'n': str[str_i++] = '\n'; break;
-                        case 't': str[str_i++] = '\t'; break;
-                        case 'r': str[str_i++] = '\r'; break;
-                        case '\\': str[str_i++] = '\\'; break;
-                        case '"': str[str_i++] = '"'; break;
-                        default:
-                            //unknown escape sequence - just include the character
-                            str[str_i++] = code[j];
-                            break;
-                    }
-                    j++;
-                } else {
-                    str[str_i++] = code[j++];
-                }
-            }
-            str[str_i] = '\0';
-
+            PUSH(STR_LIT_T, start);
+            LAST.as.length = (uint32_t)(i - start - 1);
             i++;
-            column++;
-
-            tokens[count++] = (Token){
-                .type = STR_LIT_T,
-                .value = str,
-                .line = line,
-                .column = start_col,
-                .filename = filename
-            };
-
-            if (count >= capacity) {
-                capacity *= 2;
-                tokens = realloc(tokens, capacity * sizeof(Token));
-            }
             continue;
         }
 
         //character literals
         if (c == '\'') {
             i++; //skip opening quote
-            column++;
             
             char char_val = 0;
             
             if (code[i] == '\\') {
                 i++;
-                column++;
                 if (code[i] == 'n') char_val = '\n';
                 else if (code[i] == 't') char_val = '\t';
                 else if (code[i] == 'r') char_val = '\r';
@@ -183,124 +173,44 @@ Token* tokenize(char* code, int* out_count, const char* filename) {
                 else if (code[i] == '\\') char_val = '\\';
                 else if (code[i] == '\'') char_val = '\'';
                 else {
-                    SourceLocation loc = {.line = line, .column = column, .filename = filename};
-                    add_error(g_error_collector, STAGE_LEXER, loc, "unknown escape sequence");
+                    add_error(g_error_collector, STAGE_LEXER, source_location(file_id, i), "unknown escape sequence");
                     char_val = code[i];
                 }
                 i++;
-                column++;
             } else {
                 char_val = code[i];
                 i++;
-                column++;
             }
 
             if (code[i] != '\'') {
-                SourceLocation loc = {.line = line, .column = start_col, .filename = filename};
-                add_error(g_error_collector, STAGE_LEXER, loc, "unterminated character literal (expected ')");
+                add_error(g_error_collector, STAGE_LEXER, source_location(file_id, start),
+                          "unterminated character literal (expected ')");
                 //recover by skipping until whitespace or next quote
             } else {
                 i++;
-                column++;
             }
 
-            int* val_ptr = malloc(sizeof(int));
-            *val_ptr = (int)char_val;
-
-            tokens[count++] = (Token){
-                .type = CHAR_LIT_T,
-                .value = val_ptr,
-                .line = line,
-                .column = start_col,
-                .filename = filename
-            };
-            
-            if (count >= capacity) {
-                capacity *= 2;
-                tokens = realloc(tokens, capacity * sizeof(Token));
-            }
+            PUSH(CHAR_LIT_T, start);
+            LAST.as.int_val = (int)char_val;
             continue;
         }
 
         //keywords and identifiers
         if ((code[i] >= 'a' && code[i] <= 'z') || (code[i] >= 'A' && code[i] <= 'Z') || code[i] == '_') {
-            int start = i;
             while ((code[i] >= 'a' && code[i] <= 'z') ||
                    (code[i] >= 'A' && code[i] <= 'Z') ||
                    (code[i] >= '0' && code[i] <= '9') ||
                    code[i] == '_') {
                 i++;
-                column++;
             }
 
             int len = i - start;
-            char* word = malloc(len + 1);
-            strncpy(word, &code[start], len);
-            word[len] = '\0';
-
-            TokenType type = VAR_T;
-            void* value = word;
-            bool free_word = false;
-
-            if (strcmp(word, "if") == 0) { type = IF_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "else") == 0) { type = ELSE_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "int") == 0) { type = INT_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "char") == 0) { type = CHAR_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "void") == 0) { type = VOID_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "null") == 0) { type = NULL_LIT_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "bool") == 0) { type = BOOL_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "string") == 0) { type = STR_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "def") == 0) { type = DEF_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "include") == 0) { type = INCLUDE_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "extern") == 0) { type = EXTERN_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "while") == 0) { type = WHILE_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "do") == 0) { type = DO_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "for") == 0) { type = FOR_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "to") == 0) { type = TO_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "return") == 0) { type = RETURN_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "alloc") == 0) { type = ALLOC_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "free") == 0) { type = FREE_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "match") == 0) { type = MATCH_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "some") == 0) { type = SOME_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "own") == 0) { type = OWN_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "ref") == 0) { type = REF_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "const") == 0) { type = CONST_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "float") == 0) { type = FLOAT_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "double") == 0) { type = DOUBLE_KEYWORD_T; value = NULL; free_word = true; }
-            else if (strcmp(word, "true") == 0) {
-                type = BOOL_LIT_T;
-                int* val = malloc(sizeof(int));
-                *val = 1;
-                value = val;
-                free_word = true;
-            }
-            else if (strcmp(word, "false") == 0) {
-                type = BOOL_LIT_T;
-                int* val = malloc(sizeof(int));
-                *val = 0;
-                value = val;
-                free_word = true;
-            }
-            if (strcmp(word, "_") == 0) {
-                type = UNDERSCORE_T;
-                value = NULL;
-                free_word = true;
-            }
-
-            tokens[count++] = (Token){
-                .type = type,
-                .value = value,
-                .line = line,
-                .column = start_col,
-                .filename = filename
-            };
-
-            if (free_word) free(word);
-
-            if (count >= capacity) {
-                capacity *= 2;
-                tokens = realloc(tokens, capacity * sizeof(Token));
-            }
+            TokenType type = lookup_keyword(&code[start], len);
+            PUSH(type, start);
+            if (type == VAR_T) {
+                LAST.as.ident.length = (uint32_t)len;
+                LAST.as.ident.id = intern_id(intern(&code[start], len));
+            } else if (type == BOOL_LIT_T) LAST.as.int_val = (code[start] == 't');
             continue;
         }
 
@@ -308,128 +218,71 @@ Token* tokenize(char* code, int* out_count, const char* filename) {
         if (c == '/') {
             if (code[i + 1] == '/') {
                 i += 2;
-                column += 2;
-                while (code[i] != '\n' && code[i] != '\0') {
-                    i++;
-                    column++;
-                }
+                while (code[i] != '\n' && code[i] != '\0') i++;
                 continue;
             }
             else if (code[i + 1] == '*') {
                 i += 2;
-                column += 2;
-                while (code[i] != '\0' && !(code[i] == '*' && code[i + 1] == '/')) {
-                    if (code[i] == '\n') {
-                        line++;
-                        column = 1;
-                    } else {
-                        column++;
-                    }
-                    i++;
-                }
-                if (code[i] != '\0') {
-                    i += 2;
-                    column += 2;
-                }
+                while (code[i] != '\0' && !(code[i] == '*' && code[i + 1] == '/')) i++;
+                if (code[i] != '\0') i += 2;
                 continue;
             }
             else {
-                tokens[count++] = (Token){
-                    .type = SLASH_T,
-                    .value = NULL,
-                    .line = line,
-                    .column = start_col,
-                    .filename = filename
-                };
+                PUSH(SLASH_T, start);
                 i++;
-                column++;
                 continue;
             }
         }
 
         //two-character operators
         if (c == '=') {
-            if (code[i + 1] == '=') {
-                tokens[count++] = (Token){ .type = DOUBLE_EQUALS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i += 2;
-                column += 2;
-            } else {
-                tokens[count++] = (Token){ .type = EQUALS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i++;
-                column++;
-            }
-            goto resize_check;
+            if (code[i + 1] == '=') { PUSH(DOUBLE_EQUALS_T, start); i += 2; }
+            else { PUSH(EQUALS_T, start); i++; }
+            continue;
         }
 
         if (c == '!') {
-            if (code[i + 1] == '=') {
-                tokens[count++] = (Token){ .type = NOT_EQUALS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i += 2;
-                column += 2;
-            } else {
-                tokens[count++] = (Token){ .type = NEGATION_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i++;
-                column++;
-            }
-            goto resize_check;
+            if (code[i + 1] == '=') { PUSH(NOT_EQUALS_T, start); i += 2; }
+            else { PUSH(NEGATION_T, start); i++; }
+            continue;
         }
 
         if (c == '<') {
-            if (code[i + 1] == '=') {
-                tokens[count++] = (Token){ .type = LESS_EQUALS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i += 2;
-                column += 2;
-            } else {
-                tokens[count++] = (Token){ .type = LESS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i++;
-                column++;
-            }
-            goto resize_check;
+            if (code[i + 1] == '=') { PUSH(LESS_EQUALS_T, start); i += 2; }
+            else { PUSH(LESS_T, start); i++; }
+            continue;
         }
 
         if (c == '>') {
-            if (code[i + 1] == '=') {
-                tokens[count++] = (Token){ .type = MORE_EQUALS_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i += 2;
-                column += 2;
-            } else {
-                tokens[count++] = (Token){ .type = MORE_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
-                i++;
-                column++;
-            }
-            goto resize_check;
+            if (code[i + 1] == '=') { PUSH(MORE_EQUALS_T, start); i += 2; }
+            else { PUSH(MORE_T, start); i++; }
+            continue;
         }
 
         if (c == '&') {
             if (code[i + 1] == '&') {
-                tokens[count++] = (Token){ .type = AND_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
+                PUSH(AND_T, start);
                 i += 2;
-                column += 2;
-                goto resize_check;
             } else {
                 //error with recovery - suggest && instead
-                SourceLocation loc = {.line = line, .column = start_col, .filename = filename};
-                add_error(g_error_collector, STAGE_LEXER, loc, "single '&' not supported, did you mean '&&'?");
+                add_error(g_error_collector, STAGE_LEXER, source_location(file_id, start),
+                          "single '&' not supported, did you mean '&&'?");
                 i++;
-                column++;
-                continue;
             }
+            continue;
         }
 
         if (c == '|') {
             if (code[i + 1] == '|') {
-                tokens[count++] = (Token){ .type = OR_T, .value = NULL, .line = line, .column = start_col, .filename = filename };
+                PUSH(OR_T, start);
                 i += 2;
-                column += 2;
-                goto resize_check;
             } else {
                 //error with recovery - suggest || instead
-                SourceLocation loc = {.line = line, .column = start_col, .filename = filename};
-                add_error(g_error_collector, STAGE_LEXER, loc, "single '|' not supported, did you mean '||'?");
+                add_error(g_error_collector, STAGE_LEXER, source_location(file_id, start),
+                          "single '|' not supported, did you mean '||'?");
                 i++;
-                column++;
-                continue;
             }
+            continue;
         }
 
         //single-character tokens
@@ -456,63 +309,41 @@ Token* tokenize(char* code, int* out_count, const char* filename) {
         }
 
         if (found) {
-            tokens[count++] = (Token){
-                .type = single_char_type,
-                .value = NULL,
-                .line = line,
-                .column = start_col,
-                .filename = filename
-            };
+            PUSH(single_char_type, start);
             i++;
-            column++;
-            goto resize_check;
+            continue;
         }
 
         //unknown character
-        SourceLocation loc = {.line = line, .column = start_col, .filename = filename};
-        add_error(g_error_collector, STAGE_LEXER, loc,
+        add_error(g_error_collector, STAGE_LEXER, source_location(file_id, start),
                   "unexpected character '%c' (ASCII %d)", c, c);
         i++;
-        column++;
-        continue;
-
-resize_check:
-        if (count >= capacity) {
-            capacity *= 2;
-            tokens = realloc(tokens, capacity * sizeof(Token));
-        }
     }
 
     //add EOF token
-    if (count >= capacity) {
-        capacity *= 2;
-        tokens = realloc(tokens, capacity * sizeof(Token));
-    }
-    tokens[count++] = (Token){
-        .type = EOF_T,
-        .value = NULL,
-        .line = line,
-        .column = column,
-        .filename = filename
-    };
+    PUSH(EOF_T, i);
+
+#undef LAST
+#undef PUSH
 
     *out_count = count;
     return tokens;
 }
 
 void print_tokens(Token* tokens, int count) {
-    if (!g_trace_mode) return;
+    if (!trace_on(STAGE_LEXER)) return;
     fprintf(stderr, "=== TOKENS (%d) ===\n", count);
     for (int i = 0; i < count; i++) {
-        fprintf(stderr, "[%3d] [%s:%d:%d] ", i, tokens[i].filename, tokens[i].line, tokens[i].column);
+        SourceLocation loc = token_loc(&tokens[i]);
+        fprintf(stderr, "[%3d] [%s:%d:%d] ", i, loc.filename, loc.line, loc.column);
         fprintf(stderr, "%s", token_type_name(tokens[i].type));
 
-        if (tokens[i].value != NULL) {
-            if (tokens[i].type == INT_LIT_T || tokens[i].type == BOOL_LIT_T) {
-                fprintf(stderr, " = %d", *(int*)tokens[i].value);
-            } else if (tokens[i].type == VAR_T || tokens[i].type == STR_LIT_T) {
-                fprintf(stderr, " = \"%s\"", (char*)tokens[i].value);
-            }
+        if (tokens[i].type == INT_LIT_T || tokens[i].type == BOOL_LIT_T) {
+            fprintf(stderr, " = %d", tokens[i].as.int_val);
+        } else if (tokens[i].type == VAR_T) {
+            fprintf(stderr, " = \"%s\"", intern_by_id(tokens[i].as.ident.id));
+        } else if (tokens[i].type == STR_LIT_T) {
+            fprintf(stderr, " = \"%.*s\"", (int)tokens[i].as.length, source_text(tokens[i].file_id) + tokens[i].offset + 1);
         }
 
         fprintf(stderr, "\n");
@@ -520,6 +351,45 @@ void print_tokens(Token* tokens, int count) {
     fprintf(stderr, "==================\n");
 }
 
+SourceLocation token_loc(const Token* tok) {
+    return source_location(tok->file_id, tok->offset);
+}
+
+char* token_text(const Token* tok) {
+    if (tok->type != VAR_T) return nullptr; //keywords and punctuation have no text payload
+    return intern_by_id(tok->as.ident.id);
+}
+
+char* token_string(const Token* tok) {
+    const char* src = source_text(tok->file_id) + tok->offset + 1; //skip opening quote
+    uint32_t len = tok->as.length;
+    char* str = arena_alloc(&g_arena, len + 1);
+    uint32_t str_i = 0;
+    uint32_t j = 0;
+
+    while (j < len) {
+        if (src[j] == '\\' && j + 1 < len) {
+            j++;
+            switch (src[j]) {
+                case 'n': str[str_i++] = '\n'; break;
+                case 't': str[str_i++] = '\t'; break;
+                case 'r': str[str_i++] = '\r'; break;
+                case '\\': str[str_i++] = '\\'; break;
+                case '"': str[str_i++] = '"'; break;
+                default:
+                    //unknown escape sequence - just include the character
+                    str[str_i++] = src[j];
+                    break;
+            }
+            j++;
+        } else {
+            str[str_i++] = src[j++];
+        }
+    }
+    str[str_i] = '\0';
+    return str;
+}
+
 const char* token_type_name(TokenType type) {
     switch (type) {
         case INT_LIT_T: return "int literal";
@@ -531,6 +401,11 @@ const char* token_type_name(TokenType type) {
         case MINUS_T: return "-";
         case STAR_T: return "*";
         case SLASH_T: return "/";
+        case SHIFT_LEFT_T: return "<<";
+        case SHIFT_RIGHT_T: return ">>";
+        case WRAP_PLUS_T: return "+";
+        case WRAP_MINUS_T: return "-";
+        case WRAP_STAR_T: return "*";
         case EQUALS_T: return "=";
         case DOUBLE_EQUALS_T: return "==";
         case NOT_EQUALS_T: return "!=";
@@ -4,6 +4,9 @@
 #define LYNC_LEXER_H
 
 #include "common.h"
+#include "source.h"
+#include "arena.h"
+#include "intern.h"
 
 typedef enum {
     //literals
@@ -17,6 +20,8 @@ typedef enum {
 
     //arithmetic operators
     PLUS_T, MINUS_T, STAR_T, SLASH_T,
+    SHIFT_LEFT_T, SHIFT_RIGHT_T,    //no source form, the optimizer makes them out of * and / by a power of two
+    WRAP_PLUS_T, WRAP_MINUS_T, WRAP_STAR_T, //no source form, + - * that wrap around instead of overflowing
 
     //comparison operators
     EQUALS_T,           //=
@@ -90,16 +95,36 @@ typedef enum {
     EOF_T,
 } TokenType;
 
+//token flags
+#define TOKF_FLOAT_SUFFIX 0x01  //float literal written with an f/F suffix
+
+//16 bytes: kind word, source offset and an inline payload. text is never copied here,
+//identifiers and strings are slices of the registered source (see source.h)
 typedef struct {
-    TokenType type;
-    void* value;
-    int line;
-    int column;
-    const char* filename;
+    uint32_t type : 8;      //TokenType
+    uint32_t flags : 8;     //TOKF_*
+    uint32_t file_id : 16;
+    uint32_t offset;        //byte offset of the token in its file
+    union {
+        int32_t int_val;    //int, char and bool literals
+        uint32_t length;    //string literals (without the quotes)
+        struct {
+            uint32_t length;
+            uint32_t id;    //interned name, see intern.h
+        } ident;
+        double float_val;
+    } as;
 } Token;
 
-Token* tokenize(char* code, int* out_count, const char* filename);
+_Static_assert(sizeof(Token) == 16, "Token should stay 16 bytes");
+
+Token* tokenize(int file_id, int* out_count);
+TokenType lookup_keyword(const char* s, int len); //returns VAR_T for non-keywords
 void print_tokens(Token* tokens, int count);
+
+SourceLocation token_loc(const Token* tok);
+char* token_text(const Token* tok);   //interned identifier, shared by every token with the same name
+char* token_string(const Token* tok); //arena copy of a string literal with escapes decoded
 const char* token_type_name(TokenType);
 
 
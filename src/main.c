@@ -6,43 +6,27 @@
 #include "analyzer.h"
 #include "optimizer.h"
 #include "file_loader.h"
+#include "source.h"
+#include "backend.h"
+#include "time_report.h"
+#include "thread_pool.h"
+#include "inliner.h"
+#include "ir.h"
+
+#include <limits.h>
 
 #ifdef _WIN32
 #include <process.h>
-#define NULL_REDIRECT ">nul 2>&1"
 #define EXE_EXT ".exe"
 #else
 #include <sys/wait.h>
-#define NULL_REDIRECT ">/dev/null 2>&1"
 #define EXE_EXT ""
 #endif
 
 //global state definitions
-ErrorCollector* g_error_collector = nullptr;
-bool g_trace_mode = false;
-int g_trace_depth = 0;
-
-//--- c compiler detection ---
-
-static const char* find_c_compiler(void) {
-    const char* compilers[] = {
-#ifdef _WIN32
-        "gcc", "clang", "cl",
-#else
-        "cc", "gcc", "clang",
-#endif
-    };
-    int count = sizeof(compilers) / sizeof(compilers[0]);
-
-    for (int i = 0; i < count; i++) {
-        char cmd[256];
-        snprintf(cmd, sizeof(cmd), "%s --version %s", compilers[i], NULL_REDIRECT);
-        if (system(cmd) == 0) {
-            return compilers[i];
-        }
-    }
-    return nullptr;
-}
+LYNC_THREAD_LOCAL ErrorCollector* g_error_collector = nullptr;
+unsigned g_trace_mask = 0;
+LYNC_THREAD_LOCAL int g_trace_depth = 0;
 
 static char* replace_extension(const char* path, const char* new_ext) {
     size_t len = strlen(path);
@@ -67,6 +51,61 @@ static char* replace_extension(const char* path, const char* new_ext) {
     return result;
 }
 
+static bool write_c_file(const OutBuf* code, const char* path) {
+    FILE* output = fopen(path, "w");
+    if (!output) return false;
+    bool ok = ob_write_to(code, output);
+    return fclose(output) == 0 && ok;
+}
+
+//comma separated stage names into a trace mask
+static bool parse_trace_mask(const char* list, unsigned* mask) {
+    *mask = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        bool found = len == 3 && strncmp(list, "all", 3) == 0;
+        if (found) *mask = TRACE_ALL;
+        for (int s = STAGE_LEXER; s <= STAGE_INTERNAL && !found; s++) {
+            const char* name = stage_name((ErrorStage)s);
+            if (strlen(name) == len && strncmp(list, name, len) == 0) {
+                *mask |= TRACE_STAGE_BIT(s);
+                found = true;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown trace stage: %.*s\n", (int)len, list);
+            return false;
+        }
+        list += len;
+        if (*list == ',') list++;
+    }
+    return true;
+}
+
+//-j value, 0 means one thread per cpu
+static bool parse_jobs(const char* s, int* jobs) {
+    char* end;
+    long n = strtol(s, &end, 10);
+    if (end == s || *end || n < 0 || n > 256) {
+        fprintf(stderr, "Invalid job count: %s\n", s);
+        return false;
+    }
+    *jobs = n == 0 ? pool_cpu_count() : (int)n;
+    return true;
+}
+
+//everything the pipeline built lives in g_arena and the source registry, drop it in one go
+static void release_compilation(bool mem_stats) {
+    time_report_print(stderr);
+    if (mem_stats) {
+        arena_print_stats(&g_arena, stderr);
+        intern_print_stats(stderr);
+    }
+    arena_release(&g_arena);
+    intern_release();
+    source_free_all();
+}
+
 void print_usage(const char* program_name) {
     fprintf(stderr, "Usage: %s [options] [input_file]\n", program_name);
     fprintf(stderr, "       %s run [options] [input_file]\n", program_name);
@@ -75,12 +114,29 @@ void print_usage(const char* program_name) {
     fprintf(stderr, "  -o <file>      Output executable name\n");
     fprintf(stderr, "  -S             Emit assembly instead of executable\n");
     fprintf(stderr, "  --emit-c       Keep the intermediate .c file\n");
+    fprintf(stderr, "  --emit-ir      Write the SSA IR of every function to <input>.ir\n");
+    fprintf(stderr, "  --via-ir       Emit C for the function bodies that lower to IR from the IR\n");
+    fprintf(stderr, "  --cc=<cc>      Use this C compiler, skips detection\n");
+    fprintf(stderr, "  --pipe         Stream the generated C to the compiler instead of a temp file\n");
     fprintf(stderr, "  -trace         Enable trace/debug output\n");
+    fprintf(stderr, "  --trace=<list> Trace only these stages, e.g. parser,codegen\n");
+    fprintf(stderr, "                 (lexer, parser, analyzer, optimizer, codegen, internal, all)\n");
     fprintf(stderr, "  -no-color      Disable colored output\n");
+    fprintf(stderr, "  --mem-stats    Print arena memory usage per compiler stage\n");
+    fprintf(stderr, "  -j <n>, --jobs=<n>\n");
+    fprintf(stderr, "                 Analyze and emit function bodies on n threads (0 = one per cpu, default 1)\n");
+    fprintf(stderr, "  --opt-stats    Print how often each optimizer pass ran and what it changed\n");
+    fprintf(stderr, "  --time-report[=json]\n");
+    fprintf(stderr, "                 Print wall/cpu time, peak rss and allocations per phase\n");
     fprintf(stderr, "  -O0            No optimization (default)\n");
     fprintf(stderr, "  -O1            Basic optimizations (constant folding)\n");
-    fprintf(stderr, "  -O2            More optimizations (dead code elimination)\n");
-    fprintf(stderr, "  -O3            All optimizations (including inlining)\n");
+    fprintf(stderr, "  -O2            -O1 plus constant propagation, peephole rewrites, common subexpression\n");
+    fprintf(stderr, "                 elimination, loop invariant motion, strength reduction and dead code elimination\n");
+    fprintf(stderr, "  -O3            -O2 plus inlining and loop unrolling\n");
+    fprintf(stderr, "  --inline-threshold=<n>\n");
+    fprintf(stderr, "                 Largest function (in ast nodes) -O3 inlines, default %d, 0 = never\n", INLINE_DEFAULT_THRESHOLD);
+    fprintf(stderr, "  --unroll-limit=<n>\n");
+    fprintf(stderr, "                 Most ast nodes -O3 copies a for body into when unrolling, default %d, 0 = never\n", UNROLL_DEFAULT_LIMIT);
     fprintf(stderr, "  -Os            Optimize for size\n");
     fprintf(stderr, "  -h, --help     Show this help message\n");
     fprintf(stderr, "\n");
@@ -92,8 +148,13 @@ int main(int argc, char** argv) {
     const char* exe_output = nullptr;  // -o flag: executable name
     bool no_color = false;
     bool emit_c = false;
+    bool use_pipe = false;
+    const char* cc_override = nullptr;
     bool emit_asm = false;
     bool run_mode = false;
+    bool mem_stats = false;
+    bool print_opt_stats = false;
+    bool emit_ir = false;
 
     int opt_level = 0;
     bool opt_size = false;
@@ -102,11 +163,52 @@ int main(int argc, char** argv) {
         if (strcmp(argv[i], "run") == 0 && !input_file && !run_mode) {
             run_mode = true;
         } else if (strcmp(argv[i], "-trace") == 0 || strcmp(argv[i], "--trace") == 0) {
-            g_trace_mode = true;
+            g_trace_mask = TRACE_ALL;
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            if (!parse_trace_mask(argv[i] + 8, &g_trace_mask)) {
+                print_usage(argv[0]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "-no-color") == 0 || strcmp(argv[i], "--no-color") == 0) {
             no_color = true;
         } else if (strcmp(argv[i], "--emit-c") == 0) {
             emit_c = true;
+        } else if (strcmp(argv[i], "--emit-ir") == 0) {
+            emit_ir = true;
+        } else if (strcmp(argv[i], "--via-ir") == 0) {
+            g_via_ir = true;
+        } else if (strncmp(argv[i], "--cc=", 5) == 0 && argv[i][5]) {
+            cc_override = argv[i] + 5;
+        } else if (strcmp(argv[i], "--pipe") == 0) {
+            use_pipe = true;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            mem_stats = true;
+        } else if (strncmp(argv[i], "--inline-threshold=", 19) == 0) {
+            char* end;
+            long n = strtol(argv[i] + 19, &end, 10);
+            if (end == argv[i] + 19 || *end || n < 0 || n > INT_MAX) {
+                fprintf(stderr, "Invalid inline threshold: %s\n", argv[i] + 19);
+                return 1;
+            }
+            g_inline_threshold = (int)n;
+        } else if (strncmp(argv[i], "--unroll-limit=", 15) == 0) {
+            char* end;
+            long n = strtol(argv[i] + 15, &end, 10);
+            if (end == argv[i] + 15 || *end || n < 0 || n > INT_MAX) {
+                fprintf(stderr, "Invalid unroll limit: %s\n", argv[i] + 15);
+                return 1;
+            }
+            g_unroll_limit = (int)n;
+        } else if (strcmp(argv[i], "--opt-stats") == 0) {
+            print_opt_stats = true;
+        } else if (strcmp(argv[i], "--time-report") == 0 || strcmp(argv[i], "--time-report=table") == 0) {
+            g_time_report = TIME_REPORT_TABLE;
+        } else if (strcmp(argv[i], "--time-report=json") == 0) {
+            g_time_report = TIME_REPORT_JSON;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            if (!parse_jobs(argv[++i], &g_jobs)) return 1;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0 || (strncmp(argv[i], "-j", 2) == 0 && argv[i][2])) {
+            if (!parse_jobs(argv[i] + (argv[i][1] == 'j' ? 2 : 7), &g_jobs)) return 1;
         } else if (strcmp(argv[i], "-S") == 0) {
             emit_asm = true;
         } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
@@ -133,6 +235,10 @@ int main(int argc, char** argv) {
 
     if (!input_file) input_file = "../test.lync";
 
+    if (!LYNC_ENABLE_TRACE && g_trace_mask) {
+        fprintf(stderr, "warning: tracing is compiled out of this build (LYNC_ENABLE_TRACE=0)\n");
+    }
+
     //compute output paths
     char* c_file = replace_extension(input_file, ".c");
     char* exe_file;
@@ -143,41 +249,36 @@ int main(int argc, char** argv) {
     }
 
     //find a C compiler
-    const char* compiler = find_c_compiler();
-    if (!compiler) {
+    CCompiler compiler;
+    if (!backend_find_compiler(&compiler, cc_override)) {
         fprintf(stderr, "Error: no C compiler found. Install gcc, clang, or MSVC and ensure it's on your PATH.\n");
         free(c_file);
         free(exe_file);
         return 1;
     }
-    stage_trace(STAGE_CODEGEN, "using C compiler: %s", compiler);
+    stage_trace(STAGE_CODEGEN, "using C compiler: %s (%s)", compiler.path,
+        compiler.version[0] ? compiler.version : "version not probed");
 
     //initialize error collector
     g_error_collector = init_error_collector();
     if (no_color) g_error_collector->use_color = false;
 
     //read input file
-    FILE* file = fopen(input_file, "r");
-    if (file == NULL) {
+    int file_id = source_load(input_file);
+    if (file_id < 0) {
         fprintf(stderr, "Error: Could not open '%s'\n", input_file);
         free(c_file);
         free(exe_file);
         return 1;
     }
 
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char* code = malloc(file_size + 1);
-    size_t bytes_read = fread(code, 1, file_size, file);
-    code[bytes_read] = '\0';
-    fclose(file);
-
     //--- lexer ---
+    arena_set_stage(&g_arena, STAGE_LEXER);
     stage_trace_enter(STAGE_LEXER, "starting lexical analysis");
+    time_phase_begin(PHASE_LEXER);
     int token_count;
-    Token* tokens = tokenize(code, &token_count, input_file);
+    Token* tokens = tokenize(file_id, &token_count);
+    time_phase_end(PHASE_LEXER);
     stage_trace_exit(STAGE_LEXER, "completed, %d tokens", token_count);
     print_tokens(tokens, token_count);
 
@@ -185,14 +286,16 @@ int main(int argc, char** argv) {
     if (has_errors(g_error_collector)) {
         print_messages(g_error_collector);
         free_error_collector(g_error_collector);
-        free(code);
+        release_compilation(mem_stats);
         free(c_file);
         free(exe_file);
         return 1;
     }
 
     //--- parser ---
+    arena_set_stage(&g_arena, STAGE_PARSER);
     stage_trace_enter(STAGE_PARSER, "starting parsing");
+    time_phase_begin(PHASE_PARSER);
     Parser parser = {
             .tokens = tokens,
             .count = token_count,
@@ -201,6 +304,7 @@ int main(int argc, char** argv) {
     };
 
     Program* program = parseProgram(&parser);
+    time_phase_end(PHASE_PARSER);
     stage_trace_exit(STAGE_PARSER, "parsed %d functions, %d imports",
         program->func_count, program->imports->import_count);
     print_ast(program->functions, program->func_count);
@@ -209,7 +313,7 @@ int main(int argc, char** argv) {
     if (has_errors(g_error_collector)) {
         print_messages(g_error_collector);
         free_error_collector(g_error_collector);
-        free(code);
+        release_compilation(mem_stats);
         free(c_file);
         free(exe_file);
         return 1;
@@ -217,29 +321,34 @@ int main(int argc, char** argv) {
 
     //--- file includes ---
     stage_trace_enter(STAGE_PARSER, "processing file includes");
+    time_phase_begin(PHASE_INCLUDES);
     process_file_includes(program, input_file);
+    time_phase_end(PHASE_INCLUDES);
     stage_trace_exit(STAGE_PARSER, "file includes processed, now %d functions", program->func_count);
 
     //check for include errors
     if (has_errors(g_error_collector)) {
         print_messages(g_error_collector);
         free_error_collector(g_error_collector);
-        free(code);
+        release_compilation(mem_stats);
         free(c_file);
         free(exe_file);
         return 1;
     }
 
     //--- analyzer ---
+    arena_set_stage(&g_arena, STAGE_ANALYZER);
     stage_trace_enter(STAGE_ANALYZER, "starting semantic analysis");
+    time_phase_begin(PHASE_ANALYZER);
     analyze_program(program);
+    time_phase_end(PHASE_ANALYZER);
     stage_trace_exit(STAGE_ANALYZER, "analysis complete");
 
     //check for analyzer errors
     if (has_errors(g_error_collector)) {
         print_messages(g_error_collector);
         free_error_collector(g_error_collector);
-        free(code);
+        release_compilation(mem_stats);
         free(c_file);
         free(exe_file);
         return 1;
@@ -247,17 +356,22 @@ int main(int argc, char** argv) {
 
     //--- optimizer ---
     if (opt_level > 0) {
+        arena_set_stage(&g_arena, STAGE_OPTIMIZER);
         stage_trace_enter(STAGE_OPTIMIZER, "starting optimizations");
 
         OptimizationLevel level = OPT_NONE;
         if (opt_level >= 1) level |= OPT_CONST_FOLD;
-        if (opt_level >= 2) level |= OPT_DEAD_CODE | OPT_PEEPHOLE;
-        if (opt_level >= 3) level |= OPT_INLINE;
+        if (opt_level >= 2) level |= OPT_CONST_PROP | OPT_DEAD_CODE | OPT_PEEPHOLE | OPT_CSE | OPT_LICM | OPT_STRENGTH;
+        if (opt_level >= 3) level |= OPT_INLINE | OPT_UNROLL;
         if (opt_size) {
-            level &= ~OPT_INLINE;  // inlining increases size
+            level &= ~(OPT_INLINE | OPT_UNROLL);  // inlining and unrolling increase size
         }
 
-        optimize_program(program->functions, program->func_count, level);
+        time_phase_begin(PHASE_OPTIMIZER);
+        OptStats opt_stats = {0};
+        optimize_program(program->functions, program->func_count, level, &opt_stats);
+        time_phase_end(PHASE_OPTIMIZER);
+        if (print_opt_stats) opt_stats_print(&opt_stats, stderr);
 
         //re-run analysis after optimizations? Not sure if needed?
         //analyze_program(program, func_count);
@@ -265,46 +379,96 @@ int main(int argc, char** argv) {
         stage_trace_exit(STAGE_OPTIMIZER, "optimizations complete");
     }
 
+    //--- ir ---
+    if (emit_ir || g_via_ir) {
+        arena_set_stage(&g_arena, STAGE_OPTIMIZER);
+        stage_trace_enter(STAGE_OPTIMIZER, "lowering to ir");
+        time_phase_begin(PHASE_IR);
+        int lowered = ir_lower_program(program->functions, program->func_count);
+
+        bool ir_written = true;
+        if (emit_ir) {
+            char* ir_file = replace_extension(input_file, ".ir");
+            OutBuf text;
+            ob_init(&text, 0);
+            ir_dump_program(program->functions, program->func_count, &text);
+            ir_written = write_c_file(&text, ir_file);
+            if (!ir_written) fprintf(stderr, "Error: Could not open output file '%s'\n", ir_file);
+            ob_free(&text);
+            free(ir_file);
+        }
+        time_phase_end(PHASE_IR);
+        stage_trace_exit(STAGE_OPTIMIZER, "%d of %d functions lowered", lowered, program->func_count);
+
+        //a function that fails verification is a compiler bug, nothing gets emitted from it
+        if (!ir_written || has_errors(g_error_collector)) {
+            print_messages(g_error_collector);
+            free_error_collector(g_error_collector);
+            release_compilation(mem_stats);
+            free(c_file);
+            free(exe_file);
+            return 1;
+        }
+    }
+
     //--- codegen ---
+    arena_set_stage(&g_arena, STAGE_CODEGEN);
     stage_trace_enter(STAGE_CODEGEN, "starting code generation");
-    FILE *output = fopen(c_file, "w");
-    if (!output) {
-        fprintf(stderr, "Error: Could not open output file '%s'\n", c_file);
-        free_error_collector(g_error_collector);
-        free(code);
-        free(c_file);
-        free(exe_file);
-        return 1;
+    OutBuf c_code;
+    time_phase_begin(PHASE_CODEGEN);
+    ob_init(&c_code, 0);
+    generate_code(program, &c_code);
+
+    bool pipe_c = use_pipe && compiler.can_pipe;
+    if (use_pipe && !pipe_c) {
+        stage_trace(STAGE_CODEGEN, "%s cannot read from stdin, using a temp file", compiler.name);
     }
 
-    generate_code(program, output);
-    fclose(output);
-    stage_trace_exit(STAGE_CODEGEN, "wrote %s", c_file);
+    //with --pipe the file only exists as a tee for --emit-c
+    if (!pipe_c || emit_c) {
+        if (!write_c_file(&c_code, c_file)) {
+            fprintf(stderr, "Error: Could not open output file '%s'\n", c_file);
+            ob_free(&c_code);
+            free_error_collector(g_error_collector);
+            release_compilation(mem_stats);
+            free(c_file);
+            free(exe_file);
+            return 1;
+        }
+        stage_trace_exit(STAGE_CODEGEN, "wrote %s", c_file);
+    } else {
+        stage_trace_exit(STAGE_CODEGEN, "generated %zu bytes of C", c_code.len);
+    }
+    time_phase_end(PHASE_CODEGEN);
 
     //print any warnings
     print_messages(g_error_collector);
 
     stage_trace_enter(STAGE_CODEGEN, "invoking C backend");
-    char cmd[2048];
-    snprintf(cmd, sizeof(cmd), "%s \"%s\" -o \"%s\"", compiler, c_file, exe_file);
-    stage_trace(STAGE_CODEGEN, "running: %s", cmd);
-
-    int cc_result = system(cmd);
+    time_phase_begin(PHASE_BACKEND);
+    int cc_result = pipe_c
+        ? backend_compile_pipe(&compiler, &c_code, c_file, exe_file)
+        : backend_compile_file(&compiler, c_file, exe_file);
+    time_phase_end(PHASE_BACKEND);
     stage_trace_exit(STAGE_CODEGEN, "C compiler exited with %d", cc_result);
 
     if (cc_result != 0) {
         fprintf(stderr, "\nError: C compiler failed (exit code %d)\n", cc_result);
-        fprintf(stderr, "Intermediate file kept: %s\n", c_file);
-        //dont delete .c file on failure
+        //dont delete .c file on failure, and write it out if it only went through the pipe
+        if (!pipe_c || emit_c || write_c_file(&c_code, c_file)) {
+            fprintf(stderr, "Intermediate file kept: %s\n", c_file);
+        }
+        ob_free(&c_code);
         free_error_collector(g_error_collector);
-        free(code);
+        release_compilation(mem_stats);
         free(c_file);
         free(exe_file);
         return 1;
     }
+    ob_free(&c_code);
 
     //clean up intermediate .c file (unless --emit-c)
-    if (!emit_c) {
+    if (!emit_c && !pipe_c) {
         remove(c_file);
     }
 
@@ -344,10 +508,14 @@ int main(int argc, char** argv) {
         if (emit_c) {
             printf("Kept intermediate: %s\n", c_file);
         }
+        if (emit_ir) {
+            char* ir_file = replace_extension(input_file, ".ir");
+            printf("Wrote IR: %s\n", ir_file);
+            free(ir_file);
+        }
     }
 
-    free(tokens);
-    free(code);
+    release_compilation(mem_stats);
     free(c_file);
     free(exe_file);
     free_error_collector(g_error_collector);
@@ -2,144 +2,186 @@
 
 #include "optimizer.h"
 #include "common.h"
+#include "inliner.h"
+#include "intern.h"
+#include <string.h>
 
 // ============ CONSTANT FOLDING ============
 
-bool is_constant_expr(Expr* e) {
+//the value of a constant int/bool expression, false if e is not one or if running it is undefined in c
+//(division by zero, INT_MIN / -1, overflow), that is left for the program to do at run time
+static bool constant_value(Expr* e, int* value) {
     if (!e) return false;
+    long long v;
     switch (e->type) {
-        case INT_LIT_E:
-        case BOOL_LIT_E:
-        case STR_LIT_E:
-            return true;
-        case UN_OP_E:
-            return is_constant_expr(e->as.un_op.expr);
-        case BIN_OP_E:
-            return is_constant_expr(e->as.bin_op.exprL) &&
-                   is_constant_expr(e->as.bin_op.exprR);
-        default:
-            return false;
-    }
-}
-
-int eval_constant_expr(Expr* e) {
-    if (!e) return 0;
-    switch (e->type) {
-        case INT_LIT_E: return e->as.int_val;
-        case BOOL_LIT_E: return e->as.bool_val;
+        case INT_LIT_E: *value = e->as.int_val; return true;
+        case BOOL_LIT_E: *value = e->as.bool_val; return true;
         case UN_OP_E: {
-            int val = eval_constant_expr(e->as.un_op.expr);
-            if (e->as.un_op.op == MINUS_T) return -val;
-            if (e->as.un_op.op == NEGATION_T) return !val;
-            return val;
+            int x;
+            if (!constant_value(e->as.un_op.expr, &x)) return false;
+            if (e->as.un_op.op == MINUS_T) v = -(long long)x;
+            else if (e->as.un_op.op == NEGATION_T) v = !x;
+            else v = x;
+            break;
         }
         case BIN_OP_E: {
-            int left = eval_constant_expr(e->as.bin_op.exprL);
-            int right = eval_constant_expr(e->as.bin_op.exprR);
+            int l, r;
+            if (!constant_value(e->as.bin_op.exprL, &l) || !constant_value(e->as.bin_op.exprR, &r)) return false;
             switch (e->as.bin_op.op) {
-                case PLUS_T: return left + right;
-                case MINUS_T: return left - right;
-                case STAR_T: return left * right;
-                case SLASH_T: return right != 0 ? left / right : 0;
-                case LESS_T: return left < right;
-                case MORE_T: return left > right;
-                case LESS_EQUALS_T: return left <= right;
-                case MORE_EQUALS_T: return left >= right;
-                case DOUBLE_EQUALS_T: return left == right;
-                case NOT_EQUALS_T: return left != right;
-                case AND_T: return left && right;
-                case OR_T: return left || right;
-                default: return 0;
+                case PLUS_T: v = (long long)l + r; break;
+                case MINUS_T: v = (long long)l - r; break;
+                case STAR_T: v = (long long)l * r; break;
+                case SLASH_T:
+                    if (r == 0 || (l == INT32_MIN && r == -1)) return false;
+                    v = l / r;
+                    break;
+                case SHIFT_LEFT_T:
+                    if (r < 0 || r >= 32) return false;
+                    *value = (int)((unsigned)l << r);
+                    return true;
+                case SHIFT_RIGHT_T:
+                    if (r < 0 || r >= 32) return false;
+                    v = l >> r;
+                    break;
+                case WRAP_PLUS_T: *value = (int)((unsigned)l + (unsigned)r); return true;
+                case WRAP_MINUS_T: *value = (int)((unsigned)l - (unsigned)r); return true;
+                case WRAP_STAR_T: *value = (int)((unsigned)l * (unsigned)r); return true;
+                case LESS_T: v = l < r; break;
+                case MORE_T: v = l > r; break;
+                case LESS_EQUALS_T: v = l <= r; break;
+                case MORE_EQUALS_T: v = l >= r; break;
+                case DOUBLE_EQUALS_T: v = l == r; break;
+                case NOT_EQUALS_T: v = l != r; break;
+                case AND_T: v = l && r; break;
+                case OR_T: v = l || r; break;
+                default: return false;
             }
+            break;
         }
-        default: return 0;
+        default:
+            return false;
     }
+    if (v < INT32_MIN || v > INT32_MAX) return false;
+    *value = (int)v;
+    return true;
+}
+
+bool is_constant_expr(Expr* e) {
+    int value;
+    return constant_value(e, &value);
 }
 
-//returns true if expression was modified
-bool fold_expression(Expr** e_ptr) {
-    if (!e_ptr || !*e_ptr) return false;
+int eval_constant_expr(Expr* e) {
+    int value;
+    return constant_value(e, &value) ? value : 0;
+}
+
+//returns how many rewrites it made, 0 if the expression is unchanged
+int fold_expression(Expr** e_ptr) {
+    if (!e_ptr || !*e_ptr) return 0;
 
     Expr* e = *e_ptr;
-    bool modified = false;
+    int changes = 0;
 
-    if (e->type == UN_OP_E) {
-        modified |= fold_expression(&e->as.un_op.expr);
-    } else if (e->type == BIN_OP_E) {
-        modified |= fold_expression(&e->as.bin_op.exprL);
-        modified |= fold_expression(&e->as.bin_op.exprR);
+    switch (e->type) {
+        case UN_OP_E:
+            changes += fold_expression(&e->as.un_op.expr);
+            break;
+        case BIN_OP_E:
+            changes += fold_expression(&e->as.bin_op.exprL);
+            changes += fold_expression(&e->as.bin_op.exprR);
+            break;
+        //not constant themselves, but what they are made of can be
+        case FUNC_RET_E:
+            changes += fold_expression(&e->as.func_ret_expr);
+            break;
+        case FUNC_CALL_E:
+            for (int i = 0; i < e->as.func_call.count; i++) {
+                changes += fold_expression(&e->as.func_call.params[i]);
+            }
+            break;
+        case ARRAY_ACCESS_E:
+            changes += fold_expression(&e->as.array_access.index);
+            break;
+        case MATCH_E:
+            changes += fold_expression(&e->as.match.var);
+            for (int i = 0; i < e->as.match.branchCount; i++) {
+                changes += fold_expression(&e->as.match.branches[i].caseRet);
+            }
+            break;
+        default:
+            break;
     }
 
-    if (is_constant_expr(e) && e->analyzedType != STR_KEYWORD_T) {
-        int value = eval_constant_expr(e);
-
+    int value;
+    if (e->analyzedType != STR_KEYWORD_T && constant_value(e, &value)) {
         if (e->analyzedType == INT_KEYWORD_T) {
             if (e->type != INT_LIT_E || e->as.int_val != value) {
                 e->type = INT_LIT_E;
                 e->as.int_val = value;
-                modified = true;
+                changes++;
             }
         } else if (e->analyzedType == BOOL_KEYWORD_T) {
             if (e->type != BOOL_LIT_E || e->as.bool_val != value) {
                 e->type = BOOL_LIT_E;
                 e->as.bool_val = value;
-                modified = true;
+                changes++;
             }
         }
     }
 
-    return modified;
+    return changes;
 }
 
-//returns true if statement was modified
-bool constant_folding_stmt(Stmt* s) {
-    if (!s) return false;
+//returns how many rewrites it made, 0 if the statement is unchanged
+int constant_folding_stmt(Stmt* s) {
+    if (!s) return 0;
 
-    bool modified = false;
+    int changes = 0;
 
     switch (s->type) {
         case VAR_DECL_S:
-            modified |= fold_expression(&s->as.var_decl.expr);
+            changes += fold_expression(&s->as.var_decl.expr);
             break;
         case ASSIGN_S:
-            modified |= fold_expression(&s->as.var_assign.expr);
+            changes += fold_expression(&s->as.var_assign.expr);
             break;
         case IF_S:
-            modified |= fold_expression(&s->as.if_stmt.cond);
-            modified |= constant_folding_stmt(s->as.if_stmt.trueStmt);
-            modified |= constant_folding_stmt(s->as.if_stmt.falseStmt);
+            changes += fold_expression(&s->as.if_stmt.cond);
+            changes += constant_folding_stmt(s->as.if_stmt.trueStmt);
+            changes += constant_folding_stmt(s->as.if_stmt.falseStmt);
             break;
         case WHILE_S:
-            modified |= fold_expression(&s->as.while_stmt.cond);
-            modified |= constant_folding_stmt(s->as.while_stmt.body);
+            changes += fold_expression(&s->as.while_stmt.cond);
+            changes += constant_folding_stmt(s->as.while_stmt.body);
             break;
         case DO_WHILE_S:
-            modified |= constant_folding_stmt(s->as.do_while_stmt.body);
-            modified |= fold_expression(&s->as.do_while_stmt.cond);
+            changes += constant_folding_stmt(s->as.do_while_stmt.body);
+            changes += fold_expression(&s->as.do_while_stmt.cond);
             break;
         case FOR_S:
-            modified |= fold_expression(&s->as.for_stmt.min);
-            modified |= fold_expression(&s->as.for_stmt.max);
-            modified |= constant_folding_stmt(s->as.for_stmt.body);
+            changes += fold_expression(&s->as.for_stmt.min);
+            changes += fold_expression(&s->as.for_stmt.max);
+            changes += constant_folding_stmt(s->as.for_stmt.body);
             break;
         case BLOCK_S:
             for (int i = 0; i < s->as.block_stmt.count; i++) {
-                modified |= constant_folding_stmt(s->as.block_stmt.stmts[i]);
+                changes += constant_folding_stmt(s->as.block_stmt.stmts[i]);
             }
             break;
         case EXPR_STMT_S:
-            modified |= fold_expression(&s->as.expr_stmt);
+            changes += fold_expression(&s->as.expr_stmt);
             break;
         case MATCH_S:
-            modified |= fold_expression(&s->as.match_stmt.var);
+            changes += fold_expression(&s->as.match_stmt.var);
             for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
                 MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
                 // for VALUE_PATTERN, fold the expression
                 if (branch->pattern->type == VALUE_PATTERN) {
-                    modified |= fold_expression(&branch->pattern->as.value_expr);
+                    changes += fold_expression(&branch->pattern->as.value_expr);
                 }
                 for (int j = 0; j < branch->stmtCount; j++) {
-                    modified |= constant_folding_stmt(branch->stmts[j]);
+                    changes += constant_folding_stmt(branch->stmts[j]);
                 }
             }
             break;
@@ -147,14 +189,14 @@ bool constant_folding_stmt(Stmt* s) {
             break;
     }
 
-    return modified;
+    return changes;
 }
 
 bool constant_folding(Func** program, int count) {
     stage_trace(STAGE_OPTIMIZER, "Running constant folding...");
     bool any_modified = false;
     for (int i = 0; i < count; i++) {
-        any_modified |= constant_folding_stmt(program[i]->body);
+        any_modified |= constant_folding_stmt(program[i]->body) > 0;
     }
     if (any_modified) {
         stage_trace(STAGE_OPTIMIZER, "Constant folding made changes");
@@ -162,6 +204,479 @@ bool constant_folding(Func** program, int count) {
     return any_modified;
 }
 
+// ============ LOCAL NAMES ============
+
+//what a function does with a name, over all its scopes
+typedef enum {
+    LOCAL_ESCAPED = 1 << 0, //passed or bound by ref/own, returned by ref or bound by some()
+    LOCAL_READ = 1 << 1,    //still read somewhere
+    LOCAL_IMPURE = 1 << 2,  //stored a value with a call in it
+    LOCAL_OWNED_ELEMENTS = 1 << 3,  //an array of owned pointers, its elements are no values
+    LOCAL_UNTRACKED = 1 << 4,       //declared somewhere (or a parameter) as other than a plain int/bool
+} LocalFlags;
+
+typedef struct {
+    char* name;
+    uint8_t flags;          //LocalFlags
+    int top;                //innermost visible declaration, for a pass that follows scopes. -1 if none
+} LocalName;
+
+//interned name -> LocalName, open addressing
+typedef struct {
+    LocalName* slots;
+    int capacity;           //power of two
+    int count;
+} LocalNames;
+
+//the slot for name, added on first use. only valid until the next call, the table may grow
+static LocalName* local_name(LocalNames* set, char* name) {
+    if (set->count * 2 >= set->capacity) {
+        LocalNames grown = {
+            .slots = calloc(set->capacity ? set->capacity * 2 : 64, sizeof(LocalName)),
+            .capacity = set->capacity ? set->capacity * 2 : 64,
+        };
+        for (int i = 0; i < set->capacity; i++) {
+            if (set->slots[i].name) *local_name(&grown, set->slots[i].name) = set->slots[i];
+        }
+        free(set->slots);
+        *set = grown;
+    }
+    uint32_t mask = (uint32_t)set->capacity - 1;
+    uint32_t i = intern_hash(name) & mask;
+    while (set->slots[i].name && set->slots[i].name != name) i = (i + 1) & mask;
+    if (!set->slots[i].name) {
+        set->slots[i] = (LocalName){name, 0, -1};
+        set->count++;
+    }
+    return &set->slots[i];
+}
+
+static bool local_has(LocalNames* set, char* name, LocalFlags flag) {
+    return local_name(set, name)->flags & flag;
+}
+
+typedef struct {
+    LocalNames* names;
+    Func* func;
+} EscapeScan;
+
+static void mark_escaped(EscapeScan* scan, Expr* e) {
+    if (e && e->type == VAR_E) local_name(scan->names, e->as.var.name)->flags |= LOCAL_ESCAPED;
+}
+
+static void escape_scan_expr(Expr* e, void* data) {
+    EscapeScan* scan = data;
+    if (e->type == SOME_E) {
+        mark_escaped(scan, e->as.some.var);
+    } else if (e->type == MATCH_E) {
+        for (int i = 0; i < e->as.match.branchCount; i++) {
+            Pattern* p = e->as.match.branches[i].pattern;
+            if (p && p->type == SOME_PATTERN) local_name(scan->names, p->as.binding_name)->flags |= LOCAL_ESCAPED;
+        }
+    } else if (e->type == FUNC_CALL_E && e->as.func_call.resolved_sign) {
+        FuncSign* sign = e->as.func_call.resolved_sign;
+        for (int i = 0; i < e->as.func_call.count && i < sign->paramNum; i++) {
+            if (sign->parameters[i].ownership != OWNERSHIP_NONE) mark_escaped(scan, e->as.func_call.params[i]);
+        }
+    } else if (e->type == FUNC_RET_E && scan->func->signature->retOwnership != OWNERSHIP_NONE) {
+        mark_escaped(scan, e->as.func_ret_expr);
+    }
+}
+
+static void escape_scan_stmt(Stmt* s, void* data) {
+    EscapeScan* scan = data;
+    if (s->type == VAR_DECL_S && s->as.var_decl.isArray && s->as.var_decl.elementOwnership != OWNERSHIP_NONE) {
+        local_name(scan->names, s->as.var_decl.name)->flags |= LOCAL_OWNED_ELEMENTS;
+    }
+    if (s->type == VAR_DECL_S && s->as.var_decl.ownership != OWNERSHIP_NONE) {
+        mark_escaped(scan, s->as.var_decl.expr);
+    } else if (s->type == ASSIGN_S && s->as.var_assign.ownership != OWNERSHIP_NONE) {
+        mark_escaped(scan, s->as.var_assign.expr);
+    } else if (s->type == MATCH_S) {
+        for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+            Pattern* p = s->as.match_stmt.branches[i].pattern;
+            if (p->type == SOME_PATTERN) local_name(scan->names, p->as.binding_name)->flags |= LOCAL_ESCAPED;
+        }
+    }
+}
+
+//marks LOCAL_ESCAPED on every name that can change behind a pass's back: handed to a ref/own parameter,
+//bound to a ref/own local or returned by ref. also names some() binds, expression walks do not see that scope.
+//arrays of owned elements get LOCAL_OWNED_ELEMENTS on the way
+static void scan_escapes(Func* f, LocalNames* names) {
+    EscapeScan scan = {names, f};
+    walk_stmt(f->body, escape_scan_stmt, escape_scan_expr, &scan);
+}
+
+// ============ CONSTANT PROPAGATION ============
+
+//a local the pass can follow: int or bool, no own/ref, not nullable, not an array and its address never taken
+typedef struct {
+    char* name;
+    TokenType type;
+    bool tracked;
+    int shadowed;           //the declaration of the same name this one hides, -1 if none
+} PropVar;
+
+//value of every visible variable at the current point, nullptr when it is not the same literal on all paths.
+//dead is set after a return, such a path does not count when branches join
+typedef struct {
+    Expr** values;
+    bool dead;
+} PropState;
+
+typedef struct {
+    PropVar* vars;          //in scope, innermost last
+    Expr** values;          //parallel to vars
+    int count;
+    int capacity;
+    bool dead;
+    LocalNames names;
+    int changes;
+} PropEnv;
+
+static void prop_declare(PropEnv* env, char* name, TokenType type, bool tracked, Expr* value) {
+    if (env->count == env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 16;
+        env->vars = realloc(env->vars, sizeof(PropVar) * env->capacity);
+        env->values = realloc(env->values, sizeof(Expr*) * env->capacity);
+    }
+    LocalName* slot = local_name(&env->names, name);
+    env->vars[env->count] = (PropVar){name, type, tracked, slot->top};
+    env->values[env->count] = tracked ? value : nullptr;
+    slot->top = env->count++;
+}
+
+//leaves the scope that started at mark, the names it declared uncover what they hid
+static void prop_pop(PropEnv* env, int mark) {
+    while (env->count > mark) {
+        PropVar* var = &env->vars[--env->count];
+        local_name(&env->names, var->name)->top = var->shadowed;
+    }
+}
+
+//-1 for parameters and anything not declared in the body
+static int prop_lookup(PropEnv* env, char* name) {
+    return local_name(&env->names, name)->top;
+}
+
+//the literal a tracked variable of the given type can hold, nullptr for anything else
+static Expr* prop_literal(Expr* e, TokenType type) {
+    if (!e) return nullptr;
+    if (type == INT_KEYWORD_T && e->type == INT_LIT_E) return e;
+    if (type == BOOL_KEYWORD_T && e->type == BOOL_LIT_E) return e;
+    return nullptr;
+}
+
+static bool prop_same(Expr* a, Expr* b) {
+    if (!a || !b || a->type != b->type) return false;
+    return a->type == INT_LIT_E ? a->as.int_val == b->as.int_val : a->as.bool_val == b->as.bool_val;
+}
+
+//env->values is still null while nothing is declared
+static void prop_store(PropState* st, PropEnv* env) {
+    if (env->count) memcpy(st->values, env->values, sizeof(Expr*) * env->count);
+    st->dead = env->dead;
+}
+
+static void prop_restore(PropEnv* env, PropState* st) {
+    if (env->count) memcpy(env->values, st->values, sizeof(Expr*) * env->count);
+    env->dead = st->dead;
+}
+
+static PropState prop_save(PropEnv* env) {
+    PropState st = {malloc(sizeof(Expr*) * (env->count ? env->count : 1)), false};
+    prop_store(&st, env);
+    return st;
+}
+
+//env becomes what holds after either env or st, a dead side adds nothing
+static void prop_meet(PropEnv* env, PropState* st) {
+    if (st->dead) return;
+    if (env->dead) {
+        prop_restore(env, st);
+        return;
+    }
+    for (int i = 0; i < env->count; i++) {
+        if (!prop_same(env->values[i], st->values[i])) env->values[i] = nullptr;
+    }
+}
+
+//replaces reads of variables with a known value by the literal, then folds what that made constant
+static void prop_subst(Expr* e, void* data) {
+    PropEnv* env = data;
+    if (e->type != VAR_E) return;
+    int v = prop_lookup(env, e->as.var.name);
+    if (v < 0 || !env->values[v]) return;
+    Expr* value = env->values[v];
+    e->type = value->type;
+    e->as = value->as;
+    env->changes++;
+}
+
+static void prop_expr(PropEnv* env, Expr** e_ptr) {
+    if (!*e_ptr) return;
+    int before = env->changes;
+    walk_expr(*e_ptr, prop_subst, env);
+    //anything foldable without the substitution was already folded by constant_folding
+    if (env->changes > before) env->changes += fold_expression(e_ptr);
+}
+
+//everything assigned in a loop body is unknown on entry, whatever the iteration
+static void prop_kill_assigned(Stmt* s, void* data) {
+    PropEnv* env = data;
+    if (s->type != ASSIGN_S) return;
+    int v = prop_lookup(env, s->as.var_assign.name);
+    if (v >= 0) env->values[v] = nullptr;
+}
+
+static void prop_stmt(PropEnv* env, Stmt* s);
+
+static void prop_scoped(PropEnv* env, Stmt* s) {
+    int mark = env->count;
+    prop_stmt(env, s);
+    prop_pop(env, mark);
+}
+
+static void prop_stmt(PropEnv* env, Stmt* s) {
+    if (!s) return;
+
+    switch (s->type) {
+        case VAR_DECL_S: {
+            prop_expr(env, &s->as.var_decl.arraySize);
+            prop_expr(env, &s->as.var_decl.expr);
+            TokenType type = s->as.var_decl.varType;
+            bool tracked = (type == INT_KEYWORD_T || type == BOOL_KEYWORD_T) &&
+                           s->as.var_decl.ownership == OWNERSHIP_NONE && !s->as.var_decl.isNullable &&
+                           !s->as.var_decl.isArray && !local_has(&env->names, s->as.var_decl.name, LOCAL_ESCAPED);
+            prop_declare(env, s->as.var_decl.name, type, tracked, prop_literal(s->as.var_decl.expr, type));
+            break;
+        }
+        case ASSIGN_S: {
+            prop_expr(env, &s->as.var_assign.expr);
+            int v = prop_lookup(env, s->as.var_assign.name);
+            if (v >= 0 && env->vars[v].tracked) {
+                env->values[v] = prop_literal(s->as.var_assign.expr, env->vars[v].type);
+            }
+            break;
+        }
+        case ARRAY_ELEM_ASSIGN_S:
+            prop_expr(env, &s->as.array_elem_assign.index);
+            prop_expr(env, &s->as.array_elem_assign.value);
+            break;
+        case IF_S: {
+            prop_expr(env, &s->as.if_stmt.cond);
+            //a decided branch leaves the other one to dead_code_elimination
+            if (is_constant_true(s->as.if_stmt.cond)) {
+                prop_scoped(env, s->as.if_stmt.trueStmt);
+            } else if (is_constant_false(s->as.if_stmt.cond)) {
+                prop_scoped(env, s->as.if_stmt.falseStmt);
+            } else {
+                PropState before = prop_save(env);
+                prop_scoped(env, s->as.if_stmt.trueStmt);
+                PropState taken = prop_save(env);
+                prop_restore(env, &before);
+                prop_scoped(env, s->as.if_stmt.falseStmt);
+                prop_meet(env, &taken);
+                free(before.values);
+                free(taken.values);
+            }
+            break;
+        }
+        case WHILE_S: {
+            walk_stmt(s->as.while_stmt.body, prop_kill_assigned, nullptr, env);
+            prop_expr(env, &s->as.while_stmt.cond);
+            if (is_constant_false(s->as.while_stmt.cond)) break;
+            //the loop exits with what held on entry, the body only changed what was just killed
+            PropState entry = prop_save(env);
+            prop_scoped(env, s->as.while_stmt.body);
+            prop_restore(env, &entry);
+            free(entry.values);
+            break;
+        }
+        case DO_WHILE_S:
+            //the body runs at least once and the condition sees its result, which is also the exit state
+            walk_stmt(s->as.do_while_stmt.body, prop_kill_assigned, nullptr, env);
+            prop_scoped(env, s->as.do_while_stmt.body);
+            prop_expr(env, &s->as.do_while_stmt.cond);
+            break;
+        case FOR_S: {
+            //min is evaluated once before the loop, max before every iteration
+            prop_expr(env, &s->as.for_stmt.min);
+            walk_stmt(s->as.for_stmt.body, prop_kill_assigned, nullptr, env);
+            prop_expr(env, &s->as.for_stmt.max);
+            PropState entry = prop_save(env);
+            int mark = env->count;
+            prop_declare(env, s->as.for_stmt.varName, INT_KEYWORD_T, false, nullptr);
+            prop_stmt(env, s->as.for_stmt.body);
+            prop_pop(env, mark);
+            prop_restore(env, &entry);
+            free(entry.values);
+            break;
+        }
+        case BLOCK_S: {
+            int mark = env->count;
+            for (int i = 0; i < s->as.block_stmt.count; i++) {
+                prop_stmt(env, s->as.block_stmt.stmts[i]);
+            }
+            prop_pop(env, mark);
+            break;
+        }
+        case MATCH_S: {
+            prop_expr(env, &s->as.match_stmt.var);
+            PropState before = prop_save(env);
+            PropState joined = prop_save(env);
+            joined.dead = true;
+            bool has_wildcard = false;
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                prop_restore(env, &before);
+                if (branch->pattern->type == VALUE_PATTERN) prop_expr(env, &branch->pattern->as.value_expr);
+                if (branch->pattern->type == WILDCARD_PATTERN) has_wildcard = true;
+
+                int mark = env->count;
+                if (branch->pattern->type == SOME_PATTERN) {
+                    prop_declare(env, branch->pattern->as.binding_name, VOID_KEYWORD_T, false, nullptr);
+                }
+                for (int j = 0; j < branch->stmtCount; j++) {
+                    prop_stmt(env, branch->stmts[j]);
+                }
+                prop_pop(env, mark);
+
+                prop_meet(env, &joined);
+                prop_store(&joined, env);
+            }
+            //without a wildcard the value may match no branch at all and skip every one of them
+            prop_restore(env, &joined);
+            if (!has_wildcard) prop_meet(env, &before);
+            free(before.values);
+            free(joined.values);
+            break;
+        }
+        case EXPR_STMT_S:
+            prop_expr(env, &s->as.expr_stmt);
+            if (s->as.expr_stmt && s->as.expr_stmt->type == FUNC_RET_E) env->dead = true;
+            break;
+        default:
+            break;
+    }
+}
+
+// --- locals nothing reads any more ---
+
+static void prop_find_call(Expr* e, void* data) {
+    if (e->type == FUNC_CALL_E) *(bool*)data = true;
+}
+
+static bool prop_is_pure(Expr* e) {
+    bool call = false;
+    walk_expr(e, prop_find_call, &call);
+    return !call;
+}
+
+//only stores to these are ever dropped
+static bool prop_plain_value(TokenType type, Ownership ownership, bool nullable, bool array) {
+    return (type == INT_KEYWORD_T || type == BOOL_KEYWORD_T) && ownership == OWNERSHIP_NONE && !nullable && !array;
+}
+
+static void prop_use_expr(Expr* e, void* data) {
+    PropEnv* env = data;
+    if (e->type == VAR_E) local_name(&env->names, e->as.var.name)->flags |= LOCAL_READ;
+    if (e->type == ARRAY_ACCESS_E) local_name(&env->names, e->as.array_access.arrayName)->flags |= LOCAL_READ;
+}
+
+static void prop_use_stmt(Stmt* s, void* data) {
+    PropEnv* env = data;
+    if (s->type == VAR_DECL_S) {
+        if (!prop_is_pure(s->as.var_decl.expr)) local_name(&env->names, s->as.var_decl.name)->flags |= LOCAL_IMPURE;
+        if (!prop_plain_value(s->as.var_decl.varType, s->as.var_decl.ownership, s->as.var_decl.isNullable,
+                              s->as.var_decl.isArray)) {
+            local_name(&env->names, s->as.var_decl.name)->flags |= LOCAL_UNTRACKED;
+        }
+    } else if (s->type == ASSIGN_S && !prop_is_pure(s->as.var_assign.expr)) {
+        local_name(&env->names, s->as.var_assign.name)->flags |= LOCAL_IMPURE;
+    } else if (s->type == ARRAY_ELEM_ASSIGN_S) {
+        //the element store is a use of the array, not a store to the name
+        local_name(&env->names, s->as.array_elem_assign.arrayName)->flags |= LOCAL_READ;
+    } else if (s->type == FREE_S) {
+        local_name(&env->names, s->as.free_stmt.varName)->flags |= LOCAL_READ;
+    }
+}
+
+//a store the rest of the function never reads: a followable local that is not read anywhere and
+//only ever gets values without calls in them
+static bool prop_is_dead_store(PropEnv* env, Stmt* s) {
+    char* name;
+    if (s->type == VAR_DECL_S) {
+        name = s->as.var_decl.name;
+    } else if (s->type == ASSIGN_S && s->as.var_assign.ownership == OWNERSHIP_NONE) {
+        name = s->as.var_assign.name;
+    } else {
+        return false;
+    }
+    //an assign has no type of its own, the declarations and parameters with its name say what it stores
+    return !local_has(&env->names, name, LOCAL_ESCAPED | LOCAL_READ | LOCAL_IMPURE | LOCAL_UNTRACKED);
+}
+
+static int prop_drop_stores(PropEnv* env, Stmt** stmts, int* count) {
+    int kept = 0;
+    for (int i = 0; i < *count; i++) {
+        if (!prop_is_dead_store(env, stmts[i])) stmts[kept++] = stmts[i];
+    }
+    int dropped = *count - kept;
+    *count = kept;
+    return dropped;
+}
+
+static void prop_drop_in(Stmt* s, void* data) {
+    PropEnv* env = data;
+    if (s->type == BLOCK_S) {
+        env->changes += prop_drop_stores(env, s->as.block_stmt.stmts, &s->as.block_stmt.count);
+    } else if (s->type == MATCH_S) {
+        for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+            MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+            env->changes += prop_drop_stores(env, branch->stmts, &branch->stmtCount);
+        }
+    }
+}
+
+//returns how many reads it replaced and stores it dropped plus what folding made of them, 0 if the function is unchanged
+int constant_propagation_func(Func* f) {
+    PropEnv env = {0};
+    scan_escapes(f, &env.names);
+    prop_stmt(&env, f->body);
+
+    //a local whose every read just became a literal is only written now, its stores go. flags are per
+    //name, so a name that is read in any scope is kept in all of them
+    if (env.changes > 0) {
+        for (int i = 0; i < f->signature->paramNum; i++) {
+            FuncParam* p = &f->signature->parameters[i];
+            if (!prop_plain_value(p->type, p->ownership, p->isNullable, false)) {
+                local_name(&env.names, p->name)->flags |= LOCAL_UNTRACKED;
+            }
+        }
+        walk_stmt(f->body, prop_use_stmt, prop_use_expr, &env);
+        walk_stmt(f->body, prop_drop_in, nullptr, &env);
+    }
+
+    free(env.names.slots);
+    free(env.vars);
+    free(env.values);
+    return env.changes;
+}
+
+bool constant_propagation(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running constant propagation...");
+    bool any_modified = false;
+    for (int i = 0; i < count; i++) {
+        any_modified |= constant_propagation_func(program[i]) > 0;
+    }
+    if (any_modified) {
+        stage_trace(STAGE_OPTIMIZER, "Constant propagation made changes");
+    }
+    return any_modified;
+}
+
 // ============ DEAD CODE ELIMINATION ============
 
 bool is_constant_true(Expr* e) {
@@ -172,45 +687,53 @@ bool is_constant_false(Expr* e) {
     return e && e->type == BOOL_LIT_E && e->as.bool_val == 0;
 }
 
-//returns true if statement was modified
-bool dead_code_elimination_stmt(Stmt** s_ptr) {
-    if (!s_ptr || !*s_ptr) return false;
+static bool is_empty_stmt(Stmt* s) {
+    return !s || (s->type == BLOCK_S && s->as.block_stmt.count == 0);
+}
+
+//returns how many rewrites it made, 0 if the statement is unchanged
+int dead_code_elimination_stmt(Stmt** s_ptr) {
+    if (!s_ptr || !*s_ptr) return 0;
 
     Stmt* s = *s_ptr;
-    bool modified = false;
+    int changes = 0;
 
     switch (s->type) {
         case IF_S: {
-            modified |= fold_expression(&s->as.if_stmt.cond);
+            changes += fold_expression(&s->as.if_stmt.cond);
 
             if (is_constant_true(s->as.if_stmt.cond)) {
                 Stmt* result = s->as.if_stmt.trueStmt;
-                s->as.if_stmt.trueStmt = NULL;  //prevent double free
-                free(s);
+                s->as.if_stmt.trueStmt = NULL;  //detach from the dropped if
                 *s_ptr = result;
-                return true;  //definitely modified
+                return changes + 1;  //definitely modified
             } else if (is_constant_false(s->as.if_stmt.cond)) {
                 Stmt* result = s->as.if_stmt.falseStmt;
                 s->as.if_stmt.falseStmt = NULL;
-                free(s);
                 *s_ptr = result;
-                return true;  //definitely modified
+                return changes + 1;  //definitely modified
             }
 
-            modified |= dead_code_elimination_stmt(&s->as.if_stmt.trueStmt);
-            modified |= dead_code_elimination_stmt(&s->as.if_stmt.falseStmt);
+            changes += dead_code_elimination_stmt(&s->as.if_stmt.trueStmt);
+            changes += dead_code_elimination_stmt(&s->as.if_stmt.falseStmt);
+
+            //both sides emptied (constant propagation drops stores nothing reads), only a call in the condition keeps it
+            if (is_empty_stmt(s->as.if_stmt.trueStmt) && is_empty_stmt(s->as.if_stmt.falseStmt) &&
+                prop_is_pure(s->as.if_stmt.cond)) {
+                *s_ptr = NULL;
+                return changes + 1;
+            }
             break;
         }
 
         case WHILE_S: {
-            modified |= fold_expression(&s->as.while_stmt.cond);
+            changes += fold_expression(&s->as.while_stmt.cond);
 
             if (is_constant_false(s->as.while_stmt.cond)) {
-                free(s);
                 *s_ptr = NULL;
-                return true;
+                return changes + 1;
             }
-            modified |= dead_code_elimination_stmt(&s->as.while_stmt.body);
+            changes += dead_code_elimination_stmt(&s->as.while_stmt.body);
             break;
         }
 
@@ -218,41 +741,50 @@ bool dead_code_elimination_stmt(Stmt** s_ptr) {
             //filter out NULL statements
             int new_count = 0;
             for (int i = 0; i < s->as.block_stmt.count; i++) {
-                modified |= dead_code_elimination_stmt(&s->as.block_stmt.stmts[i]);
+                changes += dead_code_elimination_stmt(&s->as.block_stmt.stmts[i]);
                 if (s->as.block_stmt.stmts[i]) {
                     s->as.block_stmt.stmts[new_count++] = s->as.block_stmt.stmts[i];
                 }
             }
             if (new_count != s->as.block_stmt.count) {
                 s->as.block_stmt.count = new_count;
-                modified = true;
+                changes++;
             }
             break;
         }
 
         case DO_WHILE_S:
-            modified |= dead_code_elimination_stmt(&s->as.do_while_stmt.body);
-            modified |= fold_expression(&s->as.do_while_stmt.cond);
+            changes += dead_code_elimination_stmt(&s->as.do_while_stmt.body);
+            changes += fold_expression(&s->as.do_while_stmt.cond);
             break;
 
-        case FOR_S:
-            modified |= fold_expression(&s->as.for_stmt.min);
-            modified |= fold_expression(&s->as.for_stmt.max);
-            modified |= dead_code_elimination_stmt(&s->as.for_stmt.body);
+        case FOR_S: {
+            changes += fold_expression(&s->as.for_stmt.min);
+            changes += fold_expression(&s->as.for_stmt.max);
+
+            //the bound is inclusive, min > max never enters the body
+            Expr* min = s->as.for_stmt.min;
+            Expr* max = s->as.for_stmt.max;
+            if (min->type == INT_LIT_E && max->type == INT_LIT_E && min->as.int_val > max->as.int_val) {
+                *s_ptr = NULL;
+                return changes + 1;
+            }
+            changes += dead_code_elimination_stmt(&s->as.for_stmt.body);
             break;
+        }
 
         default:
             break;
     }
 
-    return modified;
+    return changes;
 }
 
 bool dead_code_elimination(Func** program, int count) {
     stage_trace(STAGE_OPTIMIZER, "Running dead code elimination...");
     bool any_modified = false;
     for (int i = 0; i < count; i++) {
-        any_modified |= dead_code_elimination_stmt(&program[i]->body);
+        any_modified |= dead_code_elimination_stmt(&program[i]->body) > 0;
     }
     if (any_modified) {
         stage_trace(STAGE_OPTIMIZER, "Dead code elimination made changes");
@@ -262,32 +794,30 @@ bool dead_code_elimination(Func** program, int count) {
 
 // ============ PEEPHOLE OPTIMIZATIONS ============
 
-//returns true if expression was modified
-bool peephole_optimize_expr(Expr** e_ptr) {
-    if (!e_ptr || !*e_ptr) return false;
+//returns how many rewrites it made, 0 if the expression is unchanged
+int peephole_optimize_expr(Expr** e_ptr) {
+    if (!e_ptr || !*e_ptr) return 0;
 
     Expr* e = *e_ptr;
-    bool modified = false;
+    int changes = 0;
 
     if (e->type == UN_OP_E) {
-        modified |= peephole_optimize_expr(&e->as.un_op.expr);
+        changes += peephole_optimize_expr(&e->as.un_op.expr);
     } else if (e->type == BIN_OP_E) {
-        modified |= peephole_optimize_expr(&e->as.bin_op.exprL);
-        modified |= peephole_optimize_expr(&e->as.bin_op.exprR);
+        changes += peephole_optimize_expr(&e->as.bin_op.exprL);
+        changes += peephole_optimize_expr(&e->as.bin_op.exprR);
 
         // x + 0 -> x
         if (e->as.bin_op.op == PLUS_T) {
             if (e->as.bin_op.exprR->type == INT_LIT_E && e->as.bin_op.exprR->as.int_val == 0) {
                 *e_ptr = e->as.bin_op.exprL;
                 e->as.bin_op.exprL = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
             if (e->as.bin_op.exprL->type == INT_LIT_E && e->as.bin_op.exprL->as.int_val == 0) {
                 *e_ptr = e->as.bin_op.exprR;
                 e->as.bin_op.exprR = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
         }
 
@@ -296,14 +826,12 @@ bool peephole_optimize_expr(Expr** e_ptr) {
             if (e->as.bin_op.exprR->type == INT_LIT_E && e->as.bin_op.exprR->as.int_val == 1) {
                 *e_ptr = e->as.bin_op.exprL;
                 e->as.bin_op.exprL = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
             if (e->as.bin_op.exprL->type == INT_LIT_E && e->as.bin_op.exprL->as.int_val == 1) {
                 *e_ptr = e->as.bin_op.exprR;
                 e->as.bin_op.exprR = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
         }
 
@@ -312,8 +840,7 @@ bool peephole_optimize_expr(Expr** e_ptr) {
             if (e->as.bin_op.exprR->type == INT_LIT_E && e->as.bin_op.exprR->as.int_val == 0) {
                 *e_ptr = e->as.bin_op.exprL;
                 e->as.bin_op.exprL = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
         }
 
@@ -322,8 +849,7 @@ bool peephole_optimize_expr(Expr** e_ptr) {
             if (e->as.bin_op.exprR->type == INT_LIT_E && e->as.bin_op.exprR->as.int_val == 1) {
                 *e_ptr = e->as.bin_op.exprL;
                 e->as.bin_op.exprL = NULL;
-                free(e);
-                return true;
+                return changes + 1;
             }
         }
 
@@ -331,13 +857,11 @@ bool peephole_optimize_expr(Expr** e_ptr) {
         if (e->as.bin_op.op == MINUS_T) {
             //for now, just handle same variable
             if (e->as.bin_op.exprL->type == VAR_E && e->as.bin_op.exprR->type == VAR_E &&
-                strcmp(e->as.bin_op.exprL->as.var.name, e->as.bin_op.exprR->as.var.name) == 0) {
+                e->as.bin_op.exprL->as.var.name == e->as.bin_op.exprR->as.var.name) {
                 e->type = INT_LIT_E;
                 e->as.int_val = 0;
                 e->analyzedType = INT_KEYWORD_T;
-                free(e->as.bin_op.exprL);
-                free(e->as.bin_op.exprR);
-                return true;
+                return changes + 1;
             }
         }
     }
@@ -347,9 +871,7 @@ bool peephole_optimize_expr(Expr** e_ptr) {
         if (e->as.un_op.expr->type == UN_OP_E && e->as.un_op.expr->as.un_op.op == NEGATION_T) {
             *e_ptr = e->as.un_op.expr->as.un_op.expr;
             e->as.un_op.expr->as.un_op.expr = NULL;
-            free(e->as.un_op.expr);
-            free(e);
-            return true;
+            return changes + 1;
         }
     }
 
@@ -378,63 +900,62 @@ bool peephole_optimize_expr(Expr** e_ptr) {
                 e->analyzedType = BOOL_KEYWORD_T;
                 inner->as.bin_op.exprL = NULL;
                 inner->as.bin_op.exprR = NULL;
-                free(inner);
-                return true;
+                return changes + 1;
             }
         }
     }
 
-    return modified;
+    return changes;
 }
 
-bool peephole_optimizations_stmt(Stmt* s) {
-    if (!s) return false;
+int peephole_optimizations_stmt(Stmt* s) {
+    if (!s) return 0;
 
-    bool modified = false;
+    int changes = 0;
 
     switch (s->type) {
         case VAR_DECL_S:
-            modified |= peephole_optimize_expr(&s->as.var_decl.expr);
+            changes += peephole_optimize_expr(&s->as.var_decl.expr);
             break;
         case ASSIGN_S:
-            modified |= peephole_optimize_expr(&s->as.var_assign.expr);
+            changes += peephole_optimize_expr(&s->as.var_assign.expr);
             break;
         case IF_S:
-            modified |= peephole_optimize_expr(&s->as.if_stmt.cond);
-            modified |= peephole_optimizations_stmt(s->as.if_stmt.trueStmt);
-            modified |= peephole_optimizations_stmt(s->as.if_stmt.falseStmt);
+            changes += peephole_optimize_expr(&s->as.if_stmt.cond);
+            changes += peephole_optimizations_stmt(s->as.if_stmt.trueStmt);
+            changes += peephole_optimizations_stmt(s->as.if_stmt.falseStmt);
             break;
         case WHILE_S:
-            modified |= peephole_optimize_expr(&s->as.while_stmt.cond);
-            modified |= peephole_optimizations_stmt(s->as.while_stmt.body);
+            changes += peephole_optimize_expr(&s->as.while_stmt.cond);
+            changes += peephole_optimizations_stmt(s->as.while_stmt.body);
             break;
         case DO_WHILE_S:
-            modified |= peephole_optimizations_stmt(s->as.do_while_stmt.body);
-            modified |= peephole_optimize_expr(&s->as.do_while_stmt.cond);
+            changes += peephole_optimizations_stmt(s->as.do_while_stmt.body);
+            changes += peephole_optimize_expr(&s->as.do_while_stmt.cond);
             break;
         case FOR_S:
-            modified |= peephole_optimize_expr(&s->as.for_stmt.min);
-            modified |= peephole_optimize_expr(&s->as.for_stmt.max);
-            modified |= peephole_optimizations_stmt(s->as.for_stmt.body);
+            changes += peephole_optimize_expr(&s->as.for_stmt.min);
+            changes += peephole_optimize_expr(&s->as.for_stmt.max);
+            changes += peephole_optimizations_stmt(s->as.for_stmt.body);
             break;
         case BLOCK_S:
             for (int i = 0; i < s->as.block_stmt.count; i++) {
-                modified |= peephole_optimizations_stmt(s->as.block_stmt.stmts[i]);
+                changes += peephole_optimizations_stmt(s->as.block_stmt.stmts[i]);
             }
             break;
         case EXPR_STMT_S:
-            modified |= peephole_optimize_expr(&s->as.expr_stmt);
+            changes += peephole_optimize_expr(&s->as.expr_stmt);
             break;
         case MATCH_S:
-            modified |= peephole_optimize_expr(&s->as.match_stmt.var);
+            changes += peephole_optimize_expr(&s->as.match_stmt.var);
             for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
                 MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
                 //for VALUE_PATTERN, optimize the expression
                 if (branch->pattern->type == VALUE_PATTERN) {
-                    modified |= peephole_optimize_expr(&branch->pattern->as.value_expr);
+                    changes += peephole_optimize_expr(&branch->pattern->as.value_expr);
                 }
                 for (int j = 0; j < branch->stmtCount; j++) {
-                    modified |= peephole_optimizations_stmt(branch->stmts[j]);
+                    changes += peephole_optimizations_stmt(branch->stmts[j]);
                 }
             }
             break;
@@ -442,14 +963,14 @@ bool peephole_optimizations_stmt(Stmt* s) {
             break;
     }
 
-    return modified;
+    return changes;
 }
 
 bool peephole_optimizations(Func** program, int count) {
     stage_trace(STAGE_OPTIMIZER, "Running peephole optimizations...");
     bool any_modified = false;
     for (int i = 0; i < count; i++) {
-        any_modified |= peephole_optimizations_stmt(program[i]->body);
+        any_modified |= peephole_optimizations_stmt(program[i]->body) > 0;
     }
     if (any_modified) {
         stage_trace(STAGE_OPTIMIZER, "Peephole optimizations made changes");
@@ -457,58 +978,1668 @@ bool peephole_optimizations(Func** program, int count) {
     return any_modified;
 }
 
-// ============ INLINING ============
+// ============ COMMON SUBEXPRESSIONS ============
 
-bool is_small_function(Func* f) {
-    //count statements roughly
-    int count = 0;
-    Stmt* body = f->body;
-    if (body->type == BLOCK_S) {
-        count = body->as.block_stmt.count;
+//temps are numbered over the whole program, inlining can bring temps of two functions into one body
+static int cse_temp_count = 0;
+
+#define CSE_MAX_READS 4
+
+//the names an expression reads. past CSE_MAX_READS only spilled is set and a kill walks the expression
+typedef struct {
+    char* names[CSE_MAX_READS];
+    int count;
+    bool spilled;
+    bool memory;            //reads a string or an array, stores and calls kill it
+} CseReads;
+
+//a value already computed on every path to the current point and not changed since
+typedef struct {
+    Expr* expr;             //where it is computed: the first occurrence, or the initializer of its temp
+    uint32_t hash;
+    CseReads reads;
+    int next;               //older entry in the same bucket, -1 at the end
+    int name_next[CSE_MAX_READS + 1];   //older link in the bucket of each read name, the last one for holder
+    int memory_next;        //older entry reading memory, -1 at the end
+    int spilled_next;       //older entry with spilled reads, -1 at the end
+    bool alive;
+    char* holder;           //local or temp the value sits in, nullptr until a second occurrence asks for it
+    bool declared;          //holder is the local of a declaration, a store to it kills the entry
+    Stmt* anchor;           //statement of the first occurrence, a temp is declared right before it
+    Stmt*** list;           //the statement list anchor is in
+    int* list_count;
+} CseEntry;
+
+//a temp declaration waiting for the walk to finish, the lists it goes into must not move under the walk
+typedef struct {
+    Stmt* decl;
+    Stmt* anchor;
+    Stmt*** list;
+    int* list_count;
+} CseInsert;
+
+//what cse_expr needs to know about a node, worked out for a whole expression before the walk goes down it.
+//a part would otherwise be looked at again for every candidate around it
+typedef struct {
+    bool pure;              //literals, plain locals and operations without side effects
+    bool candidate;         //pure, worth a temp and allowed in this statement
+    bool memory;            //reads a string or an array
+    uint32_t hash;
+    int size;               //nodes in its subtree, itself included
+} CseInfo;
+
+#define CSE_BUCKETS 256
+
+typedef struct {
+    LocalNames names;
+    bool flagged;           //some name has LOCAL_ESCAPED or LOCAL_OWNED_ELEMENTS, else names is not asked
+    CseInfo* info;          //the expression being walked, in the order cse_child goes through it
+    int info_count;
+    int info_capacity;
+    CseEntry* entries;      //a stack, what a scope recorded is popped when it ends
+    int count;
+    int capacity;
+    int buckets[CSE_BUCKETS];   //newest entry per hash, -1 if none
+    int name_buckets[CSE_BUCKETS];  //newest link per read name, a kill only goes through the entries reading it
+    int memory_head;
+    int spilled_head;
+    int* killed;            //entries killed so far, an if or match arm hands its kills back for the next arm
+    int killed_count;
+    int killed_capacity;
+    CseInsert* inserts;
+    int insert_count;
+    int insert_capacity;
+
+    //the statement being walked
+    Stmt* anchor;
+    Stmt*** list;           //nullptr when it is not directly in a block or match arm, nothing is recorded then
+    int* list_count;
+    bool record;            //false where the expression does not run on every path through the statement
+    bool calls;             //the statement calls a function, string and array reads are left alone
+    bool calls_known;       //calls is only looked for when it matters
+    Expr* held;             //initializer of the declaration being walked, the declaration records it
+    int changes;
+} CseEnv;
+
+static bool cse_value_type(TokenType t) {
+    return t == INT_KEYWORD_T || t == BOOL_KEYWORD_T || t == CHAR_KEYWORD_T || t == FLOAT_KEYWORD_T ||
+           t == DOUBLE_KEYWORD_T;
+}
+
+static bool cse_is_length(Expr* e) {
+    return e->type == FUNC_CALL_E && !e->as.func_call.resolved_sign && e->as.func_call.count == 1 &&
+           is_known_name(e->as.func_call.name, NAME_LENGTH);
+}
+
+static bool cse_commutes(TokenType op) {
+    return op == PLUS_T || op == STAR_T || op == DOUBLE_EQUALS_T || op == NOT_EQUALS_T;
+}
+
+static void cse_read(CseReads* reads, char* name) {
+    for (int i = 0; i < reads->count; i++) {
+        if (reads->names[i] == name) return;
+    }
+    if (reads->count < CSE_MAX_READS) {
+        reads->names[reads->count++] = name;
+    } else {
+        reads->spilled = true;
     }
-    return count <= 5;
 }
 
-bool inline_functions(Func** program, int count) {
-    stage_trace(STAGE_OPTIMIZER, "Running function inlining...");
-    // tODO: Implement function inlining
-    return false;  //no changes yet
+//what is worth a temp: arithmetic, comparisons, length() and element reads. && and || only as parts
+static bool cse_is_root(Expr* e) {
+    if (!cse_value_type(e->analyzedType) || e->is_nullable) return false;
+    switch (e->type) {
+        case BIN_OP_E: return e->as.bin_op.op != AND_T && e->as.bin_op.op != OR_T;
+        case FUNC_CALL_E: return cse_is_length(e);
+        case ARRAY_ACCESS_E: return true;
+        default: return false;
+    }
 }
 
-// ============ MAIN OPTIMIZATION DRIVER ============
+static void cse_find_call(Expr* e, void* data) {
+    if (e->type == FUNC_CALL_E && e->as.func_call.resolved_sign) *(bool*)data = true;
+}
 
-void optimize_program(Func** program, int count, OptimizationLevel level) {
-    if (level == OPT_NONE) return;
+//a call into a function, which may write any string or array. builtins do not
+static bool cse_has_call(Expr* e) {
+    bool call = false;
+    if (e) walk_expr(e, cse_find_call, &call);
+    return call;
+}
 
-    stage_trace(STAGE_OPTIMIZER, "Optimizing with level %d", level);
+//the expressions of the statement itself, not those of statements nested in it. entries may be nullptr
+static int cse_stmt_exprs(Stmt* s, Expr* out[2]) {
+    switch (s->type) {
+        case VAR_DECL_S: out[0] = s->as.var_decl.arraySize; out[1] = s->as.var_decl.expr; return 2;
+        case ASSIGN_S: out[0] = s->as.var_assign.expr; return 1;
+        case ARRAY_ELEM_ASSIGN_S: out[0] = s->as.array_elem_assign.index; out[1] = s->as.array_elem_assign.value; return 2;
+        case IF_S: out[0] = s->as.if_stmt.cond; return 1;
+        case WHILE_S: out[0] = s->as.while_stmt.cond; return 1;
+        case DO_WHILE_S: out[0] = s->as.do_while_stmt.cond; return 1;
+        case FOR_S: out[0] = s->as.for_stmt.min; out[1] = s->as.for_stmt.max; return 2;
+        case MATCH_S: out[0] = s->as.match_stmt.var; return 1;
+        case EXPR_STMT_S: out[0] = s->as.expr_stmt; return 1;
+        default: return 0;
+    }
+}
 
-    //run multiple passes until no changes
-    bool changed;
-    int pass = 0;
-    do {
-        changed = false;
-        pass++;
-        stage_trace(STAGE_OPTIMIZER, "Optimization pass %d", pass);
+static bool cse_stmt_calls(Stmt* s) {
+    Expr* exprs[2];
+    int n = cse_stmt_exprs(s, exprs);
+    for (int i = 0; i < n; i++) {
+        if (cse_has_call(exprs[i])) return true;
+    }
+    return false;
+}
 
-        if (level & OPT_CONST_FOLD) {
-            changed |= constant_folding(program, count);
-        }
+//found on the first string or array read of a statement, most statements have none
+static bool cse_calls(CseEnv* env) {
+    if (!env->calls_known) {
+        env->calls = cse_stmt_calls(env->anchor);
+        env->calls_known = true;
+    }
+    return env->calls;
+}
 
-        if (level & OPT_PEEPHOLE) {
-            changed |= peephole_optimizations(program, count);
-        }
+//the child slots of e, in the order both cse_info and cse_expr go through them
+static int cse_child_count(Expr* e) {
+    switch (e->type) {
+        case UN_OP_E:
+        case FUNC_RET_E:
+        case ARRAY_ACCESS_E:
+        case ALLOC_E:
+        case ALLOC_ARR_E:
+            return 1;
+        case BIN_OP_E: return 2;
+        case FUNC_CALL_E: return e->as.func_call.count;
+        case MATCH_E: return 1 + e->as.match.branchCount;
+        case ARRAY_DECL_E: return e->as.arr_decl.count;
+        default: return 0;
+    }
+}
 
-        if (level & OPT_DEAD_CODE) {
-            changed |= dead_code_elimination(program, count);
-        }
+static Expr** cse_child(Expr* e, int i) {
+    switch (e->type) {
+        case UN_OP_E: return &e->as.un_op.expr;
+        case BIN_OP_E: return i == 0 ? &e->as.bin_op.exprL : &e->as.bin_op.exprR;
+        case FUNC_CALL_E: return &e->as.func_call.params[i];
+        case FUNC_RET_E: return &e->as.func_ret_expr;
+        case ARRAY_ACCESS_E: return &e->as.array_access.index;
+        case MATCH_E: return i == 0 ? &e->as.match.var : &e->as.match.branches[i - 1].caseRet;
+        case ALLOC_E:
+        case ALLOC_ARR_E: return &e->as.alloc.initialValue;
+        case ARRAY_DECL_E: return &e->as.arr_decl.values[i];
+        default: return nullptr;
+    }
+}
 
-        if (level & OPT_INLINE) {
-            changed |= inline_functions(program, count);
-        }
+//from the hashes of its first two children, equal for expressions cse_same takes as the same
+static uint32_t cse_node_hash(Expr* e, uint32_t first, uint32_t second) {
+    uint32_t h = (uint32_t)e->type * 31u + (uint32_t)e->analyzedType;
+    switch (e->type) {
+        case INT_LIT_E: return h * 31u + (uint32_t)e->as.int_val;
+        case BOOL_LIT_E: return h * 31u + (uint32_t)e->as.bool_val;
+        case CHAR_LIT_E: return h * 31u + (uint8_t)e->as.char_val;
+        case VAR_E: return h * 31u + intern_hash(e->as.var.name);
+        case UN_OP_E: return (h * 31u + e->as.un_op.op) * 31u + first;
+        case BIN_OP_E:
+            h = h * 31u + e->as.bin_op.op;
+            return cse_commutes(e->as.bin_op.op) ? h * 31u + (first ^ second) : (h * 31u + first) * 31u + second;
+        case FUNC_CALL_E: return h * 31u + intern_hash(e->as.func_call.name) * 31u + first;
+        case ARRAY_ACCESS_E: return (h * 31u + intern_hash(e->as.array_access.arrayName)) * 31u + first;
+        default: return h;
+    }
+}
 
-    } while (changed && pass < 10);
+static bool cse_local_has(CseEnv* env, char* name, LocalFlags flag) {
+    return env->flagged && local_has(&env->names, name, flag);
+}
 
-    if (pass >= 10) {
-        stage_trace(STAGE_OPTIMIZER, "Reached maximum optimization passes (10)");
+//fills env->info for e and everything below it in one bottom-up go, returns the index of e.
+//every write to what a pure expression reads goes through a kill: locals by name, the rest as memory
+static int cse_info(CseEnv* env, Expr* e) {
+    if (env->info_count == env->info_capacity) {
+        env->info_capacity = env->info_capacity ? env->info_capacity * 2 : 64;
+        env->info = realloc(env->info, sizeof(CseInfo) * env->info_capacity);
     }
-}
\ No newline at end of file
+    int k = env->info_count++;
+    CseInfo info = {.size = 1};
+    bool parts = true;
+    uint32_t hashes[2] = {0, 0};
+    int n = cse_child_count(e);
+    for (int i = 0; i < n; i++) {
+        Expr* child = *cse_child(e, i);
+        if (!child) continue;
+        //cse_info can grow env->info, the index has to be taken before the array is read
+        int ci = cse_info(env, child);
+        CseInfo* c = &env->info[ci];
+        info.size += c->size;
+        parts &= c->pure;
+        if (i < 2) hashes[i] = c->hash;
+        info.memory |= c->memory;
+    }
+
+    switch (e->type) {
+        case INT_LIT_E:
+        case BOOL_LIT_E:
+        case CHAR_LIT_E:
+        case FLOAT_LIT_E:
+            info.pure = true;
+            break;
+        case VAR_E:
+            //a ref reads through a pointer, a string only changes by assignment or through memory
+            info.pure = !e->is_nullable && !cse_local_has(env, e->as.var.name, LOCAL_ESCAPED) &&
+                        (e->as.var.ownership == OWNERSHIP_NONE || e->analyzedType == STR_KEYWORD_T);
+            break;
+        case UN_OP_E:
+            info.pure = parts;
+            break;
+        case BIN_OP_E:
+            info.pure = parts;
+            if (e->as.bin_op.exprL->analyzedType == STR_KEYWORD_T) info.memory = true;
+            break;
+        case FUNC_CALL_E:
+            info.pure = parts && cse_is_length(e);
+            info.memory = true;
+            break;
+        case ARRAY_ACCESS_E:
+            info.pure = parts && !cse_local_has(env, e->as.array_access.arrayName, LOCAL_OWNED_ELEMENTS);
+            info.memory = true;
+            break;
+        default:
+            break;
+    }
+    info.hash = cse_node_hash(e, hashes[0], hashes[1]);
+    info.candidate = info.pure && cse_is_root(e) && !(info.memory && cse_calls(env));
+    env->info[k] = info;
+    return k;
+}
+
+static bool cse_same(Expr* a, Expr* b) {
+    if (a->type != b->type || a->analyzedType != b->analyzedType) return false;
+    switch (a->type) {
+        case INT_LIT_E: return a->as.int_val == b->as.int_val;
+        case BOOL_LIT_E: return a->as.bool_val == b->as.bool_val;
+        case CHAR_LIT_E: return a->as.char_val == b->as.char_val;
+        //bitwise, 0.0 and -0.0 compare equal but are not the same value
+        case FLOAT_LIT_E: return memcmp(&a->as.double_val, &b->as.double_val, sizeof(double)) == 0;
+        case VAR_E: return a->as.var.name == b->as.var.name;
+        case UN_OP_E: return a->as.un_op.op == b->as.un_op.op && cse_same(a->as.un_op.expr, b->as.un_op.expr);
+        case BIN_OP_E:
+            if (a->as.bin_op.op != b->as.bin_op.op) return false;
+            if (cse_same(a->as.bin_op.exprL, b->as.bin_op.exprL) && cse_same(a->as.bin_op.exprR, b->as.bin_op.exprR)) return true;
+            return cse_commutes(a->as.bin_op.op) && cse_same(a->as.bin_op.exprL, b->as.bin_op.exprR) &&
+                   cse_same(a->as.bin_op.exprR, b->as.bin_op.exprL);
+        case FUNC_CALL_E: return a->as.func_call.name == b->as.func_call.name && cse_same(a->as.func_call.params[0], b->as.func_call.params[0]);
+        case ARRAY_ACCESS_E:
+            return a->as.array_access.arrayName == b->as.array_access.arrayName &&
+                   cse_same(a->as.array_access.index, b->as.array_access.index);
+        default: return false;
+    }
+}
+
+typedef struct {
+    char* name;
+    bool found;
+} CseNameSearch;
+
+static void cse_find_name(Expr* e, void* data) {
+    CseNameSearch* search = data;
+    if ((e->type == VAR_E && e->as.var.name == search->name) ||
+        (e->type == ARRAY_ACCESS_E && e->as.array_access.arrayName == search->name)) {
+        search->found = true;
+    }
+}
+
+static bool cse_mentions(Expr* e, char* name) {
+    CseNameSearch search = {name, false};
+    walk_expr(e, cse_find_name, &search);
+    return search.found;
+}
+
+static void cse_kill(CseEnv* env, int i) {
+    env->entries[i].alive = false;
+    if (env->killed_count == env->killed_capacity) {
+        env->killed_capacity = env->killed_capacity ? env->killed_capacity * 2 : 32;
+        env->killed = realloc(env->killed, sizeof(int) * env->killed_capacity);
+    }
+    env->killed[env->killed_count++] = i;
+}
+
+//a link is entry * CSE_LINK_SLOTS + slot, slot CSE_MAX_READS stands for the holder
+#define CSE_LINK_SLOTS (CSE_MAX_READS + 1)
+
+static int cse_name_bucket(char* name) {
+    return ((uintptr_t)name >> 4) % CSE_BUCKETS;
+}
+
+static char* cse_link_name(CseEntry* en, int slot) {
+    return slot < CSE_MAX_READS ? en->reads.names[slot] : en->holder;
+}
+
+//temps made later are never stored to, only a declared holder is linked
+static bool cse_linked(CseEntry* en, int slot) {
+    return slot < CSE_MAX_READS ? slot < en->reads.count : en->declared;
+}
+
+//name got a new value, or a declaration hides it
+static void cse_kill_name(CseEnv* env, char* name) {
+    for (int link = env->name_buckets[cse_name_bucket(name)]; link >= 0;) {
+        CseEntry* en = &env->entries[link / CSE_LINK_SLOTS];
+        if (en->alive && cse_link_name(en, link % CSE_LINK_SLOTS) == name) cse_kill(env, link / CSE_LINK_SLOTS);
+        link = en->name_next[link % CSE_LINK_SLOTS];
+    }
+    for (int i = env->spilled_head; i >= 0; i = env->entries[i].spilled_next) {
+        if (env->entries[i].alive && cse_mentions(env->entries[i].expr, name)) cse_kill(env, i);
+    }
+}
+
+static bool cse_memory_alive(CseEnv* env) {
+    for (int i = env->memory_head; i >= 0; i = env->entries[i].memory_next) {
+        if (env->entries[i].alive) return true;
+    }
+    return false;
+}
+
+static void cse_kill_memory(CseEnv* env) {
+    for (int i = env->memory_head; i >= 0; i = env->entries[i].memory_next) {
+        if (env->entries[i].alive) cse_kill(env, i);
+    }
+}
+
+static void cse_collect_read(Expr* e, void* data) {
+    if (e->type == VAR_E) cse_read(data, e->as.var.name);
+    if (e->type == ARRAY_ACCESS_E) cse_read(data, e->as.array_access.arrayName);
+}
+
+static void cse_record(CseEnv* env, Expr* e, uint32_t hash, bool memory, char* holder) {
+    CseReads reads = {.memory = memory};
+    walk_expr(e, cse_collect_read, &reads);
+
+    if (env->count == env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 32;
+        env->entries = realloc(env->entries, sizeof(CseEntry) * env->capacity);
+    }
+    int i = env->count++;
+    int bucket = hash % CSE_BUCKETS;
+    CseEntry* en = &env->entries[i];
+    *en = (CseEntry){
+        .expr = e,
+        .hash = hash,
+        .reads = reads,
+        .next = env->buckets[bucket],
+        .memory_next = -1,
+        .spilled_next = -1,
+        .alive = true,
+        .holder = holder,
+        .declared = holder != nullptr,
+        .anchor = env->anchor,
+        .list = env->list,
+        .list_count = env->list_count,
+    };
+    env->buckets[bucket] = i;
+
+    for (int slot = 0; slot < CSE_LINK_SLOTS; slot++) {
+        if (!cse_linked(en, slot)) continue;
+        char* name = cse_link_name(en, slot);
+        en->name_next[slot] = env->name_buckets[cse_name_bucket(name)];
+        env->name_buckets[cse_name_bucket(name)] = i * CSE_LINK_SLOTS + slot;
+    }
+    if (memory) {
+        en->memory_next = env->memory_head;
+        env->memory_head = i;
+    }
+    if (reads.spilled) {
+        en->spilled_next = env->spilled_head;
+        env->spilled_head = i;
+    }
+}
+
+//e as it reads now, if it runs on every path through the statement and there is a list to put a temp in
+static void cse_try_record(CseEnv* env, Expr* e, char* holder) {
+    if (!env->record || !env->list) return;
+    int k = cse_info(env, e);
+    CseInfo* info = &env->info[k];
+    if (info->candidate) cse_record(env, e, info->hash, info->memory, holder);
+}
+
+//leaves the scope that started at mark. the newest entries head their buckets and chains, so they unlink in reverse
+static void cse_pop(CseEnv* env, int mark) {
+    while (env->count > mark) {
+        CseEntry* en = &env->entries[--env->count];
+        env->buckets[en->hash % CSE_BUCKETS] = en->next;
+        for (int slot = CSE_LINK_SLOTS - 1; slot >= 0; slot--) {
+            if (cse_linked(en, slot)) env->name_buckets[cse_name_bucket(cse_link_name(en, slot))] = en->name_next[slot];
+        }
+        if (en->reads.memory) env->memory_head = en->memory_next;
+        if (en->reads.spilled) env->spilled_head = en->spilled_next;
+    }
+}
+
+static int cse_find(CseEnv* env, Expr* e, uint32_t hash) {
+    for (int i = env->buckets[hash % CSE_BUCKETS]; i >= 0; i = env->entries[i].next) {
+        CseEntry* en = &env->entries[i];
+        if (en->alive && en->hash == hash && cse_same(en->expr, e)) return i;
+    }
+    return -1;
+}
+
+//turns the node into a read of name in place, so whatever points at it reads the name
+static void cse_make_read(Expr* e, char* name) {
+    e->type = VAR_E;
+    e->is_nullable = false;
+    e->as.var.name = name;
+    e->as.var.ownership = OWNERSHIP_NONE;
+    e->as.var.isConst = false;
+}
+
+//the parts of an expression that moved into a temp live in its initializer now, no temp of their own can
+//go in front of it. they are not logged, an if arm must not bring them back
+static void cse_drop_moved(Expr* e, void* data) {
+    CseEnv* env = data;
+    for (int i = 0; i < env->count; i++) {
+        if (env->entries[i].expr == e) env->entries[i].alive = false;
+    }
+}
+
+//another occurrence of entry i. the first time, the first occurrence moves into a temp declared
+//right before its statement and reads it from there on
+static void cse_reuse(CseEnv* env, int i, Expr* use) {
+    CseEntry* en = &env->entries[i];
+    if (!en->holder) {
+        char name[32];
+        snprintf(name, sizeof(name), "__cse%d", cse_temp_count++);
+        en->holder = intern_cstr(name);
+
+        Expr* init = arena_alloc(&g_arena, sizeof(Expr));
+        *init = *en->expr;
+        walk_expr(init, cse_drop_moved, env);
+        cse_make_read(en->expr, en->holder);
+        en->expr = init;
+
+        if (env->insert_count == env->insert_capacity) {
+            env->insert_capacity = env->insert_capacity ? env->insert_capacity * 2 : 8;
+            env->inserts = realloc(env->inserts, sizeof(CseInsert) * env->insert_capacity);
+        }
+        Stmt* decl = makeVarDecl(en->anchor->loc, en->holder, init->analyzedType, init);
+        env->inserts[env->insert_count++] = (CseInsert){decl, en->anchor, en->list, en->list_count};
+        env->changes++;
+    }
+    cse_make_read(use, en->holder);
+    env->changes++;
+}
+
+//e has its info at index k
+static void cse_expr(CseEnv* env, Expr* e, int k) {
+    CseInfo info = env->info[k];
+    if (info.candidate) {
+        int i = cse_find(env, e, info.hash);
+        if (i >= 0) {
+            cse_reuse(env, i, e);
+            return;
+        }
+    }
+
+    int before = env->changes;
+    bool record = env->record;
+    int c = k + 1;
+    int n = cse_child_count(e);
+    for (int i = 0; i < n; i++) {
+        Expr* child = *cse_child(e, i);
+        if (!child) continue;
+        //the right side of && and || may not run, nor may a match arm. what they compute is no use after
+        if ((e->type == BIN_OP_E && i == 1 && (e->as.bin_op.op == AND_T || e->as.bin_op.op == OR_T)) ||
+            (e->type == MATCH_E && i > 0)) {
+            env->record = false;
+        }
+        int size = env->info[c].size;
+        cse_expr(env, child, c);
+        c += size;
+    }
+    env->record = record;
+
+    if (e == env->held || !env->record || !env->list) return;
+    if (env->changes == before) {
+        if (info.candidate) cse_record(env, e, info.hash, info.memory, nullptr);
+    } else {
+        //parts of it became temps, it is recorded as it reads now
+        cse_try_record(env, e, nullptr);
+    }
+}
+
+//a whole expression of a statement
+static void cse_root(CseEnv* env, Expr* e) {
+    if (!e) return;
+    env->info_count = 0;
+    cse_expr(env, e, cse_info(env, e));
+}
+
+static void cse_at(CseEnv* env, Stmt* s, Stmt*** list, int* list_count) {
+    env->anchor = s;
+    env->list = list;
+    env->list_count = list_count;
+    env->record = true;
+    env->calls_known = false;
+    if (cse_memory_alive(env) && cse_calls(env)) cse_kill_memory(env);
+}
+
+typedef struct {
+    CseEnv* env;
+    bool memory;
+} CseLoopScan;
+
+static void cse_loop_stmt(Stmt* s, void* data) {
+    CseLoopScan* scan = data;
+    switch (s->type) {
+        case ASSIGN_S:
+            cse_kill_name(scan->env, s->as.var_assign.name);
+            if (s->as.var_assign.expr && s->as.var_assign.expr->analyzedType == STR_KEYWORD_T) scan->memory = true;
+            break;
+        case FOR_S:
+            cse_kill_name(scan->env, s->as.for_stmt.varName);
+            break;
+        case FREE_S:
+            cse_kill_name(scan->env, s->as.free_stmt.varName);
+            scan->memory = true;
+            break;
+        case ARRAY_ELEM_ASSIGN_S:
+            scan->memory = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void cse_loop_expr(Expr* e, void* data) {
+    if (e->type == FUNC_CALL_E && e->as.func_call.resolved_sign) ((CseLoopScan*)data)->memory = true;
+}
+
+//the body runs again after it changed things, so whatever the loop writes is unknown from the start
+static void cse_enter_loop(CseEnv* env, Stmt* loop) {
+    CseLoopScan scan = {env, false};
+    walk_stmt(loop, cse_loop_stmt, cse_loop_expr, &scan);
+    if (scan.memory) cse_kill_memory(env);
+}
+
+//each arm of an if or match starts from what held before it, after the statement whatever one arm killed is dead
+typedef struct {
+    int mark;               //entries made before the arms
+    int log_mark;
+    int* killed;
+    int count;
+    int capacity;
+} CseArms;
+
+static void cse_arm_done(CseEnv* env, CseArms* arms) {
+    cse_pop(env, arms->mark);
+    for (int k = arms->log_mark; k < env->killed_count; k++) {
+        int i = env->killed[k];
+        if (i >= arms->mark) continue;
+        env->entries[i].alive = true;
+        if (arms->count == arms->capacity) {
+            arms->capacity = arms->capacity ? arms->capacity * 2 : 16;
+            arms->killed = realloc(arms->killed, sizeof(int) * arms->capacity);
+        }
+        arms->killed[arms->count++] = i;
+    }
+    env->killed_count = arms->log_mark;
+}
+
+static void cse_arms_end(CseEnv* env, CseArms* arms) {
+    for (int k = 0; k < arms->count; k++) {
+        if (env->entries[arms->killed[k]].alive) cse_kill(env, arms->killed[k]);
+    }
+    free(arms->killed);
+}
+
+static void cse_stmt(CseEnv* env, Stmt* s, Stmt*** list, int* list_count);
+
+static void cse_list(CseEnv* env, Stmt*** stmts, int* count) {
+    int mark = env->count;
+    for (int i = 0; i < *count; i++) cse_stmt(env, (*stmts)[i], stmts, count);
+    cse_pop(env, mark);
+}
+
+static void cse_scoped(CseEnv* env, Stmt* s) {
+    int mark = env->count;
+    cse_stmt(env, s, nullptr, nullptr);
+    cse_pop(env, mark);
+}
+
+//a declaration whose local can hold its initializer for later copies, no temp needed
+static bool cse_can_hold(CseEnv* env, Stmt* s) {
+    Expr* init = s->as.var_decl.expr;
+    return init && s->as.var_decl.ownership == OWNERSHIP_NONE && !s->as.var_decl.isNullable && !s->as.var_decl.isArray &&
+           init->analyzedType == s->as.var_decl.varType && cse_is_root(init) &&
+           !local_has(&env->names, s->as.var_decl.name, LOCAL_ESCAPED);
+}
+
+static void cse_stmt(CseEnv* env, Stmt* s, Stmt*** list, int* list_count) {
+    if (!s) return;
+    cse_at(env, s, list, list_count);
+
+    switch (s->type) {
+        case VAR_DECL_S: {
+            Expr* init = s->as.var_decl.expr;
+            bool hold = cse_can_hold(env, s);
+            cse_root(env, s->as.var_decl.arraySize);
+            env->held = hold ? init : nullptr;
+            cse_root(env, s->as.var_decl.expr);
+            env->held = nullptr;
+            cse_kill_name(env, s->as.var_decl.name);
+            //a copy of the initializer further down reads the local. not if the initializer reads
+            //the name it hides, that one means the new local from here on
+            if (hold && !cse_mentions(init, s->as.var_decl.name)) cse_try_record(env, init, s->as.var_decl.name);
+            break;
+        }
+        case ASSIGN_S:
+            cse_root(env, s->as.var_assign.expr);
+            cse_kill_name(env, s->as.var_assign.name);
+            //an owned string handed over frees the old one
+            if (s->as.var_assign.expr && s->as.var_assign.expr->analyzedType == STR_KEYWORD_T) cse_kill_memory(env);
+            break;
+        case ARRAY_ELEM_ASSIGN_S:
+            cse_root(env, s->as.array_elem_assign.index);
+            cse_root(env, s->as.array_elem_assign.value);
+            cse_kill_memory(env);
+            break;
+        case FREE_S:
+            cse_kill_name(env, s->as.free_stmt.varName);
+            cse_kill_memory(env);
+            break;
+        case EXPR_STMT_S:
+            cse_root(env, s->as.expr_stmt);
+            break;
+        case IF_S: {
+            cse_root(env, s->as.if_stmt.cond);
+            CseArms arms = {.mark = env->count, .log_mark = env->killed_count};
+            cse_stmt(env, s->as.if_stmt.trueStmt, nullptr, nullptr);
+            cse_arm_done(env, &arms);
+            cse_stmt(env, s->as.if_stmt.falseStmt, nullptr, nullptr);
+            cse_arm_done(env, &arms);
+            cse_arms_end(env, &arms);
+            break;
+        }
+        case MATCH_S: {
+            cse_root(env, s->as.match_stmt.var);
+            CseArms arms = {.mark = env->count, .log_mark = env->killed_count};
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                cse_list(env, &branch->stmts, &branch->stmtCount);
+                cse_arm_done(env, &arms);
+            }
+            cse_arms_end(env, &arms);
+            break;
+        }
+        //a loop condition runs on every iteration, a value it computes is only known on entry. it may
+        //reuse what holds before the loop but records nothing
+        case WHILE_S:
+            cse_enter_loop(env, s);
+            env->record = false;
+            cse_root(env, s->as.while_stmt.cond);
+            cse_scoped(env, s->as.while_stmt.body);
+            break;
+        case DO_WHILE_S:
+            cse_enter_loop(env, s);
+            cse_scoped(env, s->as.do_while_stmt.body);
+            cse_at(env, s, list, list_count);
+            env->record = false;
+            cse_root(env, s->as.do_while_stmt.cond);
+            break;
+        case FOR_S:
+            //the start runs once, before the loop variable exists
+            cse_root(env, s->as.for_stmt.min);
+            cse_enter_loop(env, s);
+            env->record = false;
+            cse_root(env, s->as.for_stmt.max);
+            cse_scoped(env, s->as.for_stmt.body);
+            break;
+        case BLOCK_S:
+            cse_list(env, &s->as.block_stmt.stmts, &s->as.block_stmt.count);
+            break;
+        default:
+            break;
+    }
+}
+
+static void cse_insert(CseInsert* ins) {
+    int count = *ins->list_count;
+    int at = 0;
+    while (at < count && (*ins->list)[at] != ins->anchor) at++;
+    Stmt** stmts = arena_alloc(&g_arena, sizeof(Stmt*) * (count + 1));
+    memcpy(stmts, *ins->list, sizeof(Stmt*) * at);
+    stmts[at] = ins->decl;
+    memcpy(stmts + at + 1, *ins->list + at, sizeof(Stmt*) * (count - at));
+    *ins->list = stmts;
+    *ins->list_count = count + 1;
+}
+
+//returns how many occurrences it replaced plus the temps it declared, 0 if the function is unchanged
+int common_subexpressions_func(Func* f) {
+    CseEnv env = {0};
+    for (int i = 0; i < CSE_BUCKETS; i++) env.buckets[i] = env.name_buckets[i] = -1;
+    env.memory_head = env.spilled_head = -1;
+    scan_escapes(f, &env.names);
+    for (int i = 0; i < env.names.capacity && !env.flagged; i++) {
+        env.flagged = env.names.slots[i].flags & (LOCAL_ESCAPED | LOCAL_OWNED_ELEMENTS);
+    }
+    cse_stmt(&env, f->body, nullptr, nullptr);
+
+    //in the order they were made, a temp whose initializer reads another one comes after it
+    for (int i = 0; i < env.insert_count; i++) cse_insert(&env.inserts[i]);
+
+    free(env.names.slots);
+    free(env.info);
+    free(env.entries);
+    free(env.killed);
+    free(env.inserts);
+    return env.changes;
+}
+
+bool common_subexpressions(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running common subexpression elimination...");
+    bool any_modified = false;
+    for (int i = 0; i < count; i++) {
+        any_modified |= common_subexpressions_func(program[i]) > 0;
+    }
+    if (any_modified) {
+        stage_trace(STAGE_OPTIMIZER, "Common subexpression elimination made changes");
+    }
+    return any_modified;
+}
+
+// ============ LOOP INVARIANT CODE MOTION ============
+
+static int licm_temp_count = 0;
+
+//one loop at a time: what it writes, and the temps that go in front of it
+typedef struct {
+    CseEnv cse;             //purity and hashes come from cse_info, calls stands for "the loop writes memory"
+    char** stored;          //names the loop assigns, declares or frees, its own variable included
+    int stored_count;
+    int stored_capacity;
+    bool memory;            //the loop stores to an element, frees, hands over a string or calls a function
+    int first;              //the loop's temps start here in cse.inserts
+    Stmt* loop;
+    Stmt*** list;
+    int* list_count;
+    int changes;
+} LicmEnv;
+
+static void licm_store(LicmEnv* env, char* name) {
+    for (int i = 0; i < env->stored_count; i++) {
+        if (env->stored[i] == name) return;
+    }
+    if (env->stored_count == env->stored_capacity) {
+        env->stored_capacity = env->stored_capacity ? env->stored_capacity * 2 : 16;
+        env->stored = realloc(env->stored, sizeof(char*) * env->stored_capacity);
+    }
+    env->stored[env->stored_count++] = name;
+}
+
+static bool licm_stored(LicmEnv* env, char* name) {
+    for (int i = 0; i < env->stored_count; i++) {
+        if (env->stored[i] == name) return true;
+    }
+    return false;
+}
+
+//a local declared in the body is a new value every iteration, the same as one assigned there
+static void licm_scan_stmt(Stmt* s, void* data) {
+    LicmEnv* env = data;
+    switch (s->type) {
+        case VAR_DECL_S:
+            licm_store(env, s->as.var_decl.name);
+            break;
+        case ASSIGN_S:
+            licm_store(env, s->as.var_assign.name);
+            if (s->as.var_assign.expr && s->as.var_assign.expr->analyzedType == STR_KEYWORD_T) env->memory = true;
+            break;
+        case FOR_S:
+            licm_store(env, s->as.for_stmt.varName);
+            break;
+        case FREE_S:
+            licm_store(env, s->as.free_stmt.varName);
+            env->memory = true;
+            break;
+        case ARRAY_ELEM_ASSIGN_S:
+            env->memory = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void licm_scan_expr(Expr* e, void* data) {
+    if (e->type == FUNC_CALL_E && e->as.func_call.resolved_sign) ((LicmEnv*)data)->memory = true;
+}
+
+typedef struct {
+    LicmEnv* env;
+    bool invariant;
+    bool traps;
+} LicmCheck;
+
+static void licm_check(Expr* e, void* data) {
+    LicmCheck* check = data;
+    switch (e->type) {
+        case VAR_E:
+            if (licm_stored(check->env, e->as.var.name)) check->invariant = false;
+            break;
+        case ARRAY_ACCESS_E:
+            if (licm_stored(check->env, e->as.array_access.arrayName)) check->invariant = false;
+            check->traps = true;
+            break;
+        case BIN_OP_E: {
+            //integer division by zero or -1 can trap, a nonzero literal divisor other than -1 cannot
+            Expr* r = e->as.bin_op.exprR;
+            if (e->as.bin_op.op == SLASH_T && e->analyzedType != FLOAT_KEYWORD_T && e->analyzedType != DOUBLE_KEYWORD_T &&
+                !(r->type == INT_LIT_E && r->as.int_val != 0 && r->as.int_val != -1)) {
+                check->traps = true;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//the temp for e, one the loop already has if it computes the same
+static char* licm_temp(LicmEnv* env, Expr* e) {
+    for (int i = env->first; i < env->cse.insert_count; i++) {
+        Stmt* decl = env->cse.inserts[i].decl;
+        if (cse_same(decl->as.var_decl.expr, e)) return decl->as.var_decl.name;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "__inv%d", licm_temp_count++);
+    Expr* init = arena_alloc(&g_arena, sizeof(Expr));
+    *init = *e;
+    Stmt* decl = makeVarDecl(env->loop->loc, intern_cstr(name), init->analyzedType, init);
+
+    CseEnv* cse = &env->cse;
+    if (cse->insert_count == cse->insert_capacity) {
+        cse->insert_capacity = cse->insert_capacity ? cse->insert_capacity * 2 : 8;
+        cse->inserts = realloc(cse->inserts, sizeof(CseInsert) * cse->insert_capacity);
+    }
+    cse->inserts[cse->insert_count++] = (CseInsert){decl, env->loop, env->list, env->list_count};
+    env->changes++;
+    return decl->as.var_decl.name;
+}
+
+//e has its info at index k. entry is set where e runs whenever the loop is reached, only there
+//can something that may trap move in front of it: the loop might not have run it at all
+static void licm_expr(LicmEnv* env, Expr* e, int k, bool entry) {
+    if (env->cse.info[k].candidate) {
+        LicmCheck check = {env, true, false};
+        walk_expr(e, licm_check, &check);
+        if (check.invariant && (entry || !check.traps)) {
+            cse_make_read(e, licm_temp(env, e));
+            env->changes++;
+            return;
+        }
+    }
+
+    int child = k + 1;
+    int n = cse_child_count(e);
+    for (int i = 0; i < n; i++) {
+        Expr* c = *cse_child(e, i);
+        if (!c) continue;
+        bool runs = entry && !(e->type == MATCH_E && i > 0) &&
+                    !(e->type == BIN_OP_E && i == 1 && (e->as.bin_op.op == AND_T || e->as.bin_op.op == OR_T));
+        licm_expr(env, c, child, runs);
+        child += env->cse.info[child].size;
+    }
+}
+
+static void licm_root(LicmEnv* env, Expr* e, bool entry) {
+    if (!e) return;
+    env->cse.info_count = 0;
+    licm_expr(env, e, cse_info(&env->cse, e), entry);
+}
+
+static void licm_body_stmt(Stmt* s, void* data) {
+    Expr* exprs[2];
+    int n = cse_stmt_exprs(s, exprs);
+    for (int i = 0; i < n; i++) licm_root(data, exprs[i], false);
+}
+
+//outer loops go first, so a value is taken out of every loop it does not change in at once
+static void licm_loop(LicmEnv* env, Stmt* loop, Stmt*** list, int* list_count) {
+    env->stored_count = 0;
+    env->memory = false;
+    walk_stmt(loop, licm_scan_stmt, licm_scan_expr, env);
+    env->cse.calls = env->memory;
+    env->first = env->cse.insert_count;
+    env->loop = loop;
+    env->list = list;
+    env->list_count = list_count;
+
+    //the condition and the bound are looked at before every iteration, the first time included
+    switch (loop->type) {
+        case WHILE_S:
+            licm_root(env, loop->as.while_stmt.cond, true);
+            walk_stmt(loop->as.while_stmt.body, licm_body_stmt, nullptr, env);
+            break;
+        case DO_WHILE_S:
+            walk_stmt(loop->as.do_while_stmt.body, licm_body_stmt, nullptr, env);
+            licm_root(env, loop->as.do_while_stmt.cond, false);
+            break;
+        case FOR_S:
+            licm_root(env, loop->as.for_stmt.max, true);
+            walk_stmt(loop->as.for_stmt.body, licm_body_stmt, nullptr, env);
+            break;
+        default:
+            break;
+    }
+}
+
+static void licm_stmt(LicmEnv* env, Stmt* s, Stmt*** list, int* list_count);
+
+static void licm_list(LicmEnv* env, Stmt** stmts, int count, Stmt*** list, int* list_count) {
+    for (int i = 0; i < count; i++) licm_stmt(env, stmts[i], list, list_count);
+}
+
+//temps go right before the loop, one that is not directly in a block or match arm has no place for them
+static void licm_stmt(LicmEnv* env, Stmt* s, Stmt*** list, int* list_count) {
+    if (!s) return;
+    switch (s->type) {
+        case WHILE_S:
+            if (list) licm_loop(env, s, list, list_count);
+            licm_stmt(env, s->as.while_stmt.body, nullptr, nullptr);
+            break;
+        case DO_WHILE_S:
+            if (list) licm_loop(env, s, list, list_count);
+            licm_stmt(env, s->as.do_while_stmt.body, nullptr, nullptr);
+            break;
+        case FOR_S:
+            if (list) licm_loop(env, s, list, list_count);
+            licm_stmt(env, s->as.for_stmt.body, nullptr, nullptr);
+            break;
+        case IF_S:
+            licm_stmt(env, s->as.if_stmt.trueStmt, nullptr, nullptr);
+            licm_stmt(env, s->as.if_stmt.falseStmt, nullptr, nullptr);
+            break;
+        case MATCH_S:
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                licm_list(env, branch->stmts, branch->stmtCount, &branch->stmts, &branch->stmtCount);
+            }
+            break;
+        case BLOCK_S:
+            licm_list(env, s->as.block_stmt.stmts, s->as.block_stmt.count, &s->as.block_stmt.stmts, &s->as.block_stmt.count);
+            break;
+        default:
+            break;
+    }
+}
+
+//returns how many computations it moved out of loops plus the temps it declared, 0 if the function is unchanged
+int loop_invariant_motion_func(Func* f) {
+    LicmEnv env = {0};
+    env.cse.calls_known = true;
+    scan_escapes(f, &env.cse.names);
+    for (int i = 0; i < env.cse.names.capacity && !env.cse.flagged; i++) {
+        env.cse.flagged = env.cse.names.slots[i].flags & (LOCAL_ESCAPED | LOCAL_OWNED_ELEMENTS);
+    }
+    licm_stmt(&env, f->body, nullptr, nullptr);
+
+    //an outer loop's temps were made first, an inner loop's initializer may read them
+    for (int i = 0; i < env.cse.insert_count; i++) cse_insert(&env.cse.inserts[i]);
+
+    free(env.cse.names.slots);
+    free(env.cse.info);
+    free(env.cse.inserts);
+    free(env.stored);
+    return env.changes;
+}
+
+bool loop_invariant_motion(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running loop invariant code motion...");
+    bool any_modified = false;
+    for (int i = 0; i < count; i++) {
+        any_modified |= loop_invariant_motion_func(program[i]) > 0;
+    }
+    if (any_modified) {
+        stage_trace(STAGE_OPTIMIZER, "Loop invariant code motion made changes");
+    }
+    return any_modified;
+}
+
+// ============ STRENGTH REDUCTION ============
+
+static int sr_temp_count = 0;
+
+//a value that moves in step with a for counter: i * c and c * i go up by c each round, i + c, c + i
+//and i - c by one, c - i down by one. c is a literal or a local the loop does not store to
+typedef struct {
+    Expr* shape;            //the first occurrence, later ones compare equal to it
+    char* name;
+} SrInduction;
+
+typedef struct {
+    Func* func;
+    LicmEnv loop;           //what the loop being reduced stores, escapes come from its cse part
+    char* counter;
+    SrInduction* ivs;
+    int iv_count;
+    int iv_capacity;
+    Stmt** updates;         //one per induction, the body ends with them
+    char** nonneg;          //counters of the loops around the expression that never go below zero
+    int nonneg_count;
+    int nonneg_capacity;
+    bool scanned;           //escapes are only looked for once a loop can be reduced
+    int changes;
+} SrEnv;
+
+//a plain int local, not one that can change behind the optimizer's back
+static bool sr_plain_local(SrEnv* env, Expr* e) {
+    return e->type == VAR_E && e->analyzedType == INT_KEYWORD_T && !e->is_nullable &&
+           e->as.var.ownership == OWNERSHIP_NONE && !cse_local_has(&env->loop.cse, e->as.var.name, LOCAL_ESCAPED);
+}
+
+static bool sr_is_counter(SrEnv* env, Expr* e) {
+    return e->type == VAR_E && e->as.var.name == env->counter;
+}
+
+//the body never stores the counter either, but it is the one local that still moves
+static bool sr_invariant(SrEnv* env, Expr* e) {
+    if (e->type == INT_LIT_E) return true;
+    return sr_plain_local(env, e) && !sr_is_counter(env, e) && !licm_stored(&env->loop, e->as.var.name);
+}
+
+//how e follows the counter: the operator and the step its temp is updated by, false if it does not
+static bool sr_induction(SrEnv* env, Expr* e, TokenType* op, Expr** step) {
+    if (e->type != BIN_OP_E || e->analyzedType != INT_KEYWORD_T) return false;
+    Expr* l = e->as.bin_op.exprL;
+    Expr* r = e->as.bin_op.exprR;
+    bool lc = sr_is_counter(env, l) && sr_invariant(env, r);
+    bool rc = sr_is_counter(env, r) && sr_invariant(env, l);
+    if (!lc && !rc) return false;
+
+    //the update also runs after the last round, where the value it makes is never read. it wraps
+    //instead of overflowing, so it cannot add an overflow the program did not have
+    *op = WRAP_PLUS_T;
+    *step = nullptr;
+    switch (e->as.bin_op.op) {
+        case STAR_T: *step = lc ? r : l; return true;
+        case PLUS_T: return true;
+        case MINUS_T: if (rc) *op = WRAP_MINUS_T; return true;
+        default: return false;
+    }
+}
+
+static Expr* sr_int(Expr* e) {
+    e->analyzedType = INT_KEYWORD_T;
+    return e;
+}
+
+//e with the counter's first value in place of the counter
+static Expr* sr_start(SrEnv* env, Expr* e, Expr* min) {
+    if (sr_is_counter(env, e)) return clone_expr(min);
+    if (e->type != BIN_OP_E) return clone_expr(e);
+    Expr* l = sr_start(env, e->as.bin_op.exprL, min);
+    Expr* r = sr_start(env, e->as.bin_op.exprR, min);
+    //most counters start at 0, i * c then starts at 0 and c + i at c
+    bool l0 = l->type == INT_LIT_E && l->as.int_val == 0;
+    bool r0 = r->type == INT_LIT_E && r->as.int_val == 0;
+    if (e->as.bin_op.op == STAR_T && (l0 || r0)) return l0 ? l : r;
+    if (e->as.bin_op.op == PLUS_T && (l0 || r0)) return l0 ? r : l;
+    //the start is computed in front of the loop even if it never runs, so it wraps instead of overflowing
+    TokenType op = e->as.bin_op.op == STAR_T ? WRAP_STAR_T : e->as.bin_op.op == PLUS_T ? WRAP_PLUS_T :
+                   e->as.bin_op.op == MINUS_T ? WRAP_MINUS_T : e->as.bin_op.op;
+    return sr_int(makeBinOp(e->loc, l, op, r));
+}
+
+//the temp for induction e: declared before the loop with its first value, stepped at the end of the body
+static char* sr_temp(SrEnv* env, Stmt* loop, Expr* e, TokenType op, Expr* step) {
+    for (int i = 0; i < env->iv_count; i++) {
+        if (cse_same(env->ivs[i].shape, e)) return env->ivs[i].name;
+    }
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "__iv%d", sr_temp_count++);
+    char* name = intern_cstr(buf);
+
+    LicmEnv* l = &env->loop;
+    if (l->cse.insert_count == l->cse.insert_capacity) {
+        l->cse.insert_capacity = l->cse.insert_capacity ? l->cse.insert_capacity * 2 : 8;
+        l->cse.inserts = realloc(l->cse.inserts, sizeof(CseInsert) * l->cse.insert_capacity);
+    }
+    Stmt* decl = makeVarDecl(loop->loc, name, INT_KEYWORD_T, sr_start(env, e, loop->as.for_stmt.min));
+    l->cse.inserts[l->cse.insert_count++] = (CseInsert){decl, loop, l->list, l->list_count};
+
+    Expr* by = step ? clone_expr(step) : sr_int(makeIntLit(e->loc, 1));
+    Expr* next = sr_int(makeBinOp(e->loc, sr_int(makeVar(e->loc, name)), op, by));
+
+    if (env->iv_count == env->iv_capacity) {
+        env->iv_capacity = env->iv_capacity ? env->iv_capacity * 2 : 8;
+        env->ivs = realloc(env->ivs, sizeof(SrInduction) * env->iv_capacity);
+        env->updates = realloc(env->updates, sizeof(Stmt*) * env->iv_capacity);
+    }
+    env->ivs[env->iv_count] = (SrInduction){e, name};
+    env->updates[env->iv_count++] = makeAssign(e->loc, name, next);
+    env->changes++;
+    return name;
+}
+
+static void sr_expr(SrEnv* env, Stmt* loop, Expr* e) {
+    TokenType op;
+    Expr* step;
+    if (sr_induction(env, e, &op, &step)) {
+        //the read replaces the node in place, the induction keeps a copy of what it was
+        Expr* shape = arena_alloc(&g_arena, sizeof(Expr));
+        *shape = *e;
+        cse_make_read(e, sr_temp(env, loop, shape, op, step));
+        env->changes++;
+        return;
+    }
+    int n = cse_child_count(e);
+    for (int i = 0; i < n; i++) {
+        Expr* c = *cse_child(e, i);
+        if (c) sr_expr(env, loop, c);
+    }
+}
+
+typedef struct {
+    SrEnv* env;
+    Stmt* loop;
+} SrBody;
+
+static void sr_body_stmt(Stmt* s, void* data) {
+    SrBody* body = data;
+    Expr* exprs[2];
+    int n = cse_stmt_exprs(s, exprs);
+    for (int i = 0; i < n; i++) {
+        if (exprs[i]) sr_expr(body->env, body->loop, exprs[i]);
+    }
+}
+
+//the counter goes up by one each round as long as the body neither stores to it nor hides it
+static bool sr_counter_kept(SrEnv* env, Stmt* loop) {
+    env->loop.stored_count = 0;
+    walk_stmt(loop->as.for_stmt.body, licm_scan_stmt, licm_scan_expr, &env->loop);
+    return !licm_stored(&env->loop, loop->as.for_stmt.varName);
+}
+
+static void sr_scan_escapes(SrEnv* env) {
+    if (env->scanned) return;
+    CseEnv* cse = &env->loop.cse;
+    scan_escapes(env->func, &cse->names);
+    for (int i = 0; i < cse->names.capacity && !cse->flagged; i++) {
+        cse->flagged = cse->names.slots[i].flags & (LOCAL_ESCAPED | LOCAL_OWNED_ELEMENTS);
+    }
+    env->scanned = true;
+}
+
+//the body has no break or continue, so the steps at its end run once per round. they run after the
+//last round too, its value is never read. env->loop holds what the body stores
+static void sr_loop(SrEnv* env, Stmt* loop, Stmt*** list, int* list_count) {
+    Stmt* body = loop->as.for_stmt.body;
+    Expr* min = loop->as.for_stmt.min;
+    if (!body || body->type != BLOCK_S) return;
+    sr_scan_escapes(env);
+    if (min->type != INT_LIT_E && !sr_plain_local(env, min)) return;
+
+    env->counter = loop->as.for_stmt.varName;
+    env->loop.list = list;
+    env->loop.list_count = list_count;
+    env->iv_count = 0;
+    SrBody walk = {env, loop};
+    walk_stmt(body, sr_body_stmt, nullptr, &walk);
+    if (env->iv_count == 0) return;
+
+    int count = body->as.block_stmt.count;
+    Stmt** stmts = arena_alloc(&g_arena, sizeof(Stmt*) * (count + env->iv_count));
+    memcpy(stmts, body->as.block_stmt.stmts, sizeof(Stmt*) * count);
+    memcpy(stmts + count, env->updates, sizeof(Stmt*) * env->iv_count);
+    body->as.block_stmt.stmts = stmts;
+    body->as.block_stmt.count = count + env->iv_count;
+}
+
+// --- powers of two ---
+
+static int sr_log2(Expr* e) {
+    if (e->type != INT_LIT_E || e->as.int_val < 2 || (e->as.int_val & (e->as.int_val - 1))) return -1;
+    int k = 0;
+    while ((1 << k) != e->as.int_val) k++;
+    return k;
+}
+
+//values that cannot be negative: a right shift only divides those the way / does, it rounds a negative one down
+static bool sr_nonneg(SrEnv* env, Expr* e) {
+    switch (e->type) {
+        case INT_LIT_E: return e->as.int_val >= 0;
+        case FUNC_CALL_E: return cse_is_length(e);
+        case VAR_E:
+            for (int i = 0; i < env->nonneg_count; i++) {
+                if (env->nonneg[i] == e->as.var.name) return true;
+            }
+            return false;
+        case BIN_OP_E:
+            switch (e->as.bin_op.op) {
+                case PLUS_T:
+                case STAR_T:
+                case SLASH_T:
+                case SHIFT_RIGHT_T:
+                    return sr_nonneg(env, e->as.bin_op.exprL) && sr_nonneg(env, e->as.bin_op.exprR);
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+static void sr_shift_expr(SrEnv* env, Expr* e) {
+    int n = cse_child_count(e);
+    for (int i = 0; i < n; i++) {
+        Expr* c = *cse_child(e, i);
+        if (c) sr_shift_expr(env, c);
+    }
+    if (e->type != BIN_OP_E || e->analyzedType != INT_KEYWORD_T) return;
+    Expr* l = e->as.bin_op.exprL;
+    Expr* r = e->as.bin_op.exprR;
+    if (l->analyzedType != INT_KEYWORD_T || r->analyzedType != INT_KEYWORD_T) return;
+
+    if (e->as.bin_op.op == STAR_T && sr_log2(l) >= 0 && sr_log2(r) < 0) {
+        e->as.bin_op.exprL = r;
+        e->as.bin_op.exprR = l;
+        Expr* t = l;
+        l = r;
+        r = t;
+    }
+    int k = sr_log2(r);
+    if (k < 0) return;
+    if (e->as.bin_op.op == STAR_T) {
+        e->as.bin_op.op = SHIFT_LEFT_T;
+    } else if (e->as.bin_op.op == SLASH_T && sr_nonneg(env, l)) {
+        e->as.bin_op.op = SHIFT_RIGHT_T;
+    } else {
+        return;
+    }
+    e->as.bin_op.exprR = sr_int(makeIntLit(r->loc, k));
+    env->changes++;
+}
+
+static void sr_stmt(SrEnv* env, Stmt* s, Stmt*** list, int* list_count);
+
+static void sr_list(SrEnv* env, Stmt** stmts, int count, Stmt*** list, int* list_count) {
+    for (int i = 0; i < count; i++) sr_stmt(env, stmts[i], list, list_count);
+}
+
+//loops get their inductions first, what is left of their multiplies then becomes shifts
+static void sr_stmt(SrEnv* env, Stmt* s, Stmt*** list, int* list_count) {
+    if (!s) return;
+    bool kept = s->type == FOR_S && sr_counter_kept(env, s);
+    if (kept && list) sr_loop(env, s, list, list_count);
+
+    Expr* exprs[2];
+    int n = cse_stmt_exprs(s, exprs);
+    for (int i = 0; i < n; i++) {
+        if (exprs[i]) sr_shift_expr(env, exprs[i]);
+    }
+
+    switch (s->type) {
+        case FOR_S: {
+            bool counts_up = kept && sr_nonneg(env, s->as.for_stmt.min);
+            if (counts_up) {
+                if (env->nonneg_count == env->nonneg_capacity) {
+                    env->nonneg_capacity = env->nonneg_capacity ? env->nonneg_capacity * 2 : 8;
+                    env->nonneg = realloc(env->nonneg, sizeof(char*) * env->nonneg_capacity);
+                }
+                env->nonneg[env->nonneg_count++] = s->as.for_stmt.varName;
+            }
+            sr_stmt(env, s->as.for_stmt.body, nullptr, nullptr);
+            if (counts_up) env->nonneg_count--;
+            break;
+        }
+        case WHILE_S: sr_stmt(env, s->as.while_stmt.body, nullptr, nullptr); break;
+        case DO_WHILE_S: sr_stmt(env, s->as.do_while_stmt.body, nullptr, nullptr); break;
+        case IF_S:
+            sr_stmt(env, s->as.if_stmt.trueStmt, nullptr, nullptr);
+            sr_stmt(env, s->as.if_stmt.falseStmt, nullptr, nullptr);
+            break;
+        case MATCH_S:
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                sr_list(env, branch->stmts, branch->stmtCount, &branch->stmts, &branch->stmtCount);
+            }
+            break;
+        case BLOCK_S:
+            sr_list(env, s->as.block_stmt.stmts, s->as.block_stmt.count, &s->as.block_stmt.stmts, &s->as.block_stmt.count);
+            break;
+        default:
+            break;
+    }
+}
+
+//returns how many expressions it rewrote plus the temps it declared, 0 if the function is unchanged
+int strength_reduction_func(Func* f) {
+    SrEnv env = {.func = f};
+    sr_stmt(&env, f->body, nullptr, nullptr);
+    for (int i = 0; i < env.loop.cse.insert_count; i++) cse_insert(&env.loop.cse.inserts[i]);
+
+    free(env.loop.cse.names.slots);
+    free(env.loop.cse.inserts);
+    free(env.loop.stored);
+    free(env.ivs);
+    free(env.updates);
+    free(env.nonneg);
+    return env.changes;
+}
+
+bool strength_reduction(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running strength reduction...");
+    bool any_modified = false;
+    for (int i = 0; i < count; i++) {
+        any_modified |= strength_reduction_func(program[i]) > 0;
+    }
+    if (any_modified) {
+        stage_trace(STAGE_OPTIMIZER, "Strength reduction made changes");
+    }
+    return any_modified;
+}
+
+// ============ LOOP UNROLLING ============
+
+int g_unroll_limit = UNROLL_DEFAULT_LIMIT;
+
+static int unroll_temp_count = 0;
+
+static void unroll_count_stmt(Stmt* s, void* data) {
+    (void)s;
+    (*(int*)data)++;
+}
+
+static void unroll_count_expr(Expr* e, void* data) {
+    (void)e;
+    (*(int*)data)++;
+}
+
+//ast nodes in the body, what the copies are measured in
+static int unroll_cost(Stmt* body) {
+    int cost = 0;
+    walk_stmt(body, unroll_count_stmt, unroll_count_expr, &cost);
+    return cost;
+}
+
+//one round of the loop as a block of its own: the counter declared with value, then the body
+static Stmt* unroll_round(Stmt* loop, Expr* value) {
+    Stmt* body = loop->as.for_stmt.body;
+    int count = body->as.block_stmt.count;
+    Stmt** stmts = arena_alloc(&g_arena, sizeof(Stmt*) * (count + 1));
+    stmts[0] = makeVarDecl(loop->loc, loop->as.for_stmt.varName, INT_KEYWORD_T, value);
+    for (int i = 0; i < count; i++) stmts[i + 1] = clone_stmt(body->as.block_stmt.stmts[i]);
+    return makeBlock(loop->loc, stmts, count + 1);
+}
+
+//a constant trip count small enough to copy the body for every round, the loop becomes a block of them
+static bool unroll_full(Stmt* loop, int cost) {
+    Expr* min = loop->as.for_stmt.min;
+    Expr* max = loop->as.for_stmt.max;
+    if (min->type != INT_LIT_E || max->type != INT_LIT_E) return false;
+    long long trips = (long long)max->as.int_val - min->as.int_val + 1;
+    if (trips < 0) trips = 0;
+    if (trips * cost > g_unroll_limit) return false;
+
+    Stmt** rounds = arena_alloc(&g_arena, sizeof(Stmt*) * (trips > 0 ? trips : 1));
+    for (int k = 0; k < trips; k++) {
+        rounds[k] = unroll_round(loop, sr_int(makeIntLit(loop->loc, min->as.int_val + k)));
+    }
+    loop->type = BLOCK_S;
+    loop->as.block_stmt.stmts = rounds;
+    loop->as.block_stmt.count = (int)trips;
+    return true;
+}
+
+//  __urN: int = min;
+//  while (__urN <= max - (factor - 1)) { {i: int = __urN; body} {i: int = __urN + 1; body} ... __urN = __urN + factor; }
+//  for (i: __urN to max) body
+//the bound is read a different number of times than before, so it has to be one the body cannot change
+static bool unroll_partial(SrEnv* env, Stmt* loop, int cost) {
+    Expr* max = loop->as.for_stmt.max;
+    int factor = cost * 8 <= g_unroll_limit ? 8 : cost * 4 <= g_unroll_limit ? 4 : 0;
+    if (factor == 0 || !sr_invariant(env, max)) return false;
+
+    SourceLocation loc = loop->loc;
+    char buf[32];
+    snprintf(buf, sizeof(buf), "__ur%d", unroll_temp_count++);
+    char* name = intern_cstr(buf);
+
+    Stmt** steps = arena_alloc(&g_arena, sizeof(Stmt*) * (factor + 1));
+    steps[0] = unroll_round(loop, sr_int(makeVar(loc, name)));
+    for (int k = 1; k < factor; k++) {
+        Expr* value = sr_int(makeBinOp(loc, sr_int(makeVar(loc, name)), PLUS_T, sr_int(makeIntLit(loc, k))));
+        steps[k] = unroll_round(loop, value);
+    }
+    Expr* next = sr_int(makeBinOp(loc, sr_int(makeVar(loc, name)), PLUS_T, sr_int(makeIntLit(loc, factor))));
+    steps[factor] = makeAssign(loc, name, next);
+
+    //max - (factor - 1) is wrong for a max near INT_MIN, where no full round is left anyway. it wraps
+    //instead of overflowing, licm may move it in front of the loop where the check has not run yet
+    Expr* low = sr_int(makeIntLit(loc, INT32_MIN + factor - 1));
+    Expr* fits = makeBinOp(loc, clone_expr(max), MORE_EQUALS_T, low);
+    fits->analyzedType = BOOL_KEYWORD_T;
+    Expr* last = sr_int(makeBinOp(loc, clone_expr(max), WRAP_MINUS_T, sr_int(makeIntLit(loc, factor - 1))));
+    Expr* more = makeBinOp(loc, sr_int(makeVar(loc, name)), LESS_EQUALS_T, last);
+    more->analyzedType = BOOL_KEYWORD_T;
+    Expr* cond = makeBinOp(loc, fits, AND_T, more);
+    cond->analyzedType = BOOL_KEYWORD_T;
+
+    //the original loop takes the rounds that are left, it is not unrolled again
+    Stmt* rest = arena_alloc(&g_arena, sizeof(Stmt));
+    *rest = *loop;
+    rest->as.for_stmt.min = sr_int(makeVar(loc, name));
+    rest->as.for_stmt.unrolled = true;
+
+    Stmt** stmts = arena_alloc(&g_arena, sizeof(Stmt*) * 3);
+    stmts[0] = makeVarDecl(loc, name, INT_KEYWORD_T, loop->as.for_stmt.min);
+    stmts[1] = makeWhile(loc, cond, makeBlock(loc, steps, factor + 1));
+    stmts[2] = rest;
+    loop->type = BLOCK_S;
+    loop->as.block_stmt.stmts = stmts;
+    loop->as.block_stmt.count = 3;
+    return true;
+}
+
+static void unroll_stmt(SrEnv* env, Stmt* s);
+
+//inner loops first, an outer loop is measured with what they turned into
+static void unroll_loop(SrEnv* env, Stmt* loop) {
+    Stmt* body = loop->as.for_stmt.body;
+    unroll_stmt(env, body);
+    if (loop->as.for_stmt.unrolled || !body || body->type != BLOCK_S || !sr_counter_kept(env, loop)) return;
+
+    int cost = unroll_cost(body);
+    sr_scan_escapes(env);
+    if (unroll_full(loop, cost) || unroll_partial(env, loop, cost)) env->changes++;
+}
+
+static void unroll_stmt(SrEnv* env, Stmt* s) {
+    if (!s) return;
+    switch (s->type) {
+        case FOR_S: unroll_loop(env, s); break;
+        case WHILE_S: unroll_stmt(env, s->as.while_stmt.body); break;
+        case DO_WHILE_S: unroll_stmt(env, s->as.do_while_stmt.body); break;
+        case IF_S:
+            unroll_stmt(env, s->as.if_stmt.trueStmt);
+            unroll_stmt(env, s->as.if_stmt.falseStmt);
+            break;
+        case MATCH_S:
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* branch = &s->as.match_stmt.branches[i];
+                for (int j = 0; j < branch->stmtCount; j++) unroll_stmt(env, branch->stmts[j]);
+            }
+            break;
+        case BLOCK_S:
+            for (int i = 0; i < s->as.block_stmt.count; i++) unroll_stmt(env, s->as.block_stmt.stmts[i]);
+            break;
+        default:
+            break;
+    }
+}
+
+//returns how many loops it unrolled, 0 if the function is unchanged
+int unroll_loops_func(Func* f) {
+    SrEnv env = {.func = f};
+    unroll_stmt(&env, f->body);
+    free(env.loop.cse.names.slots);
+    free(env.loop.stored);
+    return env.changes;
+}
+
+bool unroll_loops(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running loop unrolling...");
+    bool any_modified = false;
+    for (int i = 0; i < count; i++) {
+        any_modified |= unroll_loops_func(program[i]) > 0;
+    }
+    if (any_modified) {
+        stage_trace(STAGE_OPTIMIZER, "Loop unrolling made changes");
+    }
+    return any_modified;
+}
+
+// ============ INLINING ============
+
+//the cost model lives in inliner.c, this is the same test it applies
+bool is_small_function(Func* f) {
+    return inline_cost(f) <= g_inline_threshold;
+}
+
+//one sweep over every function, optimize_program drives inlining through the worklist instead
+bool inline_functions(Func** program, int count) {
+    stage_trace(STAGE_OPTIMIZER, "Running function inlining...");
+    InlineCtx* ctx = inline_begin(program, count);
+    int changes = 0;
+    for (int i = 0; i < count; i++) {
+        changes += inline_calls(ctx, i);
+        inline_update(ctx, i);
+    }
+    inline_end(ctx);
+    return changes > 0;
+}
+
+// ============ MAIN OPTIMIZATION DRIVER ============
+
+static const char* opt_pass_names[OPT_PASS_COUNT] = {"const-fold", "const-prop", "peephole", "licm", "strength", "unroll", "cse", "dead-code", "inline"};
+
+//functions waiting to be optimized, each one is in the list at most once
+typedef struct {
+    int* items;     //ring of function indices
+    bool* queued;
+    int head;
+    int len;
+    int capacity;
+} OptWorklist;
+
+static void worklist_push(OptWorklist* w, int f) {
+    if (w->queued[f]) return;
+    w->queued[f] = true;
+    w->items[(w->head + w->len++) % w->capacity] = f;
+}
+
+static int worklist_pop(OptWorklist* w) {
+    int f = w->items[w->head];
+    w->head = (w->head + 1) % w->capacity;
+    w->len--;
+    w->queued[f] = false;
+    return f;
+}
+
+//one pass over program[i], the rewrites it made go into stats
+static int run_pass(OptPass pass, Func** program, int i, InlineCtx* inliner, OptStats* stats) {
+    Func* f = program[i];
+    int changes = 0;
+    switch (pass) {
+        case OPT_PASS_CONST_FOLD: changes = constant_folding_stmt(f->body); break;
+        case OPT_PASS_CONST_PROP: changes = constant_propagation_func(f); break;
+        case OPT_PASS_PEEPHOLE: changes = peephole_optimizations_stmt(f->body); break;
+        case OPT_PASS_LICM: changes = loop_invariant_motion_func(f); break;
+        case OPT_PASS_STRENGTH: changes = strength_reduction_func(f); break;
+        case OPT_PASS_UNROLL: changes = unroll_loops_func(f); break;
+        case OPT_PASS_CSE: changes = common_subexpressions_func(f); break;
+        case OPT_PASS_DEAD_CODE: changes = dead_code_elimination_stmt(&f->body); break;
+        case OPT_PASS_INLINE: changes = inline_calls(inliner, i); break;
+        default: break;
+    }
+    stats->runs[pass]++;
+    stats->changes[pass] += changes;
+    return changes;
+}
+
+void optimize_program(Func** program, int count, OptimizationLevel level, OptStats* stats) {
+    OptStats local = {0};
+    if (!stats) stats = &local;
+    if (level == OPT_NONE || count == 0) return;
+
+    stage_trace(STAGE_OPTIMIZER, "Optimizing with level %d", level);
+
+    //in the order they run on a function
+    OptPass passes[OPT_PASS_COUNT];
+    int pass_count = 0;
+    if (level & OPT_CONST_FOLD) passes[pass_count++] = OPT_PASS_CONST_FOLD;
+    if (level & OPT_CONST_PROP) passes[pass_count++] = OPT_PASS_CONST_PROP;
+    if (level & OPT_PEEPHOLE) passes[pass_count++] = OPT_PASS_PEEPHOLE;
+    if (level & OPT_LICM) passes[pass_count++] = OPT_PASS_LICM;
+    if (level & OPT_STRENGTH) passes[pass_count++] = OPT_PASS_STRENGTH;
+    if ((level & OPT_UNROLL) && g_unroll_limit > 0) passes[pass_count++] = OPT_PASS_UNROLL;
+    if (level & OPT_CSE) passes[pass_count++] = OPT_PASS_CSE;
+    if (level & OPT_DEAD_CODE) passes[pass_count++] = OPT_PASS_DEAD_CODE;
+    InlineCtx* inliner = nullptr;
+    if ((level & OPT_INLINE) && g_inline_threshold > 0) {
+        passes[pass_count++] = OPT_PASS_INLINE;
+        inliner = inline_begin(program, count);
+    }
+
+    OptWorklist work = {
+        .items = malloc(sizeof(int) * count),
+        .queued = calloc(count, sizeof(bool)),
+        .capacity = count,
+    };
+    for (int i = 0; i < count; i++) worklist_push(&work, i);
+
+    //the passes only look inside one function, so a function is done once it stops changing and
+    //a stable one is never walked again. a pass that reaches across functions pushes what it touched
+    while (work.len > 0) {
+        int i = worklist_pop(&work);
+        stats->funcs_visited++;
+
+        int round = 0;
+        int changes;
+        do {
+            changes = 0;
+            round++;
+            for (int p = 0; p < pass_count; p++) {
+                changes += run_pass(passes[p], program, i, inliner, stats);
+            }
+        } while (changes > 0 && round < OPT_MAX_ROUNDS);
+
+        stats->rounds += round;
+        if (changes > 0) {
+            stage_trace(STAGE_OPTIMIZER, "%s still changing after %d rounds", program[i]->signature->name, round);
+        }
+
+        //it can be inlined now (its own calls got inlined, or it shrank), the callers get another go
+        if (inliner && inline_update(inliner, i)) {
+            int caller_count;
+            const int* callers = inline_callers(inliner, i, &caller_count);
+            for (int c = 0; c < caller_count; c++) worklist_push(&work, callers[c]);
+        }
+    }
+
+    inline_end(inliner);
+    free(work.items);
+    free(work.queued);
+}
+
+void opt_stats_print(const OptStats* stats, FILE* out) {
+    fprintf(out, "optimizer: %d functions visited, %d rounds\n", stats->funcs_visited, stats->rounds);
+    fprintf(out, "  %-12s %10s %10s\n", "pass", "runs", "changes");
+    for (int p = 0; p < OPT_PASS_COUNT; p++) {
+        if (stats->runs[p] == 0) continue;
+        fprintf(out, "  %-12s %10d %10d\n", opt_pass_names[p], stats->runs[p], stats->changes[p]);
+    }
+}
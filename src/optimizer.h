@@ -13,12 +13,59 @@ typedef enum {
     OPT_DEAD_CODE = 1 << 1,
     OPT_PEEPHOLE = 1 << 2,
     OPT_INLINE = 1 << 3,
-    OPT_ALL = 0xFF
+    OPT_CONST_PROP = 1 << 4,
+    OPT_CSE = 1 << 5,
+    OPT_LICM = 1 << 6,
+    OPT_STRENGTH = 1 << 7,
+    OPT_UNROLL = 1 << 8,
+    OPT_ALL = 0x1FF
 } OptimizationLevel;
 
-void optimize_program(Func** program, int count, OptimizationLevel level);
+typedef enum {
+    OPT_PASS_CONST_FOLD,
+    OPT_PASS_CONST_PROP,
+    OPT_PASS_PEEPHOLE,
+    OPT_PASS_LICM,
+    OPT_PASS_STRENGTH,
+    OPT_PASS_UNROLL,
+    OPT_PASS_CSE,
+    OPT_PASS_DEAD_CODE,
+    OPT_PASS_INLINE,
+    OPT_PASS_COUNT
+} OptPass;
+
+//a function that keeps changing is left alone after this many rounds of all passes
+#define OPT_MAX_ROUNDS 10
+
+//a for body is copied while the copies stay within this many ast nodes
+#define UNROLL_DEFAULT_LIMIT 128
+
+//--unroll-limit, 0 turns unrolling off
+extern int g_unroll_limit;
+
+//what the optimizer did, per pass
+typedef struct {
+    int runs[OPT_PASS_COUNT];       //times the pass ran over a function
+    int changes[OPT_PASS_COUNT];    //rewrites it made
+    int funcs_visited;              //worklist pops
+    int rounds;                     //rounds of all passes, summed over the visited functions
+} OptStats;
+
+//works off a per function worklist, only functions that still change are run again. stats may be nullptr
+void optimize_program(Func** program, int count, OptimizationLevel level, OptStats* stats);
+void opt_stats_print(const OptStats* stats, FILE* out);
 
 bool constant_folding(Func** program, int count);
+//values of int/bool locals followed through the body, reads of a known one become the literal
+bool constant_propagation(Func** program, int count);
+//repeated pure expressions (arithmetic, comparisons, length(), element reads) computed once into a temp
+bool common_subexpressions(Func** program, int count);
+//pure computations a loop does not change move in front of it, into temps
+bool loop_invariant_motion(Func** program, int count);
+//for counters stepped into temps instead of multiplied, * and / by powers of two into shifts
+bool strength_reduction(Func** program, int count);
+//for loops with a constant trip count copied out fully, others by 4 or 8 with a loop for the rest
+bool unroll_loops(Func** program, int count);
 bool dead_code_elimination(Func** program, int count);
 bool peephole_optimizations(Func** program, int count);
 bool inline_functions(Func** program, int count);
@@ -0,0 +1,93 @@
+//created by bucka on 10/16/2026.
+
+#include "outbuf.h"
+
+void ob_init(OutBuf* b, size_t initial) {
+    b->cap = initial ? initial : 64 * 1024;
+    b->len = 0;
+    b->data = malloc(b->cap);
+    if (!b->data) {
+        fprintf(stderr, "out of memory (output buffer of %zu bytes)\n", b->cap);
+        exit(1);
+    }
+}
+
+void ob_free(OutBuf* b) {
+    free(b->data);
+    b->data = nullptr;
+    b->len = b->cap = 0;
+}
+
+void ob_grow(OutBuf* b, size_t extra) {
+    size_t cap = b->cap ? b->cap : 64 * 1024;
+    while (cap < b->len + extra) cap *= 2;
+    char* data = realloc(b->data, cap);
+    if (!data) {
+        fprintf(stderr, "out of memory (output buffer of %zu bytes)\n", cap);
+        exit(1);
+    }
+    b->data = data;
+    b->cap = cap;
+}
+
+void ob_int(OutBuf* b, long long v) {
+    char tmp[24];
+    int n = 0;
+    unsigned long long u = v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) tmp[n++] = '-';
+
+    if (b->len + n > b->cap) ob_grow(b, n);
+    while (n) b->data[b->len++] = tmp[--n];
+}
+
+void ob_indent(OutBuf* b, int level) {
+    if (level <= 0) return;
+    size_t n = (size_t)level * 2;
+    if (b->len + n > b->cap) ob_grow(b, n);
+    memset(b->data + b->len, ' ', n);
+    b->len += n;
+}
+
+void ob_escaped(OutBuf* b, const char* s) {
+    //copy runs of plain characters at once, only the escapes go one by one
+    const char* run = s;
+    for (; *s; s++) {
+        const char* esc;
+        switch (*s) {
+            case '\n': esc = "\\n"; break;
+            case '\t': esc = "\\t"; break;
+            case '\r': esc = "\\r"; break;
+            case '\\': esc = "\\\\"; break;
+            case '"': esc = "\\\""; break;
+            default: continue;
+        }
+        ob_write(b, run, s - run);
+        ob_write(b, esc, 2);
+        run = s + 1;
+    }
+    ob_write(b, run, s - run);
+}
+
+void ob_printf(OutBuf* b, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(b->data + b->len, b->cap - b->len, fmt, args);
+    va_end(args);
+    if (n < 0) return;
+
+    if (b->len + (size_t)n + 1 > b->cap) {
+        ob_grow(b, (size_t)n + 1);
+        va_start(args, fmt);
+        vsnprintf(b->data + b->len, b->cap - b->len, fmt, args);
+        va_end(args);
+    }
+    b->len += (size_t)n;
+}
+
+bool ob_write_to(const OutBuf* b, FILE* f) {
+    return fwrite(b->data, 1, b->len, f) == b->len;
+}
@@ -0,0 +1,45 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_OUTBUF_H
+#define LYNC_OUTBUF_H
+
+#include "common.h"
+
+//growable output buffer for generated code, written out in one go at the end
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} OutBuf;
+
+void ob_init(OutBuf* b, size_t initial);
+void ob_free(OutBuf* b);
+void ob_grow(OutBuf* b, size_t extra);
+
+static inline void ob_write(OutBuf* b, const char* s, size_t n) {
+    if (b->len + n > b->cap) ob_grow(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static inline void ob_putc(OutBuf* b, char c) {
+    if (b->len + 1 > b->cap) ob_grow(b, 1);
+    b->data[b->len++] = c;
+}
+
+static inline void ob_puts(OutBuf* b, const char* s) {
+    ob_write(b, s, strlen(s));
+}
+
+//string literals only, the length is known at compile time
+#define ob_lit(b, s) ob_write((b), ("" s), sizeof(s) - 1)
+
+void ob_int(OutBuf* b, long long v);
+void ob_indent(OutBuf* b, int level);          //two spaces per level
+void ob_escaped(OutBuf* b, const char* s);     //body of a C string literal, without the quotes
+void ob_printf(OutBuf* b, const char* fmt, ...); //for the rare formats the helpers dont cover
+
+//writes everything in one call, false if the write came up short
+bool ob_write_to(const OutBuf* b, FILE* f);
+
+#endif //LYNC_OUTBUF_H
@@ -2,7 +2,6 @@
 
 #include "parser.h"
 
-#define TOK_LOC(tok) ((SourceLocation){.line = (tok)->line, .column = (tok)->column, .filename = (tok)->filename})
 
 Pattern* parsePattern(Parser* p);
 
@@ -10,7 +9,7 @@ Token* peek(Parser* parser, int offset) {
     //use last tokens location if available
     if (parser->pos + offset >= parser->count) {
         Token* lastTok = parser->pos > 0 ? &parser->tokens[parser->pos - 1] : &parser->tokens[0];
-        stage_fatal(STAGE_PARSER, TOK_LOC(lastTok),
+        stage_fatal(STAGE_PARSER, token_loc(lastTok),
                     "peek beyond token stream (pos=%d)", parser->pos);
     }
 
@@ -27,7 +26,7 @@ Token* expect(Parser* parser, TokenType type) {
     Token *tok = &parser->tokens[parser->pos++];
 
     if (tok->type != type) {
-        stage_fatal(STAGE_PARSER, TOK_LOC(tok),
+        stage_fatal(STAGE_PARSER, token_loc(tok),
                     "expected %s but found %s at token index %d",
                     token_type_name(type),
                     token_type_name(tok->type),
@@ -38,7 +37,7 @@ Token* expect(Parser* parser, TokenType type) {
 }
 
 Func** parseFunctions(Parser* p, int* num) {
-    Func** functions = malloc(sizeof(Func) * 2);
+    Func** functions = arena_alloc(&g_arena, sizeof(Func) * 2);
     int size = 2;
     int count = 0;
 
@@ -68,11 +67,11 @@ Func** parseFunctions(Parser* p, int* num) {
         Token* ret = consume(p);
         Stmt* body = parseBlock(p);
 
-        functions[count++] = makeFunc(name->value, params, pCount, ret->type, o, body);
+        functions[count++] = makeFunc(token_text(name), params, pCount, ret->type, o, body);
 
         if(count >= size) {
             size *= 2;
-            functions = realloc(functions, sizeof(Func) * size);
+            functions = arena_realloc(&g_arena, functions, sizeof(Func) * (size / 2), sizeof(Func) * size);
         }
     }
 
@@ -95,24 +94,24 @@ ExternBlock* parseExternBlock(Parser* p) {
         //we likely get VAR_T DOT_T VAR_T
         //lets just append the token text if possible, but we dont have text easily for all tokens
         //for now support simple "math.h"
-        if(t->type == VAR_T) strcat(header, (char*)t->value);
+        if(t->type == VAR_T) strncat(header, source_text(t->file_id) + t->offset, t->as.ident.length);
         else if(t->type == DOT_T) strcat(header, ".");
         else strcat(header, token_type_name(t->type)); //fallback
     }
     expect(p, MORE_T);
     expect(p, L_BRACE_T);
 
-    ExternBlock* block = malloc(sizeof(ExternBlock));
-    block->header = strdup(header);
+    ExternBlock* block = arena_alloc(&g_arena, sizeof(ExternBlock));
+    block->header = arena_strdup(&g_arena, header);
     block->capacity = 4;
     block->count = 0;
-    block->signs = malloc(sizeof(FuncSign*) * block->capacity);
+    block->signs = arena_alloc(&g_arena, sizeof(FuncSign*) * block->capacity);
 
     while(peek(p, 0)->type != R_BRACE_T && peek(p, 0)->type != EOF_T) {
         if(peek(p, 0)->type == DEF_KEYWORD_T) {
              consume(p);
              Token* nameTok = expect(p, VAR_T);
-             char* name = (char*)nameTok->value;
+             char* name = token_text(nameTok);
              
              expect(p, L_PAREN_T);
              int paramCount = 0;
@@ -146,7 +145,7 @@ ExternBlock* parseExternBlock(Parser* p) {
              
              expect(p, SEMICOLON_T);
 
-             FuncSign* sign = malloc(sizeof(FuncSign));
+             FuncSign* sign = arena_alloc(&g_arena, sizeof(FuncSign));
              sign->name = name;
              sign->parameters = params;
              sign->paramNum = paramCount;
@@ -156,7 +155,7 @@ ExternBlock* parseExternBlock(Parser* p) {
 
              if(block->count >= block->capacity) {
                  block->capacity *= 2;
-                 block->signs = realloc(block->signs, sizeof(FuncSign*) * block->capacity);
+                 block->signs = arena_realloc(&g_arena, block->signs, sizeof(FuncSign*) * (block->capacity / 2), sizeof(FuncSign*) * block->capacity);
              }
              block->signs[block->count++] = sign;
         } else {
@@ -172,7 +171,7 @@ Expr* parseExpr(Parser* p) {
     while (peek(p, 0)->type == OR_T) {
         Token* op = consume(p);
         Expr* right = parseAnd(p);
-        e = makeBinOp(TOK_LOC(op), e, op->type, right);
+        e = makeBinOp(token_loc(op), e, op->type, right);
     }
     return e;
 }
@@ -181,7 +180,7 @@ Expr* parseAnd(Parser* p) {
     while (peek(p, 0)->type == AND_T) {
         Token* op = consume(p);
         Expr* right = parseComparison(p);
-        e = makeBinOp(TOK_LOC(op), e, op->type, right);
+        e = makeBinOp(token_loc(op), e, op->type, right);
     }
     return e;
 }
@@ -192,7 +191,7 @@ Expr* parseComparison(Parser* p) {
            t == MORE_EQUALS_T || t == DOUBLE_EQUALS_T || t == NOT_EQUALS_T) {
         Token* op = consume(p);
         Expr* right = parseAdd(p);
-        e = makeBinOp(TOK_LOC(op), e, op->type, right);
+        e = makeBinOp(token_loc(op), e, op->type, right);
         t = peek(p, 0)->type;
     }
     return e;
@@ -203,7 +202,7 @@ Expr* parseAdd(Parser* p) {
     while (t == PLUS_T || t == MINUS_T) {
         Token* op = consume(p);
         Expr* right = parseTerm(p);
-        e = makeBinOp(TOK_LOC(op), e, op->type, right);
+        e = makeBinOp(token_loc(op), e, op->type, right);
         t = peek(p, 0)->type;
     }
     return e;
@@ -214,7 +213,7 @@ Expr* parseTerm(Parser* p) {
     while (t == STAR_T || t == SLASH_T) {
         Token* op = consume(p);
         Expr* right = parseFactor(p);
-        e = makeBinOp(TOK_LOC(op), e, op->type, right);
+        e = makeBinOp(token_loc(op), e, op->type, right);
         t = peek(p, 0)->type;
     }
     return e;
@@ -225,40 +224,38 @@ Expr* parseFactor(Parser* p) {
     switch (tok->type) {
         case INT_LIT_T: {
             Token* t = consume(p);
-            return makeIntLit(TOK_LOC(t), *(int*)t->value);
+            return makeIntLit(token_loc(t), t->as.int_val);
         }
         case BOOL_LIT_T: {
             Token* t = consume(p);
-            return makeBoolLit(TOK_LOC(t), *(int*)t->value);
+            return makeBoolLit(token_loc(t), t->as.int_val);
         }
         case CHAR_LIT_T: {
             Token* t = consume(p);
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
             e->type = CHAR_LIT_E;
-            e->loc = TOK_LOC(t);
-            e->as.char_val = (char)*(int*)t->value; 
+            e->loc = token_loc(t);
+            e->as.char_val = (char)t->as.int_val;
             e->is_nullable = false;
             return e;
         }
         case STR_LIT_T: {
             Token* t = consume(p);
-            return makeStrLit(TOK_LOC(t), (char*)t->value);
+            return makeStrLit(token_loc(t), token_string(t));
         }
         case NULL_LIT_T: {
             Token* t = consume(p);
-            return makeNullLit(TOK_LOC(t));
+            return makeNullLit(token_loc(t));
         }
         case FLOAT_LIT_T: {
             Token* t = consume(p);
-            char* str = (char*)t->value;
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
             e->type = FLOAT_LIT_E;
-            e->loc = TOK_LOC(t);
+            e->loc = token_loc(t);
             e->is_nullable = false;
-            e->as.double_val = strtod(str, NULL);
+            e->as.double_val = t->as.float_val;
             //set analyzedType hint for analyzer: f suffix = float, else double
-            size_t len = strlen(str);
-            if (len > 0 && (str[len-1] == 'f' || str[len-1] == 'F')) {
+            if (t->flags & TOKF_FLOAT_SUFFIX) {
                 e->analyzedType = FLOAT_KEYWORD_T;
             } else {
                 e->analyzedType = DOUBLE_KEYWORD_T;
@@ -269,7 +266,7 @@ Expr* parseFactor(Parser* p) {
             Token* t = consume(p);
             if (peek(p, 0)->type == L_PAREN_T) {
                 expect(p, L_PAREN_T);
-                Expr** args = malloc(sizeof(Expr*) * 2);
+                Expr** args = arena_alloc(&g_arena, sizeof(Expr*) * 2);
                 int count = 0;
                 int capacity = 2;
                 while (peek(p, 0)->type != R_PAREN_T) {
@@ -277,34 +274,34 @@ Expr* parseFactor(Parser* p) {
                     args[count++] = parseExpr(p);
                     if (count >= capacity) {
                         capacity *= 2;
-                        args = realloc(args, sizeof(Expr*) * capacity);
+                        args = arena_realloc(&g_arena, args, sizeof(Expr*) * (capacity / 2), sizeof(Expr*) * capacity);
                     }
                 }
                 expect(p, R_PAREN_T);
-                return makeFuncCall(TOK_LOC(t), t->value, args, count);
+                return makeFuncCall(token_loc(t), token_text(t), args, count);
             } else if (peek(p, 0)->type == L_BRACKET_T) {
                 consume(p);
                 Expr* e = parseExpr(p);
                 expect(p, R_BRACKET_T);
-                return makeArrAccess(TOK_LOC(t), t->value, e);
+                return makeArrAccess(token_loc(t), token_text(t), e);
             }
-            return makeVar(TOK_LOC(t), (char*)t->value);
+            return makeVar(token_loc(t), token_text(t));
         }
         case UNDERSCORE_T: {
             Token* t = consume(p);
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
             e->type = VOID_E;
-            e->loc = TOK_LOC(t);
+            e->loc = token_loc(t);
             e->is_nullable = false;
             return e;
         }
         case MINUS_T: {
             Token* t = consume(p);
-            return makeUnOp(TOK_LOC(t), MINUS_T, parseFactor(p));
+            return makeUnOp(token_loc(t), MINUS_T, parseFactor(p));
         }
         case NEGATION_T: {
             Token* t = consume(p);
-            return makeUnOp(TOK_LOC(t), NEGATION_T, parseFactor(p));
+            return makeUnOp(token_loc(t), NEGATION_T, parseFactor(p));
         }
         case L_PAREN_T: {
             consume(p);
@@ -314,7 +311,7 @@ Expr* parseFactor(Parser* p) {
         }
         case L_BRACE_T: {
             Token* t = consume(p);
-            Expr** exprs = malloc(sizeof(Expr*) * 2);
+            Expr** exprs = arena_alloc(&g_arena, sizeof(Expr*) * 2);
             int count = 0;
             int height = 2;
             while (peek(p, 0)->type != R_BRACE_T) {
@@ -325,18 +322,18 @@ Expr* parseFactor(Parser* p) {
 
                 if(count >= height){
                     height *= 2;
-                    exprs = realloc(exprs, sizeof(Expr*) * height);
+                    exprs = arena_realloc(&g_arena, exprs, sizeof(Expr*) * (height / 2), sizeof(Expr*) * height);
                 }
             }
             consume(p);
-            return makeArrDecl(TOK_LOC(t), exprs, count);
+            return makeArrDecl(token_loc(t), exprs, count);
         }
         case MATCH_T: {
             Token* matchTok = consume(p);
             Expr* target = parseExpr(p);
             expect(p, L_BRACE_T);
 
-            MatchBranchExpr* branches = malloc(sizeof(MatchBranchExpr) * 2);
+            MatchBranchExpr* branches = arena_alloc(&g_arena, sizeof(MatchBranchExpr) * 2);
             int count = 0;
             int capacity = 2;
             while (peek(p, 0)->type != R_BRACE_T) {
@@ -348,15 +345,15 @@ Expr* parseFactor(Parser* p) {
 
                 if (count >= capacity) {
                     capacity *= 2;
-                    branches = realloc(branches, sizeof(MatchBranchExpr) * capacity);
+                    branches = arena_realloc(&g_arena, branches, sizeof(MatchBranchExpr) * (capacity / 2), sizeof(MatchBranchExpr) * capacity);
                 }
             }
 
             expect(p, R_BRACE_T);
 
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
             e->type = MATCH_E;
-            e->loc = TOK_LOC(matchTok);
+            e->loc = token_loc(matchTok);
             e->is_nullable = false;  //will be determined by analyzer
             e->as.match.var = target;
             e->as.match.branches = branches;
@@ -364,7 +361,7 @@ Expr* parseFactor(Parser* p) {
             return e;
         }
         case SOME_T: {
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
 
             consume(p);
             expect(p, L_PAREN_T);
@@ -372,21 +369,21 @@ Expr* parseFactor(Parser* p) {
             expect(p, R_PAREN_T);
 
             e->type = SOME_E;
-            e->loc = TOK_LOC(peek(p, -4));  //some token location
+            e->loc = token_loc(peek(p, -4));  //some token location
             e->is_nullable = false;
             e->as.match.var = v;
             return e;
         }
         case RETURN_T: {
             Token* retTok = consume(p);
-            Expr* e = malloc(sizeof(Expr));
+            Expr* e = arena_alloc(&g_arena, sizeof(Expr));
             e->type = FUNC_RET_E;
-            e->loc = TOK_LOC(retTok);
+            e->loc = token_loc(retTok);
             e->is_nullable = false;
             if(peek(p, 0)->type == SEMICOLON_T){
-                Expr* ve = malloc(sizeof(Expr));
+                Expr* ve = arena_alloc(&g_arena, sizeof(Expr));
                 ve->type = VOID_E;
-                ve->loc = TOK_LOC(retTok);
+                ve->loc = token_loc(retTok);
                 ve->is_nullable = false;
                 e->as.func_ret_expr = ve;
             } else
@@ -413,9 +410,9 @@ Expr* parseFactor(Parser* p) {
 
             Expr* e = isArr ? arrSizeExpr : parseExpr(p);
 
-            Expr* al = malloc(sizeof(Expr));
+            Expr* al = arena_alloc(&g_arena, sizeof(Expr));
             al->type = ALLOC_E;
-            al->loc = TOK_LOC(allocTok);
+            al->loc = token_loc(allocTok);
             al->is_nullable = false;  //alloc always returns a pointer
             al->as.alloc.initialValue = e;
             al->as.alloc.isArray = isArr;
@@ -424,24 +421,24 @@ Expr* parseFactor(Parser* p) {
         }
 
         default:
-            stage_fatal(STAGE_PARSER, TOK_LOC(tok), "Unexpected token %s in expression", token_type_name(tok->type));
+            stage_fatal(STAGE_PARSER, token_loc(tok), "Unexpected token %s in expression", token_type_name(tok->type));
     }
 }
 
 IncludeStmt* parseIncludeStmt(Parser* p) {
-    IncludeStmt* stmt = malloc(sizeof(IncludeStmt));
+    IncludeStmt* stmt = arena_alloc(&g_arena, sizeof(IncludeStmt));
     Token* usingTok = expect(p, INCLUDE_T);
-    stmt->loc = TOK_LOC(usingTok);
+    stmt->loc = token_loc(usingTok);
 
     //parse: std.io.* or std.io.read_int
     //module is everything before the last dot, last part is * or function name
 
-    char** parts = malloc(sizeof(char*) * 10);
+    char** parts = arena_alloc(&g_arena, sizeof(char*) * 10);
     int part_count = 0;
     int part_capacity = 10;
 
     //collect all identifiers
-    parts[part_count++] = expect(p, VAR_T)->value;
+    parts[part_count++] = token_text(expect(p, VAR_T));
 
     while (peek(p, 0)->type == DOT_T) {
         consume(p);
@@ -453,23 +450,22 @@ IncludeStmt* parseIncludeStmt(Parser* p) {
             //build module name from all parts
             char* module = parts[0];
             for (int i = 1; i < part_count; i++) {
-                char* new_module = malloc(strlen(module) + strlen(parts[i]) + 2);
+                char* new_module = arena_alloc(&g_arena, strlen(module) + strlen(parts[i]) + 2);
                 sprintf(new_module, "%s.%s", module, parts[i]);
                 module = new_module;
             }
 
-            stmt->module_name = module;
+            stmt->module_name = intern_cstr(module);
             stmt->type = IMPORT_ALL;
             stmt->function_name = NULL;
-            free(parts);
             expect(p, SEMICOLON_T);
             return stmt;
         } else if (peek(p, 0)->type == VAR_T) {
             if (part_count >= part_capacity) {
                 part_capacity *= 2;
-                parts = realloc(parts, sizeof(char*) * part_capacity);
+                parts = arena_realloc(&g_arena, parts, sizeof(char*) * (part_capacity / 2), sizeof(char*) * part_capacity);
             }
-            parts[part_count++] = consume(p)->value;
+            parts[part_count++] = token_text(consume(p));
         } else {
             stage_fatal(STAGE_PARSER, stmt->loc, "expected identifier or '*' after '.'");
         }
@@ -484,16 +480,15 @@ IncludeStmt* parseIncludeStmt(Parser* p) {
     //build module from all but last part
     char* module = parts[0];
     for (int i = 1; i < part_count - 1; i++) {
-        char* new_module = malloc(strlen(module) + strlen(parts[i]) + 2);
+        char* new_module = arena_alloc(&g_arena, strlen(module) + strlen(parts[i]) + 2);
         sprintf(new_module, "%s.%s", module, parts[i]);
         module = new_module;
     }
 
-    stmt->module_name = module;
+    stmt->module_name = intern_cstr(module);
     stmt->type = IMPORT_SPECIFIC;
     stmt->function_name = parts[part_count - 1];
 
-    free(parts);
     expect(p, SEMICOLON_T);
     return stmt;
 }
@@ -501,28 +496,29 @@ IncludeStmt* parseIncludeStmt(Parser* p) {
 Program* parseProgram(Parser* p) {
     stage_trace(STAGE_PARSER, "parse program begin");
 
-    Program* prog = malloc(sizeof(Program));
-    prog->imports = malloc(sizeof(ImportList));
+    Program* prog = arena_alloc(&g_arena, sizeof(Program));
+    prog->imports = arena_alloc(&g_arena, sizeof(ImportList));
     prog->imports->import_capacity = 10;
-    prog->imports->imports = malloc(sizeof(IncludeStmt*) * prog->imports->import_capacity);
+    prog->imports->imports = arena_alloc(&g_arena, sizeof(IncludeStmt*) * prog->imports->import_capacity);
     prog->imports->import_count = 0;
 
     prog->ext_block_count = 0;
     int ext_cap = 4;
-    prog->externBlocks = malloc(sizeof(ExternBlock*) * ext_cap);
+    prog->externBlocks = arena_alloc(&g_arena, sizeof(ExternBlock*) * ext_cap);
 
     while (peek(p, 0)->type != EOF_T) {
         if(peek(p, 0)->type == INCLUDE_T) {
             if (prog->imports->import_count >= prog->imports->import_capacity) {
                 prog->imports->import_capacity *= 2;
-                prog->imports->imports = realloc(prog->imports->imports,
-                                                 sizeof(IncludeStmt *) * prog->imports->import_capacity);
+                prog->imports->imports = arena_realloc(&g_arena, prog->imports->imports,
+                                                       sizeof(IncludeStmt *) * (prog->imports->import_capacity / 2),
+                                                       sizeof(IncludeStmt *) * prog->imports->import_capacity);
             }
             prog->imports->imports[prog->imports->import_count++] = parseIncludeStmt(p);
         } else if(peek(p, 0)->type == EXTERN_T) {
             if (prog->ext_block_count >= ext_cap) {
                 ext_cap *= 2;
-                prog->externBlocks = realloc(prog->externBlocks, sizeof(ExternBlock*) * ext_cap);
+                prog->externBlocks = arena_realloc(&g_arena, prog->externBlocks, sizeof(ExternBlock*) * (ext_cap / 2), sizeof(ExternBlock*) * ext_cap);
             }
             prog->externBlocks[prog->ext_block_count++] = parseExternBlock(p);
         } else {
@@ -543,9 +539,9 @@ Program* parseProgram(Parser* p) {
 }
 
 Pattern* parsePattern(Parser* p) {
-    Pattern* pattern = malloc(sizeof(Pattern));
+    Pattern* pattern = arena_alloc(&g_arena, sizeof(Pattern));
     Token* tok = peek(p, 0);
-    pattern->loc = TOK_LOC(tok);
+    pattern->loc = token_loc(tok);
 
     switch (tok->type) {
         case NULL_LIT_T:
@@ -562,7 +558,7 @@ Pattern* parsePattern(Parser* p) {
             Token* bindingTok = expect(p, VAR_T);
             expect(p, R_PAREN_T);
             pattern->type = SOME_PATTERN;
-            pattern->as.binding_name = bindingTok->value;
+            pattern->as.binding_name = token_text(bindingTok);
             break;
         }
         default:
@@ -589,11 +585,11 @@ Stmt* parseStatement(Parser* p) {
             //continues to var as it will be var
         }
         case VAR_T: {
-            Stmt *s = malloc(sizeof(Stmt));
+            Stmt *s = arena_alloc(&g_arena, sizeof(Stmt));
             if (peek(p, 1)->type == COLON_T) {
                 Ownership o = OWNERSHIP_NONE;
                 Token* varTok = consume(p);
-                char *name = varTok->value;
+                char *name = token_text(varTok);
                 expect(p, COLON_T);
 
                 if (peek(p, 0)->type == OWN_T) {
@@ -607,7 +603,7 @@ Stmt* parseStatement(Parser* p) {
                 bool isNullable = false;
                 if (peek(p, 0)->type == QUESTION_MARK_T) {
                     if(o == OWNERSHIP_NONE)
-                        stage_fatal(STAGE_PARSER, TOK_LOC(peek(p, 0)), "Non-pointer nullable variable not allowed!");
+                        stage_fatal(STAGE_PARSER, token_loc(peek(p, 0)), "Non-pointer nullable variable not allowed!");
                     consume(p);
                     isNullable = true;
                 }
@@ -639,19 +635,19 @@ Stmt* parseStatement(Parser* p) {
                     e = parseExpr(p);
                 } else if (!isArray) {
                     //non-array variables must have an initializer
-                    stage_fatal(STAGE_PARSER, TOK_LOC(peek(p, 0)),
+                    stage_fatal(STAGE_PARSER, token_loc(peek(p, 0)),
                                 "variable declaration requires initializer (expected '=')");
                 } else {
                     //array without initializer - create VOID expression as placeholder
-                    e = malloc(sizeof(Expr));
+                    e = arena_alloc(&g_arena, sizeof(Expr));
                     e->type = VOID_E;
-                    e->loc = TOK_LOC(peek(p, 0));
+                    e->loc = token_loc(peek(p, 0));
                     e->is_nullable = false;
                 }
                 expect(p, SEMICOLON_T);
 
                 s->type = VAR_DECL_S;
-                s->loc = TOK_LOC(varTok);
+                s->loc = token_loc(varTok);
                 s->as.var_decl.expr = e;
                 s->as.var_decl.varType = varType;
                 s->as.var_decl.name = name;
@@ -664,7 +660,7 @@ Stmt* parseStatement(Parser* p) {
             } else if (peek(p, 1)->type == L_BRACKET_T) {
                 //array element assignment: arr[i] = value
                 Token* arrayTok = consume(p);
-                char* arrayName = arrayTok->value;
+                char* arrayName = token_text(arrayTok);
                 consume(p);
                 Expr* index = parseExpr(p);
                 expect(p, R_BRACKET_T);
@@ -673,19 +669,19 @@ Stmt* parseStatement(Parser* p) {
                 expect(p, SEMICOLON_T);
 
                 s->type = ARRAY_ELEM_ASSIGN_S;
-                s->loc = TOK_LOC(arrayTok);
+                s->loc = token_loc(arrayTok);
                 s->as.array_elem_assign.arrayName = arrayName;
                 s->as.array_elem_assign.index = index;
                 s->as.array_elem_assign.value = value;
             } else if (peek(p, 1)->type == EQUALS_T) {
                 Token* varTok = consume(p);
-                char *name = varTok->value;
+                char *name = token_text(varTok);
                 expect(p, EQUALS_T);
                 Expr *e = parseExpr(p);
                 expect(p, SEMICOLON_T);
 
                 s->type = ASSIGN_S;
-                s->loc = TOK_LOC(varTok);
+                s->loc = token_loc(varTok);
                 s->as.var_assign.name = name;
                 s->as.var_assign.expr = e;
                 s->as.var_assign.ownership = OWNERSHIP_NONE;
@@ -696,11 +692,11 @@ Stmt* parseStatement(Parser* p) {
                 s->loc = e->loc;  //use expressions location
                 s->as.expr_stmt = e;
             } else if (peek(p, 1)->type == R_BRACKET_T); //for = T[expr];
-            else stage_fatal(STAGE_PARSER, TOK_LOC(peek(p, 1)), "Unexpected token after variable: %s", token_type_name(peek(p, 1)->type));
+            else stage_fatal(STAGE_PARSER, token_loc(peek(p, 1)), "Unexpected token after variable: %s", token_type_name(peek(p, 1)->type));
             return s;
         }
         case IF_T: {
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             Token* ifTok = consume(p);
             expect(p, L_PAREN_T);
             Expr* c = parseExpr(p);
@@ -714,14 +710,14 @@ Stmt* parseStatement(Parser* p) {
             }
 
             s->type = IF_S;
-            s->loc = TOK_LOC(ifTok);
+            s->loc = token_loc(ifTok);
             s->as.if_stmt.cond = c;
             s->as.if_stmt.trueStmt = te;
             s->as.if_stmt.falseStmt = fe;
             return s;
         }
         case WHILE_T: {
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             Token* whileTok = consume(p);
             expect(p, L_PAREN_T);
             Expr* c = parseExpr(p);
@@ -729,13 +725,13 @@ Stmt* parseStatement(Parser* p) {
             Stmt* b = parseBlock(p);
 
             s->type = WHILE_S;
-            s->loc = TOK_LOC(whileTok);
+            s->loc = token_loc(whileTok);
             s->as.while_stmt.cond = c;
             s->as.while_stmt.body = b;
             return s;
         }
         case DO_T: {
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             Token* doTok = consume(p);
             Stmt* b = parseBlock(p);
             expect(p, WHILE_T);
@@ -744,16 +740,16 @@ Stmt* parseStatement(Parser* p) {
             expect(p, R_PAREN_T);
 
             s->type = DO_WHILE_S;
-            s->loc = TOK_LOC(doTok);
+            s->loc = token_loc(doTok);
             s->as.do_while_stmt.cond = c;
             s->as.do_while_stmt.body = b;
             return s;
         }
         case FOR_T: {
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             Token* forTok = consume(p);
             expect(p, L_PAREN_T);
-            char* name = consume(p)->value;
+            char* name = token_text(consume(p));
             expect(p, COLON_T);
             Expr* minE = parseExpr(p);
             expect(p, TO_T);
@@ -762,7 +758,7 @@ Stmt* parseStatement(Parser* p) {
             Stmt* b = parseBlock(p);
 
             s->type = FOR_S;
-            s->loc = TOK_LOC(forTok);
+            s->loc = token_loc(forTok);
             s->as.for_stmt.varName = name;
             s->as.for_stmt.min = minE;
             s->as.for_stmt.max = maxE;
@@ -770,14 +766,14 @@ Stmt* parseStatement(Parser* p) {
             return s;
         }
         case MATCH_T: {
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             Token* matchTok = consume(p);
             Expr* var = parseExpr(p);
             expect(p, L_BRACE_T);
 
             int bCount = 0;
             int bSize = 2;
-            MatchBranchStmt* branches = malloc(sizeof(MatchBranchStmt) * 2);
+            MatchBranchStmt* branches = arena_alloc(&g_arena, sizeof(MatchBranchStmt) * 2);
 
             while (peek(p, 0)->type != R_BRACE_T) {
                 Pattern* pattern = parsePattern(p);
@@ -786,13 +782,14 @@ Stmt* parseStatement(Parser* p) {
 
                 int stmtCount = 0;
                 int stmtsSize = 2;
-                branches[bCount].stmts = malloc(sizeof(Stmt*) * 2);
+                branches[bCount].stmts = arena_alloc(&g_arena, sizeof(Stmt*) * 2);
                 while (peek(p, 0)->type != R_BRACE_T) {
                     branches[bCount].stmts[stmtCount++] = parseStatement(p);
 
                     if(stmtCount >= stmtsSize) {
                         stmtsSize *= 2;
-                        branches = realloc(branches, sizeof(MatchBranchStmt) * bSize);
+                        branches[bCount].stmts = arena_realloc(&g_arena, branches[bCount].stmts,
+                                                               sizeof(Stmt*) * (stmtsSize / 2), sizeof(Stmt*) * stmtsSize);
                     }
                 }
                 expect(p, R_BRACE_T);
@@ -802,7 +799,7 @@ Stmt* parseStatement(Parser* p) {
 
                 if (bCount >= bSize) {
                     bSize *= 2;
-                    branches = realloc(branches, sizeof(MatchBranchStmt) * bSize);
+                    branches = arena_realloc(&g_arena, branches, sizeof(MatchBranchStmt) * (bSize / 2), sizeof(MatchBranchStmt) * bSize);
                 }
             }
 
@@ -810,7 +807,7 @@ Stmt* parseStatement(Parser* p) {
             expect(p, SEMICOLON_T);
 
             s->type = MATCH_S;
-            s->loc = TOK_LOC(matchTok);
+            s->loc = token_loc(matchTok);
             s->as.match_stmt.var = var;
             s->as.match_stmt.branches = branches;
             s->as.match_stmt.branchCount = bCount;
@@ -819,10 +816,10 @@ Stmt* parseStatement(Parser* p) {
         case FREE_T: {
             Token* freeTok = consume(p);
             Token* var = expect(p, VAR_T);
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             s->type = FREE_S;
-            s->loc = TOK_LOC(freeTok);
-            s->as.free_stmt.varName = var->value;
+            s->loc = token_loc(freeTok);
+            s->as.free_stmt.varName = token_text(var);
             expect(p, SEMICOLON_T);
             return s;
         }
@@ -831,18 +828,18 @@ Stmt* parseStatement(Parser* p) {
             Expr* e = parseExpr(p);
             expect(p, SEMICOLON_T);
 
-            Stmt* s = malloc(sizeof(Stmt));
+            Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
             s->type = EXPR_STMT_S;
             s->loc = e->loc;
             s->as.expr_stmt = e;
             return s;
         }
         default:
-            stage_fatal(STAGE_PARSER, TOK_LOC(t), "Unexpected token %s at start of statement", token_type_name(t->type));
+            stage_fatal(STAGE_PARSER, token_loc(t), "Unexpected token %s at start of statement", token_type_name(t->type));
     }
 }
 Stmt* parseBlock(Parser* p) {
-    Stmt** stmt = malloc(sizeof(Stmt*) * 2);
+    Stmt** stmt = arena_alloc(&g_arena, sizeof(Stmt*) * 2);
     int count = 0;
     int size = 2;
     Token* lbrace = expect(p, L_BRACE_T);
@@ -852,15 +849,15 @@ Stmt* parseBlock(Parser* p) {
         count++;
         if(count >= size)
         {
-            stmt = realloc(stmt, sizeof(Stmt*) * size * 2);
+            stmt = arena_realloc(&g_arena, stmt, sizeof(Stmt*) * size, sizeof(Stmt*) * size * 2);
             size *= 2;
         }
     }
     expect(p, R_BRACE_T);
-    return makeBlock(TOK_LOC(lbrace), stmt, count);
+    return makeBlock(token_loc(lbrace), stmt, count);
 }
 FuncParam* parseFuncParams(Parser* p, int* count) {
-    FuncParam* fps = malloc(sizeof(FuncParam));
+    FuncParam* fps = arena_alloc(&g_arena, sizeof(FuncParam));
     int counter = 0;
 
     if (peek(p, 0)->type == R_PAREN_T) {
@@ -881,7 +878,7 @@ FuncParam* parseFuncParams(Parser* p, int* count) {
         }
 
         if(t->type != VAR_T) {
-            stage_fatal(STAGE_PARSER, TOK_LOC(t),
+            stage_fatal(STAGE_PARSER, token_loc(t),
                         "Expected identifier in function parameter number %d, but got %s",
                         counter + 1, token_type_name(t->type));
         }
@@ -905,8 +902,8 @@ FuncParam* parseFuncParams(Parser* p, int* count) {
         }
 
         Token* type = consume(p);
-        FuncParam fp = (FuncParam){.type = type->type, .name = t->value, .ownership = o, .isNullable = isNullable, .isConst = isConst};
-        fps = realloc(fps, sizeof(FuncParam) * (counter + 1));
+        FuncParam fp = (FuncParam){.type = type->type, .name = token_text(t), .ownership = o, .isNullable = isNullable, .isConst = isConst};
+        fps = arena_realloc(&g_arena, fps, sizeof(FuncParam) * (counter ? counter : 1), sizeof(FuncParam) * (counter + 1));
         fps[counter] = fp;
         counter++;
     }
@@ -917,7 +914,7 @@ FuncParam* parseFuncParams(Parser* p, int* count) {
 
 //construction helpers
 Expr* makeIntLit(SourceLocation loc, int val) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = INT_LIT_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -925,7 +922,7 @@ Expr* makeIntLit(SourceLocation loc, int val) {
     return e;
 }
 Expr* makeBoolLit(SourceLocation loc, bool val) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = BOOL_LIT_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -933,7 +930,7 @@ Expr* makeBoolLit(SourceLocation loc, bool val) {
     return e;
 }
 Expr* makeStrLit(SourceLocation loc, char* val) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = STR_LIT_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -941,14 +938,14 @@ Expr* makeStrLit(SourceLocation loc, char* val) {
     return e;
 }
 Expr* makeNullLit(SourceLocation loc) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = NULL_LIT_E;
     e->loc = loc;
     e->is_nullable = true;  //null is always nullable
     return e;
 }
 Expr* makeVar(SourceLocation loc, char* name) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = VAR_E;
     e->loc = loc;
     e->is_nullable = false;  //will be determined by analyzer
@@ -958,7 +955,7 @@ Expr* makeVar(SourceLocation loc, char* name) {
     return e;
 }
 Expr* makeArrAccess(SourceLocation loc, char* name, Expr* index) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = ARRAY_ACCESS_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -967,7 +964,7 @@ Expr* makeArrAccess(SourceLocation loc, char* name, Expr* index) {
     return e;
 }
 Expr* makeArrDecl(SourceLocation loc, Expr** exprs, int count) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = ARRAY_DECL_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -976,7 +973,7 @@ Expr* makeArrDecl(SourceLocation loc, Expr** exprs, int count) {
     return e;
 }
 Expr* makeUnOp(SourceLocation loc, TokenType t, Expr* expr) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = UN_OP_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -985,7 +982,7 @@ Expr* makeUnOp(SourceLocation loc, TokenType t, Expr* expr) {
     return e;
 }
 Expr* makeBinOp(SourceLocation loc, Expr* el, TokenType t, Expr* er) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = BIN_OP_E;
     e->loc = loc;
     e->is_nullable = false;
@@ -995,7 +992,7 @@ Expr* makeBinOp(SourceLocation loc, Expr* el, TokenType t, Expr* er) {
     return e;
 }
 Expr* makeFuncCall(SourceLocation loc, char* n, Expr** params, int paramC) {
-    Expr* e = malloc(sizeof(Expr));
+    Expr* e = arena_alloc(&g_arena, sizeof(Expr));
     e->type = FUNC_CALL_E;
     e->loc = loc;
     e->is_nullable = false;  //will be determined by analyzer for read_* functions
@@ -1007,7 +1004,7 @@ Expr* makeFuncCall(SourceLocation loc, char* n, Expr** params, int paramC) {
 }
 
 Stmt* makeVarDecl(SourceLocation loc, char* n, TokenType t, Expr* e) {
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = VAR_DECL_S;
     s->loc = loc;
     s->as.var_decl.name = n;
@@ -1016,7 +1013,7 @@ Stmt* makeVarDecl(SourceLocation loc, char* n, TokenType t, Expr* e) {
     return s;
 }
 Stmt* makeAssign(SourceLocation loc, char* n, Expr* e) {
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = ASSIGN_S;
     s->loc = loc;
     s->as.var_assign.name = n;
@@ -1024,7 +1021,7 @@ Stmt* makeAssign(SourceLocation loc, char* n, Expr* e) {
     return s;
 }
 Stmt* makeIf(SourceLocation loc, Expr* c, Stmt* t, Stmt* f) {
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = IF_S;
     s->loc = loc;
     s->as.if_stmt.cond = c;
@@ -1033,7 +1030,7 @@ Stmt* makeIf(SourceLocation loc, Expr* c, Stmt* t, Stmt* f) {
     return s;
 }
 Stmt* makeWhile(SourceLocation loc, Expr* c, Stmt* b){
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = WHILE_S;
     s->loc = loc;
     s->as.while_stmt.cond = c;
@@ -1041,7 +1038,7 @@ Stmt* makeWhile(SourceLocation loc, Expr* c, Stmt* b){
     return s;
 }
 Stmt* makeBlock(SourceLocation loc, Stmt** stmts, int c) {
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = BLOCK_S;
     s->loc = loc;
     s->as.block_stmt.stmts = stmts;
@@ -1049,7 +1046,7 @@ Stmt* makeBlock(SourceLocation loc, Stmt** stmts, int c) {
     return s;
 }
 Stmt* makeExprStmt(SourceLocation loc, Expr* e) {
-    Stmt* s = malloc(sizeof(Stmt));
+    Stmt* s = arena_alloc(&g_arena, sizeof(Stmt));
     s->type = EXPR_STMT_S;
     s->loc = loc;
     s->as.expr_stmt = e;
@@ -1057,16 +1054,222 @@ Stmt* makeExprStmt(SourceLocation loc, Expr* e) {
 }
 
 Func* makeFunc(char* name, FuncParam* params, int paramCount, TokenType ret, Ownership retOwnership, Stmt* body) {
-    Func* f = malloc(sizeof(Func));
+    Func* f = arena_alloc(&g_arena, sizeof(Func));
     f->body = body;
-    f->signature = malloc(sizeof(FuncSign));
+    f->signature = arena_alloc(&g_arena, sizeof(FuncSign));
     f->signature->name = name;
     f->signature->parameters = params;
     f->signature->paramNum = paramCount;
     f->signature->retType = ret;
     f->signature->retOwnership = retOwnership;
+    f->signature->isExtern = false;
     return f;
 }
+static Pattern* clone_pattern(Pattern* p) {
+    if (!p) return nullptr;
+    Pattern* c = arena_alloc(&g_arena, sizeof(Pattern));
+    *c = *p;
+    if (p->type == VALUE_PATTERN) c->as.value_expr = clone_expr(p->as.value_expr);
+    return c;
+}
+
+static Expr** clone_expr_list(Expr** list, int count) {
+    if (!list) return nullptr;
+    Expr** c = arena_alloc(&g_arena, sizeof(Expr*) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) c[i] = clone_expr(list[i]);
+    return c;
+}
+
+static Stmt** clone_stmt_list(Stmt** list, int count) {
+    if (!list) return nullptr;
+    Stmt** c = arena_alloc(&g_arena, sizeof(Stmt*) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) c[i] = clone_stmt(list[i]);
+    return c;
+}
+
+Expr* clone_expr(Expr* e) {
+    if (!e) return nullptr;
+    Expr* c = arena_alloc(&g_arena, sizeof(Expr));
+    *c = *e;
+
+    switch (e->type) {
+        case ARRAY_ACCESS_E:
+            c->as.array_access.index = clone_expr(e->as.array_access.index);
+            break;
+        case FUNC_CALL_E:
+            c->as.func_call.params = clone_expr_list(e->as.func_call.params, e->as.func_call.count);
+            break;
+        case FUNC_RET_E:
+            c->as.func_ret_expr = clone_expr(e->as.func_ret_expr);
+            break;
+        case MATCH_E:
+            c->as.match.var = clone_expr(e->as.match.var);
+            c->as.match.branches = arena_alloc(&g_arena, sizeof(MatchBranchExpr) * (e->as.match.branchCount > 0 ? e->as.match.branchCount : 1));
+            for (int i = 0; i < e->as.match.branchCount; i++) {
+                c->as.match.branches[i] = e->as.match.branches[i];
+                c->as.match.branches[i].pattern = clone_pattern(e->as.match.branches[i].pattern);
+                c->as.match.branches[i].caseRet = clone_expr(e->as.match.branches[i].caseRet);
+            }
+            break;
+        case ARRAY_DECL_E:
+            c->as.arr_decl.values = clone_expr_list(e->as.arr_decl.values, e->as.arr_decl.count);
+            break;
+        case ALLOC_E:
+        case ALLOC_ARR_E:
+            c->as.alloc.initialValue = clone_expr(e->as.alloc.initialValue);
+            break;
+        case SOME_E:
+            c->as.some.var = clone_expr(e->as.some.var);
+            break;
+        case UN_OP_E:
+            c->as.un_op.expr = clone_expr(e->as.un_op.expr);
+            break;
+        case BIN_OP_E:
+            c->as.bin_op.exprL = clone_expr(e->as.bin_op.exprL);
+            c->as.bin_op.exprR = clone_expr(e->as.bin_op.exprR);
+            break;
+        default:
+            break; //literals and plain vars have nothing to share
+    }
+    return c;
+}
+
+Stmt* clone_stmt(Stmt* s) {
+    if (!s) return nullptr;
+    Stmt* c = arena_alloc(&g_arena, sizeof(Stmt));
+    *c = *s;
+
+    switch (s->type) {
+        case VAR_DECL_S:
+            c->as.var_decl.arraySize = clone_expr(s->as.var_decl.arraySize);
+            c->as.var_decl.expr = clone_expr(s->as.var_decl.expr);
+            break;
+        case ASSIGN_S:
+            c->as.var_assign.expr = clone_expr(s->as.var_assign.expr);
+            break;
+        case ARRAY_ELEM_ASSIGN_S:
+            c->as.array_elem_assign.index = clone_expr(s->as.array_elem_assign.index);
+            c->as.array_elem_assign.value = clone_expr(s->as.array_elem_assign.value);
+            break;
+        case IF_S:
+            c->as.if_stmt.cond = clone_expr(s->as.if_stmt.cond);
+            c->as.if_stmt.trueStmt = clone_stmt(s->as.if_stmt.trueStmt);
+            c->as.if_stmt.falseStmt = clone_stmt(s->as.if_stmt.falseStmt);
+            break;
+        case WHILE_S:
+            c->as.while_stmt.cond = clone_expr(s->as.while_stmt.cond);
+            c->as.while_stmt.body = clone_stmt(s->as.while_stmt.body);
+            break;
+        case DO_WHILE_S:
+            c->as.do_while_stmt.cond = clone_expr(s->as.do_while_stmt.cond);
+            c->as.do_while_stmt.body = clone_stmt(s->as.do_while_stmt.body);
+            break;
+        case FOR_S:
+            c->as.for_stmt.min = clone_expr(s->as.for_stmt.min);
+            c->as.for_stmt.max = clone_expr(s->as.for_stmt.max);
+            c->as.for_stmt.body = clone_stmt(s->as.for_stmt.body);
+            break;
+        case BLOCK_S:
+            c->as.block_stmt.stmts = clone_stmt_list(s->as.block_stmt.stmts, s->as.block_stmt.count);
+            break;
+        case MATCH_S:
+            c->as.match_stmt.var = clone_expr(s->as.match_stmt.var);
+            c->as.match_stmt.branches = arena_alloc(&g_arena, sizeof(MatchBranchStmt) * (s->as.match_stmt.branchCount > 0 ? s->as.match_stmt.branchCount : 1));
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* from = &s->as.match_stmt.branches[i];
+                c->as.match_stmt.branches[i] = *from;
+                c->as.match_stmt.branches[i].pattern = clone_pattern(from->pattern);
+                c->as.match_stmt.branches[i].stmts = clone_stmt_list(from->stmts, from->stmtCount);
+            }
+            break;
+        case EXPR_STMT_S:
+            c->as.expr_stmt = clone_expr(s->as.expr_stmt);
+            break;
+        default:
+            break;
+    }
+    return c;
+}
+
+void walk_expr(Expr* e, ExprVisit visit, void* data) {
+    if (!e || !visit) return;
+    visit(e, data);
+    switch (e->type) {
+        case ARRAY_ACCESS_E: walk_expr(e->as.array_access.index, visit, data); break;
+        case FUNC_CALL_E:
+            for (int i = 0; i < e->as.func_call.count; i++) walk_expr(e->as.func_call.params[i], visit, data);
+            break;
+        case FUNC_RET_E: walk_expr(e->as.func_ret_expr, visit, data); break;
+        case MATCH_E:
+            walk_expr(e->as.match.var, visit, data);
+            for (int i = 0; i < e->as.match.branchCount; i++) {
+                MatchBranchExpr* b = &e->as.match.branches[i];
+                if (b->pattern && b->pattern->type == VALUE_PATTERN) walk_expr(b->pattern->as.value_expr, visit, data);
+                walk_expr(b->caseRet, visit, data);
+            }
+            break;
+        case ARRAY_DECL_E:
+            for (int i = 0; i < e->as.arr_decl.count; i++) walk_expr(e->as.arr_decl.values[i], visit, data);
+            break;
+        case ALLOC_E:
+        case ALLOC_ARR_E: walk_expr(e->as.alloc.initialValue, visit, data); break;
+        case SOME_E: walk_expr(e->as.some.var, visit, data); break;
+        case UN_OP_E: walk_expr(e->as.un_op.expr, visit, data); break;
+        case BIN_OP_E:
+            walk_expr(e->as.bin_op.exprL, visit, data);
+            walk_expr(e->as.bin_op.exprR, visit, data);
+            break;
+        default: break;
+    }
+}
+
+void walk_stmt(Stmt* s, StmtVisit stmt_visit, ExprVisit visit, void* data) {
+    if (!s) return;
+    if (stmt_visit) stmt_visit(s, data);
+    switch (s->type) {
+        case VAR_DECL_S:
+            walk_expr(s->as.var_decl.arraySize, visit, data);
+            walk_expr(s->as.var_decl.expr, visit, data);
+            break;
+        case ASSIGN_S: walk_expr(s->as.var_assign.expr, visit, data); break;
+        case ARRAY_ELEM_ASSIGN_S:
+            walk_expr(s->as.array_elem_assign.index, visit, data);
+            walk_expr(s->as.array_elem_assign.value, visit, data);
+            break;
+        case IF_S:
+            walk_expr(s->as.if_stmt.cond, visit, data);
+            walk_stmt(s->as.if_stmt.trueStmt, stmt_visit, visit, data);
+            walk_stmt(s->as.if_stmt.falseStmt, stmt_visit, visit, data);
+            break;
+        case WHILE_S:
+            walk_expr(s->as.while_stmt.cond, visit, data);
+            walk_stmt(s->as.while_stmt.body, stmt_visit, visit, data);
+            break;
+        case DO_WHILE_S:
+            walk_stmt(s->as.do_while_stmt.body, stmt_visit, visit, data);
+            walk_expr(s->as.do_while_stmt.cond, visit, data);
+            break;
+        case FOR_S:
+            walk_expr(s->as.for_stmt.min, visit, data);
+            walk_expr(s->as.for_stmt.max, visit, data);
+            walk_stmt(s->as.for_stmt.body, stmt_visit, visit, data);
+            break;
+        case BLOCK_S:
+            for (int i = 0; i < s->as.block_stmt.count; i++) walk_stmt(s->as.block_stmt.stmts[i], stmt_visit, visit, data);
+            break;
+        case MATCH_S:
+            walk_expr(s->as.match_stmt.var, visit, data);
+            for (int i = 0; i < s->as.match_stmt.branchCount; i++) {
+                MatchBranchStmt* b = &s->as.match_stmt.branches[i];
+                if (b->pattern && b->pattern->type == VALUE_PATTERN) walk_expr(b->pattern->as.value_expr, visit, data);
+                for (int j = 0; j < b->stmtCount; j++) walk_stmt(b->stmts[j], stmt_visit, visit, data);
+            }
+            break;
+        case EXPR_STMT_S: walk_expr(s->as.expr_stmt, visit, data); break;
+        default: break;
+    }
+}
+
 bool check_func_sign(FuncSign* a, FuncSign* b) {
     if(a->paramNum != b->paramNum)
         return false;
@@ -1077,7 +1280,7 @@ bool check_func_sign(FuncSign* a, FuncSign* b) {
     }
 
     if (a->retType != b->retType) return false;
-    return (a->retType == b->retType && strcmp(a->name, b->name) == 0);
+    return (a->retType == b->retType && a->name == b->name); //names are interned
 }
 
 bool check_func_sign_unwrapped(FuncSign* a, char* name, int paramNum, Expr** parameters) {
@@ -1087,7 +1290,7 @@ bool check_func_sign_unwrapped(FuncSign* a, char* name, int paramNum, Expr** par
         if(a->parameters[i].type != parameters[i]->analyzedType) { return false; }
     }
 
-    return strcmp(a->name, name) == 0;
+    return a->name == name;
 }
 
 //aST printing functions (only active in trace mode, output to stderr)
@@ -1236,11 +1439,11 @@ void print_stmt(Stmt* s, int depth) {
 }
 
 void print_ast(Func** program, int count) {
-    if (!g_trace_mode) return;
+    if (!trace_on(STAGE_PARSER)) return;
     fprintf(stderr, "\n=== AST (%d functions) ===\n", count);
     for (int i = 0; i < count; i++) {
         fprintf(stderr, "Function: %s\n", program[i]->signature->name);
         print_stmt(program[i]->body, 1);
     }
     fprintf(stderr, "===========\n");
-}
\ No newline at end of file
+}
@@ -11,6 +11,7 @@ typedef struct Stmt Stmt;
 typedef struct Func Func;
 typedef struct Func Func;
 typedef struct ExternBlock ExternBlock;
+typedef struct FuncTable FuncTable;
 
 typedef enum {
     OWNERSHIP_NONE,
@@ -42,6 +43,7 @@ typedef struct {
     int ext_block_count;
     Func** functions;
     int func_count;
+    FuncTable* func_table; //set by the analyzer
 } Program;
 
 typedef struct {
@@ -59,11 +61,13 @@ typedef struct {
     TokenType retType;
     Ownership retOwnership;
     bool isExtern; //nEW: true if function is from extern block
+    char* c_name;  //mangled name, filled in once by codegen
 } FuncSign;
 
 struct Func {
     FuncSign* signature;
     Stmt* body;
+    struct IrFunc* ir;  //set by ir_lower_program when the body lowered, see ir.h
 };
 
 struct ExternBlock {
@@ -259,6 +263,7 @@ struct Stmt {
             Expr* min;
             Expr* max;
             Stmt* body;
+            bool unrolled;  //what is left of a loop the optimizer unrolled, it is not unrolled again
         } for_stmt;
 
         struct {
@@ -319,6 +324,17 @@ Stmt* makeBlock(SourceLocation, Stmt**, int);
 Stmt* makeExprStmt(SourceLocation, Expr*);
 
 Func* makeFunc(char*, FuncParam*, int, TokenType, Ownership, Stmt*);
+
+//deep copies in g_arena, analyzer annotations included. names and resolved signatures stay shared
+Expr* clone_expr(Expr*);
+Stmt* clone_stmt(Stmt*);
+
+//every expression node below e, parents before children. visit may be nullptr to only walk statements
+typedef void (*ExprVisit)(Expr* e, void* data);
+void walk_expr(Expr* e, ExprVisit visit, void* data);
+//every statement and expression below s, stmt_visit may be nullptr
+typedef void (*StmtVisit)(Stmt* s, void* data);
+void walk_stmt(Stmt* s, StmtVisit stmt_visit, ExprVisit visit, void* data);
 bool check_func_sign(FuncSign *a, FuncSign *b);
 bool check_func_sign_unwrapped(FuncSign* a, char* name, int paramNum, Expr** parameters);
 
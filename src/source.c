@@ -0,0 +1,192 @@
+//created by bucka on 10/16/2026.
+
+//mmap/posix_madvise under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "source.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static SourceFile** files = nullptr;
+static int file_count = 0;
+static int file_capacity = 0;
+
+int source_add(const char* path, char* text, uint32_t length) {
+    if (file_count >= MAX_SOURCE_FILES) {
+        stage_fatal(STAGE_INTERNAL, NO_LOC, "too many source files (limit %d)", MAX_SOURCE_FILES);
+    }
+    if (file_count >= file_capacity) {
+        file_capacity = file_capacity ? file_capacity * 2 : 8;
+        files = realloc(files, sizeof(SourceFile*) * file_capacity);
+    }
+
+    SourceFile* f = malloc(sizeof(SourceFile));
+    f->path = strdup(path);
+    f->text = text;
+    f->length = length;
+    f->mapped_size = 0;
+    f->line_starts = nullptr;
+    f->line_count = 0;
+    f->last_line = 0;
+
+    files[file_count] = f;
+    return file_count++;
+}
+
+#ifdef _WIN32
+int source_load(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* code = malloc(file_size + 1);
+    size_t bytes_read = fread(code, 1, file_size, file);
+    code[bytes_read] = '\0';
+    fclose(file);
+
+    return source_add(path, code, (uint32_t)bytes_read);
+}
+#else
+static char* read_all(int fd, size_t size, uint32_t* out_length) {
+    char* code = malloc(size + 1);
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = read(fd, code + total, size - total);
+        if (n < 0) {
+            free(code);
+            return nullptr;
+        }
+        if (n == 0) break; //file shrank under us
+        total += (size_t)n;
+    }
+    code[total] = '\0';
+    *out_length = (uint32_t)total;
+    return code;
+}
+
+int source_load(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size >= UINT32_MAX) {
+        close(fd);
+        stage_fatal(STAGE_INTERNAL, NO_LOC, "source file '%s' is too large (%zu bytes)", path, size);
+    }
+
+    //the lexer relies on a NUL after the last byte. a mapping only has one when the file
+    //doesnt end on a page boundary (the rest of the page is zero filled), so read those instead
+    long page = sysconf(_SC_PAGESIZE);
+    if (size > 0 && page > 0 && size % (size_t)page != 0) {
+        char* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            posix_madvise(map, size, POSIX_MADV_SEQUENTIAL); //the lexer makes one forward pass
+            int id = source_add(path, map, (uint32_t)size);
+            files[id]->mapped_size = size;
+            return id;
+        }
+    }
+
+    uint32_t length = 0;
+    char* code = read_all(fd, size, &length);
+    close(fd);
+    if (!code) return -1;
+    return source_add(path, code, length);
+}
+#endif
+
+SourceFile* source_get(int id) {
+    if (id < 0 || id >= file_count) return nullptr;
+    return files[id];
+}
+
+const char* source_text(int id) {
+    SourceFile* f = source_get(id);
+    return f ? f->text : nullptr;
+}
+
+static void build_line_starts(SourceFile* f) {
+    int capacity = 64;
+    f->line_starts = malloc(sizeof(uint32_t) * capacity);
+    f->line_starts[0] = 0;
+    f->line_count = 1;
+
+    for (uint32_t i = 0; i < f->length; i++) {
+        if (f->text[i] != '\n') continue;
+        if (f->line_count >= capacity) {
+            capacity *= 2;
+            f->line_starts = realloc(f->line_starts, sizeof(uint32_t) * capacity);
+        }
+        f->line_starts[f->line_count++] = i + 1;
+    }
+}
+
+SourceLocation source_location(int id, uint32_t offset) {
+    SourceFile* f = source_get(id);
+    if (!f) return NO_LOC;
+    if (!f->line_starts) build_line_starts(f);
+
+    //the parser asks in token order, so the answer is almost always the cached line or the next few
+    int line = f->last_line;
+    if (f->line_starts[line] <= offset) {
+        int steps = 0;
+        while (line + 1 < f->line_count && f->line_starts[line + 1] <= offset && steps < 8) {
+            line++;
+            steps++;
+        }
+        if (line + 1 < f->line_count && f->line_starts[line + 1] <= offset) line = -1;
+    } else {
+        line = -1;
+    }
+
+    if (line < 0) {
+        //binary search for the last line starting at or before offset
+        int lo = 0, hi = f->line_count - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo + 1) / 2;
+            if (f->line_starts[mid] <= offset) lo = mid;
+            else hi = mid - 1;
+        }
+        line = lo;
+    }
+
+    f->last_line = line;
+    return (SourceLocation){
+        .line = line + 1,
+        .column = (int)(offset - f->line_starts[line]) + 1,
+        .filename = f->path
+    };
+}
+
+void source_free_all(void) {
+    for (int i = 0; i < file_count; i++) {
+        free(files[i]->path);
+#ifndef _WIN32
+        if (files[i]->mapped_size) munmap(files[i]->text, files[i]->mapped_size);
+        else
+#endif
+        free(files[i]->text);
+        free(files[i]->line_starts);
+        free(files[i]);
+    }
+    free(files);
+    files = nullptr;
+    file_count = 0;
+    file_capacity = 0;
+}
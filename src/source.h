@@ -0,0 +1,35 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_SOURCE_H
+#define LYNC_SOURCE_H
+
+#include "common.h"
+
+//tokens carry a 16 bit file id, so that is the registry limit
+#define MAX_SOURCE_FILES 0xFFFF
+
+typedef struct {
+    char* path;
+    char* text;             //NUL terminated, owned by the registry
+    uint32_t length;
+    size_t mapped_size;     //non zero if text is an mmap of the file rather than a heap buffer
+    uint32_t* line_starts;  //offset of each line, built on the first location lookup
+    int line_count;
+    int last_line;          //line index of the previous lookup, lookups mostly move forward
+} SourceFile;
+
+//register an already loaded buffer, the registry takes ownership of text. returns the file id
+int source_add(const char* path, char* text, uint32_t length);
+//map (or read) a file from disk and register it, the bytes stay put until source_free_all().
+//returns -1 if it cant be read
+int source_load(const char* path);
+
+SourceFile* source_get(int id);
+const char* source_text(int id);
+
+//turn a byte offset into the line/column form used by diagnostics
+SourceLocation source_location(int id, uint32_t offset);
+
+void source_free_all(void);
+
+#endif //LYNC_SOURCE_H
@@ -0,0 +1,116 @@
+//created by bucka on 10/16/2026.
+
+//pthreads/sysconf under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#endif
+
+#define POOL_MAX_WORKERS 256
+
+int g_jobs = 1;
+
+typedef struct {
+    PoolTask task;
+    void* ctx;
+    int count;
+#ifdef _WIN32
+    volatile LONG next;
+#else
+    atomic_int next;
+#endif
+} PoolJob;
+
+typedef struct {
+    PoolJob* job;
+    int worker;
+} PoolWorker;
+
+static int claim(PoolJob* job) {
+#ifdef _WIN32
+    return (int)InterlockedIncrement(&job->next) - 1;
+#else
+    return atomic_fetch_add(&job->next, 1);
+#endif
+}
+
+static void drain(PoolJob* job, int worker) {
+    for (int i = claim(job); i < job->count; i = claim(job)) {
+        job->task(job->ctx, worker, i);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+    PoolWorker* w = arg;
+    drain(w->job, w->worker);
+    return 0;
+}
+#else
+static void* worker_main(void* arg) {
+    PoolWorker* w = arg;
+    drain(w->job, w->worker);
+    return nullptr;
+}
+#endif
+
+void pool_run(int workers, int count, PoolTask task, void* ctx) {
+    PoolJob job = {.task = task, .ctx = ctx, .count = count};
+#ifndef _WIN32
+    atomic_init(&job.next, 0);
+#endif
+    if (workers > count) workers = count;
+    if (workers > POOL_MAX_WORKERS) workers = POOL_MAX_WORKERS;
+
+    //the calling thread is worker 0, a thread that fails to start just leaves its share to the others
+    PoolWorker info[POOL_MAX_WORKERS];
+#ifdef _WIN32
+    HANDLE threads[POOL_MAX_WORKERS];
+#else
+    pthread_t threads[POOL_MAX_WORKERS];
+#endif
+    bool started[POOL_MAX_WORKERS] = {false};
+
+    for (int w = 1; w < workers; w++) {
+        info[w] = (PoolWorker){.job = &job, .worker = w};
+#ifdef _WIN32
+        threads[w] = CreateThread(nullptr, 0, worker_main, &info[w], 0, nullptr);
+        started[w] = threads[w] != nullptr;
+#else
+        started[w] = pthread_create(&threads[w], nullptr, worker_main, &info[w]) == 0;
+#endif
+        if (!started[w]) stage_trace(STAGE_INTERNAL, "worker %d did not start", w);
+    }
+
+    drain(&job, 0);
+
+    for (int w = 1; w < workers; w++) {
+        if (!started[w]) continue;
+#ifdef _WIN32
+        WaitForSingleObject(threads[w], INFINITE);
+        CloseHandle(threads[w]);
+#else
+        pthread_join(threads[w], nullptr);
+#endif
+    }
+}
+
+int pool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
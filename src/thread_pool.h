@@ -0,0 +1,22 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_THREAD_POOL_H
+#define LYNC_THREAD_POOL_H
+
+#include "common.h"
+
+//threads the parallel stages (analyzer, codegen) may use, set by -j. 1 keeps everything on the calling thread
+extern int g_jobs;
+
+//one unit of work, index is the item, worker is which thread (0..workers-1) runs it
+typedef void (*PoolTask)(void* ctx, int worker, int index);
+
+//runs task for every index in [0, count) on up to `workers` threads and waits for all of them.
+//indices are handed out in increasing order, so each worker sees its items in index order.
+//workers <= 1 (or a failed thread start) runs everything on the calling thread as worker 0
+void pool_run(int workers, int count, PoolTask task, void* ctx);
+
+//online cpus, at least 1
+int pool_cpu_count(void);
+
+#endif //LYNC_THREAD_POOL_H
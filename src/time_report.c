@@ -0,0 +1,168 @@
+//created by bucka on 10/16/2026.
+
+//clock_gettime/getrusage under strict -std=c23, must come before any system header
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "time_report.h"
+#include "arena.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+TimeReportFormat g_time_report = TIME_REPORT_OFF;
+
+static const char* phase_names[PHASE_COUNT] = {
+    "lexer", "parser", "includes", "analyzer", "optimizer", "ir", "codegen", "backend",
+};
+
+typedef struct {
+    double wall_ms;
+    double cpu_ms;
+    long maxrss_kb;
+    size_t alloc_bytes;
+    size_t allocs;
+} Sample;
+
+static PhaseTiming phases[PHASE_COUNT];
+static Sample started[PHASE_COUNT];
+
+static double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+
+#ifndef _WIN32
+static double tv_ms(struct timeval tv) {
+    return (double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0;
+}
+
+static long maxrss_kb(const struct rusage* ru) {
+#ifdef __APPLE__
+    return ru->ru_maxrss / 1024;    //bytes there, kilobytes everywhere else
+#else
+    return ru->ru_maxrss;
+#endif
+}
+#endif
+
+//the backend runs in a child, so it is measured from the children side of getrusage
+static void take_sample(Sample* s, bool children) {
+    s->wall_ms = now_ms();
+    s->cpu_ms = 0;
+    s->maxrss_kb = 0;
+#ifdef _WIN32
+    if (!children) {
+        FILETIME created, exited, kernel, user;
+        if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+            ULARGE_INTEGER k = {.LowPart = kernel.dwLowDateTime, .HighPart = kernel.dwHighDateTime};
+            ULARGE_INTEGER u = {.LowPart = user.dwLowDateTime, .HighPart = user.dwHighDateTime};
+            s->cpu_ms = (double)(k.QuadPart + u.QuadPart) / 10000.0;
+        }
+    }
+#else
+    struct rusage ru;
+    if (getrusage(children ? RUSAGE_CHILDREN : RUSAGE_SELF, &ru) == 0) {
+        s->cpu_ms = tv_ms(ru.ru_utime) + tv_ms(ru.ru_stime);
+        s->maxrss_kb = maxrss_kb(&ru);
+    }
+#endif
+
+    s->alloc_bytes = 0;
+    s->allocs = 0;
+    for (int i = 0; i < ARENA_STAGE_COUNT; i++) {
+        s->alloc_bytes += g_arena.stats[i].bytes;
+        s->allocs += g_arena.stats[i].allocs;
+    }
+}
+
+void time_phase_begin(TimePhase phase) {
+    if (g_time_report == TIME_REPORT_OFF) return;
+    take_sample(&started[phase], phase == PHASE_BACKEND);
+}
+
+void time_phase_end(TimePhase phase) {
+    if (g_time_report == TIME_REPORT_OFF) return;
+    Sample end;
+    take_sample(&end, phase == PHASE_BACKEND);
+    const Sample* start = &started[phase];
+
+    PhaseTiming* t = &phases[phase];
+    t->ran = true;
+    t->wall_ms += end.wall_ms - start->wall_ms;
+    t->cpu_ms += end.cpu_ms - start->cpu_ms;
+    //children maxrss is the largest child so far, there is only ever the one compiler
+    t->rss_delta_kb = phase == PHASE_BACKEND ? end.maxrss_kb : t->rss_delta_kb + (end.maxrss_kb - start->maxrss_kb);
+    t->alloc_bytes += end.alloc_bytes - start->alloc_bytes;
+    t->allocs += end.allocs - start->allocs;
+}
+
+static void print_table(FILE* out) {
+    double lync_wall = 0, lync_cpu = 0;
+    size_t bytes = 0, allocs = 0;
+
+    fprintf(out, "\n=== time report ===\n");
+    fprintf(out, "  %-10s %10s %10s %10s %14s %10s\n", "phase", "wall ms", "cpu ms", "rss +KB", "alloc bytes", "allocs");
+    for (int i = 0; i < PHASE_BACKEND; i++) {
+        const PhaseTiming* t = &phases[i];
+        if (!t->ran) continue;
+        fprintf(out, "  %-10s %10.2f %10.2f %10ld %14zu %10zu\n",
+                phase_names[i], t->wall_ms, t->cpu_ms, t->rss_delta_kb, t->alloc_bytes, t->allocs);
+        lync_wall += t->wall_ms;
+        lync_cpu += t->cpu_ms;
+        bytes += t->alloc_bytes;
+        allocs += t->allocs;
+    }
+    fprintf(out, "  %-10s %10.2f %10.2f %10s %14zu %10zu\n", "lync", lync_wall, lync_cpu, "", bytes, allocs);
+
+    const PhaseTiming* cc = &phases[PHASE_BACKEND];
+    if (cc->ran) {
+        fprintf(out, "  %-10s %10.2f %10.2f %10ld %14s %10s   (C compiler, rss is its peak)\n",
+                phase_names[PHASE_BACKEND], cc->wall_ms, cc->cpu_ms, cc->rss_delta_kb, "-", "-");
+        double total = lync_wall + cc->wall_ms;
+        if (total > 0) {
+            fprintf(out, "  wall split: lync %.1f%%, C compiler %.1f%%\n",
+                    lync_wall * 100.0 / total, cc->wall_ms * 100.0 / total);
+        }
+    }
+}
+
+//a single line, so build scripts can pick it out of the compilers diagnostics with tail -1
+static void print_json(FILE* out) {
+    double lync_wall = 0;
+    bool first = true;
+
+    fprintf(out, "{\"phases\": [");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseTiming* t = &phases[i];
+        if (!t->ran) continue;
+        fprintf(out, "%s{\"name\": \"%s\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"rss_delta_kb\": %ld, "
+                     "\"alloc_bytes\": %zu, \"allocs\": %zu}",
+                first ? "" : ", ", phase_names[i], t->wall_ms, t->cpu_ms, t->rss_delta_kb, t->alloc_bytes, t->allocs);
+        if (i != PHASE_BACKEND) lync_wall += t->wall_ms;
+        first = false;
+    }
+    fprintf(out, "], \"lync_wall_ms\": %.3f, \"backend_wall_ms\": %.3f}\n",
+            lync_wall, phases[PHASE_BACKEND].wall_ms);
+}
+
+void time_report_print(FILE* out) {
+    switch (g_time_report) {
+        case TIME_REPORT_TABLE: print_table(out); break;
+        case TIME_REPORT_JSON: print_json(out); break;
+        default: break;
+    }
+}
@@ -0,0 +1,45 @@
+//created by bucka on 10/16/2026.
+
+#ifndef LYNC_TIME_REPORT_H
+#define LYNC_TIME_REPORT_H
+
+#include "common.h"
+
+//phases of one compile as main runs them, finer than ErrorStage so includes and the C backend show up on their own
+typedef enum {
+    PHASE_LEXER,
+    PHASE_PARSER,
+    PHASE_INCLUDES,
+    PHASE_ANALYZER,
+    PHASE_OPTIMIZER,
+    PHASE_IR,               //lowering to ir and dumping it, only with --emit-ir/--via-ir
+    PHASE_CODEGEN,
+    PHASE_BACKEND,          //the external C compiler, measured through its child rusage
+    PHASE_COUNT
+} TimePhase;
+
+typedef struct {
+    bool ran;
+    double wall_ms;
+    double cpu_ms;          //user + system, of the C compiler for PHASE_BACKEND
+    long rss_delta_kb;      //growth of our peak rss, the compilers own peak for PHASE_BACKEND
+    size_t alloc_bytes;     //g_arena traffic while the phase ran
+    size_t allocs;
+} PhaseTiming;
+
+typedef enum {
+    TIME_REPORT_OFF,
+    TIME_REPORT_TABLE,
+    TIME_REPORT_JSON,
+} TimeReportFormat;
+
+extern TimeReportFormat g_time_report;
+
+//bracket a phase, no-ops unless --time-report is on
+void time_phase_begin(TimePhase phase);
+void time_phase_end(TimePhase phase);
+
+//table or json on out, whatever g_time_report asks for
+void time_report_print(FILE* out);
+
+#endif //LYNC_TIME_REPORT_H